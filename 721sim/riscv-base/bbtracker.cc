@@ -7,6 +7,7 @@ bb_tracker_t::bb_tracker_t ()
 
   bb_id = 0;
 
+  bbtrace = NULL;
   first_interval = 1;
   interval_sum=0; 
   
@@ -17,8 +18,26 @@ bb_tracker_t::bb_tracker_t ()
 }
 
 
+bb_tracker_t::~bb_tracker_t ()
+{
+  int64_t i;
+  bb_node_ptr next;
+
+  /* the last, partial interval is not emitted */
+  if (bbtrace)
+    pclose(bbtrace);
 
-void bb_tracker_t::init_bb_tracker (char* dir_name, char* out_name, uint64_t m_interval_size)
+  for (i=0; i<bb_size; i++) {
+    while (bb_hash[i] != NULL) {
+      next = bb_hash[i]->next;
+      free(bb_hash[i]);
+      bb_hash[i] = next;
+    }
+  }
+}
+
+
+void bb_tracker_t::init_bb_tracker (const char* dir_name, const char* out_name, uint64_t m_interval_size)
 {
   int64_t i;
 
@@ -96,16 +115,14 @@ void bb_tracker_t::print_list (bb_node_ptr head, uint64_t array[])
 void bb_tracker_t::print_bb_hash (bb_node_ptr hash[])
 {
   uint64_t i;
-  uint64_t bb_array[bb_id];
 
-  /* initialize array for sorting bb according to bb_id */
-  for(i=0; i<bb_id; i++) {
-    bb_array[i] = 0;
-  }
+  /* initialize array for sorting bb according to bb_id
+     (on the heap: there may be too many bbs for the stack) */
+  bb_array.assign(bb_id, 0);
 
   for(i=0; i<bb_size; i++) {
     if (hash[i] != NULL)
-      print_list(hash[i], bb_array);
+      print_list(hash[i], bb_array.data());
   }
 
   if (first_interval) {
@@ -3,6 +3,7 @@
 
 #include <cinttypes>
 #include <stdio.h>
+#include <vector>
 
 /* Initializes interval size, output directory and output name, 
    as well as the basic block hash table */
@@ -32,8 +33,8 @@ class bb_tracker_t{
 
     FILE* bbtrace;
     char finalname[450];
-    char *outdir;                                                                
-    char *outfile;                                                               
+    const char *outdir;
+    const char *outfile;
     
     uint64_t interval_size; 
     uint64_t first_interval;
@@ -49,12 +50,14 @@ class bb_tracker_t{
     void print_list (bb_node_ptr head, uint64_t array[]);
     void print_bb_hash (bb_node_ptr hash[]);
 
+    std::vector<uint64_t> bb_array;
+
   public:
 
     bb_tracker_t ();
     ~bb_tracker_t();
 
-    void init_bb_tracker (char* m_dir_name, char* m_out_name, uint64_t m_interval_size);
+    void init_bb_tracker (const char* m_dir_name, const char* m_out_name, uint64_t m_interval_size);
     void set_interval_size(size_t m_interval_size);
  
 
@@ -0,0 +1,215 @@
+// See LICENSE for license details.
+
+#include "chkpt_image.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+/////////////////////////////////////////////////////////////////////////////
+// chkpt_writer_t
+/////////////////////////////////////////////////////////////////////////////
+
+chkpt_writer_t::chkpt_writer_t()
+  : fp(NULL)
+{
+}
+
+chkpt_writer_t::~chkpt_writer_t()
+{
+  if (fp)
+    fclose(fp);
+}
+
+bool chkpt_writer_t::open(const std::string& file, size_t memsz, const std::string& htif_replay)
+{
+  assert((memsz % CHKPT_PAGE_SIZE) == 0);
+
+  fp = fopen(file.c_str(), "wb");
+  if (!fp)
+    return false;
+
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic = CHKPT_MAGIC;
+  hdr.version = CHKPT_VERSION;
+  hdr.page_size = CHKPT_PAGE_SIZE;
+  hdr.memsz = memsz;
+  hdr.npages = memsz / CHKPT_PAGE_SIZE;
+  index.reserve(hdr.npages);
+
+  // Header is rewritten with the final offsets by close().
+  fwrite(&hdr, sizeof(hdr), 1, fp);
+
+  uLongf clen = compressBound(htif_replay.size());
+  buf.resize(std::max(clen, compressBound(CHKPT_PAGE_SIZE)));
+  if (compress2(buf.data(), &clen, (const Bytef*)htif_replay.data(), htif_replay.size(), Z_DEFAULT_COMPRESSION) != Z_OK)
+    return false;
+  hdr.htif_off = ftell(fp);
+  hdr.htif_clen = clen;
+  hdr.htif_len = htif_replay.size();
+  fwrite(buf.data(), 1, clen, fp);
+
+  return !ferror(fp);
+}
+
+void chkpt_writer_t::add_page(const char* data)
+{
+  assert(index.size() < hdr.npages);
+  chkpt_page_t entry = {0, 0};
+
+  const uint64_t* word = (const uint64_t*)data;
+  bool zero = true;
+  for (size_t i = 0; zero && i < CHKPT_PAGE_SIZE / sizeof(uint64_t); i++)
+    zero = (word[i] == 0);
+
+  if (!zero) {
+    uLongf clen = buf.size();
+    entry.off = ftell(fp);
+    if (compress2(buf.data(), &clen, (const Bytef*)data, CHKPT_PAGE_SIZE, Z_DEFAULT_COMPRESSION) == Z_OK && clen < CHKPT_PAGE_SIZE) {
+      entry.clen = clen;
+      fwrite(buf.data(), 1, clen, fp);
+    }
+    else {
+      entry.clen = CHKPT_PAGE_SIZE;
+      fwrite(data, 1, CHKPT_PAGE_SIZE, fp);
+    }
+  }
+
+  index.push_back(entry);
+}
+
+void chkpt_writer_t::set_state(const void* data, size_t len)
+{
+  state.assign((const char*)data, (const char*)data + len);
+}
+
+bool chkpt_writer_t::close()
+{
+  assert(index.size() == hdr.npages);
+
+  hdr.index_off = ftell(fp);
+  fwrite(index.data(), sizeof(chkpt_page_t), index.size(), fp);
+  hdr.state_off = ftell(fp);
+  hdr.state_len = state.size();
+  fwrite(state.data(), 1, state.size(), fp);
+
+  fseek(fp, 0, SEEK_SET);
+  fwrite(&hdr, sizeof(hdr), 1, fp);
+
+  bool ok = !ferror(fp);
+  ok = (fclose(fp) == 0) && ok;
+  fp = NULL;
+  return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// chkpt_image_t
+/////////////////////////////////////////////////////////////////////////////
+
+chkpt_image_t::chkpt_image_t()
+  : fd(-1), base(NULL), size(0), hdr(NULL), index(NULL), page_shift(0), nonzero(0), mem(NULL), nloaded(0)
+{
+}
+
+chkpt_image_t::~chkpt_image_t()
+{
+  if (base)
+    munmap((void*)base, size);
+  if (fd >= 0)
+    ::close(fd);
+}
+
+bool chkpt_image_t::open(const std::string& file)
+{
+  struct stat st;
+
+  fd = ::open(file.c_str(), O_RDONLY);
+  if (fd < 0 || fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(chkpt_header_t))
+    return false;
+
+  size = st.st_size;
+  void* p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (p == MAP_FAILED)
+    return false;
+  base = (const unsigned char*)p;
+  hdr = (const chkpt_header_t*)base;
+
+  if (hdr->magic != CHKPT_MAGIC || hdr->version != CHKPT_VERSION) {
+    fprintf(stderr, "ERROR: `%s' is not a version %d checkpoint image.\n", file.c_str(), CHKPT_VERSION);
+    return false;
+  }
+  if ((hdr->page_size & (hdr->page_size - 1)) || hdr->npages * hdr->page_size != hdr->memsz ||
+      hdr->index_off + hdr->npages * sizeof(chkpt_page_t) > size ||
+      hdr->state_off + hdr->state_len > size ||
+      hdr->htif_off + hdr->htif_clen > size) {
+    fprintf(stderr, "ERROR: Checkpoint image `%s' is truncated or corrupt.\n", file.c_str());
+    return false;
+  }
+
+  page_shift = __builtin_ctzll(hdr->page_size);
+  index = (const chkpt_page_t*)(base + hdr->index_off);
+  for (size_t pg = 0; pg < hdr->npages; pg++)
+    if (index[pg].clen)
+      nonzero++;
+
+  // Pages are read in whatever order the program touches them.
+  madvise(p, size, MADV_RANDOM);
+  return true;
+}
+
+std::string chkpt_image_t::htif_replay()
+{
+  std::string text(hdr->htif_len, '\0');
+  uLongf len = hdr->htif_len;
+  int ret = uncompress((Bytef*)&text[0], &len, base + hdr->htif_off, hdr->htif_clen);
+  assert(ret == Z_OK && len == hdr->htif_len);
+  return text;
+}
+
+const char* chkpt_image_t::state(size_t& len)
+{
+  len = hdr->state_len;
+  return (const char*)(base + hdr->state_off);
+}
+
+void chkpt_image_t::attach(char* _mem, size_t _memsz)
+{
+  assert(_memsz == hdr->memsz);
+  mem = _mem;
+  loaded.assign((hdr->npages + 63) / 64, 0);
+  nloaded = 0;
+}
+
+void chkpt_image_t::load(uint64_t pg)
+{
+  assert(mem && pg < hdr->npages);
+  char* dst = mem + (pg << page_shift);
+  const chkpt_page_t& entry = index[pg];
+
+  if (entry.clen == 0) {
+    memset(dst, 0, hdr->page_size);
+  }
+  else if (entry.clen == hdr->page_size) {
+    memcpy(dst, base + entry.off, hdr->page_size);
+  }
+  else {
+    uLongf len = hdr->page_size;
+    int ret = uncompress((Bytef*)dst, &len, base + entry.off, entry.clen);
+    if (ret != Z_OK || len != hdr->page_size) {
+      fprintf(stderr, "ERROR: Checkpoint image page %lu is corrupt.\n", (unsigned long)pg);
+      abort();
+    }
+  }
+
+  loaded[pg >> 6] |= (1ULL << (pg & 63));
+  nloaded++;
+}
+
+void chkpt_image_t::load_all()
+{
+  touch(0, hdr->memsz);
+}
@@ -0,0 +1,118 @@
+// See LICENSE for license details.
+
+#ifndef _RISCV_CHKPT_IMAGE_H
+#define _RISCV_CHKPT_IMAGE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Seekable checkpoint container (".ckpt"). Unlike the streamed .gz format,
+// memory is stored as independently compressed fixed-size pages with an
+// index, so the file can be memory-mapped and each page inflated on first
+// touch. Layout:
+//
+//   chkpt_header_t
+//   HTIF replay text     (zlib)
+//   compressed pages     (zlib, only for non-zero pages)
+//   page index           (npages x chkpt_page_t)
+//   state_t              (raw)
+//
+// An index entry with clen == 0 is an all-zero page and has no data.
+// An entry with clen == page_size is stored uncompressed.
+
+#define CHKPT_MAGIC     0x74706b6331323700ULL  // "\0721ckpt"
+#define CHKPT_VERSION   1
+#define CHKPT_PAGE_SIZE 8192
+#define CHKPT_EXT       "ckpt"
+
+struct chkpt_header_t {
+  uint64_t magic;
+  uint64_t version;
+  uint64_t page_size;
+  uint64_t memsz;
+  uint64_t npages;
+  uint64_t htif_off;
+  uint64_t htif_clen;
+  uint64_t htif_len;
+  uint64_t index_off;
+  uint64_t state_off;
+  uint64_t state_len;
+};
+
+struct chkpt_page_t {
+  uint64_t off;
+  uint64_t clen;
+};
+
+// Writes a .ckpt file. Pages must be added in order, starting at address 0.
+class chkpt_writer_t
+{
+public:
+  chkpt_writer_t();
+  ~chkpt_writer_t();
+
+  bool open(const std::string& file, size_t memsz, const std::string& htif_replay);
+  void add_page(const char* data);
+  void set_state(const void* state, size_t len);
+  bool close();
+
+private:
+  FILE* fp;
+  chkpt_header_t hdr;
+  std::vector<chkpt_page_t> index;
+  std::vector<char> state;
+  std::vector<unsigned char> buf;
+};
+
+// A memory-mapped .ckpt file. Once attached to the target memory, pages are
+// inflated into it the first time the MMU translates to them.
+class chkpt_image_t
+{
+public:
+  chkpt_image_t();
+  ~chkpt_image_t();
+
+  bool open(const std::string& file);
+
+  size_t memsz() { return hdr->memsz; }
+  std::string htif_replay();
+  const char* state(size_t& len);
+
+  // Take over target memory. Pages are (re)loaded from the image on first
+  // touch, discarding anything written to them before the attach.
+  void attach(char* _mem, size_t _memsz);
+
+  // Make sure the pages spanning [paddr, paddr+bytes) are loaded.
+  inline void touch(uint64_t paddr, size_t bytes)
+  {
+    for (uint64_t pg = paddr >> page_shift; pg <= (paddr + bytes - 1) >> page_shift; pg++)
+      if (__builtin_expect(!((loaded[pg >> 6] >> (pg & 63)) & 1), 0))
+        load(pg);
+  }
+
+  void load_all();
+
+  size_t pages_total() { return hdr->npages; }
+  size_t pages_nonzero() { return nonzero; }
+  size_t pages_loaded() { return nloaded; }
+
+private:
+  void load(uint64_t pg);
+
+  int fd;
+  const unsigned char* base;
+  size_t size;
+  const chkpt_header_t* hdr;
+  const chkpt_page_t* index;
+  unsigned page_shift;
+  size_t nonzero;
+
+  char* mem;
+  std::vector<uint64_t> loaded;  // bitmap, one bit per page
+  size_t nloaded;
+};
+
+#endif
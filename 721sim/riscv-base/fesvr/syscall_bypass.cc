@@ -39,15 +39,19 @@ syscall_mirror_t::syscall_mirror_t(htif_t *htif) : syscall_t(htif) {
 }
 
 void syscall_mirror_t::notify_syscall_sequence(syscall_service_sequence_t *new_seq) {
+  std::lock_guard<std::mutex> guard(queue_lock);
   cores_queued_service_seq[new_seq->seq_coreid].push(new_seq);
+  queue_cv.notify_all();
 }
 
 void syscall_mirror_t::syscall_handler_mirror(command_t cmd) {
   // perform action according to the seq in the queue for this cpu core
   auto coreid = cmd.get_coreid();
-  assert(!cores_queued_service_seq[coreid].empty());
+  std::unique_lock<std::mutex> lock(queue_lock);
+  queue_cv.wait(lock, [&]() { return !cores_queued_service_seq[coreid].empty(); });
   auto service_seq = cores_queued_service_seq[coreid].front();
   cores_queued_service_seq[coreid].pop();
+  lock.unlock();
   assert(service_seq->seq_coreid == coreid);
 
   if (service_seq->seq_payload != cmd.payload()) {
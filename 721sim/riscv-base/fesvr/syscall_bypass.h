@@ -6,6 +6,9 @@
 #include "memif.h"
 #include <functional>
 #include <iostream>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 
 #define CORE_SEQ_QUEUE_MAX 8
 
@@ -32,7 +35,8 @@ public:
 
 struct syscall_service_sequence_t {
 private:
-  size_t ref_cnt;
+  // The main device and its mirrors may run on different threads.
+  std::atomic<size_t> ref_cnt;
 public:
   reg_t seq_payload;
   uint32_t seq_coreid;
@@ -48,7 +52,7 @@ public:
   };
 
   syscall_service_sequence_t(syscall_service_sequence_t &&o) noexcept:
-    ref_cnt(o.ref_cnt), seq_payload(o.seq_payload), seq_coreid(o.seq_coreid), seq_respond(o.seq_respond),
+    ref_cnt(o.ref_cnt.load()), seq_payload(o.seq_payload), seq_coreid(o.seq_coreid), seq_respond(o.seq_respond),
     seq_final_htif_exitcode(o.seq_final_htif_exitcode), seq_trans(std::move(o.seq_trans)) {
     o.seq_trans.clear();
     o.ref_cnt = 0;
@@ -61,11 +65,7 @@ public:
   }
 
   static void free(syscall_service_sequence_t *&seq) {
-    if (seq->ref_cnt != 0) {
-      --seq->ref_cnt;
-    }
-
-    if (seq->ref_cnt == 0) {
+    if (seq->ref_cnt.load() == 0 || seq->ref_cnt.fetch_sub(1) == 1) {
       delete seq;
     }
     seq = nullptr;
@@ -97,6 +97,10 @@ private:
   std::vector<
     std::queue<syscall_service_sequence_t *>
   > cores_queued_service_seq;
+  // The main device may be on another thread (asynchronous checker), and may not
+  // have serviced a syscall yet when the mirror reaches it.
+  std::mutex queue_lock;
+  std::condition_variable queue_cv;
 public:
   explicit syscall_mirror_t(htif_t *htif);
 
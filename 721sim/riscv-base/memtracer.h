@@ -15,6 +15,11 @@ class memtracer_t
 
   virtual bool interested_in_range(uint64_t begin, uint64_t end, bool store, bool fetch) = 0;
   virtual void trace(uint64_t addr, size_t bytes, bool store, bool fetch) = 0;
+  // Same, also given the access's virtual address (for tracers that model virtually-addressed structures).
+  virtual void trace_virtual(uint64_t vaddr, uint64_t addr, size_t bytes, bool store, bool fetch)
+  {
+    trace(addr, bytes, store, fetch);
+  }
 };
 
 class memtracer_list_t : public memtracer_t
@@ -33,6 +38,11 @@ class memtracer_list_t : public memtracer_t
     for (std::vector<memtracer_t*>::iterator it = list.begin(); it != list.end(); ++it)
       (*it)->trace(addr, bytes, store, fetch);
   }
+  void trace_virtual(uint64_t vaddr, uint64_t addr, size_t bytes, bool store, bool fetch)
+  {
+    for (std::vector<memtracer_t*>::iterator it = list.begin(); it != list.end(); ++it)
+      (*it)->trace_virtual(vaddr, addr, bytes, store, fetch);
+  }
   void hook(memtracer_t* h)
   {
     list.push_back(h);
@@ -3,16 +3,17 @@
 #include "mmu.h"
 #include "sim.h"
 #include "processor.h"
+#include "chkpt_image.h"
 
 mmu_t::mmu_t(char* _mem, size_t _memsz)
- : mem(_mem), memsz(_memsz), proc(NULL)
+ : mem(_mem), memsz(_memsz), proc(NULL), image(NULL)
 {
   flush_tlb();
   debug_mmu = false;
 }
 
 mmu_t::mmu_t(char* _mem, size_t _memsz, bool _debug_mmu)
- : mem(_mem), memsz(_memsz), proc(NULL)
+ : mem(_mem), memsz(_memsz), proc(NULL), image(NULL)
 {
   flush_tlb();
   debug_mmu = _debug_mmu; // Set flag to true if this is a debug MMU
@@ -26,6 +27,9 @@ void mmu_t::flush_icache()
 {
   for (size_t i = 0; i < ICACHE_ENTRIES; i++)
     icache[i].tag = -1;
+
+  if (proc)
+    proc->flush_uop_cache();
 }
 
 void mmu_t::flush_tlb()
@@ -65,8 +69,11 @@ void* mmu_t::refill_tlb(reg_t addr, reg_t bytes, bool store, bool fetch)
   reg_t pgbase = pte >> PGSHIFT << PGSHIFT;
   reg_t paddr = pgbase + pgoff;
 
+  if (unlikely(image != NULL))
+    image->touch(pgbase, PGSIZE);
+
   if (unlikely(tracer.interested_in_range(pgbase, pgbase + PGSIZE, store, fetch)))
-    tracer.trace(paddr, bytes, store, fetch);
+    tracer.trace_virtual(addr, paddr, bytes, store, fetch);
   else
   {
     tlb_load_tag[idx] = (pte_perm & PTE_UR) ? expected_tag : -1;
@@ -105,6 +112,8 @@ pte_t mmu_t::walk(reg_t addr)
       if(pte_addr >= memsz)
         break;
 
+      if (unlikely(image != NULL))
+        image->touch(pte_addr, sizeof(pte_t));
       ptd = *(pte_t*)(mem+pte_addr);
 
       if (!(ptd & PTE_V)) // invalid mapping
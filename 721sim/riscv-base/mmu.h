@@ -12,6 +12,8 @@
 #include <vector>
 #include "debug.h"
 
+class chkpt_image_t;
+
 // virtual memory configuration
 typedef reg_t pte_t;
 const reg_t LEVELS = sizeof(pte_t) == 8 ? 3 : 2;
@@ -176,7 +178,7 @@ public:
     if (!tracer.empty() && tracer.interested_in_range(paddr, paddr + 1, false, true))
     {
       icache[idx].tag = -1;
-      tracer.trace(paddr, 1, false, true);
+      tracer.trace_virtual(addr, paddr, 1, false, true);
     }
     return &icache[idx];
   }
@@ -188,6 +190,9 @@ public:
 
   void set_processor(processor_t* p) { proc = p; flush_tlb(); }
 
+  // Lazily-loaded checkpoint backing target memory, if any.
+  void set_chkpt_image(chkpt_image_t* i) { image = i; flush_tlb(); }
+
   void flush_tlb();
   void flush_icache();
 
@@ -197,6 +202,7 @@ private:
   char* mem;
   size_t memsz;
   processor_t* proc;
+  chkpt_image_t* image;
   memtracer_list_t tracer;
 
   bool debug_mmu; //Set to true if this is a debug MMU
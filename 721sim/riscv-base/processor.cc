@@ -16,6 +16,7 @@
 #include <stdexcept>
 #include <algorithm>
 #include "debug.h"
+#include "bbtracker.h"
 
 #undef STATE
 #define STATE state
@@ -24,7 +25,7 @@ extern bool logging_on;
 
 processor_t::processor_t(sim_t* _sim, mmu_t* _mmu, uint32_t _id)
   : sim(_sim), mmu(_mmu), ext(NULL), disassembler(new disassembler_t),
-    id(_id), run(false), debug(false), serialized(false)
+    id(_id), run(false), debug(false), serialized(false), bbv(NULL), bb_length(0)
 {
   reset(true);
   mmu->set_processor(this);
@@ -206,6 +207,27 @@ inline void processor_t::update_histogram(size_t pc)
 #endif
 }
 
+void processor_t::set_bbv(bb_tracker_t* _bbv)
+{
+  bbv = _bbv;
+  bb_length = 0;
+}
+
+// A basic block ends at a control transfer instruction, or at anything
+// else that does not fall through (e.g., eret).
+inline void processor_t::update_bbv(reg_t pc, insn_t insn, reg_t npc)
+{
+  if (likely(bbv == NULL))
+    return;
+
+  reg_t opcode = insn.bits() & 0x7f;
+  bb_length++;
+  if ((opcode == 0x63) || (opcode == 0x67) || (opcode == 0x6f) || (npc != pc + 4)) {
+    bbv->bb_tracker(pc, bb_length);
+    bb_length = 0;
+  }
+}
+
 #ifdef RISCV_MICRO_CHECKER
 inline reg_t processor_t::get_rs(reg_t rs, reg_t pc, operand_t type){
       reg_t rdata = STATE.XPR[rs]; /* value is a func with side-effects */
@@ -237,6 +259,7 @@ static reg_t execute_insn(processor_t* p, reg_t pc, insn_fetch_t fetch)
   //TODO: Push to debug buffer RD value and next PC
   commit_log(p->get_state(), pc, fetch.insn);
   p->update_histogram(pc);
+  p->update_bbv(pc, fetch.insn, npc);
   #ifdef RISCV_MICRO_CHECKER
     if(p->get_checker()){
 	    p->get_pipe()->push_instr_actual(fetch.insn, 0, 0, pc, npc, 0, 0);
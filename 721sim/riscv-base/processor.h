@@ -17,6 +17,7 @@ class trap_t;
 class extension_t;
 class disassembler_t;
 class debug_buffer_t;
+class bb_tracker_t;
 
 struct serialize_t {};
 
@@ -95,6 +96,8 @@ public:
   extension_t* get_extension() { return ext; }
   void yield_load_reservation() { state.load_reservation = (reg_t)-1; }
   virtual void update_histogram(size_t pc);
+  void set_bbv(bb_tracker_t* _bbv);
+  inline void update_bbv(reg_t pc, insn_t insn, reg_t npc);
 
   void register_insn(insn_desc_t);
   void register_extension(extension_t*);
@@ -124,6 +127,9 @@ protected:
 
   std::map<size_t,size_t> pc_histogram;
 
+  bb_tracker_t* bbv;   // basic block vector profiling (SimPoint), if not NULL
+  uint64_t bb_length;  // instructions so far in the current basic block
+
   void serialize(); // collapse into defined architectural state
   void take_interrupt(); // take a trap if any interrupts are pending
   virtual reg_t take_trap(trap_t& t, reg_t epc); // take an exception
@@ -131,6 +137,7 @@ protected:
   virtual void disasm(insn_t insn,reg_t pc); // disassemble and print an instruction
   virtual void set_pipe(debug_buffer_t* _pipe);
   virtual inline reg_t get_pc(){return state.pc;}
+  virtual void flush_uop_cache() {} // the mmu's instruction cache was flushed: drop any decoded instructions cached by the processor
 
   friend class sim_t;
   friend class mmu_t;
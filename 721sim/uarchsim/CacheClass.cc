@@ -26,7 +26,7 @@ CacheClass::CacheClass(int sets, int assoc, int _lineSize,
                        pipeline_t* _proc, const char* _identifier, 
                        CacheClass* _nextLevel, int histLen)
 	: proc(_proc),
-    array(sets, assoc),  // Allocate cache array.
+    array(sets, assoc, (repl_policy_e)CACHE_REPL),  // Allocate cache array.
     nextLevel(_nextLevel),
     lineSize(_lineSize),
     hitLatency(_hitLatency),
@@ -56,6 +56,11 @@ CacheClass::CacheClass(int sets, int assoc, int _lineSize,
 
   identifier = _identifier;
 
+  if ((CACHE_REPL == REPL_PLRU) && !IsPow2(assoc)) {
+    fprintf(stderr, "ERROR: %s: tree-PLRU replacement requires a power-of-2 associativity (%d).\n", identifier.c_str(), assoc);
+    exit(-1);
+  }
+
 	/* Set cache parameters. */
 //	lastCycle      = 0;
 
@@ -74,10 +79,24 @@ CacheClass::CacheClass(int sets, int assoc, int _lineSize,
 		missPortAvail[i]=0;
 	}
 
+  /* No prefetcher, until set_prefetcher(). */
+  prefetcher = (prefetcher_t*)NULL;
+  pfIssued = pfUseful = pfLate = pfUseless = pfPollution = pfRedundant = pfDropped = 0;
+
   this->stats = proc->get_stats();
 
   assert(stats);
 
+  // Resolve the counter names once, rather than on every access.
+  load_count_id         = stats_t::counter_id((identifier+"_load_count").c_str());
+  store_count_id        = stats_t::counter_id((identifier+"_store_count").c_str());
+  load_hit_count_id     = stats_t::counter_id((identifier+"_load_hit_count").c_str());
+  store_hit_count_id    = stats_t::counter_id((identifier+"_store_hit_count").c_str());
+  load_miss_count_id    = stats_t::counter_id((identifier+"_load_miss_count").c_str());
+  store_miss_count_id   = stats_t::counter_id((identifier+"_store_miss_count").c_str());
+  read_access_count_id  = stats_t::counter_id((identifier+"_read_access_count").c_str());
+  write_access_count_id = stats_t::counter_id((identifier+"_write_access_count").c_str());
+
 #if 0
   stats->register_counter((identifier+"_load_count").c_str()        ,identifier.c_str());
   stats->register_counter((identifier+"_store_count").c_str()       ,identifier.c_str());
@@ -114,13 +133,16 @@ CacheClass::~CacheClass()
 {
 	delete [] mhsr;
 	delete [] missPortAvail;
+	if (prefetcher)
+		delete prefetcher;
 
 }
 
 cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
                              cycle_t curCycle, reg_t addr,
                              bool isStore, bool* isHit,
-                             bool probe, bool commit)
+                             bool probe, bool commit,
+                             reg_t pc)
 /*------------------------------------------------------------------------*\
  | Access the data cache.  Determines how many cycles access will take.
  |
@@ -134,6 +156,8 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
  |  addr              The address of the word being accessed.
  |  isStore           Indicates whether the access is a store (true) or
  |                     load (false).
+ |  pc                The PC of the load or store (0 if none), for the
+ |                     prefetcher.
  |
  | Returns the cycle when the access will complete.  Returns -1 if the
  |  access can not be handled, due to limited miss handleing status
@@ -141,10 +165,13 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 \*------------------------------------------------------------------------*/
 {
 	bool hit;
+	bool demandHit;
+	bool pfTrigger;
 	reg_t lineAddr;
 	reg_t oldAddr;
 	CacheLineClass* line;
-	CacheLineClass* newLine;
+	CacheLineClass newLine;
+	CacheLineClass oldLine;
 	int busyMHSR;
 	int newMHSR;
 	int newPort;
@@ -159,17 +186,21 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 	assert((Tid < 4) && (lineSize >= 2));
 	lineAddr = ((addr >> lineSize) | (Tid << 30));
 
-	line = array.lookup(lineAddr, NULL, &hit, &oldAddr, false);
+	line = array.lookup(lineAddr, &hit, &oldAddr, false);
 
 	if (probe) {
 		(*isHit) = hit;
 		return(curCycle);
 	}
 
+	// A miss, or the first demand access to a prefetched line, triggers the prefetcher.
+	demandHit = hit;
+	pfTrigger = !hit;
+
   if(isStore){
-    inc_counter_str((identifier+"_store_count").c_str());
+    stats->update_counter(store_count_id);
   } else {
-    inc_counter_str((identifier+"_load_count").c_str());
+    stats->update_counter(load_count_id);
   }
   // Line has been allocated in cache.
 	if (hit) {
@@ -180,6 +211,15 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 			line->dirty = true;
 		}
 
+		// First demand access to a prefetched line.
+		if (line->prefetched && commit) {
+			line->prefetched = false;
+			pfTrigger = true;
+			pfUseful++;
+			if ((line->mhsr != -1) && (mhsr[line->mhsr].resolved > curCycle))
+				pfLate++;
+		}
+
 		// Check if line is currently being loaded (is busy).
 		busyMHSR = line->mhsr;
 		if (busyMHSR != -1) {
@@ -209,11 +249,11 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 			//lineInArray = curCycle + hitLatency;
 			lineInArray = curCycle;
       if(isStore){
-        inc_counter_str((identifier+"_store_hit_count").c_str());
-        inc_counter_str((identifier+"_write_access_count").c_str());
+        stats->update_counter(store_hit_count_id);
+        stats->update_counter(write_access_count_id);
       } else {
-        inc_counter_str((identifier+"_load_hit_count").c_str());
-        inc_counter_str((identifier+"_read_access_count").c_str());
+        stats->update_counter(load_hit_count_id);
+        stats->update_counter(read_access_count_id);
       }
 		}
 	}
@@ -221,11 +261,17 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 	else {
 
     if(isStore){
-      inc_counter_str((identifier+"_store_miss_count").c_str());
+      stats->update_counter(store_miss_count_id);
     } else {
-      inc_counter_str((identifier+"_load_miss_count").c_str());
+      stats->update_counter(load_miss_count_id);
     }
 
+		// A miss to a line that a prefetch evicted.
+		if (prefetcher && commit && (pfEvicted[MOD(lineAddr, pfEvicted.size())] == lineAddr)) {
+			pfEvicted[MOD(lineAddr, pfEvicted.size())] = INVALID;
+			pfPollution++;
+		}
+
 		// Allocate MHSR to handle cache miss.
     // Return error value if no free MHSR
     // is found. The previous level will
@@ -245,16 +291,17 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 		// Find the miss port to use for handling the miss.
 		newPort = FindNextPort(curCycle, &portAvail);
 
-		// Allocate a new cache line structure.
+		// Allocate a new cache line.
 		if (commit) {
-			// Allocate a new cache line structure.
-			newLine = new CacheLineClass;
-			assert(newLine);
-			newLine -> mhsr = newMHSR;
-			newLine -> dirty = isStore;
+			newLine.mhsr = newMHSR;
+			newLine.dirty = isStore;
+			newLine.prefetched = false;
 
 			// Replace the old line in the cache.
-			line = array.lookup(lineAddr, newLine, &hit, &oldAddr, true);
+			array.lookup(lineAddr, &hit, &oldAddr, true, &newLine, &oldLine);
+			line = ((oldAddr != (reg_t)INVALID) ? &oldLine : (CacheLineClass*)NULL);
+			if (line && line->prefetched)
+				pfUseless++;
 		}
 
 		// Compute the time to load the new line from the next memory level.
@@ -283,7 +330,7 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 
 			// See if line is dirty.  Line must be written back, if dirty.
 			if (line->dirty) {
-        inc_counter_str((identifier+"_read_access_count").c_str());
+        stats->update_counter(read_access_count_id);
         if(nextLevel == NULL){
 				  lineInArray = lineInArray + missLatency;
         } else {
@@ -312,7 +359,7 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
       // as it's access cycle and returns when the line becomes 
       // available for access.
       // This is always a read from the next level as this is a WBWA cache model. 
-  		lineInArray = nextLevel->Access(Tid,lineInArray,addr,false,&hit);
+  		lineInArray = nextLevel->Access(Tid,lineInArray,addr,false,&hit,false,true,pc);
       // Cannot miss in MHSR in the next level if the next level has
       // as many or more MHSRs as this level. A miss in this level can
       // be a hit or a miss in the next level. There can be numMHSR outstanding 
@@ -321,29 +368,178 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
       assert(lineInArray > curCycle);
     }
 
-		// Free old cache line, allocate miss port and MHSR.
+		// Allocate miss port and MHSR.
 		// NOTE: Slight simulation approximation error here.
 		//       MHSR is being allocated this cycle, but in reality, can not
 		//       be allocated until hitLat cycles later, when miss is
 		//       known.
-		if (commit && line) {
-			delete line;
-		}
 		mhsr[newMHSR].resolved = lineInArray;
 		mhsr[newMHSR].busy = true;
 		mhsr[newMHSR].lineAddress = lineAddr;
-    inc_counter_str((identifier+"_write_access_count").c_str());
+    stats->update_counter(write_access_count_id);
 	}
 
 	if (isHit!=NULL) {
 		(*isHit) = (lineInArray == curCycle);
 	}
 
+	// Train the prefetcher, and issue its prefetches.
+	if (prefetcher && commit) {
+		pfAddrs.clear();
+		prefetcher->train(pc, addr, pfTrigger, pfAddrs);
+		for (unsigned int i = 0; i < pfAddrs.size(); i++)
+			Prefetch(Tid, curCycle, pfAddrs[i]);
+	}
+
   //LOG(proc->lsu_log,proc->cycle,uint64_t(0),uint64_t(0),"Executed %s which %s resolve cycle %" PRIcycle "",isStore?"store":"load",isHit?"hit":"miss",(lineInArray+hitLatency));
 
 	return(lineInArray + hitLatency);
 }
 
+void CacheClass::Warm(unsigned int Tid, reg_t addr, bool isStore)
+/*------------------------------------------------------------------------*\
+ | Functional warming (sampled simulation).  Updates the cache contents
+ |  and LRU state as Access() would, but without timing, MHSRs, miss
+ |  ports, or stats.  A miss fills the line from the next level; a dirty
+ |  victim is written back to the next level the same way Access() does.
+\*------------------------------------------------------------------------*/
+{
+	bool hit;
+	reg_t lineAddr;
+	reg_t oldAddr;
+	CacheLineClass* line;
+	CacheLineClass newLine;
+	CacheLineClass oldLine;
+
+	assert((Tid < 4) && (lineSize >= 2));
+	lineAddr = ((addr >> lineSize) | (Tid << 30));
+
+	line = array.lookup(lineAddr, &hit, &oldAddr, false);
+
+	if (hit) {
+		if (isStore)
+			line->dirty = true;
+		return;
+	}
+
+	newLine.mhsr = -1;
+	newLine.dirty = isStore;
+	newLine.prefetched = false;
+	array.lookup(lineAddr, &hit, &oldAddr, true, &newLine, &oldLine);
+
+	if ((oldAddr != (reg_t)INVALID) && oldLine.dirty && (nextLevel != NULL))
+		nextLevel->Warm(Tid, addr, true);
+
+	if (nextLevel != NULL)
+		nextLevel->Warm(Tid, addr, false);
+}
+
+void CacheClass::set_prefetcher(unsigned int type, unsigned int degree)
+{
+	assert(!prefetcher);
+	prefetcher = new_prefetcher(type, degree, lineSize);
+	if (prefetcher)
+		pfEvicted.assign(array.size, (reg_t)INVALID);
+}
+
+bool CacheClass::SpareMHSRs(cycle_t curCycle)
+/*------------------------------------------------------------------------*\
+ | Are more than half of the MHSRs free at 'curCycle'?  The other half is
+ |  reserved for demand misses.
+\*------------------------------------------------------------------------*/
+{
+	int i;
+	int numFree = 0;
+
+	for (i=0; i<numMHSR; i++) {
+		if (!mhsr[i].busy || (mhsr[i].resolved < curCycle))
+			numFree++;
+	}
+	return(numFree > (numMHSR/2));
+}
+
+void CacheClass::Prefetch(unsigned int Tid, cycle_t curCycle, reg_t addr)
+/*------------------------------------------------------------------------*\
+ | Prefetch the line of 'addr' into the cache, like a load miss, if it is
+ |  not already in the cache (or being loaded), and if an MHSR and a miss
+ |  port can be spared.
+\*------------------------------------------------------------------------*/
+{
+	bool hit;
+	reg_t lineAddr;
+	reg_t oldAddr;
+	CacheLineClass newLine;
+	CacheLineClass oldLine;
+	int newMHSR;
+	int newPort;
+	cycle_t portAvail;
+	cycle_t lineInArray;
+	cycle_t fill;
+
+	lineAddr = ((addr >> lineSize) | (Tid << 30));
+	if (array.find(lineAddr)) {
+		pfRedundant++;
+		return;
+	}
+
+	// Don't take an MHSR or a miss port away from demand misses, here or in the next level.
+	newPort = FindNextPort(curCycle, &portAvail);
+	if ((portAvail > curCycle) || !SpareMHSRs(curCycle) ||
+	    (nextLevel && !nextLevel->SpareMHSRs(curCycle + hitLatency))) {
+		pfDropped++;
+		return;
+	}
+	newMHSR = FindFreeMHSR(curCycle);
+	assert(newMHSR != -1);
+
+	newLine.mhsr = newMHSR;
+	newLine.dirty = false;
+	newLine.prefetched = true;
+	array.lookup(lineAddr, &hit, &oldAddr, true, &newLine, &oldLine);
+	lineInArray = curCycle + hitLatency;
+
+	// The replaced line, as for a miss.
+	if (oldAddr != (reg_t)INVALID) {
+		if ((oldLine.mhsr != -1) && (mhsr[oldLine.mhsr].resolved > lineInArray))
+			lineInArray = mhsr[oldLine.mhsr].resolved;
+		if (oldLine.prefetched)
+			pfUseless++;
+		else
+			pfEvicted[MOD(oldAddr, pfEvicted.size())] = oldAddr;
+		if (oldLine.dirty) {
+			fill = ((nextLevel == NULL) ? -1 : nextLevel->Access(Tid,lineInArray,(oldAddr << lineSize),true,&hit));
+			lineInArray = ((fill == -1) ? (lineInArray + missLatency) : fill);
+		}
+	}
+
+	missPortAvail[newPort] = lineInArray + missSrvLatency;
+
+	// The line is loaded from the next level by a read, like a miss.
+	fill = ((nextLevel == NULL) ? -1 : nextLevel->Access(Tid,lineInArray,addr,false,&hit));
+	lineInArray = ((fill == -1) ? (lineInArray + missLatency) : fill);
+
+	mhsr[newMHSR].resolved = lineInArray;
+	mhsr[newMHSR].busy = true;
+	mhsr[newMHSR].lineAddress = lineAddr;
+	pfIssued++;
+}
+
+void CacheClass::dump_prefetch_stats(FILE* fp)
+{
+	if (!prefetcher)
+		return;
+
+	fprintf(fp, "%s PREFETCHER MEASUREMENTS----------------------------\n", identifier.c_str());
+	fprintf(fp, "  type             = %s (degree %u)\n", prefetcher->name(), prefetcher->get_degree());
+	fprintf(fp, "  issued           = %lu\n", pfIssued);
+	fprintf(fp, "  useful           = %lu (%.2f%% of issued)\n", pfUseful, (pfIssued ? (100.0*(double)pfUseful/(double)pfIssued) : 0.0));
+	fprintf(fp, "     late          = %lu (%.2f%% of useful)\n", pfLate, (pfUseful ? (100.0*(double)pfLate/(double)pfUseful) : 0.0));
+	fprintf(fp, "  useless          = %lu (evicted before a demand access)\n", pfUseless);
+	fprintf(fp, "  pollution        = %lu (demand misses to lines evicted by prefetches)\n", pfPollution);
+	fprintf(fp, "  redundant        = %lu (already cached or being loaded)\n", pfRedundant);
+	fprintf(fp, "  dropped          = %lu (no spare MHSR or miss port)\n", pfDropped);
+}
+
 void CacheClass::set_nextLevel(CacheClass* nLevel){
 	nextLevel = nLevel;
 }
@@ -362,7 +558,7 @@ int CacheClass::FindFreeMHSR(cycle_t curCycle)
 		}
 		if (mhsr[i].resolved < curCycle) {
 			// MHSR is finished.  Free it.
-			line = array.lookup(mhsr[i].lineAddress, NULL, &hit, &oldAddr, false);
+			line = array.lookup(mhsr[i].lineAddress, &hit, &oldAddr, false);
 			if (hit) {
 				if (line->mhsr == i) {
 					line->mhsr = -1;
@@ -18,16 +18,18 @@
  |  Number of outstanding misses
  |  Number of ports to backing store
  |  Backing store port reuse latency
+ |  Replacement policy (LRU, tree-PLRU or SRRIP, for all levels)
  |
  | Fixed cache parameters:
- |  Replacement policy (LRU)
  |  Write policy (Write Back)
  |  Number of cache ports (unlimited)
 \*--------------------------------------------------------------------------*/
 #include "decode.h"
 #include "cache.h"
 #include "histogram.h"
+#include "prefetcher.h"
 #include <string.h>
+#include <vector>
 
 /*--------------------------------------------------------------------------*\
  | Miss Handleing Status Register provides multiple outstanding reads and
@@ -41,20 +43,22 @@ public:
 };
 
 /*--------------------------------------------------------------------------*\
- | State maintained by a D-Cache line.
+ | State maintained by a D-Cache line, stored inline in the cache array.
 \*--------------------------------------------------------------------------*/
 class CacheLineClass {
 public:
 	int mhsr;   /* Index of MHSR that is loading this line.        */
 	bool mhsrValid; /* -1 indicates that the line is not being loaded. */
 	bool dirty; /* Indicates the line is dirty.                    */
+	bool prefetched; /* Loaded by the prefetcher, and not yet accessed by a demand access. */
 };
 
 typedef cache<CacheLineClass> CacheArray;
 
+#include "stats.h"
+
 //Forward declaring class
 class pipeline_t;
-class stats_t;
 
 class CacheClass {
 public:
@@ -94,7 +98,8 @@ public:
 
 	cycle_t Access(unsigned int Tid /* ER 11/16/02 */,
 	               cycle_t curCycle, reg_t addr, bool isStore,
-	               bool* hit=NULL, bool probe=false, bool commit=true);
+	               bool* hit=NULL, bool probe=false, bool commit=true,
+	               reg_t pc=0);
 	/*------------------------------------------------------------------------*\
 	 | Access the data cache.  Determines how many cycles access will take.
 	 |
@@ -104,11 +109,30 @@ public:
 	 |  isStore           Indicates whether the access is a store (true) or
 	 |                     load (false).
 	 |
+	 |  pc                The PC of the load or store (0 if none), for the
+	 |                     prefetcher.
+	 |
 	 | Returns the cycle when the access will complete.  Returns -1 if the
 	 |  access can not be handled, due to limited miss handleing status
 	 |  registers.
 	\*------------------------------------------------------------------------*/
 
+	void set_prefetcher(unsigned int type, unsigned int degree);
+	/*------------------------------------------------------------------------*\
+	 | Attach a prefetcher of 'type' (PF_*), prefetching 'degree' lines per
+	 |  trigger, trained on demand accesses.  Prefetches are issued only into
+	 |  an idle miss port and only while more than half of the MHSRs (of
+	 |  this level and the next) are free, so they never block demand misses.
+	\*------------------------------------------------------------------------*/
+
+	void dump_prefetch_stats(FILE* fp);
+
+	void Warm(unsigned int Tid, reg_t addr, bool isStore);
+	/*------------------------------------------------------------------------*\
+	 | Functional warming: update the cache contents and LRU state for an
+	 |  access, with no timing and no stats.
+	\*------------------------------------------------------------------------*/
+
 	bool Probe(unsigned int Tid,cycle_t curCycle, reg_t addr1, unsigned int length);
 	HistogramClass* accessLatency;
 	void set_nextLevel(CacheClass* nLevel);
@@ -117,6 +141,8 @@ private:
   pipeline_t* proc;
 	int FindFreeMHSR(cycle_t curCycle);
 	int FindNextPort(cycle_t curCycle, cycle_t* portAvail);
+	bool SpareMHSRs(cycle_t curCycle);
+	void Prefetch(unsigned int Tid, cycle_t curCycle, reg_t addr);
 
 	CacheArray  array;          /* The D-Cache array.                           */
   CacheClass* nextLevel; 
@@ -133,7 +159,27 @@ private:
 	int         numMissSrvPorts;       /* Number of miss ports available.              */
 	cycle_t     missSrvLatency;    /* Pipeline reuse latency for miss ports.       */
 
+	/* Prefetcher, if any. */
+	prefetcher_t* prefetcher;
+	std::vector<reg_t> pfAddrs;   /* Addresses chosen by the prefetcher for the current access. */
+	std::vector<reg_t> pfEvicted; /* Lines evicted by prefetches, by set, to detect pollution. */
+	uint64_t pfIssued;     /* Prefetches issued.                                  */
+	uint64_t pfUseful;     /* Prefetched lines accessed by a demand access.       */
+	uint64_t pfLate;       /* ... while still being loaded.                       */
+	uint64_t pfUseless;    /* Prefetched lines evicted before any demand access.  */
+	uint64_t pfPollution;  /* Demand misses to lines evicted by a prefetch.       */
+	uint64_t pfRedundant;  /* Candidates already in the cache (or being loaded).  */
+	uint64_t pfDropped;    /* Candidates dropped for lack of a spare MHSR or port. */
+
   stats_t* stats;
+  counter_id_t load_count_id;
+  counter_id_t store_count_id;
+  counter_id_t load_hit_count_id;
+  counter_id_t store_hit_count_id;
+  counter_id_t load_miss_count_id;
+  counter_id_t store_miss_count_id;
+  counter_id_t read_access_count_id;
+  counter_id_t write_access_count_id;
 
 };
 
@@ -0,0 +1,75 @@
+#ifndef VPINTERFACE_H
+#define VPINTERFACE_H
+
+#include <cinttypes>
+#include <cstdio>
+
+////////////////////////////////////////////////////
+// Abstract base class for all value predictors.
+//
+// Ensures all value predictors adhere to the
+// same interface. The value_predictor class owns
+// the VPQ and stats; a predictor only supplies
+// predictions and trains on retired values.
+//
+// In-flight instances are identified by their VPQ
+// index ("vpq_index"), which a predictor may use
+// to index its own log.
+////////////////////////////////////////////////////
+
+class VPinterface_t {
+   private:
+
+   public:
+      VPinterface_t() {};
+      virtual ~VPinterface_t() {};
+
+      ///////////////////////////////////////////////
+      // Called by the Rename2 Stage.
+      ///////////////////////////////////////////////
+
+      // Predict the value of the eligible instruction at "pc", which was just allocated VPQ entry "vpq_index".
+      // Returns 'true' if there is a prediction, in which case "pred_value" and "confident" are valid.
+      // The predictor may speculatively update its state (e.g., in-flight instance counts or value histories),
+      // logging w.r.t. "vpq_index" whatever it needs to undo or train the update later.
+      virtual bool predict(uint64_t pc, unsigned int vpq_index, uint64_t& pred_value, bool& confident) = 0;
+
+      // Speculatively update the predictor's global context with a renamed conditional branch.
+      // pc: PC of the branch.
+      // taken: its predicted direction.
+      virtual void spec_update_branch(uint64_t pc, bool taken) = 0;
+
+      // Get and set the speculative global context, for branch and value prediction checkpoints.
+      virtual uint64_t get_context() = 0;
+      virtual void set_context(uint64_t context) = 0;
+
+      ///////////////////////////////////////////////
+      // Called when instructions are squashed.
+      ///////////////////////////////////////////////
+
+      // Undo the speculative update of a squashed instruction's prediction.
+      // Squashed instructions are presented youngest first.
+      virtual void squash(unsigned int vpq_index, uint64_t pc) = 0;
+
+      // Complete squash: nothing is in flight anymore, so speculative state reverts to the committed state.
+      virtual void flush() = 0;
+
+      ///////////////////////////////////////////////
+      // Called by the Retire Stage.
+      ///////////////////////////////////////////////
+
+      // Train the predictor with the retired value of the instruction at "pc" (the oldest in-flight instance).
+      virtual void train(unsigned int vpq_index, uint64_t pc, uint64_t value) = 0;
+
+      // Update the committed global context with a retired conditional branch.
+      virtual void commit_branch(uint64_t pc, bool taken) = 0;
+
+      ///////////////////////////////////////////////
+      // Configuration and stats.
+      ///////////////////////////////////////////////
+
+      virtual void dump_config(FILE* fp) = 0;
+      virtual void dump_stats(FILE* fp) = 0;
+};
+
+#endif //VPINTERFACE_H
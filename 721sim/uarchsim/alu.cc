@@ -49,8 +49,6 @@ void pipeline_t::agen(unsigned int index) {
 
 void pipeline_t::alu(unsigned int index) {
   auto& pay_buf = PAY.buf[index];
-	insn_t insn = pay_buf.inst;
-  auto alu_op_fn = alu_ops.get_alu_op_fn(insn);
   state_t& state = *get_state();
-  alu_op_fn(pay_buf, state);
+  pay_buf.alu_op_fn(pay_buf, state);	// resolved at decode
 }
@@ -8,8 +8,6 @@
 #include "trap.h"
 #include "payload.h"
 
-typedef reg_t (*alu_op_func_t)(payload_t &pay_buf, const state_t &state);
-
 struct alu_op_desc_t {
   uint32_t match;
   uint32_t mask;
@@ -1,6 +1,9 @@
 #include <cinttypes>
 #include <cassert>
 #include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "processor.h"
 #include "decode.h"
@@ -18,26 +21,37 @@ btb_t::btb_t(uint64_t num_entries, uint64_t banks, uint64_t assoc, uint64_t cond
 
    assert(IsPow2(banks));
    assert(IsPow2(sets));
+   assert(banks <= 64);				// The positions of a fetch bundle are a bit vector.
+   assert((assoc > 0) && (assoc <= 64));	// The ways of a set are a bit vector.
 
    log2banks = (uint64_t) log2((double)banks);
    log2sets = (uint64_t) log2((double)sets);
 
-   // Allocate the 3D array.
-   btb = new btb_entry_t **[banks];
-   for (uint64_t b = 0; b < banks; b++) {
-      btb[b] = new btb_entry_t *[sets];
-      for (uint64_t s = 0; s < sets; s++) {
-         btb[b][s] = new btb_entry_t[assoc];
-	 for (uint64_t way = 0; way < assoc; way++) {
-	    btb[b][s][way].valid = false;
-	    btb[b][s][way].lru = way;
-	 }
-      }
+   stride = ((assoc + 1) & ~1UL);
+   way_mask = ((assoc == 64) ? ~(uint64_t)0 : (((uint64_t)1 << assoc) - 1));
+
+   // Allocate the flat arrays.
+   tags = new uint64_t[banks * sets * stride];
+   btb = new btb_entry_t[banks * sets * assoc];
+   lru = new uint8_t[banks * sets * assoc];
+   bundle_set = new uint64_t[banks];
+   bundle_way = new uint64_t[banks];
+
+   for (uint64_t s = 0; s < (banks * sets); s++) {
+      for (uint64_t way = 0; way < stride; way++)
+         tags[s * stride + way] = BTB_INVALID_TAG;
+      for (uint64_t way = 0; way < assoc; way++)
+         lru[s * assoc + way] = way;
    }
 }
 
 
 btb_t::~btb_t() {
+   delete [] tags;
+   delete [] btb;
+   delete [] lru;
+   delete [] bundle_set;
+   delete [] bundle_way;
 }
 
 
@@ -62,8 +76,7 @@ btb_t::~btb_t() {
 //    - Whether or not it needs to pop the RAS.
 //    - Whether or not it needs to push the RAS, and, if so, which pc to push onto the RAS.
 void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_target, uint64_t ras_predicted_target, fetch_bundle_t bundle[], spec_update_t *update) {
-   uint64_t btb_bank;
-   uint64_t btb_pc;
+   uint64_t hits;
    uint64_t set;
    uint64_t way;
    bool taken;
@@ -76,6 +89,9 @@ void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_t
    update->pop_ras = false;
    update->push_ras = false;
 
+   // Search all banks for the maximum-length sequential fetch bundle at once.
+   hits = search_bundle(pc);
+
    while ((pos < banks) && !terminated) {	// "pos" is position of the instruction within the maximum-length sequential fetch bundle.
       // This instruction in the bundle is valid.
       bundle[pos].valid = true;
@@ -83,18 +99,16 @@ void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_t
       // Each instruction in the bundle carries with it, its full pc.
       bundle[pos].pc = (pc + (pos << 2));
 
-      // convert {pc, pos} to {btb_bank, btb_pc}
-      convert(pc, pos, btb_bank, btb_pc);
-
-      // Search for the instruction in its bank.
-      if (search(btb_bank, btb_pc, set, way)) {
-         // BTB hit.  The BTB coordinates of this branch are {btb_bank, set, way}.
+      if ((hits >> pos) & 1) {
+         // BTB hit.  The BTB coordinates of this branch are {set, way}, where "set" is the flat index of the set in its bank.
+         set = bundle_set[pos];
+         way = bundle_way[pos];
          bundle[pos].branch = true;
-         bundle[pos].branch_type = btb[btb_bank][set][way].branch_type;
-         bundle[pos].branch_target = btb[btb_bank][set][way].target;
+         bundle[pos].branch_type = btb[set * assoc + way].branch_type;
+         bundle[pos].branch_target = btb[set * assoc + way].target;
 
          // Update LRU.
-	 update_lru(btb_bank, set, way);
+	 update_lru(set, way);
 
 	 // (1) Determine the instruction's next_pc field (i.e., pc of the next instruction, which may be in the same bundle or at the start of the next bundle).
 	 // (2) Determine if this is the last instruction in the bundle.
@@ -113,7 +127,7 @@ void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_t
 	       cb_predictions = (cb_predictions >> 1);
 
 	       // (1) Determine the instruction's next_pc field.
-	       bundle[pos].next_pc = (taken ?  btb[btb_bank][set][way].target : INCREMENT_PC(bundle[pos].pc));
+	       bundle[pos].next_pc = (taken ?  bundle[pos].branch_target : INCREMENT_PC(bundle[pos].pc));
 
 	       // (2) Determine if this is the last instruction in the bundle.
 	       //     End the fetch bundle at any taken branch or at the maximum number of conditional branches.
@@ -124,7 +138,7 @@ void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_t
 
 	    case BTB_JUMP_DIRECT:
 	       // (1) Determine the instruction's next_pc field.
-	       bundle[pos].next_pc = btb[btb_bank][set][way].target;
+	       bundle[pos].next_pc = bundle[pos].branch_target;
 
 	       // (2) Determine if this is the last instruction in the bundle.
 	       //     End the fetch bundle at any taken branch or at the maximum number of conditional branches.
@@ -133,7 +147,7 @@ void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_t
 
 	    case BTB_CALL_DIRECT:
 	       // (1) Determine the instruction's next_pc field.
-	       bundle[pos].next_pc = btb[btb_bank][set][way].target;
+	       bundle[pos].next_pc = bundle[pos].branch_target;
 
 	       // (2) Determine if this is the last instruction in the bundle.
 	       //     End the fetch bundle at any taken branch or at the maximum number of conditional branches.
@@ -235,22 +249,42 @@ void btb_t::update(uint64_t pc, uint64_t pos, insn_t insn) {
    convert(pc, pos, btb_bank, btb_pc);	// convert {pc, pos} to {btb_bank, btb_pc}
 
    // Search for the instruction in its bank.
-   // The BTB entry to replace (miss) or update (hit) is at coordinates {btb_bank, set, way}.
+   // The BTB entry to replace (miss) or update (hit) is at coordinates {set, way}.
    // If it hits, assert that the reason for updating the entry is that the branch type changed or non-indirect branch's target changed
    // (self-modifying code or BTB was trained with data on the wrong-path beyond the text segment).
    bool btb_hit = search(btb_bank, btb_pc, set, way);
    if (btb_hit)
-     assert((btb[btb_bank][set][way].branch_type != new_branch_type) ||
-            ((insn.opcode() != OP_JALR) && (btb[btb_bank][set][way].target != new_target)));
+     assert((btb[set * assoc + way].branch_type != new_branch_type) ||
+            ((insn.opcode() != OP_JALR) && (btb[set * assoc + way].target != new_target)));
 
    // The entry's metadata:
-   btb[btb_bank][set][way].valid = true;
-   btb[btb_bank][set][way].tag = (btb_pc >> log2sets);
-   update_lru(btb_bank, set, way); // Update LRU.
+   tags[set * stride + way] = (btb_pc >> log2sets);
+   update_lru(set, way); // Update LRU.
 
    // The entry's payload:
-   btb[btb_bank][set][way].branch_type = new_branch_type;
-   btb[btb_bank][set][way].target = new_target;
+   btb[set * assoc + way].branch_type = new_branch_type;
+   btb[set * assoc + way].target = new_target;
+}
+
+// Functional warming (sampled simulation): the branch at {pc, pos} was fetched on the correct path.
+// A hit with the right type and target only updates LRU; otherwise, the entry is (re)trained as update() would.
+void btb_t::warm(uint64_t pc, uint64_t pos, insn_t insn) {
+   uint64_t btb_bank;
+   uint64_t btb_pc;
+   uint64_t set;
+   uint64_t way;
+   uint64_t target;
+   btb_branch_type_e branch_type;
+
+   branch_type = btb_t::decode(insn, (pc + (pos << 2)), target);
+   convert(pc, pos, btb_bank, btb_pc);
+
+   if (search(btb_bank, btb_pc, set, way) &&
+       (btb[set * assoc + way].branch_type == branch_type) &&
+       ((insn.opcode() == OP_JALR) || (btb[set * assoc + way].target == target)))
+      update_lru(set, way);
+   else
+      update(pc, pos, insn);
 }
 
 void btb_t::invalidate(uint64_t pc, uint64_t pos) {
@@ -262,19 +296,18 @@ void btb_t::invalidate(uint64_t pc, uint64_t pos) {
    convert(pc, pos, btb_bank, btb_pc);   // convert {pc, pos} to {btb_bank, btb_pc}
    
    // Search for the instruction in its bank.
-   // The BTB entry to invalidate is at coordinates {btb_bank, set, way}.
+   // The BTB entry to invalidate is at coordinates {set, way}.
    // The pipeline should not invalidate an entry that doesn't exist.
    bool btb_hit = search(btb_bank, btb_pc, set, way);
    assert(btb_hit);
    
    // Invalidate the entry and make it the LRU way of the set.
-   btb[btb_bank][set][way].valid = false;
+   tags[set * stride + way] = BTB_INVALID_TAG;
    
-   for (uint64_t i = 0; i < assoc; i++) {
-      if (btb[btb_bank][set][i].lru > btb[btb_bank][set][way].lru)
-         btb[btb_bank][set][i].lru--;
-   }
-   btb[btb_bank][set][way].lru = assoc - 1;
+   uint8_t *r = &lru[set * assoc];
+   for (uint64_t i = 0; i < assoc; i++)
+      r[i] -= (r[i] > r[way]);
+   r[way] = assoc - 1;
 }
 
 ////////////////////////////////////
@@ -301,44 +334,80 @@ void btb_t::convert(uint64_t pc, uint64_t pos, uint64_t &btb_bank, uint64_t &btb
    btb_pc = (((pc >> 2) + pos) >> log2banks);
 }
 
+// Bit vector of the ways of flat set "set" whose tag is "tag".
+inline uint64_t btb_t::match(uint64_t set, uint64_t tag) {
+   const uint64_t *t = &tags[set * stride];
+   uint64_t m = 0;
+#ifdef __SSE2__
+   // SSE2 has no 64-bit compare: two 64-bit tags are equal if both of their 32-bit halves are.
+   __m128i key = _mm_set1_epi64x((long long)tag);
+   for (uint64_t i = 0; i < stride; i += 2) {
+      __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(t + i)), key);
+      eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+      m |= ((uint64_t)_mm_movemask_pd(_mm_castsi128_pd(eq)) << i);
+   }
+#else
+   for (uint64_t i = 0; i < assoc; i++)
+      m |= ((uint64_t)(t[i] == tag) << i);
+#endif
+   return(m & way_mask);
+}
+
 // This function searches for the specified branch, "btb_pc", in the specified bank, "btb_bank".
 // It returns true if found (hit) and false if not found (miss).
-// It outputs the "set" and "way" of either (a) the branch's entry (hit) or (b) the LRU entry (which can be used by the caller for replacement).
+// It outputs the flat "set" (see btb.h) and "way" of either (a) the branch's entry (hit) or (b) the LRU entry (which can be used by the caller for replacement).
 bool btb_t::search(uint64_t btb_bank, uint64_t btb_pc, uint64_t &set, uint64_t &way) {
    // Break up btb_pc into index and tag.
    uint64_t index = (btb_pc & (sets - 1));
    uint64_t tag = (btb_pc >> log2sets);
 
    // Search the indexed set.
-   bool hit = false;
-   uint64_t hit_way = assoc; // out-of-bounds
-   uint64_t lru_way = assoc; // out-of-bounds
-   for (uint64_t i = 0; i < assoc; i++) {
-      if (btb[btb_bank][index][i].valid && (btb[btb_bank][index][i].tag == tag)) {
-         hit = true;
-	 hit_way = i;
-	 break;
-      }
-      else if (btb[btb_bank][index][i].lru == (assoc - 1)) {
-         lru_way = i;
-      }
+   set = ((btb_bank << log2sets) | index);
+   uint64_t m = match(set, tag);
+   bool hit = (m != 0);
+   if (hit) {
+      way = (uint64_t)__builtin_ctzll(m);
+   }
+   else {
+      const uint8_t *r = &lru[set * assoc];
+      for (way = 0; r[way] != (assoc - 1); way++)
+         ;
    }
 
    // Outputs.
-   set = index;
-   way = (hit ? hit_way : lru_way);
    assert(way < assoc);
    return(hit);
 }
 
+// Batch lookup: searches the banks for all positions of the maximum-length sequential fetch bundle starting at "pc", in one pass.
+// It returns a bit vector of the positions that hit, and outputs the flat set and way of each hit in bundle_set[] and bundle_way[].
+// The LRU state is not updated: the caller updates it only for the positions that end up in the fetch bundle.
+uint64_t btb_t::search_bundle(uint64_t pc) {
+   uint64_t hits = 0;
+   uint64_t btb_bank;
+   uint64_t btb_pc;
+   uint64_t set;
+   uint64_t m;
 
-void btb_t::update_lru(uint64_t btb_bank, uint64_t set, uint64_t way) {
-   // Make "way" most-recently-used.
-   for (uint64_t i = 0; i < assoc; i++) {
-      if (btb[btb_bank][set][i].lru < btb[btb_bank][set][way].lru)
-         btb[btb_bank][set][i].lru++;
+   // Each position is in a different bank, so there are no conflicts between the positions' searches.
+   for (uint64_t pos = 0; pos < banks; pos++) {
+      convert(pc, pos, btb_bank, btb_pc);
+      set = ((btb_bank << log2sets) | (btb_pc & (sets - 1)));
+      m = match(set, (btb_pc >> log2sets));
+      bundle_set[pos] = set;
+      bundle_way[pos] = (m ? (uint64_t)__builtin_ctzll(m) : 0);
+      hits |= ((uint64_t)(m != 0) << pos);
    }
-   btb[btb_bank][set][way].lru = 0;
+   return(hits);
+}
+
+void btb_t::update_lru(uint64_t set, uint64_t way) {
+   // Make "way" most-recently-used.
+   uint8_t *r = &lru[set * assoc];
+   uint8_t old_rank = r[way];
+   for (uint64_t i = 0; i < assoc; i++)
+      r[i] += (r[i] < old_rank);
+   r[way] = 0;
 }
 
 
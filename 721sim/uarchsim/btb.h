@@ -1,27 +1,33 @@
-
-// A BTB entry.
+// A BTB entry's payload.
+// Its metadata for hit/miss determination and replacement (tag, LRU rank) is stored separately, see btb_t.
 typedef
 struct {
-   // Metadata for hit/miss determination and replacement.
-   bool valid;
-   uint64_t tag;
-   uint64_t lru;
-
-   // Payload.
    btb_branch_type_e branch_type;
    uint64_t target;
 } btb_entry_t;
 
-
+// Tag of an invalid BTB entry: no branch's tag has all bits set, because the bank and set bits are shifted out of it.
+#define BTB_INVALID_TAG		(~(uint64_t)0)
 
 class btb_t {
 private:
 	// The BTB has three dimensions: number of banks, number of sets per bank, and associativity (number of ways per set).
-	// btb[bank][set][way]
-	btb_entry_t ***btb;
+	// It is stored as flat arrays, bank by bank and set by set, where a set's flat index is (bank * sets) + set:
+	// the tags of a set are contiguous (searched with a SIMD compare), apart from the payloads and the LRU ranks.
+	// 'stride' is the associativity rounded up to the SIMD width; the padding ways hold invalid tags.
 	uint64_t banks;
 	uint64_t sets;
 	uint64_t assoc;
+	uint64_t stride;
+	uint64_t way_mask;
+
+	uint64_t *tags;		// [banks * sets * stride]
+	btb_entry_t *btb;	// [banks * sets * assoc]
+	uint8_t *lru;		// [banks * sets * assoc] recency rank of each way (0: MRU, assoc-1: LRU)
+
+	// Batch lookup: the flat set and way of each position of the fetch bundle that hit, see search_bundle().
+	uint64_t *bundle_set;	// [banks]
+	uint64_t *bundle_way;	// [banks]
 
 	uint64_t log2banks; // number of pc bits that selects the bank
 	uint64_t log2sets;  // number of pc bits that selects the set within a bank
@@ -34,8 +40,10 @@ private:
 	////////////////////////////////////
 
 	void convert(uint64_t pc, uint64_t pos, uint64_t &btb_bank, uint64_t &btb_pc);
+	uint64_t match(uint64_t set, uint64_t tag);
 	bool search(uint64_t btb_bank, uint64_t btb_pc, uint64_t &set, uint64_t &way);
-	void update_lru(uint64_t btb_bank, uint64_t set, uint64_t way);
+	uint64_t search_bundle(uint64_t pc);
+	void update_lru(uint64_t set, uint64_t way);
 	
 
 public:
@@ -44,5 +52,6 @@ public:
         void lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_target, uint64_t ras_predicted_target, fetch_bundle_t bundle[], spec_update_t *update);
 	void update(uint64_t pc, uint64_t pos, insn_t insn);
 	void invalidate(uint64_t pc, uint64_t pos);
+	void warm(uint64_t pc, uint64_t pos, insn_t insn);
 	static btb_branch_type_e decode(insn_t insn, uint64_t pc, uint64_t &target);
 };
@@ -3,6 +3,10 @@
 #pragma interface
 #include <cstdio>
 #include <cassert>
+#include <cstdint>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "common.h"
 #include "decode.h"
 
@@ -10,23 +14,124 @@
 #define	INVALID		-1
 
 
+// Replacement policies.
+typedef
+enum {
+	REPL_LRU,	// true LRU: a recency rank per way
+	REPL_PLRU,	// tree pseudo-LRU: assoc-1 bits per set
+	REPL_SRRIP	// static re-reference interval prediction: a 2-bit RRPV per way
+} repl_policy_e;
+
+#define RRPV_MAX	3	// SRRIP: distant re-reference
+#define RRPV_INSERT	2	// SRRIP: long re-reference, for new entries
+
+
 ///////////////////////
 // STANDARD CACHE
 ///////////////////////
 template<class T>
 class cache {
 private:
-	// The cache is a 2-D array of entries, each entry
-	// is a tag + lru + pointer to object of type T.
+	// The cache is stored as flat arrays, set by set:
+	// the tags of a set are contiguous (searched with a SIMD
+	// compare), next to the entries' contents of type T (stored
+	// inline) and the replacement state.
+	// 'stride' is the number of ways rounded up to the SIMD width;
+	// the padding ways hold INVALID tags.
+
+	unsigned int stride;
+	uint64_t way_mask;
+
+	reg_t* tags;		// [size * stride]
+	T* contents;		// [size * assoc]
+	uint8_t* rank;		// [size * assoc] LRU: recency rank (0: MRU), SRRIP: RRPV
+	uint64_t* plru;		// [size] tree-PLRU: bit n is tree node n (1..assoc-1), 0: the LRU side is left, 1: right
+
+	repl_policy_e repl;
+
+	// Bit vector of the ways of 'set' whose tag is 'id'.
+	inline uint64_t match(const reg_t* set, reg_t id) {
+		uint64_t m = 0;
+#ifdef __SSE2__
+		// SSE2 has no 64-bit compare: two 64-bit tags are equal if both of their 32-bit halves are.
+		__m128i key = _mm_set1_epi64x((long long)id);
+		for (unsigned int i = 0; i < stride; i += 2) {
+			__m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(set + i)), key);
+			eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+			m |= ((uint64_t)_mm_movemask_pd(_mm_castsi128_pd(eq)) << i);
+		}
+#else
+		for (unsigned int i = 0; i < assoc; i++)
+			m |= ((uint64_t)(set[i] == id) << i);
+#endif
+		return(m & way_mask);
+	}
+
+	// Update the replacement state of 'way' of set 'index' for a hit (or a new entry, if 'insert').
+	inline void touch(unsigned int index, unsigned int way, bool insert) {
+		uint8_t* r = &rank[index * assoc];
+		unsigned int node;
+
+		switch (repl) {
+		case REPL_LRU: {
+			uint8_t old_rank = r[way];
+			for (unsigned int i = 0; i < assoc; i++)
+				r[i] += (r[i] < old_rank);
+			r[way] = 0;
+			break;
+		}
+		case REPL_PLRU:
+			// Point each node on the path to 'way' away from it.
+			for (node = (way + assoc); node > 1; node >>= 1) {
+				if (node & 1)
+					plru[index] &= ~((uint64_t)1 << (node >> 1));
+				else
+					plru[index] |= ((uint64_t)1 << (node >> 1));
+			}
+			break;
+		case REPL_SRRIP:
+			r[way] = (insert ? RRPV_INSERT : 0);
+			break;
+		}
+	}
+
+	// Choose the way of set 'index' to replace.
+	inline unsigned int victim(unsigned int index) {
+		uint8_t* r = &rank[index * assoc];
+		uint64_t empty;
+		unsigned int i;
+		unsigned int node;
+		uint8_t max;
+
+		if (repl == REPL_LRU) {
+			// The least-recently used way, even if another is empty (as always).
+			for (i = 0; r[i] != (assoc - 1); i++)
+				;
+			return(i);
+		}
 
-	typedef
-	struct {
-		reg_t tag;
-		unsigned int lru;
-		T* contents;
-	} entry;
+		// Fill an empty way first.
+		empty = match(&tags[index * stride], (reg_t)INVALID);
+		if (empty)
+			return((unsigned int)__builtin_ctzll(empty));
 
-	entry**	C;
+		if (repl == REPL_PLRU) {
+			for (node = 1; node < assoc; node = ((node << 1) | ((plru[index] >> node) & 1)))
+				;
+			return(node - assoc);
+		}
+
+		// SRRIP: the first way predicted to be re-referenced in the distant future,
+		// after aging all ways until there is one.
+		max = 0;
+		for (i = 0; i < assoc; i++)
+			max = ((r[i] > max) ? r[i] : max);
+		for (i = 0; i < assoc; i++)
+			r[i] += (RRPV_MAX - max);
+		for (i = 0; r[i] != RRPV_MAX; i++)
+			;
+		return(i);
+	}
 
 
 public:
@@ -39,33 +144,35 @@ public:
 	unsigned int num_misses;
 
 	// constructor
-	cache(unsigned int size, unsigned int assoc) {
-		unsigned int i,j;
-
+	cache(unsigned int size, unsigned int assoc, repl_policy_e repl = REPL_LRU) {
 		// First ensure that 'size' is a power of 2.
 		assert( IsPow2(size) );
-
-		C = new entry *[size];
-		for (i = 0; i < size; i++) {
-			C[i] = new entry[assoc];
-			for (j = 0; j < assoc; j++) {
-				C[i][j].tag = INVALID;
-				C[i][j].lru = j;
-				C[i][j].contents = (T*)NULL;
-			}
-		}
+		// The ways of a set are a bit vector, and the PLRU tree is binary.
+		assert((assoc > 0) && (assoc <= 64));
+		assert((repl != REPL_PLRU) || IsPow2(assoc));
 
 		this->size = size;
 		this->assoc = assoc;
+		this->repl = repl;
 		this->num_misses = 0;
+
+		stride = ((assoc + 1) & ~1U);
+		way_mask = ((assoc == 64) ? ~(uint64_t)0 : (((uint64_t)1 << assoc) - 1));
+
+		tags = new reg_t[size * stride];
+		contents = new T[size * assoc];
+		rank = new uint8_t[size * assoc];
+		plru = new uint64_t[size];
+
+		flush();
 	}
 
 	// destructor
 	~cache() {
-		//unsigned int i;
-		//for (i = 0; i < size; i++)
-		//   delete C[i];
-		//delete C;
+		delete [] tags;
+		delete [] contents;
+		delete [] rank;
+		delete [] plru;
 	}
 
 	//
@@ -77,114 +184,89 @@ public:
 		unsigned int i,j;
 
 		for (i = 0; i < size; i++) {
+			for (j = 0; j < stride; j++)
+				tags[i * stride + j] = INVALID;
 			for (j = 0; j < assoc; j++) {
-				C[i][j].tag = INVALID;
-				C[i][j].lru = j;
-				C[i][j].contents = (T*)NULL;
+				contents[i * assoc + j] = T();
+				rank[i * assoc + j] = ((repl == REPL_SRRIP) ? RRPV_MAX : j);
 			}
+			plru[i] = 0;
 		}
 	}
 
 
+	// Find object 'id' without updating the replacement state.
+	// Returns a pointer to its contents in the cache, NULL if not present.
+	T* find(reg_t id) {
+		unsigned int index = MOD(id, size);
+		uint64_t m = match(&tags[index * stride], id);
+		return(m ? &contents[index * assoc + (unsigned int)__builtin_ctzll(m)] : (T*)NULL);
+	}
+
 	// Cache lookup and maintenance.
 	// Inputs:
 	//   (1) object id
-	//   (2) pointer to object's contents
-	//   (3) replace the entry on a cache miss
+	//   (2) replace the entry on a cache miss
+	//   (3) object's contents, for the new entry
 	// Outputs:
 	//   (1) hit
-	//   (2) old object id (i.e. id that was replaced, if miss)
-	//   (3) return value: pointer to old object's contents
-	T* lookup(reg_t id, T* contents,
-	          bool* hit, reg_t* old_id,
+	//   (2) old object id (i.e. id that was replaced, if miss; INVALID if the entry was empty)
+	//   (3) old object's contents (i.e. copy of the replaced entry's contents, if miss and replaced)
+	//   (4) return value: pointer to the object's contents in the cache, if hit or replaced,
+	//       NULL otherwise
+	// A hit updates the replacement state, even if not 'replace'.
+	T* lookup(reg_t id, bool* hit, reg_t* old_id,
 	          bool replace,
+	          const T* new_contents = NULL,
+	          T* old_contents = NULL,
 	          bool use_raw_index = false,
 	          unsigned int raw_index = 0);
 };
 
 
 template<class T>
-T* cache<T>::lookup(reg_t id, T* contents,
-                    bool* hit, reg_t* old_id,
+T* cache<T>::lookup(reg_t id, bool* hit, reg_t* old_id,
                     bool replace,
+                    const T* new_contents, T* old_contents,
                     bool use_raw_index, unsigned int raw_index) {
 	unsigned int index;
-	entry* set;
-	unsigned int i;
-	bool found;
-	unsigned int hit_way;
-	int replace_way;
-	T* old_contents;
+	reg_t* set;
+	uint64_t m;
+	unsigned int way;
 
 	index = MOD((use_raw_index ? raw_index : id), size);
-	set = C[index];
-
-	i = 0;
-	found = false;
-	while (i < assoc && !found) {
-		if (set[i].tag == id) {
-			found = true;
-		}
-		else {
-			i += 1;
-		}
-	}
-
-	if (found) {
-		hit_way = i;
+	set = &tags[index * stride];
 
-		// Update LRU state.
-		for (i = 0; i < assoc; i++) {
-			if (set[i].lru < set[hit_way].lru) {
-				set[i].lru += 1;
-			}
-		}
-		set[hit_way].lru = 0;
+	m = match(set, id);
+	if (m) {
+		way = (unsigned int)__builtin_ctzll(m);
+		touch(index, way, false);
 
 		// Set outputs of function.
 		*hit = true;
-		*old_id = set[hit_way].tag;
-		old_contents = set[hit_way].contents;
+		*old_id = id;
+		return(&contents[index * assoc + way]);
 	}
-	else {
-		// record the miss
-		num_misses += 1;
-
-		// Find replacement entry, and update LRU state.
-		replace_way = -1;
-		if (replace) {
-			for (i = 0; i < assoc; i++) {
-				if (set[i].lru == (assoc-1)) {	// least-recently used
-					replace_way = (int)i;
-					set[i].lru = 0;
-				}
-				else {
-					set[i].lru += 1;
-				}
-			}
-		}
-		else {
-			for (i = 0; i < assoc; i++) {
-				if (set[i].lru == (assoc-1)) {	// least-recently used
-					replace_way = (int)i;
-				}
-			}
-		}
-		assert(replace_way != -1);
 
-		// Set outputs of function.
-		*hit = false;
-		*old_id = set[replace_way].tag;
-		old_contents = set[replace_way].contents;
-
-		// Perform the actual replacement.
-		if (replace) {
-			set[replace_way].tag = id;
-			set[replace_way].contents = contents;
-		}
+	// record the miss
+	num_misses += 1;
+
+	*hit = false;
+	if (!replace) {
+		*old_id = INVALID;
+		return((T*)NULL);
 	}
 
-	return(old_contents);
+	// Perform the actual replacement.
+	way = victim(index);
+	*old_id = set[way];
+	if (old_contents)
+		*old_contents = contents[index * assoc + way];
+	set[way] = id;
+	contents[index * assoc + way] = (new_contents ? *new_contents : T());
+	touch(index, way, true);
+
+	return(&contents[index * assoc + way]);
 }
 
 
@@ -0,0 +1,29 @@
+#include "pipeline.h"
+#include "mmu.h"
+#include "cache_warmer.h"
+
+
+cache_warmer_t::cache_warmer_t(pipeline_t* proc, mmu_t* mmu) : proc(proc), mmu(mmu) {
+   registered = false;
+   enabled = false;
+}
+
+void cache_warmer_t::enable(bool on) {
+   if (on && !registered) {
+      mmu->register_memtracer(this);
+      registered = true;
+   }
+   if (on && !enabled) {
+      // Force the accesses to previously cached pages and instructions through the tracer
+      // (flushing the TLB also flushes the instruction cache).
+      mmu->flush_tlb();
+   }
+   enabled = on;
+}
+
+void cache_warmer_t::trace_virtual(uint64_t vaddr, uint64_t addr, size_t bytes, bool store, bool fetch) {
+   if (fetch)
+      proc->FetchUnit->warm_ic(vaddr);
+   else
+      proc->LSU.warm(vaddr, store);
+}
@@ -0,0 +1,46 @@
+#ifndef CACHE_WARMER_H
+#define CACHE_WARMER_H
+
+#include <cinttypes>
+#include <cstddef>
+
+#include "memtracer.h"
+
+class mmu_t;
+class pipeline_t;
+
+///////////////////////////////////////////////////////////////
+// Functional cache warming during fast skip (FAST_SKIP_WARMING).
+//
+// A memory tracer hooked into the pipeline's mmu. While enabled,
+// the mmu reports every fetch, load and store that the functional
+// simulator makes, and each one updates the tags and replacement
+// state of the pipeline's I$ or D$ (and, through their misses,
+// the L2 and L3), with no timing and no measurements.
+//
+// The timing caches are indexed by virtual address, so only
+// trace_virtual() is used.
+//
+// The mmu does not cache translations or fetched instructions of
+// traced pages, so enabling flushes its TLB and instruction
+// cache: fast skip is slower while warming.
+///////////////////////////////////////////////////////////////
+
+class cache_warmer_t : public memtracer_t {
+private:
+   pipeline_t* proc;
+   mmu_t* mmu;
+   bool registered;	// hooked into the mmu (on first use: the mmu cannot unhook a tracer)
+   bool enabled;
+
+public:
+   cache_warmer_t(pipeline_t* proc, mmu_t* mmu);
+
+   void enable(bool on);
+
+   bool interested_in_range(uint64_t begin, uint64_t end, bool store, bool fetch) { return(enabled); }
+   void trace(uint64_t addr, size_t bytes, bool store, bool fetch) {}
+   void trace_virtual(uint64_t vaddr, uint64_t addr, size_t bytes, bool store, bool fetch);
+};
+
+#endif //CACHE_WARMER_H
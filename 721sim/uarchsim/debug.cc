@@ -7,6 +7,9 @@ extern bool logging_on;
 
 // Checks to see if index 'e' lies between 'head' and 'tail'.
 bool debug_buffer_t::is_active(unsigned int e) {
+   if (async)
+      wait_for(e);
+
    if (length > 0) {
       if (head <= tail)
          return((e >= head) && (e <= tail));
@@ -42,11 +45,27 @@ debug_buffer_t::debug_buffer_t(unsigned int window_size) {
    tail = (DEBUG_SIZE - 1);
    length = 0;
 
+   fill = tail;
+
    pc_ptr = 0;
    inst_sequence = 0;
+
+   isa_sim = NULL;
+
+   async = false;
+   num_started = 0;
+   num_pushed = 0;
+   num_popped = 0;
+   producer_created = false;
+   producer_go = false;
+   producer_stop = false;
+   producer_done = false;
+   producer_waiting = false;
+   consumer_waiting = false;
 }
 
 debug_buffer_t::~debug_buffer_t() {
+   stop_async();
 }
 
 void debug_buffer_t::run_ahead(){
@@ -62,6 +81,142 @@ void debug_buffer_t::run_ahead(){
   }
 }
 
+uint64_t debug_buffer_t::push_limit(uint64_t popped) {
+   // The synchronous functional simulator fills the debug buffer before the first pop,
+   // and then refills one entry at the start of each pop but the first.
+   return(popped + ACTIVE_SIZE - ((popped > 0) ? 1 : 0));
+}
+
+// Once it reaches the back-pressure limit, the producer sleeps until it may fill this many entries,
+// unless the consumer needs an entry sooner.
+uint64_t debug_buffer_t::resume_room() {
+   return((ACTIVE_SIZE >= 4) ? (ACTIVE_SIZE / 4) : 1);
+}
+
+template <typename F>
+void debug_buffer_t::block_until(std::atomic<bool>& waiting, F ready) {
+   std::unique_lock<std::mutex> lock(sync_mutex);
+   waiting.store(true, std::memory_order_relaxed);
+   // Pairs with the fence in wake(): either the other thread sees 'waiting', or this thread sees its update.
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   while (!ready()) {
+      // The producer may be sleeping until there is more room; tell it that the consumer needs an entry now.
+      if ((&waiting == &consumer_waiting) && producer_waiting.load(std::memory_order_relaxed))
+         sync_cv.notify_all();
+      sync_cv.wait(lock);
+   }
+   waiting.store(false, std::memory_order_relaxed);
+}
+
+void debug_buffer_t::wake(std::atomic<bool>& waiting) {
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   if (waiting.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(sync_mutex);
+      sync_cv.notify_all();
+   }
+}
+
+sim_t* debug_buffer_t::create_async(std::function<sim_t*()> create) {
+   assert(!async);
+   async = true;
+   producer = std::thread(&debug_buffer_t::produce, this, create);
+
+   // Wait for the producer to create the functional simulator.
+   block_until(consumer_waiting, [&]() { return(producer_created.load(std::memory_order_acquire)); });
+   return(isa_sim);
+}
+
+void debug_buffer_t::run_async(std::function<void()> setup) {
+   assert(async);
+   producer_setup = setup;
+   producer_go.store(true, std::memory_order_release);
+   wake(producer_waiting);
+}
+
+void debug_buffer_t::stop_async() {
+   if (producer.joinable()) {
+      producer_stop.store(true, std::memory_order_release);
+      wake(producer_waiting);
+      producer.join();
+   }
+}
+
+void debug_buffer_t::produce(std::function<sim_t*()> create) {
+   sim_t* sim = create();
+   sim->set_procs_pipe(this);
+   isa_sim = sim;
+   producer_created.store(true, std::memory_order_release);	// hand the functional simulator back to create_async()
+   wake(consumer_waiting);
+
+   block_until(producer_waiting, [&]() { return(producer_go.load(std::memory_order_acquire) || producer_stop.load(std::memory_order_acquire)); });
+   if (producer_stop.load(std::memory_order_acquire)) {
+      producer_done.store(true, std::memory_order_release);
+      wake(consumer_waiting);
+      return;
+   }
+
+   producer_setup();
+
+   fprintf(stderr, "Functional simulator running ahead (asynchronous)\n");
+   // Set to debug mode so that simulator single steps
+   isa_sim->set_procs_debug(true);
+   // Set to checker mode so that instructions are pushed to 
+   // debug buffer
+   isa_sim->set_procs_checker(true);
+
+   while (!producer_stop.load(std::memory_order_acquire)) {
+      // Back-pressure: don't get further ahead than the synchronous functional simulator.
+      if (num_started >= push_limit(num_popped.load(std::memory_order_acquire))) {
+         block_until(producer_waiting, [&]() {
+            uint64_t limit = push_limit(num_popped.load(std::memory_order_acquire));
+            return(producer_stop.load(std::memory_order_acquire) ||
+                   (limit >= (num_started + resume_room())) ||
+                   ((limit > num_started) && consumer_waiting.load(std::memory_order_relaxed)));
+         });
+         continue;
+      }
+
+      // Make sure the simulator is still running and is not already 
+      // done with the program.
+      if (!isa_sim->running())
+         break;
+
+      isa_sim->step();  // Step 1 cycle, which is 1 instruction for isa_sim.
+
+      // Publish the entry (its contents were written before this release).
+      num_pushed.store(num_started, std::memory_order_release);
+      wake(consumer_waiting);
+   }
+
+   producer_done.store(true, std::memory_order_release);
+   wake(consumer_waiting);
+}
+
+void debug_buffer_t::wait_for(debug_index_t e) {
+   uint64_t popped = num_popped.load(std::memory_order_relaxed);	// only the consumer pops
+   uint64_t n = popped + MOD((e + DEBUG_SIZE - head), DEBUG_SIZE);	// number of the entry in 'e', if it were pushed
+   uint64_t visible;
+
+   auto ready = [&]() {
+      bool final = producer_done.load(std::memory_order_acquire);
+      uint64_t pushed = num_pushed.load(std::memory_order_acquire);
+      final = (final || (pushed == push_limit(popped)));
+
+      // The latest entry is not visible until the producer moves on, because the functional simulator
+      // may still update it (e.g., an interrupt taken before the next instruction is started).
+      visible = (((pushed == 0) || final) ? pushed : (pushed - 1));
+
+      return((n < visible) || final);
+   };
+
+   if (!ready())
+      block_until(consumer_waiting, ready);
+
+   assert(visible >= popped);
+   length = (unsigned int)(visible - popped);
+   tail = MOD((visible + DEBUG_SIZE - 1), DEBUG_SIZE);
+}
+
 void debug_buffer_t::skip_till_pc(reg_t pc, unsigned int proc_id){
   ifprintf(logging_on,stderr, "Functional simulator skipping till PC %" PRIreg "\n",pc);
   bool old_debug = isa_sim->get_procs_debug();
@@ -75,28 +230,37 @@ void debug_buffer_t::skip_till_pc(reg_t pc, unsigned int proc_id){
 
 void debug_buffer_t::start() {
    // Check for overflow and maintain 'length'.
-   assert(length < ACTIVE_SIZE);
-   length += 1;
+   // If asynchronous, 'length' and 'tail' belong to the consumer.
+   if (!async) {
+      assert(length < ACTIVE_SIZE);
+      length += 1;
+   }
+   else {
+      assert(num_started < push_limit(num_popped.load(std::memory_order_acquire)));
+   }
+   num_started++;
 
    // Initialize a new debug entry.
-   tail = MOD((tail + 1), DEBUG_SIZE);
+   fill = MOD((fill + 1), DEBUG_SIZE);
+   if (!async)
+      tail = fill;
 
-   assert(db[tail].entry_id == tail);
+   assert(db[fill].entry_id == fill);
 
-   db[tail].a_valid = true;
-   db[tail].a_exception   = false;
-   db[tail].a_num_rdst = 0;
-   db[tail].a_num_rsrc = 0;
-   db[tail].a_num_rsrcA = 0;
-   db[tail].a_sequence = ++inst_sequence;
+   db[fill].a_valid = true;
+   db[fill].a_exception   = false;
+   db[fill].a_num_rdst = 0;
+   db[fill].a_num_rsrc = 0;
+   db[fill].a_num_rsrcA = 0;
+   db[fill].a_sequence = ++inst_sequence;
 
    for(unsigned int i=0;i<D_MAX_RSRC;i++)
-     db[tail].a_rsrc[i].valid = 0;
+     db[fill].a_rsrc[i].valid = 0;
 
    for(unsigned int i=0;i<D_MAX_RDST;i++)
-     db[tail].a_rdst[i].valid = 0;
+     db[fill].a_rdst[i].valid = 0;
 
-   ifprintf(logging_on,stderr, "Starting debug buffer entry %u\n",tail);
+   ifprintf(logging_on,stderr, "Starting debug buffer entry %u\n",fill);
 }
 
 void debug_buffer_t::push_operand_actual( unsigned int n, operand_t t, reg_t value, reg_t pc) 
@@ -104,62 +268,62 @@ void debug_buffer_t::push_operand_actual( unsigned int n, operand_t t, reg_t val
                           
     unsigned int i;
 
-    ifprintf(logging_on,stderr,"Pushing operand type: %u to entry %u\n",t,tail);                          
+    ifprintf(logging_on,stderr,"Pushing operand type: %u to entry %u\n",t,fill);                          
    switch (t) {
       case RDST_OPERAND:
         // Push RS1 if not already pushed
-        if(!db[tail].a_rdst[0].valid){
-	        assert(db[tail].a_num_rdst < D_MAX_RDST);
-	        db[tail].a_rdst[0].n = n;
-	        db[tail].a_rdst[0].value = value;
-	        db[tail].a_rdst[0].valid = true;
-	        db[tail].a_num_rdst += 1;
+        if(!db[fill].a_rdst[0].valid){
+	        assert(db[fill].a_num_rdst < D_MAX_RDST);
+	        db[fill].a_rdst[0].n = n;
+	        db[fill].a_rdst[0].value = value;
+	        db[fill].a_rdst[0].valid = true;
+	        db[fill].a_num_rdst += 1;
         }
 	      break;
       // Ordering of operand read ISA sim is not fixed
       // Hence separate operand types for RS1
       case RSRC1_OPERAND:
         // Push RS1 if not already pushed
-        if(!db[tail].a_rsrc[0].valid){
-	        assert(db[tail].a_num_rsrc < D_MAX_RSRC);
-	        db[tail].a_rsrc[0].n = n;
-	        db[tail].a_rsrc[0].value = value;
-	        db[tail].a_rsrc[0].valid = true;
-	        db[tail].a_num_rsrc += 1;
+        if(!db[fill].a_rsrc[0].valid){
+	        assert(db[fill].a_num_rsrc < D_MAX_RSRC);
+	        db[fill].a_rsrc[0].n = n;
+	        db[fill].a_rsrc[0].value = value;
+	        db[fill].a_rsrc[0].valid = true;
+	        db[fill].a_num_rsrc += 1;
         }
 	      break;
       // Ordering of operand read ISA sim is not fixed
       // Hence separate operand types for RS2
       case RSRC2_OPERAND:
         // Push RS2 if not already pushed
-        if(!db[tail].a_rsrc[1].valid){
-	        assert(db[tail].a_num_rsrc < D_MAX_RSRC);
-	        db[tail].a_rsrc[1].n = n;
-	        db[tail].a_rsrc[1].value = value;
-	        db[tail].a_rsrc[1].valid = true;
-	        db[tail].a_num_rsrc += 1;
+        if(!db[fill].a_rsrc[1].valid){
+	        assert(db[fill].a_num_rsrc < D_MAX_RSRC);
+	        db[fill].a_rsrc[1].n = n;
+	        db[fill].a_rsrc[1].value = value;
+	        db[fill].a_rsrc[1].valid = true;
+	        db[fill].a_num_rsrc += 1;
         }
 	      break;
       // Ordering of operand read ISA sim is not fixed
       // Hence separate operand types for RS3
       case RSRC3_OPERAND:
         // Push RS2 if not already pushed
-        if(!db[tail].a_rsrc[2].valid){
-	        assert(db[tail].a_num_rsrc < D_MAX_RSRC);
-	        db[tail].a_rsrc[2].n = n;
-	        db[tail].a_rsrc[2].value = value;
-	        db[tail].a_rsrc[2].valid = true;
-	        db[tail].a_num_rsrc += 1;
+        if(!db[fill].a_rsrc[2].valid){
+	        assert(db[fill].a_num_rsrc < D_MAX_RSRC);
+	        db[fill].a_rsrc[2].n = n;
+	        db[fill].a_rsrc[2].value = value;
+	        db[fill].a_rsrc[2].valid = true;
+	        db[fill].a_num_rsrc += 1;
         }
 	      break;
       case RSRC_A_OPERAND:
         assert(0);
-	      i = db[tail].a_num_rsrcA;
+	      i = db[fill].a_num_rsrcA;
 	      assert(i < D_MAX_RSRC);
-	      db[tail].a_rsrcA[i].n = n;
-	      db[tail].a_rsrcA[i].value = value;
-	      db[tail].a_rsrcA[i].valid = true;
-	      db[tail].a_num_rsrcA += 1;
+	      db[fill].a_rsrcA[i].n = n;
+	      db[fill].a_rsrcA[i].value = value;
+	      db[fill].a_rsrcA[i].valid = true;
+	      db[fill].a_num_rsrcA += 1;
          break;
       default:
 	      assert(0);
@@ -174,11 +338,11 @@ void debug_buffer_t::push_address_actual( reg_t addr,
 			                    unsigned int real_lower) {
 
    assert(t == MSRC_OPERAND || t == MDST_OPERAND);
-   ifprintf(logging_on,stderr,"Pushing operand type: %u to entry %u addr %lu\n",t,tail,addr);                          
-   db[tail].a_addr = addr;
+   ifprintf(logging_on,stderr,"Pushing operand type: %u to entry %u addr %lu\n",t,fill,addr);                          
+   db[fill].a_addr = addr;
 
-   db[tail].real_upper = real_upper;
-   db[tail].real_lower = real_lower;
+   db[fill].real_upper = real_upper;
+   db[fill].real_lower = real_lower;
 }
 
 void debug_buffer_t::push_store_data_actual( reg_t addr,
@@ -189,7 +353,7 @@ void debug_buffer_t::push_store_data_actual( reg_t addr,
 
    assert(t == MDST_OPERAND);
 
-   db[tail].store_data.dword = real_upper;
+   db[fill].store_data.dword = real_upper;
 }
 
 void debug_buffer_t::push_load_data_actual( reg_t addr,
@@ -200,7 +364,7 @@ void debug_buffer_t::push_load_data_actual( reg_t addr,
 
    assert(t == MSRC_OPERAND);
 
-   db[tail].real_upper = real_upper;
+   db[fill].real_upper = real_upper;
 }
 
 void debug_buffer_t::push_instr_actual( insn_t       inst,
@@ -211,17 +375,17 @@ void debug_buffer_t::push_instr_actual( insn_t       inst,
 		                    reg_t real_upper,
 		                    unsigned int real_lower) {
 
-   db[tail].a_inst = inst;
-   db[tail].a_flags = flags;
-   db[tail].a_lat = latency;
-   db[tail].a_pc = pc;
-   db[tail].a_next_pc = next_pc;
+   db[fill].a_inst = inst;
+   db[fill].a_flags = flags;
+   db[fill].a_lat = latency;
+   db[fill].a_pc = pc;
+   db[fill].a_next_pc = next_pc;
 
 }
 
 void debug_buffer_t::push_exception_actual(reg_t handler_pc){
-   db[tail].a_exception   = true;
-   db[tail].a_next_pc     = handler_pc;
+   db[fill].a_exception   = true;
+   db[fill].a_next_pc     = handler_pc;
 }
 
 void debug_buffer_t::push_state_actual(state_t* a_state_ptr,bool checkpoint_state){
@@ -230,48 +394,48 @@ void debug_buffer_t::push_state_actual(state_t* a_state_ptr,bool checkpoint_stat
   if(checkpoint_state){
 
     for(size_t i = 0;i < NXPR;i++){
-      db[tail].a_state->XPR.write(i,a_state_ptr->XPR[i]);
+      db[fill].a_state->XPR.write(i,a_state_ptr->XPR[i]);
     }
     for(size_t i = 0;i < NFPR;i++){
-      db[tail].a_state->FPR.write(i,a_state_ptr->FPR[i]);
+      db[fill].a_state->FPR.write(i,a_state_ptr->FPR[i]);
     }
 
-    db[tail].a_state->epc               =  a_state_ptr->epc;
-    db[tail].a_state->badvaddr          =  a_state_ptr->badvaddr;
-    db[tail].a_state->evec              =  a_state_ptr->evec;
-    db[tail].a_state->ptbr              =  a_state_ptr->ptbr;
-    db[tail].a_state->pcr_k0            =  a_state_ptr->pcr_k0;
-    db[tail].a_state->pcr_k1            =  a_state_ptr->pcr_k1;
-    db[tail].a_state->cause             =  a_state_ptr->cause;
-    db[tail].a_state->tohost            =  a_state_ptr->tohost;
-    db[tail].a_state->fromhost          =  a_state_ptr->fromhost;
-    db[tail].a_state->count             =  a_state_ptr->count;
-    db[tail].a_state->compare           =  a_state_ptr->compare;
-    db[tail].a_state->sr                =  a_state_ptr->sr;
-    db[tail].a_state->fflags            =  a_state_ptr->fflags;
-    db[tail].a_state->frm               =  a_state_ptr->frm;
-    db[tail].a_state->load_reservation  =  a_state_ptr->load_reservation;
+    db[fill].a_state->epc               =  a_state_ptr->epc;
+    db[fill].a_state->badvaddr          =  a_state_ptr->badvaddr;
+    db[fill].a_state->evec              =  a_state_ptr->evec;
+    db[fill].a_state->ptbr              =  a_state_ptr->ptbr;
+    db[fill].a_state->pcr_k0            =  a_state_ptr->pcr_k0;
+    db[fill].a_state->pcr_k1            =  a_state_ptr->pcr_k1;
+    db[fill].a_state->cause             =  a_state_ptr->cause;
+    db[fill].a_state->tohost            =  a_state_ptr->tohost;
+    db[fill].a_state->fromhost          =  a_state_ptr->fromhost;
+    db[fill].a_state->count             =  a_state_ptr->count;
+    db[fill].a_state->compare           =  a_state_ptr->compare;
+    db[fill].a_state->sr                =  a_state_ptr->sr;
+    db[fill].a_state->fflags            =  a_state_ptr->fflags;
+    db[fill].a_state->frm               =  a_state_ptr->frm;
+    db[fill].a_state->load_reservation  =  a_state_ptr->load_reservation;
 
   } 
   // Checkpoint only state necessary for checking
   else 
   {
 
-    //db[tail].a_state->epc               =  a_state_ptr->epc;
-    db[tail].a_state->badvaddr          =  a_state_ptr->badvaddr;
-    //db[tail].a_state->evec              =  a_state_ptr->evec;
-    //db[tail].a_state->ptbr              =  a_state_ptr->ptbr;
-    //db[tail].a_state->pcr_k0            =  a_state_ptr->pcr_k0;
-    //db[tail].a_state->pcr_k1            =  a_state_ptr->pcr_k1;
-    //db[tail].a_state->cause             =  a_state_ptr->cause;
-    db[tail].a_state->tohost            =  a_state_ptr->tohost;
-    db[tail].a_state->fromhost          =  a_state_ptr->fromhost;
-    db[tail].a_state->count             =  a_state_ptr->count;
-    //db[tail].a_state->compare           =  a_state_ptr->compare;
-    db[tail].a_state->sr                =  a_state_ptr->sr;
-    db[tail].a_state->fflags            =  a_state_ptr->fflags;
-    db[tail].a_state->frm               =  a_state_ptr->frm;
-    //db[tail].a_state->load_reservation  =  a_state_ptr->load_reservation;
+    //db[fill].a_state->epc               =  a_state_ptr->epc;
+    db[fill].a_state->badvaddr          =  a_state_ptr->badvaddr;
+    //db[fill].a_state->evec              =  a_state_ptr->evec;
+    //db[fill].a_state->ptbr              =  a_state_ptr->ptbr;
+    //db[fill].a_state->pcr_k0            =  a_state_ptr->pcr_k0;
+    //db[fill].a_state->pcr_k1            =  a_state_ptr->pcr_k1;
+    //db[fill].a_state->cause             =  a_state_ptr->cause;
+    db[fill].a_state->tohost            =  a_state_ptr->tohost;
+    db[fill].a_state->fromhost          =  a_state_ptr->fromhost;
+    db[fill].a_state->count             =  a_state_ptr->count;
+    //db[fill].a_state->compare           =  a_state_ptr->compare;
+    db[fill].a_state->sr                =  a_state_ptr->sr;
+    db[fill].a_state->fflags            =  a_state_ptr->fflags;
+    db[fill].a_state->frm               =  a_state_ptr->frm;
+    //db[fill].a_state->load_reservation  =  a_state_ptr->load_reservation;
   }
 }
 
@@ -283,18 +447,24 @@ db_t* debug_buffer_t::pop(debug_index_t i) {
    ifprintf(logging_on,stderr, "Timing simulator popping entry %u\n",i);
    assert(i == head);
 
+   // The producer must be done with the head entry before it is modified.
+   if (async)
+      wait_for(head);
+
    // Set the valid bit to 0 so that perfect branch prediction
    // does not fail at PC mismatch assertion at the end of the 
    // program.
    db[head].a_valid = false;
 
 
-   // Fill out the debug buffer
-   // Make sure the simulator is still running and is not already 
-   // done with the program.
-   while(hungry() && isa_sim->running()){
-    ifprintf(logging_on,stderr, "Functional simulator hungry\n");
-     isa_sim->step();  // Step 1 cycle, which is 1 instruction for isa_sim.
+   if (!async) {
+      // Fill out the debug buffer
+      // Make sure the simulator is still running and is not already 
+      // done with the program.
+      while(hungry() && isa_sim->running()){
+         ifprintf(logging_on,stderr, "Functional simulator hungry\n");
+         isa_sim->step();  // Step 1 cycle, which is 1 instruction for isa_sim.
+      }
    }
 
    // Check for underflow and maintain 'length'.
@@ -304,6 +474,15 @@ db_t* debug_buffer_t::pop(debug_index_t i) {
    // Pop the head entry by advancing head pointer.
    head = MOD((head + 1), DEBUG_SIZE);
 
+   // Let the producer reuse the entry popped before this one.
+   // Wake it only once it has enough room to make sleeping worthwhile (see produce()).
+   if (async) {
+      uint64_t popped = num_popped.load(std::memory_order_relaxed) + 1;
+      num_popped.store(popped, std::memory_order_release);
+      if (push_limit(popped) >= (num_pushed.load(std::memory_order_acquire) + resume_room()))
+         wake(producer_waiting);
+   }
+
 
    // Return a pointer to (what was) the head entry.
    return( &(db[i]) );
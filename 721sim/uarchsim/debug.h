@@ -3,6 +3,11 @@
 
 #include <cstdio>
 #include <cassert>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 #include "common.h"
 #include "decode.h"
 
@@ -111,6 +116,40 @@ private:
 
   sim_t* isa_sim;
 
+  debug_index_t fill;	// Entry being filled by the functional simulator (same as 'tail', unless asynchronous).
+
+	///////////////////////////////////////////////////
+	// ASYNCHRONOUS CO-SIMULATION
+	//
+	// The functional simulator runs on its own thread (the producer) and fills
+	// entries, while the timing simulator (the consumer) peeks and pops them.
+	// The n-th entry pushed (n = 0, 1, ...) occupies debug buffer entry MOD(n, DEBUG_SIZE).
+	//
+	// The producer never gets further ahead than the synchronous functional simulator:
+	// it may fill ACTIVE_SIZE entries before the first pop, and one more entry per pop after that.
+	// (The entry popped last is not overwritten until the next pop, as the timing simulator still uses it.)
+	// Conversely, the consumer waits for an entry that the synchronous functional simulator would
+	// already have pushed. Thus, the timing simulator sees the same debug buffer either way.
+	//
+	// A thread that has to wait blocks on 'sync_cv', after announcing itself in its 'waiting' flag.
+	// The other thread only takes 'sync_mutex' to wake it if the flag is set.
+	///////////////////////////////////////////////////
+
+	bool async;
+	std::thread producer;
+	uint64_t num_started;			// Producer: number of entries started.
+	std::atomic<uint64_t> num_pushed;	// Number of entries completed by the producer.
+	std::atomic<uint64_t> num_popped;	// Number of entries popped by the consumer.
+	std::atomic<bool> producer_created;	// The producer created the functional simulator.
+	std::atomic<bool> producer_go;		// The producer may set up and run the functional simulator.
+	std::atomic<bool> producer_stop;	// The producer must stop.
+	std::atomic<bool> producer_done;	// The producer stopped: 'num_pushed' is final.
+	std::function<void()> producer_setup;
+	std::mutex sync_mutex;
+	std::condition_variable sync_cv;
+	std::atomic<bool> producer_waiting;	// The producer is blocked (or about to block) on 'sync_cv'.
+	std::atomic<bool> consumer_waiting;	// The consumer is blocked (or about to block) on 'sync_cv'.
+
   ///////////////////////
   // PRIVATE FUNCTIONS
   ///////////////////////
@@ -118,6 +157,15 @@ private:
   // Checks to see if index 'e' lies between 'head' and 'tail'.
   bool is_active(unsigned int e);
 
+  // Asynchronous co-simulation.
+  uint64_t push_limit(uint64_t popped);	// Number of entries the synchronous functional simulator would have pushed, after 'popped' pops.
+  uint64_t resume_room();		// Room the blocked producer waits for before it resumes.
+  void produce(std::function<sim_t*()> create);	// The producer thread.
+  void wait_for(debug_index_t e);	// Consumer: wait until entry 'e' is pushed, or would not have been pushed by now, and update 'tail' and 'length'.
+  template <typename F>
+  void block_until(std::atomic<bool>& waiting, F ready);	// Block until 'ready()' holds; 'waiting' is the caller's flag.
+  void wake(std::atomic<bool>& waiting);	// Wake the other thread, if it is blocked on its 'waiting' flag.
+
 public:
 	///////////////
 	// INTERFACE
@@ -128,6 +176,15 @@ public:
 
   void set_isa_sim(sim_t* _isa_sim){ isa_sim = _isa_sim; }
   void run_ahead();
+
+  // Asynchronous co-simulation.
+  // create_async(): Start the producer thread and wait for it to create the functional simulator with 'create'.
+  //                 (The functional simulator must be created by the thread that steps it, as its HTIF uses thread-local contexts.)
+  // run_async():    The producer sets up the functional simulator with 'setup' (boot, checkpoint restore or fast skip) and runs ahead.
+  // stop_async():   Stop the producer thread.
+  sim_t* create_async(std::function<sim_t*()> create);
+  void run_async(std::function<void()> setup);
+  void stop_async();
   void skip_till_pc(reg_t pc, unsigned int proc_id);
 
 	//////////////////////////////////////////////////////////////
@@ -155,10 +212,20 @@ public:
 	// value equal to 'pc'.
 	// Then return the index of the head entry.
 	inline debug_index_t first(reg_t pc) {
+	   if (async)
+	      wait_for(head);
 	   assert(pc == db[head].a_pc);
 	   return(head);
 	}
 
+	// Return the program counter of the head entry,
+	// i.e., of the oldest instruction not yet retired.
+	inline reg_t head_pc() {
+	   if (async)
+	      wait_for(head);
+	   return(db[head].a_pc);
+	}
+
 	// Check if the entry following 'i' has the same
 	// program counter value as 'pc'.
 	// If yes, then return the index of the entry following 'i',
@@ -178,11 +245,15 @@ public:
 	// Return a pointer to the contents of an arbitrary debug buffer entry.
 	// The debug buffer entry must be in the 'active window' of the buffer.
 	inline	db_t *peek(debug_index_t i) {
+	   if (async)
+	      wait_for(i);
 	   assert(is_active(i));
 	   return( &(db[i]) );
 	}
 
 	inline	bool empty() {
+	   if (async)
+	      wait_for(head);
 	   return(length == 0);
 	}
 
@@ -195,12 +266,16 @@ public:
 	inline	reg_t pop_pc() {
 	   // Return PC of *next* instruction.
 	   pc_ptr = MOD((pc_ptr + 1), DEBUG_SIZE);
+	   if (async)
+	      wait_for(pc_ptr);
 	   return(db[pc_ptr].a_pc);
 	}
 
 	inline	bool pop_pc_valid() {
 	   // Return PC valid of *next* instruction.
 	   unsigned int ptr = MOD((pc_ptr + 1), DEBUG_SIZE);
+	   if (async)
+	      wait_for(ptr);
 	   return(db[ptr].a_valid);
 	}
 
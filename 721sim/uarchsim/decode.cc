@@ -5,6 +5,7 @@ void pipeline_t::decode() {
 	unsigned int i;
 	unsigned int index;
 	insn_t inst;
+	bool cacheable;
 
 	// Stall the Decode Stage if there is not enough space in the Fetch Queue for 2x the fetch bundle width.
 	// The factor of 2x assumes that each instruction in the fetch bundle is split, in the worst case.
@@ -38,6 +39,24 @@ void pipeline_t::decode() {
 
     LOG(decode_log,cycle,PAY.buf[index].sequence,PAY.buf[index].pc,"Instruction: %08" PRIX32 "",(word_t)inst.bits());
 
+		// Look up the decoded instruction cache. On a hit, the decoded instruction is copied
+		// into its payload and the instruction skips the decode logic below.
+		// Instructions with a fetch exception bypass the cache.
+		cacheable = (UOPC && !PAY.buf[index].trap.valid());
+		if (cacheable) {
+			if (UOPC->lookup(PAY.buf[index])) {
+				inc_counter(uop_cache_hit_count);
+				FQ.push(index);
+
+				#ifdef RISCV_MICRO_DEBUG
+				PAY.dump(this,index,decode_log);
+				#endif
+
+				continue;
+			}
+			inc_counter(uop_cache_miss_count);
+		}
+
 		// Set checkpoint flag.
 		switch (inst.opcode()) {
 			case OP_JAL:
@@ -159,6 +178,9 @@ void pipeline_t::decode() {
 				break;
 		}
 
+		// Resolve the ALU function once, here, instead of at every execution.
+		PAY.buf[index].alu_op_fn = alu_ops.get_alu_op_fn(inst);
+
 
 		// Set register operands and split instructions.
 		// Select IQ.
@@ -557,6 +579,10 @@ void pipeline_t::decode() {
 				break;
 		}
 
+		// Cache the decoded instruction, unless it was split or decoding raised an exception.
+		if (cacheable && !PAY.buf[index].split && !PAY.buf[index].trap.valid())
+			UOPC->fill(PAY.buf[index]);
+
 		// Insert one or two instructions into the Fetch Queue (indices).
 		FQ.push(index);
 		if (PAY.buf[index].split) {
@@ -594,6 +620,7 @@ void pipeline_t::split(uint64_t index) {
    PAY.buf[index+1].fu               = PAY.buf[index].fu;
    PAY.buf[index+1].latency          = PAY.buf[index].latency;
    PAY.buf[index+1].checkpoint       = PAY.buf[index].checkpoint;
+   PAY.buf[index+1].alu_op_fn        = PAY.buf[index].alu_op_fn;
    // split
    // upper
    // split_store
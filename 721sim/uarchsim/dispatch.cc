@@ -201,6 +201,16 @@ void pipeline_t::dispatch() {
       B_ready = PAY.buf[index].B_valid ? REN->is_ready(PAY.buf[index].B_phys_reg) : true;
       D_ready = PAY.buf[index].D_valid ? REN->is_ready(PAY.buf[index].D_phys_reg) : true;
 
+      // Value prediction's consumer filter: note the source registers the instruction waits (or would wait) for.
+      if (VALUE_PRED_EN && VP_CONSUMER_FILTER) {
+         if (PAY.buf[index].A_valid)
+            VP->dispatch_consumer(PAY.buf[index].A_phys_reg, A_ready);
+         if (PAY.buf[index].B_valid)
+            VP->dispatch_consumer(PAY.buf[index].B_phys_reg, B_ready);
+         if (PAY.buf[index].D_valid)
+            VP->dispatch_consumer(PAY.buf[index].D_phys_reg, D_ready);
+      }
+
       //********************************************
       // FIX_ME #8 END
       //********************************************
@@ -225,8 +235,19 @@ void pipeline_t::dispatch() {
       //Destination register: C
       //Check if valid
       //clear_ready function from the renamer class clears the ready bit of specfied physical register 
+      //If the instruction has a confident value prediction, write the predicted value into its
+      //destination register and mark it ready instead, so that consumers can issue right away.
+      //The computed value overwrites it later, and a misprediction is detected in the Writeback Stage.
       if(PAY.buf[index].C_valid){
-         REN->clear_ready(PAY.buf[index].C_phys_reg); 
+         if (VALUE_PRED_EN && VP_CONSUMER_FILTER)
+            VP->dispatch_producer(PAY.buf[index].C_phys_reg, PAY.buf[index].vp_confident);
+         if (VALUE_PRED_EN && PAY.buf[index].vp_confident) {
+            REN->write(PAY.buf[index].C_phys_reg, PAY.buf[index].vp_pred_value);
+            REN->set_ready(PAY.buf[index].C_phys_reg);
+         }
+         else {
+            REN->clear_ready(PAY.buf[index].C_phys_reg); 
+         }
       }
 
       //********************************************
@@ -356,6 +377,13 @@ void pipeline_t::dispatch() {
                          PAY.buf[index].LQ_index, PAY.buf[index].LQ_phase,
                          PAY.buf[index].SQ_index, PAY.buf[index].SQ_phase);
 
+            // Predict the load's address and probe the D$ with it.
+            PAY.buf[index].lap_probed = false;
+            PAY.buf[index].lap_probe_hit = false;
+            if (LOAD_ADDR_PRED && IS_LOAD(PAY.buf[index].flags)) {
+               LSU.predict_load_addr(cycle, PAY.buf[index].LQ_index, PAY.buf[index].lap_probed, PAY.buf[index].lap_probe_hit);
+            }
+
             // The lower part of a split-store should inherit the same LSU indices.
             if (PAY.buf[index].split_store) {
                assert(PAY.buf[index+1].split && !PAY.buf[index+1].upper);
@@ -381,6 +409,15 @@ void pipeline_t::dispatch() {
       if (PAY.buf[index].checkpoint) {
          LSU.checkpoint(PAY.buf[index].LQ_index, PAY.buf[index].LQ_phase, PAY.buf[index].SQ_index, PAY.buf[index].SQ_phase);
       }
+
+      // Checkpointed value predictions must record the same information, in separate fields
+      // (a predicted load still needs its own LQ_index/SQ_index).
+      if (PAY.buf[index].vp_checkpoint) {
+         LSU.checkpoint(PAY.buf[index].vp_LQ_tail, PAY.buf[index].vp_LQ_tail_phase, PAY.buf[index].vp_SQ_tail, PAY.buf[index].vp_SQ_tail_phase);
+      }
+
+      // Selective replay may need to re-insert the instruction into the IQ, with its branch mask.
+      PAY.buf[index].branch_mask = DISPATCH[i].branch_mask;
    }
 }
 
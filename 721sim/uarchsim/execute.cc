@@ -77,9 +77,12 @@ void pipeline_t::execute(unsigned int lane_number) {
             //********************************************
             
             //use the write function from the renamer to write a value into a physical register. Input: Physical register & value(which is the doubleword here)
+            //A confidently value-predicted load already woke up its dependents at dispatch: only write the loaded value
             if (PAY.buf[index].C_valid && hit){
-                IQ.wakeup(PAY.buf[index].C_phys_reg);
-                REN->set_ready(PAY.buf[index].C_phys_reg);
+                if (!PAY.buf[index].vp_confident) {
+                   IQ.wakeup(PAY.buf[index].C_phys_reg);
+                   REN->set_ready(PAY.buf[index].C_phys_reg);
+                }
                 REN->write(PAY.buf[index].C_phys_reg, PAY.buf[index].C_value.dw);
             }
 
@@ -216,9 +219,11 @@ void pipeline_t::execute(unsigned int lane_number) {
 	      // FIX_ME #11b BEGIN
          //********************************************
 
+         //A confidently value-predicted destination register was already marked ready at dispatch
          bool check = PAY.buf[index].C_valid &&  
                               !IS_LOAD(PAY.buf[index].flags) && 
-                              !IS_AMO(PAY.buf[index].flags);
+                              !IS_AMO(PAY.buf[index].flags) &&
+                              !PAY.buf[index].vp_confident;
 
          if (check) {
             IQ.wakeup(PAY.buf[index].C_phys_reg);
@@ -286,8 +291,11 @@ void pipeline_t::load_replay() {
          //1.wakeup 
          //2. set ready bit
          //3. write doubleword value to physical register 
-         IQ.wakeup(PAY.buf[index].C_phys_reg);
-         REN->set_ready(PAY.buf[index].C_phys_reg);
+         //(skip 1 and 2 if the load was confidently value-predicted: done at dispatch)
+         if (!PAY.buf[index].vp_confident) {
+            IQ.wakeup(PAY.buf[index].C_phys_reg);
+            REN->set_ready(PAY.buf[index].C_phys_reg);
+         }
          REN->write(PAY.buf[index].C_phys_reg, PAY.buf[index].C_value.dw);
 
          //********************************************
@@ -295,6 +303,9 @@ void pipeline_t::load_replay() {
          //********************************************
       }
 
+      // Verify the load's value prediction, if any.
+      vp_verify(index);
+
       // FIX_ME #18b
       // Set completed bit in Active List.
       //
@@ -0,0 +1,161 @@
+#include <stdlib.h>
+#include <cinttypes>
+
+#include "pipeline.h"
+#include "fcm.h"
+#include "vp_conf.h"
+
+
+fcm_t::fcm_t(unsigned int vpq_size,
+             unsigned int vht_index_bits,
+             unsigned int tag_bits,
+             unsigned int vpt_index_bits,
+             unsigned int order,
+             unsigned int confmax,
+             unsigned int confinc,
+             unsigned int confdec,
+             unsigned int replace_value) {
+   assert(vpq_size > 0);
+   assert(vht_index_bits < 32);
+   assert(tag_bits < 64);
+   assert((vpt_index_bits > 0) && (vpt_index_bits < 32));
+   assert(order > 0);
+
+   this->vht_index_bits = vht_index_bits;
+   this->tag_bits = tag_bits;
+   this->vpt_index_bits = vpt_index_bits;
+   this->order = order;
+   hist_shamt = ((vpt_index_bits / order) > 0) ? (vpt_index_bits / order) : 1;
+   this->confmax = confmax;
+   this->confinc = confinc;
+   this->confdec = confdec;
+   this->replace_value = replace_value;
+
+   VHT = new fcm_vht_entry[1 << vht_index_bits];
+   for (unsigned int i = 0; i < (1U << vht_index_bits); i++) {
+      VHT[i].tag = 0;
+      VHT[i].hist = 0;
+      VHT[i].spec_hist = 0;
+      VHT[i].instance = 0;
+   }
+
+   VPT = new fcm_vpt_entry[1 << vpt_index_bits];
+   for (unsigned int i = 0; i < (1U << vpt_index_bits); i++) {
+      VPT[i].value = 0;
+      VPT[i].conf = 0;
+   }
+
+   log = new fcm_log_t[vpq_size];
+}
+
+fcm_t::~fcm_t() {
+   delete [] VHT;
+   delete [] VPT;
+   delete [] log;
+}
+
+unsigned int fcm_t::vht_index(uint64_t pc) {
+   return((unsigned int)((pc >> 2) & ((1 << vht_index_bits) - 1)));
+}
+
+uint64_t fcm_t::vht_tag(uint64_t pc) {
+   return((pc >> (2 + vht_index_bits)) & ((((uint64_t)1) << tag_bits) - 1));
+}
+
+unsigned int fcm_t::vpt_index(uint64_t pc, uint64_t hist) {
+   return((unsigned int)((hist ^ (pc >> 2)) & ((1 << vpt_index_bits) - 1)));
+}
+
+// Shift the value, folded down to the VPT index width, into the history hash.
+uint64_t fcm_t::update_hist(uint64_t hist, uint64_t value) {
+   uint64_t folded = 0;
+   for (unsigned int i = 0; i < 64; i += vpt_index_bits)
+      folded ^= (value >> i);
+   return(((hist << hist_shamt) ^ folded) & ((1 << vpt_index_bits) - 1));
+}
+
+bool fcm_t::predict(uint64_t pc, unsigned int vpq_index, uint64_t& pred_value, bool& confident) {
+   fcm_vht_entry* e = &VHT[vht_index(pc)];
+   unsigned int i;
+
+   log[vpq_index].hit = (e->tag == vht_tag(pc));
+   if (!log[vpq_index].hit) {
+      pred_value = 0;
+      confident = false;
+      return(false);
+   }
+
+   i = vpt_index(pc, e->spec_hist);
+   pred_value = VPT[i].value;
+   confident = (VPT[i].conf == confmax);
+
+   // Younger instances see this instance's predicted value in their history.
+   log[vpq_index].old_spec_hist = e->spec_hist;
+   e->spec_hist = update_hist(e->spec_hist, pred_value);
+   e->instance++;
+
+   return(true);
+}
+
+void fcm_t::squash(unsigned int vpq_index, uint64_t pc) {
+   fcm_vht_entry* e = &VHT[vht_index(pc)];
+
+   if (log[vpq_index].hit) {
+      assert(e->instance > 0);
+      e->spec_hist = log[vpq_index].old_spec_hist;
+      e->instance--;
+   }
+}
+
+void fcm_t::flush() {
+   for (unsigned int i = 0; i < (1U << vht_index_bits); i++) {
+      VHT[i].spec_hist = VHT[i].hist;
+      VHT[i].instance = 0;
+   }
+}
+
+void fcm_t::train(unsigned int vpq_index, uint64_t pc, uint64_t value) {
+   fcm_vht_entry* e = &VHT[vht_index(pc)];
+   unsigned int i;
+
+   if (e->tag == vht_tag(pc)) {
+      // Train the VPT entry selected by the committed history.
+      i = vpt_index(pc, e->hist);
+      if (VPT[i].value == value) {
+         VPT[i].conf = vp_conf_inc(VPT[i].conf, confinc, confmax);
+      }
+      else {
+         if (VPT[i].conf <= replace_value)
+            VPT[i].value = value;
+         VPT[i].conf = (VPT[i].conf > confdec) ? (VPT[i].conf - confdec) : 0;
+      }
+      e->hist = update_hist(e->hist, value);
+
+      if (log[vpq_index].hit) {
+         assert(e->instance > 0);
+         e->instance--;
+      }
+
+      // Nothing in flight extends the speculative history, so resync it
+      // (it diverged if an in-flight instance was mispredicted).
+      if (e->instance == 0)
+         e->spec_hist = e->hist;
+   }
+   else if (e->instance == 0) {
+      // Replace the entry, unless in-flight instances of the current owner depend on it.
+      e->tag = vht_tag(pc);
+      e->hist = update_hist(0, value);
+      e->spec_hist = e->hist;
+   }
+}
+
+void fcm_t::dump_config(FILE* fp) {
+   fprintf(fp, "FCM_VHT_INDEX_BITS = %d\n", vht_index_bits);
+   fprintf(fp, "FCM_VHT_TAG_BITS = %d\n", tag_bits);
+   fprintf(fp, "FCM_VPT_INDEX_BITS = %d\n", vpt_index_bits);
+   fprintf(fp, "FCM_ORDER = %d\n", order);
+   fprintf(fp, "FCM_CONFMAX = %d\n", confmax);
+   fprintf(fp, "FCM_CONFINC = %d\n", confinc);
+   fprintf(fp, "FCM_CONFDEC = %d\n", confdec);
+   fprintf(fp, "FCM_REPLACE_VALUE = %d\n", replace_value);
+}
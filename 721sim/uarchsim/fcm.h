@@ -0,0 +1,87 @@
+#ifndef FCM_H
+#define FCM_H
+
+#include "VPinterface.h"
+
+///////////////////////////////////////////////////////////////
+// Two-level Finite Context Method (FCM) value predictor.
+//
+// Level 1, the Value History Table (VHT), is PC-indexed and
+// tagged. It holds a hash of the instruction's last <order>
+// values. Level 2, the Value Prediction Table (VPT), is indexed
+// by that hash (xor'd with the PC) and holds {value, confidence}.
+//
+// Each VHT entry keeps a committed history, updated with retired
+// values, and a speculative history that in-flight instances
+// extend with their predicted values. The speculative history
+// is rolled back when instances are squashed, and is resynced
+// with the committed history when no instances are in flight.
+///////////////////////////////////////////////////////////////
+
+typedef struct {
+  uint64_t tag;
+  uint64_t hist;              // committed value history hash
+  uint64_t spec_hist;         // speculative value history hash
+  unsigned int instance;      // number of in-flight instances that extended spec_hist
+} fcm_vht_entry;
+
+typedef struct {
+  uint64_t value;
+  unsigned int conf;
+} fcm_vpt_entry;
+
+typedef struct {
+  bool hit;                   // the instance hit in the VHT and extended its spec_hist
+  uint64_t old_spec_hist;     // spec_hist before this instance extended it
+} fcm_log_t;
+
+
+class fcm_t : public VPinterface_t {
+
+private:
+  fcm_vht_entry* VHT;
+  unsigned int vht_index_bits;
+  unsigned int tag_bits;
+
+  fcm_vpt_entry* VPT;
+  unsigned int vpt_index_bits;
+  unsigned int order;         // number of values in the history
+  unsigned int hist_shamt;    // shift per value, so a value ages out after <order> updates
+
+  unsigned int confmax;
+  unsigned int confinc;
+  unsigned int confdec;
+  unsigned int replace_value; // only replace a VPT value if conf <= replace_value
+
+  fcm_log_t* log;             // indexed by VPQ index
+
+  unsigned int vht_index(uint64_t pc);
+  uint64_t vht_tag(uint64_t pc);
+  unsigned int vpt_index(uint64_t pc, uint64_t hist);
+  uint64_t update_hist(uint64_t hist, uint64_t value);
+
+public:
+  fcm_t(unsigned int vpq_size,
+        unsigned int vht_index_bits,
+        unsigned int tag_bits,
+        unsigned int vpt_index_bits,
+        unsigned int order,
+        unsigned int confmax,
+        unsigned int confinc,
+        unsigned int confdec,
+        unsigned int replace_value);
+  ~fcm_t();
+
+  bool predict(uint64_t pc, unsigned int vpq_index, uint64_t& pred_value, bool& confident);
+  void spec_update_branch(uint64_t pc, bool taken) {}
+  uint64_t get_context() { return(0); }
+  void set_context(uint64_t context) {}
+  void squash(unsigned int vpq_index, uint64_t pc);
+  void flush();
+  void train(unsigned int vpq_index, uint64_t pc, uint64_t value);
+  void commit_branch(uint64_t pc, bool taken) {}
+  void dump_config(FILE* fp);
+  void dump_stats(FILE* fp) {}
+};
+
+#endif //FCM_H
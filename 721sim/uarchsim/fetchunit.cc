@@ -12,10 +12,18 @@ fetchunit_t::fetchunit_t(uint64_t instr_per_cycle,			// "n"
 			 uint64_t cbp_algorithm,			// conditional branch predictor algorithm: 0 for gshare, 1 for tage-sc-l
 			 uint64_t cb_pc_length, uint64_t cb_bhr_length,	// gshare cond. br. predictor: pc length (index size), bhr length
 			 uint64_t ib_pc_length, uint64_t ib_bhr_length,	// gshare indirect br. predictor: pc length (index size), bhr length
+			 uint64_t ibp_algorithm,			// indirect branch predictor algorithm: 0 for gshare, 1 for ittage
+			 uint64_t ittage_num_tables, uint64_t ittage_log2_size,	// ittage: tagged tables, log2 entries per table,
+			 uint64_t ittage_min_hist, uint64_t ittage_max_hist,	// ittage: shortest and longest history lengths
 			 uint64_t ras_size,				// # entries in the RAS
 			 uint64_t bq_size,				// branch queue size (max. number of outstanding branches)
 			 bool tc_enable,				// enable trace cache
 			 bool tc_perfect,				// perfect trace cache (only relevant if trace cache is enabled)
+			 uint64_t tc_sets,				// real trace cache: sets
+			 uint64_t tc_assoc,				// real trace cache: set-associativity (paths per start pc included)
+			 uint64_t tc_max_cb,				// maximum number of conditional branches in a trace (0: "m")
+			 uint64_t tc_max_length,			// maximum number of instructions in a trace (0: "n")
+			 bool tc_partial,				// real trace cache: supply partial hits
 			 bool bp_perfect,				// perfect branch prediction
 			 bool ic_perfect,				// perfect instruction cache
 			 uint64_t ic_sets,				// I$ sets
@@ -42,7 +50,10 @@ fetchunit_t::fetchunit_t(uint64_t instr_per_cycle,			// "n"
 	      ic_miss(false),
 	      btb(btb_entries, instr_per_cycle, btb_assoc, cond_branch_per_cycle),
 	      tc_enable(tc_enable),
-	      tc(tc_perfect, mmu, cond_branch_per_cycle, instr_per_cycle),
+	      tc(tc_perfect, mmu, instr_per_cycle,
+	         (tc_max_cb ? MIN(tc_max_cb, cond_branch_per_cycle) : cond_branch_per_cycle),
+	         (tc_max_length ? MIN(tc_max_length, instr_per_cycle) : instr_per_cycle),
+	         tc_sets, tc_assoc, tc_partial),
 	      bp_perfect(bp_perfect),
 	      bq(bq_size) {
 
@@ -52,6 +63,11 @@ fetchunit_t::fetchunit_t(uint64_t instr_per_cycle,			// "n"
    // Memory-allocate FETCH2, the pipeline register between the Fetch1 and Fetch2 stages.
    FETCH2 = new pipeline_register[instr_per_cycle];
 
+   // Memory-allocate the functional warming bundle.
+   warm_bundle = new fetch_bundle_t[instr_per_cycle];
+   warm_length = 0;
+   warm_num_cb = 0;
+
    // Initialize the Fetch2 stage's status.
    fetch2_status.valid = false;
 
@@ -73,7 +89,22 @@ fetchunit_t::fetchunit_t(uint64_t instr_per_cycle,			// "n"
          assert(0);
          break;
    }
-   IBP = new gshare_t(false, 1, ib_pc_length, ib_bhr_length, bq_size);
+   ittage = NULL;
+   switch (ibp_algorithm) {
+      case 0: // gshare
+         IBP = new gshare_t(false, 1, ib_pc_length, ib_bhr_length, bq_size);
+         break;
+
+      case 1: // ittage
+         ittage = new ittage_t(ittage_num_tables, ittage_log2_size, ittage_min_hist, ittage_max_hist, instr_per_cycle, bq_size);
+         IBP = ittage;
+         break;
+
+      default:
+         printf("Error: unknown indirect branch prediction algorithm %lu.\n", (unsigned long)ibp_algorithm);
+         exit(-1);
+         break;
+   }
    RBP = new ras_t(ras_size, ras_recover_e::RAS_RECOVER_TOS_POINTER, bq_size);
 
    // Initialize measurements.
@@ -539,6 +570,12 @@ bool fetchunit_t::fetch2(pipeline_register DECODE[]) {
 	 IBP->log_branch(pred_tag, bq.bq[pred_tag].branch_type, taken, bq.bq[pred_tag].fetch_pc, bq.bq[pred_tag].next_pc);
 	 RBP->log_branch(pred_tag, bq.bq[pred_tag].branch_type, taken, bq.bq[pred_tag].fetch_pc, bq.bq[pred_tag].next_pc);
       }
+      else {
+	 // Mark the instruction's position among the branches, i.e., the branch queue entry of the next branch.
+	 // This makes it possible to restart fetch right after a non-branch instruction, see rollback().
+	 bq.mark(pred_tag, pred_tag_phase);
+	 PAY->buf[index].pred_tag = ((pred_tag << 1) | (pred_tag_phase ? 1 : 0));
+      }
 
       // Go to next instruction in the fetch bundle.
       pos++;
@@ -609,6 +646,59 @@ void fetchunit_t::mispredict(uint64_t branch_pred_tag, bool taken, uint64_t next
 }
 
 
+// A non-branch instruction was "mispredicted" (e.g., a value misprediction).
+// 1. Roll-back the branch queue to the instruction's mark, squashing the branches after it.
+// 2. Restore predictors' contexts.
+// 3. Restore the pc.
+// 4. Go active again, whether or not currently active (restore fetch_active).
+// 5. Squash the fetch2_status register and FETCH2 pipeline register.
+void fetchunit_t::rollback(uint64_t mark_pred_tag, uint64_t next_pc) {
+   // Extract the pred_tag and pred_tag_phase from the unified mark_pred_tag.
+
+   uint64_t pred_tag = (mark_pred_tag >> 1);
+   bool pred_tag_phase = (((mark_pred_tag & 1) == 1) ? true : false);
+
+   // Are there branches after the instruction, in the branch queue?
+   uint64_t tail;
+   bool tail_phase;
+   bq.mark(tail, tail_phase);
+   bool younger_branches = ((pred_tag != tail) || (pred_tag_phase != tail_phase));
+
+   // 1. Roll-back the branch queue to the instruction's mark.
+   //    The mark may equal the tail, so skip the checks (which assume the entry is in the branch queue).
+
+   bq.rollback(pred_tag, pred_tag_phase, false);
+
+   // 2. Restore predictors' contexts.
+   //    If there are branches after the instruction, the context logged by the first of them is the
+   //    context right after the instruction. Otherwise, only the Fetch2 bundle (which is being squashed)
+   //    may have speculatively updated the predictors after the instruction, so undo that.
+
+   if (younger_branches) {
+      CBP->flush(pred_tag);
+      IBP->flush(pred_tag);
+      RBP->flush(pred_tag);
+   }
+   else if (fetch2_status.valid) {
+      CBP->restore_fetch2_context();
+      IBP->restore_fetch2_context();
+      RBP->restore_fetch2_context();
+   }
+
+   // 3. Restore the pc.
+
+   pc = next_pc;
+
+   // 4. Go active again, whether or not currently active (restore fetch_active).
+
+   fetch_active = true;
+
+   // 5. Squash the fetch2_status register and FETCH2 pipeline register.
+
+   squash_fetch2();
+}
+
+
 // Commit the indicated branch from the branch queue.
 // We assert that it is at the head.
 void fetchunit_t::commit(uint64_t branch_pred_tag) {
@@ -719,6 +809,187 @@ void fetchunit_t::flush(uint64_t pc) {
 }
 
 
+// Functional warming (sampled simulation).
+void fetchunit_t::warm(uint64_t pc, insn_t insn, uint64_t next_pc) {
+   fetch_bundle_t *slot;
+   bool terminated;
+
+   // A bundle starts at the pc that follows the previous bundle.
+   slot = &warm_bundle[warm_length];
+   slot->valid = true;
+   slot->pc = pc;
+   slot->next_pc = next_pc;
+   slot->insn = insn;
+   slot->exception = false;
+   warm_length++;
+
+   // The trace cache is filled with correct-path instructions, too.
+   if (tc_enable)
+      tc.fill(pc, insn, next_pc);
+
+   // End the bundle where Fetch1 + Fetch2 would: at the n'th instruction, a taken branch, the m'th conditional branch,
+   // any jump, or a serializing instruction; and wherever control leaves the sequential path (e.g., an exception).
+   terminated = ((warm_length == instr_per_cycle) || (next_pc != INCREMENT_PC(pc)));
+   switch (insn.opcode()) {
+      case OP_BRANCH:
+         slot->branch = true;
+         slot->branch_type = btb_t::decode(insn, pc, slot->branch_target);
+         warm_num_cb++;
+         if (warm_num_cb == cond_branch_per_cycle)
+            terminated = true;
+         break;
+
+      case OP_JAL:
+      case OP_JALR:
+         slot->branch = true;
+         slot->branch_type = btb_t::decode(insn, pc, slot->branch_target);
+         terminated = true;
+         break;
+
+      case OP_AMO:
+      case OP_SYSTEM:
+         slot->branch = false;
+         terminated = true;
+         break;
+
+      default:
+         slot->branch = false;
+         break;
+   }
+
+   if (terminated)
+      warm_flush();
+}
+
+// Functional warming (fast skip).
+void fetchunit_t::warm_ic(uint64_t pc) {
+   ic.warm_line(pc);
+}
+
+// Trace cache fill unit.
+void fetchunit_t::retire(uint64_t pc, insn_t insn, uint64_t next_pc) {
+   if (tc_enable)
+      tc.fill(pc, insn, next_pc);
+}
+
+void fetchunit_t::warm_flush() {
+   uint64_t fetch_pc;
+   uint64_t pos;
+   uint64_t cb_outcomes;
+   uint64_t num_cb;
+   bool taken;
+   spec_update_t update;
+   uint64_t pred_tag;
+   bool pred_tag_phase;
+   uint64_t fetch_cbID_in_bundle;
+
+   if (warm_length == 0)
+      return;
+
+   fetch_pc = warm_bundle[0].pc;
+
+   // Access the I$ and train the BTB.
+   ic.warm(fetch_pc);
+   for (pos = 0; pos < warm_length; pos++) {
+      if (warm_bundle[pos].branch)
+         btb.warm(fetch_pc, pos, warm_bundle[pos].insn);
+   }
+
+   if (!bp_perfect) {
+      // Fetch1: predict, save the context, and speculatively update with the actual outcomes.
+      CBP->predict(fetch_pc);
+      IBP->predict(fetch_pc);
+      RBP->predict(fetch_pc);
+
+      CBP->save_fetch2_context();
+      IBP->save_fetch2_context();
+      RBP->save_fetch2_context();
+
+      cb_outcomes = 0;
+      num_cb = 0;
+      update.pop_ras = false;
+      update.push_ras = false;
+      update.push_ras_pc = 0;
+      for (pos = 0; pos < warm_length; pos++) {
+         if (warm_bundle[pos].branch) {
+            switch (warm_bundle[pos].branch_type) {
+               case BTB_BRANCH:
+                  if (warm_bundle[pos].next_pc != INCREMENT_PC(warm_bundle[pos].pc))
+                     cb_outcomes |= (1ULL << num_cb);
+                  num_cb++;
+                  break;
+               case BTB_CALL_DIRECT:
+               case BTB_CALL_INDIRECT:
+                  update.push_ras = true;
+                  update.push_ras_pc = INCREMENT_PC(warm_bundle[pos].pc);
+                  break;
+               case BTB_RETURN:
+                  update.pop_ras = true;
+                  break;
+               default:
+                  break;
+            }
+         }
+      }
+      update.num_cb = num_cb;
+      update.next_pc = warm_bundle[warm_length - 1].next_pc;
+
+      CBP->spec_update(cb_outcomes, update.num_cb, fetch_pc, update.next_pc, update.pop_ras, update.push_ras, update.push_ras_pc);
+      IBP->spec_update(cb_outcomes, update.num_cb, fetch_pc, update.next_pc, update.pop_ras, update.push_ras, update.push_ras_pc);
+      RBP->spec_update(cb_outcomes, update.num_cb, fetch_pc, update.next_pc, update.pop_ras, update.push_ras, update.push_ras_pc);
+
+      // Fetch2: push the branches onto the branch queue and log their contexts.
+      CBP->log_begin();
+      IBP->log_begin();
+      RBP->log_begin();
+
+      fetch_cbID_in_bundle = 0;
+      for (pos = 0; pos < warm_length; pos++) {
+         if (warm_bundle[pos].branch) {
+            bq.push(pred_tag, pred_tag_phase);
+            bq.bq[pred_tag].branch_type = warm_bundle[pos].branch_type;
+            bq.bq[pred_tag].fetch_pc = fetch_pc;
+            if (warm_bundle[pos].branch_type == BTB_BRANCH) {
+               bq.bq[pred_tag].fetch_cbID_in_bundle = fetch_cbID_in_bundle;
+               fetch_cbID_in_bundle++;
+            }
+            else {
+               bq.bq[pred_tag].fetch_cbID_in_bundle = 0;
+            }
+            bq.bq[pred_tag].misp = false;
+            taken = (warm_bundle[pos].next_pc != INCREMENT_PC(warm_bundle[pos].pc));
+            bq.bq[pred_tag].taken = taken;
+            bq.bq[pred_tag].next_pc = warm_bundle[pos].next_pc;
+
+            CBP->log_branch(pred_tag, bq.bq[pred_tag].branch_type, taken, fetch_pc, bq.bq[pred_tag].next_pc);
+            IBP->log_branch(pred_tag, bq.bq[pred_tag].branch_type, taken, fetch_pc, bq.bq[pred_tag].next_pc);
+            RBP->log_branch(pred_tag, bq.bq[pred_tag].branch_type, taken, fetch_pc, bq.bq[pred_tag].next_pc);
+         }
+      }
+
+      // Retire: commit the branches, oldest first (as commit(), without measurements).
+      for (pos = 0; pos < warm_length; pos++) {
+         if (warm_bundle[pos].branch) {
+            bq.pop(pred_tag, pred_tag_phase);
+            switch (bq.bq[pred_tag].branch_type) {
+               case BTB_BRANCH:
+                  CBP->commit(pred_tag, bq.bq[pred_tag].fetch_pc, bq.bq[pred_tag].fetch_cbID_in_bundle, bq.bq[pred_tag].taken, bq.bq[pred_tag].next_pc);
+                  break;
+               case BTB_JUMP_INDIRECT:
+               case BTB_CALL_INDIRECT:
+                  IBP->commit(pred_tag, bq.bq[pred_tag].fetch_pc, bq.bq[pred_tag].fetch_cbID_in_bundle, bq.bq[pred_tag].taken, bq.bq[pred_tag].next_pc);
+                  break;
+               default:
+                  break;
+            }
+         }
+      }
+   }
+
+   warm_length = 0;
+   warm_num_cb = 0;
+}
+
 // Output all branch prediction measurements.
 
 #define BP_OUTPUT(fp, str, n, m, i) \
@@ -739,6 +1010,11 @@ void fetchunit_t::output(uint64_t num_instr, uint64_t num_cycles, FILE *fp) {
    fprintf(fp, "(Number of Jump Indirects whose target was the next sequential PC = %lu)\n", meas_jumpind_seq);
    fprintf(fp, "BTB MEASUREMENTS-----------------------------------\n");
    fprintf(fp, "BTB misses (fetch cycles squashed due to a BTB miss) = %lu (%.2f%% of all cycles)\n", meas_btbmiss, 100.0*((double)meas_btbmiss/(double)num_cycles));
+   if (ittage)
+      ittage->dump_stats(fp);
+   if (tc_enable)
+      tc.dump_stats(fp);
+   ic.dump_stats(fp);
 }
 
 void fetchunit_t::setPC(uint64_t pc) {
@@ -752,3 +1028,8 @@ uint64_t fetchunit_t::getPC() {
 bool fetchunit_t::active() {
    return(fetch_active);
 }
+
+bool fetchunit_t::ic_miss_pending(cycle_t& resolve_cycle) {
+   resolve_cycle = ic_miss_resolve_cycle;
+   return(ic_miss);
+}
@@ -5,6 +5,7 @@
 #include "BPinterface.h"
 #include "gshare.h"
 #include "tage-sc-l-wrapper.h"
+#include "ittage.h"
 #include "ras.h"
 #include "perfectbp.h"
 #include "ic.h"
@@ -72,6 +73,7 @@ private:
 
 	// Indirect branch predictor.
 	BPinterface_t *IBP;
+	ittage_t *ittage;	// The indirect branch predictor, if ITTAGE (for its measurements). Otherwise NULL.
 
 	// Branch predictor for return instructions.
 	BPinterface_t *RBP;
@@ -109,6 +111,15 @@ private:
 
 	uint64_t meas_btbmiss;		// # of btb misses, i.e., number of discarded fetch bundles (idle fetch cycles) due to a btb miss within the bundle
 
+	////////////////////////////////////////////////////////////////
+	// Functional warming (sampled simulation).
+	////////////////////////////////////////////////////////////////
+
+	// The correct-path fetch bundle being assembled from functionally executed instructions.
+	fetch_bundle_t *warm_bundle;
+	uint64_t warm_length;		// number of instructions in warm_bundle
+	uint64_t warm_num_cb;		// number of conditional branches in warm_bundle
+
 	////////////////////////////
 	// Private functions.
 	////////////////////////////
@@ -130,10 +141,18 @@ public:
 		    uint64_t cbp_algorithm,				// conditional branch predictor algorithm: 0 for gshare, 1 for tage-sc-l
 	            uint64_t cb_pc_length, uint64_t cb_bhr_length,	// gshare cond. br. predictor: pc length (index size), bhr length
 	            uint64_t ib_pc_length, uint64_t ib_bhr_length,	// gshare indirect br. predictor: pc length (index size), bhr length
+		    uint64_t ibp_algorithm,				// indirect branch predictor algorithm: 0 for gshare, 1 for ittage
+		    uint64_t ittage_num_tables, uint64_t ittage_log2_size,	// ittage: tagged tables, log2 entries per table,
+		    uint64_t ittage_min_hist, uint64_t ittage_max_hist,	// ittage: shortest and longest history lengths
 	            uint64_t ras_size,					// # entries in the RAS
 	            uint64_t bq_size,					// branch queue size (max. number of outstanding branches)
 	            bool tc_enable,					// enable trace cache
 	            bool tc_perfect,					// perfect trace cache (only relevant if trace cache is enabled)
+	            uint64_t tc_sets,					// real trace cache: sets
+	            uint64_t tc_assoc,					// real trace cache: set-associativity (paths per start pc included)
+	            uint64_t tc_max_cb,					// maximum number of conditional branches in a trace (0: "m")
+	            uint64_t tc_max_length,				// maximum number of instructions in a trace (0: "n")
+	            bool tc_partial,					// real trace cache: supply partial hits
 		    bool bp_perfect,					// perfect branch prediction
 		    bool ic_perfect,					// perfect instruction cache
 		    uint64_t ic_sets,					// I$ sets
@@ -185,6 +204,15 @@ public:
 	// 7. Squash the fetch2_status register and FETCH2 pipeline register.
 	void mispredict(uint64_t branch_pred_tag, bool taken, uint64_t next_pc);
 
+	// A non-branch instruction was "mispredicted" (e.g., a value misprediction),
+	// so fetch must restart right after it.
+	// 1. Roll-back the branch queue to the instruction's mark (see fetch2()).
+	// 2. Restore checkpointed global histories and the RAS (as best we can for RAS).
+	// 3. Restore the pc.
+	// 4. Go active again, whether or not currently active (restore fetch_active).
+	// 5. Squash the fetch2_status register and FETCH2 pipeline register.
+	void rollback(uint64_t mark_pred_tag, uint64_t next_pc);
+
 	// Commit the indicated branch from the branch queue.
 	// We assert that it is at the head.
 	void commit(uint64_t branch_pred_tag);
@@ -198,6 +226,20 @@ public:
 	// 6. Reset ic_miss (discard pending I$ misses).
 	void flush(uint64_t pc);
 
+	// Functional warming (sampled simulation).
+	// warm(): The instruction at 'pc' executed on the correct path and 'next_pc' followed it.
+	//         Instructions are grouped into the fetch bundles that Fetch1 would form with perfect prediction.
+	//         As each bundle completes, the I$ and BTB are accessed, and the branch predictors are predicted, speculatively
+	//         updated with the outcomes, and committed, in the same order as the pipeline would; no measurements are taken.
+	// warm_flush(): Complete a partially assembled bundle, e.g., at the end of a functional phase.
+	void warm(uint64_t pc, insn_t insn, uint64_t next_pc);
+	void warm_flush();
+	// warm_ic(): The instruction at 'pc' was fetched by the functional simulator (fast skip): warm its I$ line only.
+	void warm_ic(uint64_t pc);
+
+	// Trace cache fill unit: the instruction at 'pc' retired and 'next_pc' followed it.
+	void retire(uint64_t pc, insn_t insn, uint64_t next_pc);
+
 	// Output all branch prediction measurements.
 	void output(uint64_t num_instr, uint64_t num_cycles, FILE *fp);
 
@@ -207,4 +249,7 @@ public:
 
 	// Public function for querying fetch_active.
 	bool active();
+
+	// Public function for querying an outstanding instruction cache miss, and the cycle when it resolves.
+	bool ic_miss_pending(cycle_t& resolve_cycle);
 };
@@ -0,0 +1,149 @@
+#include <stdlib.h>
+#include <cinttypes>
+
+#include "pipeline.h"
+#include "hybrid_vp.h"
+
+
+hybrid_vp_t::hybrid_vp_t(unsigned int vpq_size, unsigned int chooser_index_bits) {
+   assert(vpq_size > 0);
+   assert(chooser_index_bits < 32);
+
+   num_components = 0;
+   context_component = -1;
+
+   this->chooser_index_bits = chooser_index_bits;
+   chooser = new unsigned int[1 << chooser_index_bits][HYBRID_VP_MAX_COMPONENTS];
+   for (unsigned int i = 0; i < (1U << chooser_index_bits); i++)
+      for (unsigned int c = 0; c < HYBRID_VP_MAX_COMPONENTS; c++)
+         chooser[i][c] = 0;
+
+   log = new hybrid_vp_log_t[vpq_size];
+
+   // STATS
+   for (unsigned int c = 0; c < HYBRID_VP_MAX_COMPONENTS; c++) {
+      n_chosen_conf[c] = 0;
+      n_chosen_conf_correct[c] = 0;
+   }
+}
+
+hybrid_vp_t::~hybrid_vp_t() {
+   for (unsigned int c = 0; c < num_components; c++)
+      delete component[c];
+   delete [] chooser;
+   delete [] log;
+}
+
+void hybrid_vp_t::add_component(const char* name, VPinterface_t* vp, bool uses_context) {
+   assert(num_components < HYBRID_VP_MAX_COMPONENTS);
+   if (uses_context) {
+      assert(context_component < 0);
+      context_component = num_components;
+   }
+   component_name[num_components] = name;
+   component[num_components] = vp;
+   num_components++;
+}
+
+unsigned int hybrid_vp_t::chooser_index(uint64_t pc) {
+   return((unsigned int)((pc >> 2) & ((1 << chooser_index_bits) - 1)));
+}
+
+bool hybrid_vp_t::predict(uint64_t pc, unsigned int vpq_index, uint64_t& pred_value, bool& confident) {
+   hybrid_vp_log_t* l = &log[vpq_index];
+   unsigned int* score = chooser[chooser_index(pc)];
+   int best_conf = -1;
+   int best_hit = -1;
+
+   // Every component predicts, so that each one logs and speculatively updates its own state.
+   for (unsigned int c = 0; c < num_components; c++) {
+      l->hit[c] = component[c]->predict(pc, vpq_index, l->pred_value[c], l->confident[c]);
+      if (l->hit[c]) {
+         if (l->confident[c] && ((best_conf < 0) || (score[c] > score[best_conf])))
+            best_conf = c;
+         if ((best_hit < 0) || (score[c] > score[best_hit]))
+            best_hit = c;
+      }
+   }
+
+   l->chosen = ((best_conf >= 0) ? best_conf : best_hit);
+   if (l->chosen >= 0) {
+      pred_value = l->pred_value[l->chosen];
+      confident = (best_conf >= 0);
+      return(true);
+   }
+   else {
+      pred_value = 0;
+      confident = false;
+      return(false);
+   }
+}
+
+void hybrid_vp_t::spec_update_branch(uint64_t pc, bool taken) {
+   for (unsigned int c = 0; c < num_components; c++)
+      component[c]->spec_update_branch(pc, taken);
+}
+
+uint64_t hybrid_vp_t::get_context() {
+   return((context_component >= 0) ? component[context_component]->get_context() : 0);
+}
+
+void hybrid_vp_t::set_context(uint64_t context) {
+   if (context_component >= 0)
+      component[context_component]->set_context(context);
+}
+
+void hybrid_vp_t::squash(unsigned int vpq_index, uint64_t pc) {
+   for (unsigned int c = 0; c < num_components; c++)
+      component[c]->squash(vpq_index, pc);
+}
+
+void hybrid_vp_t::flush() {
+   for (unsigned int c = 0; c < num_components; c++)
+      component[c]->flush();
+}
+
+void hybrid_vp_t::train(unsigned int vpq_index, uint64_t pc, uint64_t value) {
+   hybrid_vp_log_t* l = &log[vpq_index];
+   unsigned int* score = chooser[chooser_index(pc)];
+
+   for (unsigned int c = 0; c < num_components; c++) {
+      if (l->hit[c]) {
+         if (l->pred_value[c] == value) {
+            if (score[c] < HYBRID_VP_SCORE_MAX)
+               score[c]++;
+         }
+         else if (score[c] > 0) {
+            score[c]--;
+         }
+      }
+      component[c]->train(vpq_index, pc, value);
+   }
+
+   if ((l->chosen >= 0) && l->confident[l->chosen]) {
+      n_chosen_conf[l->chosen]++;
+      if (l->pred_value[l->chosen] == value)
+         n_chosen_conf_correct[l->chosen]++;
+   }
+}
+
+void hybrid_vp_t::commit_branch(uint64_t pc, bool taken) {
+   for (unsigned int c = 0; c < num_components; c++)
+      component[c]->commit_branch(pc, taken);
+}
+
+void hybrid_vp_t::dump_config(FILE* fp) {
+   fprintf(fp, "HYBRID_CHOOSER_INDEX_BITS = %d\n", chooser_index_bits);
+   for (unsigned int c = 0; c < num_components; c++) {
+      fprintf(fp, "HYBRID_COMPONENT_%d = %s\n", c, component_name[c]);
+      component[c]->dump_config(fp);
+   }
+}
+
+void hybrid_vp_t::dump_stats(FILE* fp) {
+   fprintf(fp, "HYBRID CHOICE (retired, confident)\n");
+   for (unsigned int c = 0; c < num_components; c++)
+      fprintf(fp, "  %-16s = %" PRIu64 " (%" PRIu64 " correct)\n", component_name[c], n_chosen_conf[c], n_chosen_conf_correct[c]);
+   for (unsigned int c = 0; c < num_components; c++)
+      component[c]->dump_stats(fp);
+}
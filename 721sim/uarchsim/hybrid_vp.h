@@ -0,0 +1,68 @@
+#ifndef HYBRID_VP_H
+#define HYBRID_VP_H
+
+#include "VPinterface.h"
+
+///////////////////////////////////////////////////////////////
+// Hybrid value predictor.
+//
+// Runs several component predictors side by side. A PC-indexed
+// chooser keeps a saturating score per component, trained at
+// retire on whether each component's prediction was correct.
+// Among the confident components, the one with the highest
+// score provides the prediction (ties go to the earlier
+// component). If none is confident, the highest-scoring
+// component that has a prediction provides it, not confidently.
+///////////////////////////////////////////////////////////////
+
+#define HYBRID_VP_MAX_COMPONENTS	4
+#define HYBRID_VP_SCORE_MAX		3
+
+typedef struct {
+  bool hit[HYBRID_VP_MAX_COMPONENTS];
+  bool confident[HYBRID_VP_MAX_COMPONENTS];
+  uint64_t pred_value[HYBRID_VP_MAX_COMPONENTS];
+  int chosen;                 // component that provided the prediction, or -1
+} hybrid_vp_log_t;
+
+
+class hybrid_vp_t : public VPinterface_t {
+
+private:
+  VPinterface_t* component[HYBRID_VP_MAX_COMPONENTS];
+  const char* component_name[HYBRID_VP_MAX_COMPONENTS];
+  unsigned int num_components;
+  int context_component;      // the component whose global context (if any) is checkpointed
+
+  unsigned int (*chooser)[HYBRID_VP_MAX_COMPONENTS];
+  unsigned int chooser_index_bits;
+
+  hybrid_vp_log_t* log;       // indexed by VPQ index
+
+  unsigned int chooser_index(uint64_t pc);
+
+  // STATS
+  uint64_t n_chosen_conf[HYBRID_VP_MAX_COMPONENTS];  // retired confident predictions, by providing component
+  uint64_t n_chosen_conf_correct[HYBRID_VP_MAX_COMPONENTS];
+
+public:
+  hybrid_vp_t(unsigned int vpq_size, unsigned int chooser_index_bits);
+  ~hybrid_vp_t();
+
+  // Components are owned (and deleted) by the hybrid predictor.
+  // At most one component may use a global context (branch history).
+  void add_component(const char* name, VPinterface_t* vp, bool uses_context);
+
+  bool predict(uint64_t pc, unsigned int vpq_index, uint64_t& pred_value, bool& confident);
+  void spec_update_branch(uint64_t pc, bool taken);
+  uint64_t get_context();
+  void set_context(uint64_t context);
+  void squash(unsigned int vpq_index, uint64_t pc);
+  void flush();
+  void train(unsigned int vpq_index, uint64_t pc, uint64_t value);
+  void commit_branch(uint64_t pc, bool taken);
+  void dump_config(FILE* fp);
+  void dump_stats(FILE* fp);
+};
+
+#endif //HYBRID_VP_H
@@ -4,6 +4,7 @@
 #include "CacheClass.h"
 #include "fetchunit_types.h"
 #include "ic.h"
+#include "parameters.h"
 
 
 ic_t::ic_t(bool perfect,
@@ -22,6 +23,7 @@ ic_t::ic_t(bool perfect,
    this->perfect = perfect;
    this->mmu = mmu;
    IC = new CacheClass(sets, assoc, line_size, hit_latency, miss_latency, num_MHSRs, miss_srv_ports, miss_srv_latency, proc, "l1_ic", L2C);
+   IC->set_prefetcher(L1_IC_PREFETCHER, L1_IC_PREFETCH_DEGREE);
    this->line_size = line_size;
    this->fetch_width = fetch_width;
 
@@ -93,3 +95,22 @@ bool ic_t::lookup(cycle_t cycle, uint64_t pc, fetch_bundle_t bundle[], cycle_t &
 
    return(true);	// I$ hit, and the miss_resolve_cycle is a dont-care.
 }
+
+void ic_t::dump_stats(FILE* fp) {
+   IC->dump_prefetch_stats(fp);
+}
+
+// Functional warming (sampled simulation): the fetch bundle at 'pc' was fetched on the correct path.
+// Touch the same two consecutive lines as lookup(), without timing.
+void ic_t::warm(uint64_t pc) {
+   if (!perfect) {
+      IC->Warm(0, ((pc >> line_size) << line_size), false);
+      IC->Warm(0, (((pc >> line_size) + 1) << line_size), false);
+   }
+}
+
+// Functional warming (fast skip): the instruction at 'pc' was fetched. Touch its line only.
+void ic_t::warm_line(uint64_t pc) {
+   if (!perfect)
+      IC->Warm(0, ((pc >> line_size) << line_size), false);
+}
@@ -24,4 +24,7 @@ public:
 	~ic_t();
 
 	bool lookup(cycle_t cycle, uint64_t pc, fetch_bundle_t bundle[], cycle_t &miss_resolve_cycle);
+	void warm(uint64_t pc);
+	void warm_line(uint64_t pc);
+	void dump_stats(FILE* fp);
 };
@@ -2,7 +2,7 @@
 
 
 // constructor
-issue_queue::issue_queue(unsigned int size, unsigned int num_parts, pipeline_t* _proc):proc(_proc) {
+issue_queue::issue_queue(unsigned int size, unsigned int num_parts, unsigned int num_phys_regs, pipeline_t* _proc):proc(_proc) {
 	// Initialize the issue queue.
 	q = new issue_queue_entry_t[size];
 	this->size = size;
@@ -28,6 +28,35 @@ issue_queue::issue_queue(unsigned int size, unsigned int num_parts, pipeline_t*
 	oldest = -1;
 	youngest = -1;
 
+	// Initialize the consumer lists for event-driven wakeup: all lists are initially empty.
+	this->num_phys_regs = num_phys_regs;
+	consumer_head = new int[num_phys_regs];
+	for (unsigned int i = 0; i < num_phys_regs; i++) {
+		consumer_head[i] = -1;
+	}
+	consumer_prev = new int[3*size];
+	consumer_next = new int[3*size];
+	consumer_linked = new bool[3*size];
+	for (unsigned int i = 0; i < 3*size; i++) {
+		consumer_linked[i] = false;
+	}
+
+	// Initialize the ready bitmap: no entries are ready.
+	num_words = (size + 63)/64;
+	ready_bits = new uint64_t[num_words];
+	for (unsigned int w = 0; w < num_words; w++) {
+		ready_bits[w] = 0;
+	}
+	// Initialize the age-ordered ready bitmap: no positions are ready.
+	for (age_size = 64; age_size < 4*size; age_size *= 2)
+		;
+	age_ready_bits = new uint64_t[age_size/64];
+	for (unsigned int w = 0; w < age_size/64; w++) {
+		age_ready_bits[w] = 0;
+	}
+	age_entry = new unsigned int[age_size];
+	age_stamp = 0;
+
   // Needed for macro
   stats = proc->get_stats();
 }
@@ -70,6 +99,14 @@ void issue_queue::dispatch(unsigned int index, unsigned long long branch_mask, u
 	q[free].D_ready = D_ready;
 	q[free].D_tag = D_tag;
 
+	// Take the next position in the age-ordered ready bitmap, renumbering first if it would wrap around onto the oldest instruction.
+	if ((oldest != -1) && ((age_stamp - q[oldest].age) >= age_size))
+	   renumber();
+	q[free].age = age_stamp++;
+	age_entry[MOD(q[free].age, age_size)] = free;
+	update_ready(free);
+
+
 	// Add this instruction to tail of linked-list for ideal age-based priority.
 	if (oldest == -1) {	// IQ empty
 	   assert(youngest == -1);
@@ -86,6 +123,16 @@ void issue_queue::dispatch(unsigned int index, unsigned long long branch_mask, u
 	   q[youngest].next = free;
 	   youngest = free;
 	}
+
+	// Record the instruction as a consumer of each of its not-ready source operands.
+	if (IQ_WAKEUP) {
+	   if (A_valid && !A_ready)
+	      link_consumer(A_tag, 3*free);
+	   if (B_valid && !B_ready)
+	      link_consumer(B_tag, 3*free + 1);
+	   if (D_valid && !D_ready)
+	      link_consumer(D_tag, 3*free + 2);
+	}
 }
 
 void issue_queue::wakeup(unsigned int tag) {
@@ -98,11 +145,60 @@ void issue_queue::wakeup(unsigned int tag) {
 
   inc_counter(wakeup_cam_read_count);
 
+	if (IQ_WAKEUP) {
+		// Event-driven wakeup: only visit the source operands recorded as consumers of the tag.
+		// Every consumer is woken up, so the tag's consumer list is emptied.
+		assert(tag < num_phys_regs);
+		int slot = consumer_head[tag];
+		consumer_head[tag] = -1;
+		while (slot != -1) {
+			unsigned int i = (unsigned int)slot / 3;
+			assert(q[i].valid);
+			assert(consumer_linked[slot]);
+			consumer_linked[slot] = false;
+			switch (slot % 3) {
+				case 0:
+					assert(q[i].A_valid && (tag == q[i].A_tag));
+					assert(!q[i].A_ready);
+					q[i].A_ready = true;
+					update_ready(i);
+	        #ifdef RISCV_MICRO_DEBUG
+	          LOG(proc->issue_log,proc->cycle,proc->PAY.buf[q[i].index].sequence,proc->PAY.buf[q[i].index].pc,"Waking up RS1 iq entry %u",i);
+	          dump_iq(proc,i,proc->issue_log);
+	        #endif
+					break;
+				case 1:
+					assert(q[i].B_valid && (tag == q[i].B_tag));
+					assert(!q[i].B_ready);
+					q[i].B_ready = true;
+					update_ready(i);
+	        #ifdef RISCV_MICRO_DEBUG
+	          LOG(proc->issue_log,proc->cycle,proc->PAY.buf[q[i].index].sequence,proc->PAY.buf[q[i].index].pc,"Waking up RS2 iq entry %u",i);
+	          dump_iq(proc,i,proc->issue_log);
+	        #endif
+					break;
+				default:
+					assert(q[i].D_valid && (tag == q[i].D_tag));
+					assert(!q[i].D_ready);
+					q[i].D_ready = true;
+					update_ready(i);
+	        #ifdef RISCV_MICRO_DEBUG
+	          LOG(proc->issue_log,proc->cycle,proc->PAY.buf[q[i].index].sequence,proc->PAY.buf[q[i].index].pc,"Waking up RS3 iq entry %u",i);
+	          dump_iq(proc,i,proc->issue_log);
+	        #endif
+					break;
+			}
+			slot = consumer_next[slot];
+		}
+		return;
+	}
+
 	for (unsigned int i = 0; i < size; i++) {
 		if (q[i].valid) {					// Only consider valid issue queue entries.
 			if (q[i].A_valid && (tag == q[i].A_tag)) {	// Check first source operand.
 				assert(!q[i].A_ready);
 				q[i].A_ready = true;
+				update_ready(i);
         #ifdef RISCV_MICRO_DEBUG
           LOG(proc->issue_log,proc->cycle,proc->PAY.buf[q[i].index].sequence,proc->PAY.buf[q[i].index].pc,"Waking up RS1 iq entry %u",i);
           dump_iq(proc,i,proc->issue_log);
@@ -112,6 +208,7 @@ void issue_queue::wakeup(unsigned int tag) {
 			if (q[i].B_valid && (tag == q[i].B_tag)) {	// Check second source operand.
 				assert(!q[i].B_ready);
 				q[i].B_ready = true;
+				update_ready(i);
         #ifdef RISCV_MICRO_DEBUG
           LOG(proc->issue_log,proc->cycle,proc->PAY.buf[q[i].index].sequence,proc->PAY.buf[q[i].index].pc,"Waking up RS2 iq entry %u",i);
           dump_iq(proc,i,proc->issue_log);
@@ -120,6 +217,7 @@ void issue_queue::wakeup(unsigned int tag) {
 			if (q[i].D_valid && (tag == q[i].D_tag)) {	// Check third source operand.
 				assert(!q[i].D_ready);
 				q[i].D_ready = true;
+				update_ready(i);
         #ifdef RISCV_MICRO_DEBUG
           LOG(proc->issue_log,proc->cycle,proc->PAY.buf[q[i].index].sequence,proc->PAY.buf[q[i].index].pc,"Waking up RS3 iq entry %u",i);
           dump_iq(proc,i,proc->issue_log);
@@ -129,10 +227,168 @@ void issue_queue::wakeup(unsigned int tag) {
 	}
 }
 
-void issue_queue::select_and_issue(unsigned int num_lanes, lane* Execution_Lanes) {
-   unsigned int i, j;
+void issue_queue::replay(unsigned int tag) {
+	// The producer of the tag is going to re-execute (selective replay of a value misprediction's dependents).
+	// Undo its earlier wakeup: clear the ready bit of every matching source operand, so that
+	// its dependents in the issue queue wait for the producer's new wakeup.
+	// With event-driven wakeup, an operand that was already woken up is re-linked into the tag's consumer list.
+	for (unsigned int i = 0; i < size; i++) {
+		if (q[i].valid) {
+			if ((q[i].A_valid && (tag == q[i].A_tag)) || (q[i].B_valid && (tag == q[i].B_tag)) || (q[i].D_valid && (tag == q[i].D_tag)))
+				clear_ready(i);
+			if (q[i].A_valid && (tag == q[i].A_tag)) {
+				if (IQ_WAKEUP && q[i].A_ready)
+					link_consumer(tag, 3*i);
+				q[i].A_ready = false;
+			}
+			if (q[i].B_valid && (tag == q[i].B_tag)) {
+				if (IQ_WAKEUP && q[i].B_ready)
+					link_consumer(tag, 3*i + 1);
+				q[i].B_ready = false;
+			}
+			if (q[i].D_valid && (tag == q[i].D_tag)) {
+				if (IQ_WAKEUP && q[i].D_ready)
+					link_consumer(tag, 3*i + 2);
+				q[i].D_ready = false;
+			}
+		}
+	}
+}
+
+void issue_queue::link_consumer(unsigned int tag, unsigned int slot) {
+	// Push the slot onto the head of the tag's consumer list.
+	assert(tag < num_phys_regs);
+	assert(!consumer_linked[slot]);
+	consumer_linked[slot] = true;
+	consumer_prev[slot] = -1;
+	consumer_next[slot] = consumer_head[tag];
+	if (consumer_head[tag] != -1)
+		consumer_prev[consumer_head[tag]] = slot;
+	consumer_head[tag] = slot;
+}
+
+void issue_queue::unlink_consumer(unsigned int tag, unsigned int slot) {
+	assert(tag < num_phys_regs);
+	assert(consumer_linked[slot]);
+	consumer_linked[slot] = false;
+	if (consumer_prev[slot] == -1) {
+		assert(consumer_head[tag] == (int)slot);
+		consumer_head[tag] = consumer_next[slot];
+	}
+	else {
+		consumer_next[consumer_prev[slot]] = consumer_next[slot];
+	}
+	if (consumer_next[slot] != -1)
+		consumer_prev[consumer_next[slot]] = consumer_prev[slot];
+}
+
+void issue_queue::update_ready(unsigned int i) {
+	if (q[i].valid && (!q[i].A_valid || q[i].A_ready) && (!q[i].B_valid || q[i].B_ready) && (!q[i].D_valid || q[i].D_ready)) {
+		SET_BIT(ready_bits[i/64], (i%64));
+		unsigned int p = MOD(q[i].age, age_size);
+		SET_BIT(age_ready_bits[p/64], (p%64));
+	}
+}
+
+void issue_queue::clear_ready(unsigned int i) {
+	CLEAR_BIT(ready_bits[i/64], (i%64));
+	unsigned int p = MOD(q[i].age, age_size);
+	CLEAR_BIT(age_ready_bits[p/64], (p%64));
+}
+
+// Bit-scan 'bits' for the lowest set bit in [from, to), or -1 if none.
+static int next_bit(const uint64_t* bits, unsigned int from, unsigned int to) {
+	if (from >= to)
+		return(-1);
+	unsigned int w = from/64;
+	uint64_t word = (bits[w] & (~((uint64_t)0) << (from%64)));
+	while (true) {
+		if (word) {
+			unsigned int i = (w*64) + __builtin_ctzll(word);
+			return((i < to) ? (int)i : -1);
+		}
+		w++;
+		if ((w*64) >= to)
+			return(-1);
+		word = bits[w];
+	}
+}
+
+int issue_queue::next_ready(unsigned int from, unsigned int to) {
+	return(next_bit(ready_bits, from, to));
+}
+
+int issue_queue::next_age_ready(unsigned int from, unsigned int to) {
+	return(next_bit(age_ready_bits, from, to));
+}
+
+void issue_queue::renumber() {
+	// Walk the age-ordered list and move each instruction to the position of its rank.
+	uint64_t n = 0;
+	for (unsigned int w = 0; w < age_size/64; w++) {
+		age_ready_bits[w] = 0;
+	}
+	for (int i = oldest; i != -1; i = q[i].next) {
+		q[i].age = n++;
+		age_entry[q[i].age] = (unsigned int)i;
+		if (BIT_IS_ONE(ready_bits[i/64], (i%64)))
+			SET_BIT(age_ready_bits[q[i].age/64], (q[i].age%64));
+	}
+	age_stamp = n;
+}
+
+bool issue_queue::issue(unsigned int i, unsigned int num_lanes, lane* Execution_Lanes) {
    bool issue;
    unsigned int dyn_lane_id;
+
+   if (PRESTEER) {
+      // Check if the instruction's desired Execution Lane is free.
+      issue = !Execution_Lanes[q[i].lane_id].rr.valid;
+   }
+   else {
+      // Check if there is a free Execution Lane among all candidate lanes.
+      issue = false;
+      dyn_lane_id = 0;
+      while (!issue && (dyn_lane_id < num_lanes)) {
+         if ((q[i].lane_id & (1 << dyn_lane_id)) && !Execution_Lanes[dyn_lane_id].rr.valid) {
+            issue = true;
+            q[i].lane_id = dyn_lane_id;
+         }
+         else {
+            dyn_lane_id++;
+         }
+      }
+   }
+
+   if (issue) {
+      assert(q[i].lane_id < num_lanes);
+      assert(!Execution_Lanes[q[i].lane_id].rr.valid);
+
+      // Issue the instruction to the Register Read Stage within the Execution Lane.
+      Execution_Lanes[q[i].lane_id].rr.valid = true;
+      Execution_Lanes[q[i].lane_id].rr.index = q[i].index;
+      Execution_Lanes[q[i].lane_id].rr.branch_mask = q[i].branch_mask;
+      proc->PAY.buf[q[i].index].issued = true;
+
+      // Remove the instruction from the issue queue.
+      remove(i);
+
+      inc_counter(issued_inst_count);
+   }
+
+   return(issue);
+}
+
+void issue_queue::select_and_issue(unsigned int num_lanes, lane* Execution_Lanes) {
+   if (IQ_SELECT)
+      select_and_issue_bitmap(num_lanes, Execution_Lanes);
+   else
+      select_and_issue_scan(num_lanes, Execution_Lanes);
+}
+
+void issue_queue::select_and_issue_scan(unsigned int num_lanes, lane* Execution_Lanes) {
+   unsigned int i, j;
+   bool ready;
    bool issuedThisCycle = false;
 
    // Set up the first IQ index to be examined this cycle.
@@ -157,42 +413,10 @@ void issue_queue::select_and_issue(unsigned int num_lanes, lane* Execution_Lanes
       assert(!IDEAL_AGE_BASED || q[i].valid);
  
       // Check if the instruction is valid and ready.
-      if (q[i].valid && (!q[i].A_valid || q[i].A_ready) && (!q[i].B_valid || q[i].B_ready) && (!q[i].D_valid || q[i].D_ready)) {
-         if (PRESTEER) {
-            // Check if the instruction's desired Execution Lane is free.
-	    issue = !Execution_Lanes[q[i].lane_id].rr.valid;
-	 }
-	 else {
-	    // Check if there is a free Execution Lane among all candidate lanes.
-            issue = false;
-	    dyn_lane_id = 0;
-	    while (!issue && (dyn_lane_id < num_lanes)) {
-	       if ((q[i].lane_id & (1 << dyn_lane_id)) && !Execution_Lanes[dyn_lane_id].rr.valid) {
-		  issue = true;
-                  q[i].lane_id = dyn_lane_id;
-	       }
-	       else {
-	          dyn_lane_id++;
-	       }
-	    }
-         }
-
-	 if (issue) {
-            assert(q[i].lane_id < num_lanes);
-            assert(!Execution_Lanes[q[i].lane_id].rr.valid);
-
-            // Issue the instruction to the Register Read Stage within the Execution Lane.
-            Execution_Lanes[q[i].lane_id].rr.valid = true;
-            Execution_Lanes[q[i].lane_id].rr.index = q[i].index;
-            Execution_Lanes[q[i].lane_id].rr.branch_mask = q[i].branch_mask;
-
-            // Remove the instruction from the issue queue.
-            remove(i);
-   
-            issuedThisCycle = true;
-            inc_counter(issued_inst_count);
-         }
-      }
+      ready = (q[i].valid && (!q[i].A_valid || q[i].A_ready) && (!q[i].B_valid || q[i].B_ready) && (!q[i].D_valid || q[i].D_ready));
+      assert(ready == BIT_IS_ONE(ready_bits[i/64], (i%64)));
+      if (ready && issue(i, num_lanes, Execution_Lanes))
+         issuedThisCycle = true;
 
       if (IDEAL_AGE_BASED) {
 	 // Set q index to that of the next-oldest instruction, or break from loop if there is no next-oldest instruction.
@@ -219,14 +443,92 @@ void issue_queue::select_and_issue(unsigned int num_lanes, lane* Execution_Lanes
       part_next = 0;
 }
 
+void issue_queue::select_and_issue_bitmap(unsigned int num_lanes, lane* Execution_Lanes) {
+   // Same issue decisions as select_and_issue_scan(), but only the ready entries are visited, in the same order.
+   // Non-ready entries can't issue, and entries can't become ready during select, so skipping them is exact.
+   // Once every Execution Lane is occupied, no further instruction can issue, so select stops early.
+   unsigned int i, start;
+   int r;
+   unsigned int free_lanes = 0;
+   bool issuedThisCycle = false;
+
+   if (IDEAL_AGE_BASED && (length == 0)) {
+      assert((oldest == -1) && (youngest == -1));
+      return;
+   }
+
+   for (i = 0; i < num_lanes; i++) {
+      if (!Execution_Lanes[i].rr.valid)
+         free_lanes++;
+   }
+
+   if (IDEAL_AGE_BASED) {
+      // Visit the ready positions from the oldest instruction's position on, wrapping around: oldest to youngest.
+      start = MOD(q[oldest].age, age_size);
+      for (r = next_age_ready(start, age_size); (r != -1) && (free_lanes > 0); r = next_age_ready((unsigned int)r + 1, age_size)) {
+         if (issue(age_entry[r], num_lanes, Execution_Lanes)) {
+            issuedThisCycle = true;
+            free_lanes--;
+         }
+      }
+      for (r = next_age_ready(0, start); (r != -1) && (free_lanes > 0); r = next_age_ready((unsigned int)r + 1, start)) {
+         if (issue(age_entry[r], num_lanes, Execution_Lanes)) {
+            issuedThisCycle = true;
+            free_lanes--;
+         }
+      }
+   }
+   else {
+      // Visit the ready entries in index order, starting at the partition with priority this cycle and wrapping around.
+      for (r = next_ready(part_next, size); (r != -1) && (free_lanes > 0); r = next_ready((unsigned int)r + 1, size)) {
+         if (issue((unsigned int)r, num_lanes, Execution_Lanes)) {
+            issuedThisCycle = true;
+            free_lanes--;
+         }
+      }
+      for (r = next_ready(0, part_next); (r != -1) && (free_lanes > 0); r = next_ready((unsigned int)r + 1, part_next)) {
+         if (issue((unsigned int)r, num_lanes, Execution_Lanes)) {
+            issuedThisCycle = true;
+            free_lanes--;
+         }
+      }
+   }
+
+   if (issuedThisCycle)
+      inc_counter(issued_bundle_count);
+
+   // Set up the next partition based on round-robin.
+   part_next += part_size;
+   if (part_next == size)
+      part_next = 0;
+}
+
+void issue_queue::skip_cycles(uint64_t num_cycles) {
+   // Nothing issues, but select_and_issue() still sets up the next partition each cycle, unless the IQ is empty with ideal age-based priority.
+   if (IDEAL_AGE_BASED && (length == 0))
+      return;
+   part_next = (unsigned int)((part_next + (num_cycles % (size/part_size))*part_size) % size);
+}
+
 void issue_queue::remove(unsigned int i) {
 	assert(length > 0);
 	assert(fl_length < size);
 
 	// Remove the instruction from the issue queue.
 	q[i].valid = false;
+	clear_ready(i);
 	length--;
 
+	// Remove its not-ready source operands from their consumer lists (squashed instructions).
+	if (IQ_WAKEUP) {
+		if (consumer_linked[3*i])
+			unlink_consumer(q[i].A_tag, 3*i);
+		if (consumer_linked[3*i + 1])
+			unlink_consumer(q[i].B_tag, 3*i + 1);
+		if (consumer_linked[3*i + 2])
+			unlink_consumer(q[i].D_tag, 3*i + 2);
+	}
+
 	// Push the issue queue entry back onto the free list.
 	fl[fl_tail] = i;
 	fl_tail = MOD_S((fl_tail + 1), size);
@@ -280,6 +582,22 @@ void issue_queue::flush() {
 
 	oldest = -1;
 	youngest = -1;
+
+	for (unsigned int w = 0; w < num_words; w++) {
+		ready_bits[w] = 0;
+	}
+	for (unsigned int w = 0; w < age_size/64; w++) {
+		age_ready_bits[w] = 0;
+	}
+	age_stamp = 0;
+
+	// Empty all consumer lists.
+	for (unsigned int i = 0; i < num_phys_regs; i++) {
+		consumer_head[i] = -1;
+	}
+	for (unsigned int i = 0; i < 3*size; i++) {
+		consumer_linked[i] = false;
+	}
 }
 
 void issue_queue::clear_branch_bit(unsigned int branch_ID) {
@@ -34,6 +34,7 @@ typedef struct {
 	// Support for ideal age-based priority.
 	int prev;	// IQ index of previous-oldest instruction still in the IQ.
 	int next;	// IQ index of next-oldest instruction still in the IQ.
+	uint64_t age;	// Dispatch stamp: position MOD(age, age_size) in the age-ordered ready bitmap.
 
 } issue_queue_entry_t;
 
@@ -65,18 +66,60 @@ private:
 	unsigned int fl_tail;		// Tail of issue queue's free list.
 	unsigned int fl_length;			// Length of issue queue's free list.
 
+	// Event-driven wakeup (IQ_WAKEUP == 1).
+	// Each issue queue entry has three source operand slots: slot (3*i + k) is operand k (0: A, 1: B, 2: D) of entry i.
+	// A not-ready source operand is linked into the consumer list of its physical register at dispatch.
+	// Wakeup of a physical register visits only the slots on its consumer list, instead of broadcasting
+	// the tag to every issue queue entry.
+	unsigned int num_phys_regs;	// Number of physical registers, i.e., number of consumer lists.
+	int* consumer_head;		// Head slot of each physical register's consumer list (-1 if empty).
+	int* consumer_prev;		// Doubly-linked consumer list: previous slot.
+	int* consumer_next;		// Doubly-linked consumer list: next slot.
+	bool* consumer_linked;		// The slot is linked into the consumer list of its operand's tag.
+
+	void link_consumer(unsigned int tag, unsigned int slot);	// Add a slot to the tag's consumer list.
+	void unlink_consumer(unsigned int tag, unsigned int slot);	// Remove a slot from the tag's consumer list.
+
+	// Ready-bitmap select (IQ_SELECT == 1).
+	// Bit i of the ready bitmap is set when issue queue entry i is valid and all of its source operands are ready.
+	// Select finds the ready entries with bit-scans instead of testing every issue queue entry.
+	uint64_t* ready_bits;		// Ready bitmap, 64 entries per word.
+	unsigned int num_words;		// Number of words in the ready bitmap.
+
+	// Age-ordered ready bitmap, for ideal age-based select with the ready bitmap.
+	// Each dispatched instruction takes the next position in a circular space of age_size positions,
+	// so from the oldest instruction's position on, the positions are in dispatch order (the order of the age-ordered list).
+	// Bit p is set when the instruction at position p is ready. Before the positions would wrap around onto the
+	// oldest instruction, the instructions in the IQ are renumbered compactly in age order (at most once per 3*size dispatches).
+	uint64_t* age_ready_bits;	// Ready bitmap by position, 64 positions per word.
+	unsigned int* age_entry;	// IQ index of the instruction at each position.
+	unsigned int age_size;		// Number of positions: a power of two, at least 4*size.
+	uint64_t age_stamp;		// Dispatch stamp of the next dispatched instruction.
+
+	void update_ready(unsigned int i);	// Set entry i's ready bit if it is valid and all of its source operands are ready.
+	void clear_ready(unsigned int i);	// Clear entry i's ready bit.
+	int next_ready(unsigned int from, unsigned int to);	// Lowest ready entry in [from, to), or -1 if none.
+	int next_age_ready(unsigned int from, unsigned int to);	// Lowest ready position in [from, to), or -1 if none.
+	void renumber();	// Give the instructions in the IQ consecutive dispatch stamps, in age order.
+	bool issue(unsigned int i, unsigned int num_lanes, lane* Execution_Lanes);	// Try to issue entry i to a free Execution Lane.
+	void select_and_issue_scan(unsigned int num_lanes, lane* Execution_Lanes);
+	void select_and_issue_bitmap(unsigned int num_lanes, lane* Execution_Lanes);
+
 	void remove(unsigned int i);	// Remove the instruction in issue queue entry 'i' from the issue queue.
 
 
 public:
-	issue_queue(unsigned int size, unsigned int num_parts, pipeline_t* _proc=NULL);	// constructor
+	issue_queue(unsigned int size, unsigned int num_parts, unsigned int num_phys_regs, pipeline_t* _proc=NULL);	// constructor
 	bool stall(unsigned int bundle_inst);
+	unsigned int get_length() { return(length); }
 	void dispatch(unsigned int index, unsigned long long branch_mask, unsigned int lane_id,
 	              bool A_valid, bool A_ready, unsigned int A_tag,
 	              bool B_valid, bool B_ready, unsigned int B_tag,
 	              bool D_valid, bool D_ready, unsigned int D_tag);
 	void wakeup(unsigned int tag);
+	void replay(unsigned int tag);
 	void select_and_issue(unsigned int num_lanes, lane* Execution_Lanes);
+	void skip_cycles(uint64_t num_cycles);	// Idle-cycle fast-forward: select_and_issue() with nothing ready, 'num_cycles' times.
 	void flush();
 	void clear_branch_bit(unsigned int branch_ID);
 	void squash(unsigned int branch_ID);
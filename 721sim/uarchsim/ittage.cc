@@ -0,0 +1,364 @@
+#include <cinttypes>
+#include <cstdio>
+#include <cassert>
+#include <cmath>
+#include "decode.h"
+#include "fetchunit_types.h"
+#include "BPinterface.h"
+#include "ittage.h"
+
+////////////////////////////////////////////////////
+// ITTAGE indirect branch target predictor.
+//
+// Global history: the direction of every conditional
+// branch, and ITTAGE_PATH_BITS bits of the target of
+// every taken branch.
+////////////////////////////////////////////////////
+
+ittage_t::ittage_t(uint64_t num_tables, uint64_t log2_size, uint64_t min_hist, uint64_t max_hist, uint64_t width, uint64_t bq_size):
+   num_tables(num_tables),
+   log2_size(log2_size),
+   width(width) {
+
+   assert((num_tables > 0) && (num_tables <= ITTAGE_MAX_TABLES));
+   assert((log2_size > 0) && (log2_size <= 24));
+   assert((min_hist > 0) && (min_hist <= max_hist));
+
+   // History lengths form a geometric series from min_hist to max_hist.
+   // Tags are wider for longer histories.
+   for (uint64_t i = 0; i < num_tables; i++) {
+      if (num_tables == 1)
+         hist_length[i] = max_hist;
+      else
+         hist_length[i] = (uint64_t)(min_hist * pow((double)max_hist/(double)min_hist, (double)i/(double)(num_tables - 1)) + 0.5);
+      tag_width[i] = (9 + (i >> 1));
+
+      fold_init(index_fold[i], hist_length[i], log2_size);
+      fold_init(tag_fold[0][i], hist_length[i], tag_width[i]);
+      fold_init(tag_fold[1][i], hist_length[i], tag_width[i] - 1);
+   }
+
+   // Memory-allocate the tables.
+   base = new ittage_base_entry_t[1 << log2_size]();
+   table = new ittage_entry_t *[num_tables];
+   for (uint64_t i = 0; i < num_tables; i++)
+      table[i] = new ittage_entry_t[1 << log2_size]();
+
+   // The circular global history buffer must hold the longest history plus the history bits of all in-flight branches:
+   // those in the branch queue and those in the Fetch2 bundle, each inserting up to one direction bit and ITTAGE_PATH_BITS target bits.
+   uint64_t ghist_size = 1;
+   while (ghist_size < (max_hist + (bq_size + width) * (1 + ITTAGE_PATH_BITS)))
+      ghist_size <<= 1;
+   ghist = new uint8_t[ghist_size]();
+   ghist_mask = (ghist_size - 1);
+
+   ctx.pos = 0;
+   hist_rebuild(ctx);
+   fetch2_ctx = ctx;
+   log_ctx = ctx;
+
+   // Memory-allocate the branch log.
+   log = new ittage_log_t[bq_size]();	// zeroed: flush() may consult the entry of an empty branch queue
+
+   seed = 0;
+
+   meas_commit = 0;
+   meas_provider = 0;
+   meas_alloc = 0;
+}
+
+ittage_t::~ittage_t() {
+}
+
+/////////////////////////////////////
+// Private utility functions.
+/////////////////////////////////////
+
+void ittage_t::fold_init(ittage_fold_t &f, uint64_t olength, uint64_t clength) {
+   f.olength = olength;
+   f.clength = clength;
+   f.outpoint = (olength % clength);
+}
+
+// Insert "bit", the history bit at position "pos", into the folded history "comp", and evict the bit that is now "olength" positions older.
+uint32_t ittage_t::fold_update(const ittage_fold_t &f, uint32_t comp, bool bit, uint64_t pos) {
+   comp = ((comp << 1) | (bit ? 1 : 0));
+   comp ^= (ghist[(pos - f.olength) & ghist_mask] << f.outpoint);
+   comp ^= (comp >> f.clength);
+   return(comp & ((1 << f.clength) - 1));
+}
+
+// Fold the "olength" history bits prior to position "pos", from scratch.
+uint32_t ittage_t::fold_rebuild(const ittage_fold_t &f, uint64_t pos) {
+   uint32_t comp = 0;
+   for (uint64_t p = (pos - f.olength); p != pos; p++) {
+      comp = ((comp << 1) | ghist[p & ghist_mask]);
+      comp ^= (comp >> f.clength);
+      comp &= ((1 << f.clength) - 1);
+   }
+   return(comp);
+}
+
+// Insert a history bit into context "c".
+// If not "write", the bit is already in the circular buffer, and only the context's position and folded histories advance.
+void ittage_t::hist_push(ittage_context_t &c, bool bit, bool write) {
+   if (write)
+      ghist[c.pos & ghist_mask] = (bit ? 1 : 0);
+   for (uint64_t i = 0; i < num_tables; i++) {
+      c.index[i] = fold_update(index_fold[i], c.index[i], bit, c.pos);
+      c.tag[0][i] = fold_update(tag_fold[0][i], c.tag[0][i], bit, c.pos);
+      c.tag[1][i] = fold_update(tag_fold[1][i], c.tag[1][i], bit, c.pos);
+   }
+   c.pos++;
+}
+
+// Insert ITTAGE_PATH_BITS bits of the target of a taken branch into context "c".
+void ittage_t::hist_push_target(ittage_context_t &c, uint64_t target) {
+   uint64_t h = (target >> 2);
+   h = (h ^ (h >> ITTAGE_PATH_BITS) ^ (h >> (2*ITTAGE_PATH_BITS)));
+   for (uint64_t i = 0; i < ITTAGE_PATH_BITS; i++)
+      hist_push(c, ((h >> i) & 1));
+}
+
+// Recompute the folded histories of context "c" from the circular buffer.
+void ittage_t::hist_rebuild(ittage_context_t &c) {
+   for (uint64_t i = 0; i < num_tables; i++) {
+      c.index[i] = fold_rebuild(index_fold[i], c.pos);
+      c.tag[0][i] = fold_rebuild(tag_fold[0][i], c.pos);
+      c.tag[1][i] = fold_rebuild(tag_fold[1][i], c.pos);
+   }
+}
+
+// Compute the base table index, and the tagged tables' indices and tags, for "pc" in context "c".
+void ittage_t::compute(const ittage_context_t &c, uint64_t pc, uint64_t &base_index, uint64_t index[], uint64_t tag[]) {
+   uint64_t mask = ((1 << log2_size) - 1);
+   pc = (pc >> 2);
+   base_index = (pc & mask);
+   for (uint64_t i = 0; i < num_tables; i++) {
+      index[i] = ((pc ^ (pc >> (log2_size - (i % log2_size))) ^ c.index[i]) & mask);
+      tag[i] = ((pc ^ c.tag[0][i] ^ (c.tag[1][i] << 1)) & ((1 << tag_width[i]) - 1));
+   }
+}
+
+// Returns the predicted target.
+// Outputs the provider, the longest matching tagged table (-1 if none: the base table), and the alternate, the next longest matching
+// tagged table (-1 if none: the base table).
+// The alternate provides the prediction if the provider's confidence is null (e.g., a newly allocated entry).
+uint64_t ittage_t::lookup(uint64_t base_index, const uint64_t index[], const uint64_t tag[], int &provider, int &alt) {
+   provider = -1;
+   alt = -1;
+   for (int i = (int)num_tables - 1; i >= 0; i--) {
+      if (table[i][index[i]].tag == tag[i]) {
+         if (provider < 0) {
+            provider = i;
+         }
+         else {
+            alt = i;
+            break;
+         }
+      }
+   }
+
+   if ((provider >= 0) && (table[provider][index[provider]].ctr > 0))
+      return(table[provider][index[provider]].target);
+   else if (alt >= 0)
+      return(table[alt][index[alt]].target);
+   else
+      return(base[base_index].target);
+}
+
+/////////////////////////////////////
+// ittage_t member functions
+/////////////////////////////////////
+
+uint64_t ittage_t::predict(uint64_t pc) {
+   uint64_t base_index;
+   uint64_t index[ITTAGE_MAX_TABLES];
+   uint64_t tag[ITTAGE_MAX_TABLES];
+   int provider;
+   int alt;
+
+   compute(ctx, pc, base_index, index, tag);
+   return(lookup(base_index, index, tag, provider, alt));
+}
+
+void ittage_t::save_fetch2_context() {
+   fetch2_ctx = ctx;
+}
+
+void ittage_t::spec_update(uint64_t predictions, uint64_t num,                  /* used: for speculatively updating branch history */
+                           uint64_t pc, uint64_t next_pc,                       /* used: for speculatively updating path history */
+		           bool pop_ras, bool push_ras, uint64_t push_ras_pc) { /* used: a call or return ends the fetch bundle at a taken branch */
+   // The fetch bundle ends at a taken branch if its last conditional branch is predicted taken, if it ends at a call or return,
+   // or if the next fetch bundle does not start sequentially after it (a jump).
+   bool taken_end = (((num > 0) && (((predictions >> (num - 1)) & 1) == 1)) ||
+                     pop_ras || push_ras ||
+                     (next_pc <= pc) || (next_pc > (pc + (width << 2))));
+
+   for (uint64_t i = 0; i < num; i++) {
+      hist_push(ctx, ((predictions & 1) == 1));
+      predictions = (predictions >> 1);
+   }
+
+   if (taken_end)
+      hist_push_target(ctx, next_pc);
+}
+
+void ittage_t::restore_fetch2_context() {
+   ctx = fetch2_ctx;
+}
+
+void ittage_t::log_begin() {
+   log_ctx = fetch2_ctx;
+}
+
+void ittage_t::log_branch(uint64_t log_id,
+                          btb_branch_type_e branch_type,
+                          bool taken,
+                          uint64_t pc, uint64_t next_pc) {
+   log[log_id].precise = log_ctx;
+
+   // The prediction was made at the start of the fetch bundle, in the context prior to it.
+   if ((branch_type == BTB_JUMP_INDIRECT) || (branch_type == BTB_CALL_INDIRECT))
+      compute(fetch2_ctx, pc, log[log_id].base_index, log[log_id].index, log[log_id].tag);
+
+   // A conditional branch's direction was inserted into the circular buffer by spec_update() in the Fetch1 stage.
+   // Any other branch, or a taken conditional branch, ends the fetch bundle.
+   if (branch_type == BTB_BRANCH)
+      hist_push(log_ctx, taken, false);
+}
+
+void ittage_t::mispredict(uint64_t log_id, bool iscond, bool taken, uint64_t next_pc) {
+   ctx = log[log_id].precise;
+   if (iscond)
+      hist_push(ctx, taken);
+   if (taken)
+      hist_push_target(ctx, next_pc);
+}
+
+void ittage_t::flush(uint64_t log_id) {
+   // If the branch queue is empty, the log entry is stale (its branch committed or was squashed), and the circular buffer
+   // may have moved on: rebuild the folded histories so that they are at least consistent with the buffer.
+   ctx = log[log_id].precise;
+   hist_rebuild(ctx);
+}
+
+void ittage_t::commit(uint64_t log_id,
+                      // Original fetch bundle PC:
+                      uint64_t pc,
+		      // Unused (conditional branches):
+		      uint64_t branch_in_bundle,
+		      bool taken,
+		      // The branch's target:
+		      uint64_t next_pc) {
+   uint64_t base_index = log[log_id].base_index;
+   uint64_t *index = log[log_id].index;
+   uint64_t *tag = log[log_id].tag;
+   int provider;
+   int alt;
+   uint64_t pred_target;
+   uint64_t alt_target;
+   bool use_alt;
+
+   // Re-reference the tables, using the same context that was used by the fetch bundle that this branch was a part of.
+   pred_target = lookup(base_index, index, tag, provider, alt);
+   alt_target = ((alt >= 0) ? table[alt][index[alt]].target : base[base_index].target);
+   use_alt = ((provider < 0) || (table[provider][index[provider]].ctr == 0));
+
+   meas_commit++;
+   if (!use_alt)
+      meas_provider++;
+
+   // Train the provider.
+   if (provider >= 0) {
+      ittage_entry_t *e = &(table[provider][index[provider]]);
+
+      // Its usefulness: whether it is right where the alternate is wrong.
+      if ((e->target == next_pc) != (alt_target == next_pc)) {
+         if (e->target == next_pc) {
+            if (e->u < ITTAGE_U_MAX)
+               e->u++;
+         }
+         else {
+            if (e->u > 0)
+               e->u--;
+         }
+      }
+
+      // Its target, with hysteresis.
+      if (e->target == next_pc) {
+         if (e->ctr < ITTAGE_CTR_MAX)
+            e->ctr++;
+      }
+      else if (e->ctr > 0) {
+         e->ctr--;
+      }
+      else {
+         e->target = next_pc;
+      }
+   }
+
+   // Train the alternate, if it provided the prediction.
+   if (use_alt) {
+      uint64_t *target;
+      uint8_t *ctr;
+      if (alt >= 0) {
+         target = &(table[alt][index[alt]].target);
+         ctr = &(table[alt][index[alt]].ctr);
+      }
+      else {
+         target = &(base[base_index].target);
+         ctr = &(base[base_index].ctr);
+      }
+
+      if (*target == next_pc) {
+         if (*ctr < ITTAGE_CTR_MAX)
+            (*ctr)++;
+      }
+      else if (*ctr > 0) {
+         (*ctr)--;
+      }
+      else {
+         *target = next_pc;
+      }
+   }
+
+   // On a misprediction, allocate entries in up to ITTAGE_ALLOC tables with longer histories than the provider's.
+   // As in TAGE, the first candidate table is randomly the next one or the one after, and a table is skipped after each allocation:
+   // always allocating in the shortest free table would let the new, not yet useful entries of conflicting branches evict each other.
+   // If all candidate entries are useful, age them instead.
+   if (pred_target != next_pc) {
+      uint64_t start = (uint64_t)(provider + 1);
+      uint64_t num_alloc = 0;
+
+      seed = ((seed * 1103515245) + 12345);
+      if (((seed >> 16) & 1) && ((start + 1) < num_tables))
+         start++;
+
+      for (uint64_t i = start; (i < num_tables) && (num_alloc < ITTAGE_ALLOC); i++) {
+         if (table[i][index[i]].u == 0) {
+            table[i][index[i]].tag = tag[i];
+            table[i][index[i]].target = next_pc;
+            table[i][index[i]].ctr = 0;
+            meas_alloc++;
+            num_alloc++;
+            i++;
+         }
+      }
+      if (num_alloc == 0) {
+         for (uint64_t i = start; i < num_tables; i++)
+            table[i][index[i]].u--;
+      }
+   }
+}
+
+void ittage_t::dump_stats(FILE *fp) {
+   fprintf(fp, "ITTAGE MEASUREMENTS--------------------------------\n");
+   fprintf(fp, "Tables        = base + %lu tagged x %lu entries, history lengths:", num_tables, ((uint64_t)1 << log2_size));
+   for (uint64_t i = 0; i < num_tables; i++)
+      fprintf(fp, " %lu", hist_length[i]);
+   fprintf(fp, "\n");
+   fprintf(fp, "Committed indirect branches = %lu\n", meas_commit);
+   fprintf(fp, "Tagged-table predictions    = %lu (%.2f%%)\n", meas_provider, (meas_commit ? (100.0*((double)meas_provider/(double)meas_commit)) : 0.0));
+   fprintf(fp, "Tagged-table allocations    = %lu\n", meas_alloc);
+}
@@ -0,0 +1,189 @@
+////////////////////////////////////////////////////
+// ITTAGE indirect branch target predictor.
+//
+// A tagless base table indexed by PC, backed by
+// tagged tables indexed with geometrically longer
+// global histories. The longest matching table
+// provides the target.
+//
+// Like the gshare indirect predictor, it is indexed
+// with the start PC of the fetch bundle.
+////////////////////////////////////////////////////
+
+#define ITTAGE_MAX_TABLES	16	// maximum number of tagged tables
+#define ITTAGE_PATH_BITS	2	// global history bits inserted for the target of a taken branch
+#define ITTAGE_CTR_MAX		3	// 2-bit confidence counter
+#define ITTAGE_U_MAX		3	// 2-bit useful counter
+#define ITTAGE_ALLOC		2	// maximum number of entries allocated on a misprediction
+
+
+// The geometry of a folded history: the 'olength' most recent global history bits, compressed to 'clength' bits
+// by XOR-ing 'clength'-bit chunks. It is updated incrementally, one inserted and one evicted history bit at a time.
+typedef
+struct {
+   uint32_t clength;
+   uint32_t olength;
+   uint32_t outpoint;	// olength % clength: where the evicted bit is folded in
+} ittage_fold_t;
+
+// The speculative history context.
+// The global history bits themselves are kept in a circular buffer, in which positions are not wrapped:
+// restoring the context only restores the position of the next history bit, and the folded histories.
+typedef
+struct {
+   uint64_t pos;				// position of the next history bit in the circular buffer
+   uint32_t index[ITTAGE_MAX_TABLES];		// folded histories for table indices
+   uint32_t tag[2][ITTAGE_MAX_TABLES];		// folded histories for tags (two different lengths, as in TAGE)
+} ittage_context_t;
+
+// A tagged table entry.
+typedef
+struct {
+   uint64_t tag;
+   uint64_t target;
+   uint8_t ctr;		// confidence
+   uint8_t u;		// usefulness
+} ittage_entry_t;
+
+// A base table entry.
+typedef
+struct {
+   uint64_t target;
+   uint8_t ctr;		// confidence
+} ittage_base_entry_t;
+
+
+class ittage_log_t {
+   public:
+      ittage_context_t precise;	// Precise context (all prior branches included).  Restore this context after a misprediction or flush.
+
+      // Indirect branches only: the base and tagged table entries referenced by the prediction, for training the tables at commit.
+      // They are computed from the context prior to the fetch bundle containing this branch.
+      uint64_t base_index;
+      uint64_t index[ITTAGE_MAX_TABLES];
+      uint64_t tag[ITTAGE_MAX_TABLES];
+};
+
+
+class ittage_t : public BPinterface_t {
+   private:
+      // Geometry.
+      uint64_t num_tables;			// number of tagged tables
+      uint64_t log2_size;			// log2 of the number of entries of each table (tagged tables and base table)
+      uint64_t hist_length[ITTAGE_MAX_TABLES];	// history length of each tagged table (geometric series)
+      uint64_t tag_width[ITTAGE_MAX_TABLES];	// tag width of each tagged table
+      uint64_t width;				// fetch bundle width (number of instructions)
+
+      // Geometry of the folded histories, see ittage_context_t.
+      ittage_fold_t index_fold[ITTAGE_MAX_TABLES];
+      ittage_fold_t tag_fold[2][ITTAGE_MAX_TABLES];
+
+      // The tables.
+      ittage_base_entry_t *base;		// [1 << log2_size]
+      ittage_entry_t **table;			// [num_tables][1 << log2_size]
+
+      // Speculative global history: the circular buffer and the current context.
+      // The buffer holds the longest history plus the history bits of all in-flight branches.
+      uint8_t *ghist;
+      uint64_t ghist_mask;
+      ittage_context_t ctx;
+
+      // Pseudo-random state for allocation.
+      uint64_t seed;
+
+      // Context prior to the fetch2 bundle: used in the FETCH2 stage to either restore the context in the case of a misfetch or log the context.
+      ittage_context_t fetch2_ctx;
+
+      // Temp for logging the precise context.
+      ittage_context_t log_ctx;
+
+      // The branch log.
+      ittage_log_t *log;
+
+      // Measurements.
+      uint64_t meas_commit;	// committed indirect branches
+      uint64_t meas_provider;	// ... predicted by a tagged table
+      uint64_t meas_alloc;	// tagged entries allocated
+
+      ////////////////////////////////////
+      // Private utility functions.
+      // Comments are in ittage.cc.
+      ////////////////////////////////////
+
+      void fold_init(ittage_fold_t &f, uint64_t olength, uint64_t clength);
+      uint32_t fold_update(const ittage_fold_t &f, uint32_t comp, bool bit, uint64_t pos);
+      uint32_t fold_rebuild(const ittage_fold_t &f, uint64_t pos);
+      void hist_push(ittage_context_t &c, bool bit, bool write = true);
+      void hist_push_target(ittage_context_t &c, uint64_t target);
+      void hist_rebuild(ittage_context_t &c);
+      void compute(const ittage_context_t &c, uint64_t pc, uint64_t &base_index, uint64_t index[], uint64_t tag[]);
+      uint64_t lookup(uint64_t base_index, const uint64_t index[], const uint64_t tag[], int &provider, int &alt);
+
+   public:
+      ittage_t(uint64_t num_tables, uint64_t log2_size, uint64_t min_hist, uint64_t max_hist, uint64_t width, uint64_t bq_size);
+      ~ittage_t();
+
+      ///////////////////////////////////////////////
+      // Called by the Fetch Unit's FETCH1 stage.
+      ///////////////////////////////////////////////
+
+      // Get 1 indirect target prediction.
+      // "pc" is the start PC of the fetch bundle.
+      uint64_t predict(uint64_t pc);
+
+      // Save the context in the fetch2_ctx register.
+      void save_fetch2_context();
+
+      // Speculatively update the global history with "num" predictions from "predictions" and, if the fetch bundle ends at a taken branch, with "next_pc".
+      void spec_update(uint64_t predictions, uint64_t num,                  /* used: for speculatively updating branch history */
+                       uint64_t pc, uint64_t next_pc,                       /* used: for speculatively updating path history */
+		       bool pop_ras, bool push_ras, uint64_t push_ras_pc);  /* used: a call or return ends the fetch bundle at a taken branch */
+
+      ///////////////////////////////////////////////
+      // Called by the Fetch Unit's FETCH2 stage.
+      ///////////////////////////////////////////////
+
+      // Misfetch: restore the context to fetch2_ctx.
+      void restore_fetch2_context();
+
+      // Begin logging.  Simply sets log_ctx to fetch2_ctx.
+      void log_begin();
+
+      // Log a branch: record the precise context (log_ctx) and, for an indirect branch, the table entries of its prediction.
+      // If it is a conditional branch, also update the ongoing log_ctx based on "taken".
+      void log_branch(uint64_t log_id,
+                      btb_branch_type_e branch_type,
+                      bool taken,
+                      uint64_t pc, uint64_t next_pc);
+
+      ///////////////////////////////////////////////
+      // Called when a branch resolves.
+      ///////////////////////////////////////////////
+
+      // Restore the context to the indicated checkpointed context.
+      // Then update the global history with the branch's corrected outcome: its direction, if it is a conditional branch ("iscond"),
+      // and its target ("next_pc"), if it is taken.
+      void mispredict(uint64_t log_id, bool iscond, bool taken, uint64_t next_pc);
+
+      ///////////////////////////////////////////////
+      // Called when there is a full pipeline flush.
+      ///////////////////////////////////////////////
+
+      void flush(uint64_t log_id);
+
+      ///////////////////////////////////////////////
+      // Called when a branch retires.
+      ///////////////////////////////////////////////
+
+      // Train the tables for the indicated indirect branch.
+      void commit(uint64_t log_id,
+                  // Original fetch bundle PC:
+                  uint64_t pc,
+		  // Unused (conditional branches):
+		  uint64_t branch_in_bundle,
+		  bool taken,
+		  // The branch's target:
+		  uint64_t next_pc);
+
+      void dump_stats(FILE *fp);
+};
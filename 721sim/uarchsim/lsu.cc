@@ -14,30 +14,52 @@ bool lsu::disambiguate(unsigned int lq_index,
 	bool stall;		// return value
 	uint64_t max_size;
 	uint64_t mask;
+	uint64_t* bucket;
+	unsigned int lo, hi;
+	bool wrapped;
+	int entry;
 
-	// Check if the load is logically at the head of the SQ, i.e., no prior stores.
-	if ((sq_index == sq_head) && (sq_index_phase == sq_head_phase)) {
-		// There are no stores prior to the load.
-		stall = false;
-		forward = false;
-	}
-	else {
-		stall = false;
-		forward = false;
+	stall = false;
+	forward = false;
 
+	// Check if the load is logically at the head of the SQ, i.e., no prior stores.
+	if (!((sq_index == sq_head) && (sq_index_phase == sq_head_phase))) {
 		// Because the load is not logically at the head of the SQ,
 		// it must be true that the SQ has at least one store.
 		assert(sq_length > 0);
 
-		store_entry = sq_index;
-		do {
-			store_entry = MOD_S((store_entry + sq_size - 1), sq_size);
+		// The only stores that can stall or forward to the load: those whose address is in the load's bucket,
+		// and those whose address is unknown if the load stalls on them (prediction says to): all of them,
+		// or only the store that store sets predict it depends on.
+		bucket = &sq_bucket[sq_bucket_of(LQ[lq_index].addr) * sq_words];
+		for (unsigned int w = 0; w < sq_words; w++)
+			sq_cand[w] = (bucket[w] | (LQ[lq_index].mdp_stall ? sq_addr_unknown[w] : 0));
+		if (LQ[lq_index].ss_dep)
+			sq_cand[LQ[lq_index].ss_store/64] |= (sq_addr_unknown[LQ[lq_index].ss_store/64] & (((uint64_t)1) << (LQ[lq_index].ss_store%64)));
+
+		// Visit the candidates among the prior stores, from the youngest one back to the SQ head,
+		// as a walk of the SQ would. The prior stores may wrap around the end of the SQ.
+		wrapped = (sq_index <= sq_head);
+		lo = (wrapped ? 0 : sq_head);
+		hi = sq_index;
+		while (!stall && !forward) {
+			entry = sq_prev_cand(lo, hi);
+			if (entry < 0) {
+				if (!wrapped)
+					break;
+				wrapped = false;
+				lo = sq_head;
+				hi = sq_size;
+				continue;
+			}
+			store_entry = (unsigned int)entry;
+			hi = store_entry;
 
 			max_size = MAX(SQ[store_entry].size, LQ[lq_index].size);
 			mask = (~(max_size - 1));
 
 			if (!SQ[store_entry].addr_avail) {
-				stall = LQ[lq_index].mdp_stall;  // stall (if prediction says to): possible conflict
+				stall = (LQ[lq_index].mdp_stall || (LQ[lq_index].ss_dep && (store_entry == LQ[lq_index].ss_store)));  // stall (if prediction says to): possible conflict
 				if (stall)
 				   LQ[lq_index].stat_load_stall_disambig_addrunknown = true;
 			}
@@ -54,7 +76,7 @@ bool lsu::disambiguate(unsigned int lq_index,
 					forward = true;    // forward: sizes match and value is available
 				}
 			}
-		} while ((store_entry != sq_head) && !stall && !forward);
+		}
 	}
 
 	return(stall);
@@ -83,6 +105,8 @@ bool lsu::ld_violation(unsigned int sq_index,
       if (match && LQ[load_entry].value_avail) {
          misp = true;
 	 // STATS, and feedback to the memory dependence predictor.
+	 if (!LQ[load_entry].stat_load_violation)
+	    LQ[load_entry].stat_violation_store_pc = proc->PAY.buf[SQ[sq_index].pay_index].pc;
 	 LQ[load_entry].stat_load_violation = true;
       }
       else {
@@ -99,6 +123,138 @@ bool lsu::ld_violation(unsigned int sq_index,
    return(misp);
 } // ld_violation()
 
+// Store Queue index: the bucket of an address (by 8-byte block).
+unsigned int lsu::sq_bucket_of(reg_t addr) {
+	return((unsigned int)((addr >> 3) & (sq_buckets - 1)));
+}
+
+// The address of the store in SQ entry 'sq_index' is now available.
+void lsu::sq_index_add(unsigned int sq_index) {
+	CLEAR_BIT(sq_addr_unknown[sq_index/64], (sq_index%64));
+	SET_BIT(sq_bucket[(sq_bucket_of(SQ[sq_index].addr) * sq_words) + (sq_index/64)], (sq_index%64));
+}
+
+// The store in SQ entry 'sq_index' leaves the SQ (committed or squashed).
+void lsu::sq_index_remove(unsigned int sq_index) {
+	CLEAR_BIT(sq_addr_unknown[sq_index/64], (sq_index%64));
+	if (SQ[sq_index].addr_avail)
+		CLEAR_BIT(sq_bucket[(sq_bucket_of(SQ[sq_index].addr) * sq_words) + (sq_index/64)], (sq_index%64));
+	for (unsigned int w = 0; w < lq_words; w++)
+		sq_waiters[(sq_index * lq_words) + w] = 0;
+
+	// Later loads of the store's store set no longer depend on it.
+	if (SQ[sq_index].ss_valid && LFST[SQ[sq_index].ssid].valid && (LFST[SQ[sq_index].ssid].sq_index == sq_index))
+		LFST[SQ[sq_index].ssid].valid = false;
+}
+
+int lsu::sq_prev_cand(unsigned int from, unsigned int to) {
+	// Bit-scan the candidate stores for the highest entry in [from, to).
+	if (from >= to)
+		return(-1);
+	unsigned int w = (to - 1)/64;
+	uint64_t bits = (sq_cand[w] & (~((uint64_t)0) >> (63 - ((to - 1)%64))));
+	while (true) {
+		if (bits) {
+			unsigned int i = (w*64) + 63 - __builtin_clzll(bits);
+			return((i >= from) ? (int)i : -1);
+		}
+		if ((w*64) <= from)
+			return(-1);
+		w--;
+		bits = sq_cand[w];
+	}
+}
+
+int lsu::lq_next_stalled(unsigned int from, unsigned int to) {
+	// Bit-scan the stalled loads for the lowest entry in [from, to).
+	if (from >= to)
+		return(-1);
+	unsigned int w = from/64;
+	uint64_t bits = (lq_stalled[w] & (~((uint64_t)0) << (from%64)));
+	while (true) {
+		if (bits) {
+			unsigned int i = (w*64) + __builtin_ctzll(bits);
+			return((i < to) ? (int)i : -1);
+		}
+		w++;
+		if ((w*64) >= to)
+			return(-1);
+		bits = lq_stalled[w];
+	}
+}
+
+// The store in SQ entry 'sq_index' produced its address or value, or committed: wake up the loads it stalled.
+void lsu::wake_waiters(unsigned int sq_index) {
+	for (unsigned int w = 0; w < lq_words; w++) {
+		lq_wake[w] |= sq_waiters[(sq_index * lq_words) + w];
+		sq_waiters[(sq_index * lq_words) + w] = 0;
+	}
+}
+
+// The address of the store in SQ entry 'sq_index' is now available: wake up the stalled loads after it
+// (from LQ entry 'lq_index' to the tail) that it conflicts with. They may now forward from it or stall on it.
+void lsu::wake_matching(unsigned int sq_index, unsigned int lq_index, bool lq_index_phase) {
+	bool wrapped = ((lq_index > lq_tail) || ((lq_index == lq_tail) && (lq_index_phase != lq_tail_phase)));
+	uint64_t max_size;
+	uint64_t mask;
+	int scan;
+
+	for (unsigned int seg = 0; seg < (wrapped ? 2 : 1); seg++) {
+		unsigned int from = (seg ? 0 : lq_index);
+		unsigned int to = ((wrapped && !seg) ? lq_size : lq_tail);
+		for (scan = lq_next_stalled(from, to); scan >= 0; scan = lq_next_stalled((scan + 1), to)) {
+			max_size = MAX(SQ[sq_index].size, LQ[scan].size);
+			mask = (~(max_size - 1));
+			if ((SQ[sq_index].addr & mask) == (LQ[scan].addr & mask))
+				SET_BIT(lq_wake[scan/64], (scan%64));
+		}
+	}
+}
+
+// Bookkeeping after running the load in LQ entry 'lq_index' through the load execution datapath:
+// if it stalled, record what it waits for. 'stall_store' indicates that the store in SQ entry 'store_entry' stalled it.
+void lsu::record_stall(unsigned int lq_index, bool stall_store, unsigned int store_entry) {
+	unsigned int w = lq_index/64;
+	unsigned int b = lq_index%64;
+
+	CLEAR_BIT(lq_wake[w], b);
+	if (LQ[lq_index].value_avail) {
+		CLEAR_BIT(lq_stalled[w], b);
+		CLEAR_BIT(lq_poll[w], b);
+		return;
+	}
+
+	SET_BIT(lq_stalled[w], b);
+	if (LQ[lq_index].amo || (!PERFECT_DCACHE && (LQ[lq_index].miss_resolve_cycle == (cycle_t)-1)))
+		SET_BIT(lq_poll[w], b);
+	else
+		CLEAR_BIT(lq_poll[w], b);
+
+	LQ[lq_index].stall_store = stall_store;
+	if (stall_store)
+		SET_BIT(sq_waiters[(store_entry * lq_words) + w], b);
+	else if (LQ[lq_index].missed)
+		lq_next_resolve = MIN(lq_next_resolve, LQ[lq_index].miss_resolve_cycle);
+}
+
+// The load in LQ entry 'lq_index' is no longer stalled (squashed or dispatched anew).
+void lsu::clear_stalled(unsigned int lq_index) {
+	CLEAR_BIT(lq_stalled[lq_index/64], (lq_index%64));
+	CLEAR_BIT(lq_wake[lq_index/64], (lq_index%64));
+	CLEAR_BIT(lq_poll[lq_index/64], (lq_index%64));
+}
+
+// Empty SQ index, and no stalled loads.
+void lsu::clear_indices() {
+	memset(sq_addr_unknown, 0, sq_words * sizeof(uint64_t));
+	memset(sq_bucket, 0, sq_buckets * sq_words * sizeof(uint64_t));
+	memset(lq_stalled, 0, lq_words * sizeof(uint64_t));
+	memset(lq_wake, 0, lq_words * sizeof(uint64_t));
+	memset(lq_poll, 0, lq_words * sizeof(uint64_t));
+	memset(sq_waiters, 0, sq_size * lq_words * sizeof(uint64_t));
+	lq_next_resolve = (cycle_t)-1;
+}
+
 void lsu::set_l2_cache(CacheClass* l2_dc){
 	DC->set_nextLevel(l2_dc);
 }
@@ -121,6 +277,7 @@ lsu::lsu(unsigned int lq_size, unsigned int sq_size, unsigned int Tid, mmu_t* _m
                         _proc,
                         "l1_dc",
                         _proc->L2C);
+	DC->set_prefetcher(L1_DC_PREFETCHER, L1_DC_PREFETCH_DEGREE);
 
 	// LQ initialization.
 	this->lq_size = lq_size;
@@ -148,6 +305,57 @@ lsu::lsu(unsigned int lq_size, unsigned int sq_size, unsigned int Tid, mmu_t* _m
 		SQ[i].valid = false;
   }
 
+	// SQ index initialization: about two buckets per store.
+	sq_words = (sq_size + 63)/64;
+	for (sq_buckets = 1; sq_buckets < (2 * sq_size); sq_buckets <<= 1)
+		;
+	sq_addr_unknown = new uint64_t[sq_words];
+	sq_bucket = new uint64_t[sq_buckets * sq_words];
+	sq_cand = new uint64_t[sq_words];
+
+	// Stalled loads initialization.
+	lq_words = (lq_size + 63)/64;
+	lq_stalled = new uint64_t[lq_words];
+	lq_wake = new uint64_t[lq_words];
+	lq_poll = new uint64_t[lq_words];
+	sq_waiters = new uint64_t[sq_size * lq_words];
+
+	clear_indices();
+
+	// MDP initialization.
+	mdp_size = (1 << MDP_NUM_INDEX_BITS);
+	MDP = new mdp_entry[mdp_size];
+	for (unsigned int i = 0; i < mdp_size; i++) {
+		MDP[i].valid = false;
+		MDP[i].pc = 0;
+		MDP[i].ctr = 0;
+	}
+
+	ssit_size = (1 << SSIT_NUM_INDEX_BITS);
+	SSIT = new ssit_entry[ssit_size];
+	for (unsigned int i = 0; i < ssit_size; i++) {
+		SSIT[i].valid = false;
+		SSIT[i].ssid = 0;
+	}
+	LFST = new lfst_entry[LFST_SIZE];
+	for (unsigned int i = 0; i < LFST_SIZE; i++) {
+		LFST[i].valid = false;
+		LFST[i].sq_index = 0;
+	}
+	ss_next_ssid = 0;
+	ss_loads = 0;
+
+	// LAP initialization.
+	lap_size = (1 << LAP_NUM_INDEX_BITS);
+	LAP = new lap_entry[lap_size];
+	for (unsigned int i = 0; i < lap_size; i++) {
+		LAP[i].tag = 0;
+		LAP[i].conf = 0;
+		LAP[i].retired_addr = 0;
+		LAP[i].stride = 0;
+		LAP[i].instance = 0;
+	}
+
 	// STATS
 	n_stall_disambig = 0;
 	n_forward = 0;
@@ -158,10 +366,26 @@ lsu::lsu(unsigned int lq_size, unsigned int sq_size, unsigned int Tid, mmu_t* _m
 	n_true_stall = 0;
 	n_false_stall = 0;
 	n_load_violation = 0;
+	n_lap_miss = 0;
+	n_lap_not_confident = 0;
+	n_lap_correct[0] = n_lap_correct[1] = 0;
+	n_lap_incorrect[0] = n_lap_incorrect[1] = 0;
+	n_lap_prefetch_drop = 0;
 }
 
 lsu::~lsu(){
   delete DC;
+  delete [] LAP;
+  delete [] MDP;
+  delete [] SSIT;
+  delete [] LFST;
+  delete [] sq_addr_unknown;
+  delete [] sq_bucket;
+  delete [] sq_cand;
+  delete [] lq_stalled;
+  delete [] lq_wake;
+  delete [] lq_poll;
+  delete [] sq_waiters;
 }
 
 bool lsu::stall(unsigned int bundle_load, unsigned int bundle_store) {
@@ -206,11 +430,30 @@ void lsu::dispatch(bool load,
 		LQ[lq_tail].pay_index = pay_index;
 		LQ[lq_tail].sq_index = sq_index;
 		LQ[lq_tail].sq_index_phase = sq_index_phase;
+		LQ[lq_tail].stall_store = false;
+		clear_stalled(lq_tail);
 
 		uint64_t load_pc = proc->PAY.buf[pay_index].pc;
-                LQ[lq_tail].mdp_stall = (!SPEC_DISAMBIG || (MEM_DEP_PRED && (MDP.find(load_pc) != MDP.end()) && (MDP[load_pc] > 0)));
+		mdp_entry* m = ((SPEC_DISAMBIG && MEM_DEP_PRED && !MDP_STORE_SETS) ? mdp_lookup(load_pc) : NULL);
+                LQ[lq_tail].mdp_stall = (!SPEC_DISAMBIG || (m && (m->ctr > 0)));
+
+		// Store sets: the load depends on the last dispatched store of its store set, if it is still in the SQ.
+		LQ[lq_tail].ss_dep = false;
+		if (SPEC_DISAMBIG && MDP_STORE_SETS) {
+			ssit_entry* ss = &SSIT[ssit_index(load_pc)];
+			if (ss->valid && LFST[ss->ssid].valid) {
+				LQ[lq_tail].ss_dep = true;
+				LQ[lq_tail].ss_store = LFST[ss->ssid].sq_index;
+			}
+		}
+
+		LQ[lq_tail].lap_hit = false;
+		LQ[lq_tail].lap_confident = false;
+		LQ[lq_tail].lap_probed = false;
+		LQ[lq_tail].lap_probe_hit = false;
 
 		// STATS
+		LQ[lq_tail].stat_lap_correct = false;
 		LQ[lq_tail].stat_load_stall_disambig = false;
 		LQ[lq_tail].stat_load_stall_disambig_addrunknown = false;
 		LQ[lq_tail].stat_load_stall_miss = false;
@@ -250,6 +493,21 @@ void lsu::dispatch(bool load,
 
 		SQ[sq_tail].pay_index = pay_index;
 
+		// The store's address is unknown.
+		SET_BIT(sq_addr_unknown[sq_tail/64], (sq_tail%64));
+
+		// Store sets: the store becomes the last dispatched store of its store set.
+		SQ[sq_tail].ss_valid = false;
+		if (SPEC_DISAMBIG && MDP_STORE_SETS) {
+			ssit_entry* ss = &SSIT[ssit_index(proc->PAY.buf[pay_index].pc)];
+			if (ss->valid) {
+				SQ[sq_tail].ss_valid = true;
+				SQ[sq_tail].ssid = ss->ssid;
+				LFST[ss->ssid].valid = true;
+				LFST[ss->ssid].sq_index = sq_tail;
+			}
+		}
+
 		// STATS
 		SQ[sq_tail].stat_load_stall_disambig = false;
 		SQ[sq_tail].stat_load_stall_disambig_addrunknown = false;
@@ -278,6 +536,146 @@ void lsu::dispatch(bool load,
 }
 
 
+// Instructions are word-aligned, so the two LSBs of the PC are dropped.
+unsigned int lsu::mdp_index(uint64_t pc) {
+	return((unsigned int)((pc >> 2) & (mdp_size - 1)));
+}
+
+// The MDP entry of the load at 'pc', NULL if it has none.
+mdp_entry* lsu::mdp_lookup(uint64_t pc) {
+	mdp_entry* m = &MDP[mdp_index(pc)];
+	return((m->valid && (m->pc == pc)) ? m : (mdp_entry*)NULL);
+}
+
+unsigned int lsu::ssit_index(uint64_t pc) {
+	return((unsigned int)((pc >> 2) & (ssit_size - 1)));
+}
+
+// Retire Stage: the load at 'load_pc' violated with the store at 'store_pc'. Put them in the same store set:
+// a new one if neither is in a store set, the one of the other if only one is, otherwise the one with the
+// smaller ID (so that merging converges).
+void lsu::ss_train(uint64_t load_pc, uint64_t store_pc) {
+	ssit_entry* l = &SSIT[ssit_index(load_pc)];
+	ssit_entry* s = &SSIT[ssit_index(store_pc)];
+	unsigned int ssid;
+
+	if (!l->valid && !s->valid) {
+		ssid = ss_next_ssid;
+		ss_next_ssid = MOD_S((ss_next_ssid + 1), LFST_SIZE);
+	}
+	else if (!l->valid)
+		ssid = s->ssid;
+	else if (!s->valid)
+		ssid = l->ssid;
+	else
+		ssid = MIN(l->ssid, s->ssid);
+
+	l->valid = true;
+	l->ssid = ssid;
+	s->valid = true;
+	s->ssid = ssid;
+}
+
+unsigned int lsu::lap_index(uint64_t pc) {
+	return((unsigned int)((pc >> 2) & (lap_size - 1)));
+}
+
+uint64_t lsu::lap_tag(uint64_t pc) {
+	return((pc >> (2 + LAP_NUM_INDEX_BITS)) & ((((uint64_t)1) << LAP_NUM_TAG_BITS) - 1));
+}
+
+bool lsu::lap_hit(uint64_t pc) {
+	return(LAP[lap_index(pc)].tag == lap_tag(pc));
+}
+
+void lsu::predict_load_addr(cycle_t cycle, unsigned int lq_index, bool& probed, bool& probe_hit) {
+	uint64_t pc = proc->PAY.buf[LQ[lq_index].pay_index].pc;
+	lap_entry* e = &LAP[lap_index(pc)];
+	bool hit;
+
+	assert(LQ[lq_index].valid);
+	probed = false;
+	probe_hit = false;
+
+	// Atomics are not predicted.
+	if (LQ[lq_index].amo || !lap_hit(pc))
+		return;
+
+	// Like the SVP, predict the next instance after all in-flight instances.
+	LQ[lq_index].lap_hit = true;
+	LQ[lq_index].lap_addr = e->retired_addr + ((uint64_t)(e->instance + 1) * (uint64_t)e->stride);
+	LQ[lq_index].lap_confident = (e->conf == LAP_CONFMAX);
+	e->instance++;
+
+	if (LQ[lq_index].lap_confident && !PERFECT_DCACHE) {
+		// Probe the D$ (tag check only: it doesn't change cache state or stats).
+		DC->Access(Tid, cycle, LQ[lq_index].lap_addr, false, &hit, true);
+		LQ[lq_index].lap_probed = true;
+		LQ[lq_index].lap_probe_hit = hit;
+
+		// Predicted miss: start bringing the line in now.
+		if (!hit && LAP_PREFETCH) {
+			if (DC->Access(Tid, cycle, LQ[lq_index].lap_addr, false, &hit) == -1)
+				n_lap_prefetch_drop++;
+		}
+
+		probed = true;
+		probe_hit = LQ[lq_index].lap_probe_hit;
+	}
+}
+
+// Retire Stage: train the LAP with the retired address of the load at the LQ head ('lq_index').
+void lsu::lap_train(uint64_t pc, reg_t addr, unsigned int lq_index) {
+	unsigned int index = lap_index(pc);
+	lap_entry* e = &LAP[index];
+	int64_t new_stride;
+
+	if (lap_hit(pc)) {
+		new_stride = (int64_t)(addr - e->retired_addr);
+		if (new_stride == e->stride) {
+			if (e->conf < LAP_CONFMAX)
+				e->conf++;
+		}
+		else {
+			e->stride = new_stride;
+			e->conf = 0;
+		}
+		e->retired_addr = addr;
+
+		// The retired instance is no longer in-flight.
+		assert(e->instance > 0);
+		e->instance--;
+	}
+	else if (e->conf == 0) {
+		// Replace the entry.
+		e->tag = lap_tag(pc);
+		e->retired_addr = addr;
+		e->stride = 0;
+
+		// Other in-flight instances of this load missed in the LAP when they were dispatched.
+		// Count them now, so that the instance counter reflects all in-flight instances of the new owner.
+		e->instance = 0;
+		for (unsigned int j = MOD_S((lq_index + 1), lq_size); j != lq_tail; j = MOD_S((j + 1), lq_size)) {
+			if (!LQ[j].amo && (lap_index(proc->PAY.buf[LQ[j].pay_index].pc) == index) && lap_hit(proc->PAY.buf[LQ[j].pay_index].pc))
+				e->instance++;
+		}
+	}
+	else {
+		// Don't replace a confident entry right away: gradually weaken it.
+		e->conf--;
+	}
+}
+
+// Branch/value misprediction recovery: the load in LQ entry 'lq_index' is squashed.
+void lsu::lap_squash(unsigned int lq_index) {
+	uint64_t pc = proc->PAY.buf[LQ[lq_index].pay_index].pc;
+
+	if (!LQ[lq_index].amo && lap_hit(pc)) {
+		assert(LAP[lap_index(pc)].instance > 0);
+		LAP[lap_index(pc)].instance--;
+	}
+}
+
 void lsu::store_addr(cycle_t cycle,
                      reg_t addr,
                      unsigned int sq_index,
@@ -305,6 +703,12 @@ void lsu::store_addr(cycle_t cycle,
    SQ[sq_index].addr_avail = true;
    SQ[sq_index].addr = addr;
 
+   // Index the store by its address. Wake up the loads that stalled on its unknown address,
+   // and the later stalled loads that it conflicts with.
+   sq_index_add(sq_index);
+   wake_waiters(sq_index);
+   wake_matching(sq_index, lq_index, lq_index_phase);
+
    // Attempt to translate the store address. Catch store exceptions.
    try {
       switch (SQ[sq_index].size) {
@@ -346,7 +750,7 @@ void lsu::store_addr(cycle_t cycle,
 
    if (!PERFECT_DCACHE) {
       bool hit;
-      SQ[sq_index].miss_resolve_cycle = DC->Access(Tid, cycle, addr, true, &hit);
+      SQ[sq_index].miss_resolve_cycle = DC->Access(Tid, cycle, addr, true, &hit, false, true, proc->PAY.buf[SQ[sq_index].pay_index].pc);
       SQ[sq_index].missed = !hit;
 
       if (!hit) inc_counter(spec_store_miss_count);
@@ -365,6 +769,9 @@ void lsu::store_value(unsigned int sq_index, reg_t value) {
 
 	SQ[sq_index].value_avail = true;
 	SQ[sq_index].value = value;
+
+	// Wake up the loads that stalled on the store's value.
+	wake_waiters(sq_index);
 }
 
 
@@ -381,6 +788,10 @@ bool lsu::load_addr(cycle_t cycle,
 	LQ[lq_index].addr = addr;
 	//LQ[lq_index].back_data = back_data;
 
+	// Confirm the load's predicted address.
+	if (LQ[lq_index].lap_confident)
+		LQ[lq_index].stat_lap_correct = (LQ[lq_index].lap_addr == addr);
+
   #ifdef RISCV_MICRO_DEBUG
     LOG(proc->lsu_log,proc->cycle,proc->PAY.buf[LQ[lq_index].pay_index].sequence,proc->PAY.buf[LQ[lq_index].pay_index].pc,"Executing load lq entry %u",lq_index);
     dump_lq(proc,lq_index,proc->lsu_log);
@@ -388,7 +799,7 @@ bool lsu::load_addr(cycle_t cycle,
 
 	if (!PERFECT_DCACHE) {
 		bool hit;
-		LQ[lq_index].miss_resolve_cycle = DC->Access(Tid, cycle, addr, false, &hit);
+		LQ[lq_index].miss_resolve_cycle = DC->Access(Tid, cycle, addr, false, &hit, false, true, proc->PAY.buf[LQ[lq_index].pay_index].pc);
 		LQ[lq_index].missed = !hit;
     if(!hit){
       inc_counter(spec_load_miss_count);
@@ -408,33 +819,92 @@ bool lsu::load_addr(cycle_t cycle,
 }
 
 bool lsu::load_unstall(cycle_t cycle, unsigned int& pay_index, reg_t& value) {
-   unsigned int scan = lq_head;
-   bool scan_phase = lq_head_phase;
+   unsigned int w;
+   unsigned int n;
+   int scan;
+   bool replay;
    bool unstalled = false;
-   while (!((scan == lq_tail) && (scan_phase == lq_tail_phase)) && !unstalled) {
-      assert(LQ[scan].valid);
-      if (LQ[scan].addr_avail && !LQ[scan].value_avail) {
-         // If this load did not get an MHSR during initial execution, access the D$ again.
-         if (!PERFECT_DCACHE && (LQ[scan].miss_resolve_cycle == -1)) {
-            bool hit;
-            assert(LQ[scan].addr_avail);
-            LQ[scan].miss_resolve_cycle = DC->Access(Tid, cycle, LQ[scan].addr, false, &hit);
-            LQ[scan].missed = !hit;
+   cycle_t next_resolve = (cycle_t)-1;
+
+   // If no stalled load was woken up, is polled, or may see its cache miss resolve, all of them stall again
+   // with the same outcome: just count their replays.
+   if (cycle < lq_next_resolve) {
+      n = 0;
+      for (w = 0; w < lq_words; w++) {
+         if ((lq_wake[w] | lq_poll[w]) & lq_stalled[w])
+            break;
+         n += __builtin_popcountll(lq_stalled[w]);
+      }
+      if (w == lq_words) {
+         if (n)
+            stats->update_counter(COUNTER_ID(spec_load_count), n);
+         return(false);
+      }
+   }
+
+   // Replay the stalled loads in program order, from the LQ head, until one unstalls.
+   for (unsigned int seg = 0; (seg < 2) && !unstalled; seg++) {
+      unsigned int from = (seg ? 0 : lq_head);
+      unsigned int to = (seg ? lq_head : lq_size);
+      bool scan_phase = (seg ? !lq_head_phase : lq_head_phase);
+      for (scan = lq_next_stalled(from, to); (scan >= 0) && !unstalled; scan = lq_next_stalled((scan + 1), to)) {
+         assert(LQ[scan].valid);
+         assert(LQ[scan].addr_avail && !LQ[scan].value_avail);
+         replay = (BIT_IS_ONE(lq_wake[scan/64], (scan%64)) ||
+                   BIT_IS_ONE(lq_poll[scan/64], (scan%64)) ||
+                   (!LQ[scan].stall_store && LQ[scan].missed && (cycle >= LQ[scan].miss_resolve_cycle)));
+         if (replay) {
+            // If this load did not get an MHSR during initial execution, access the D$ again.
+            if (!PERFECT_DCACHE && (LQ[scan].miss_resolve_cycle == -1)) {
+               bool hit;
+               LQ[scan].miss_resolve_cycle = DC->Access(Tid, cycle, LQ[scan].addr, false, &hit, false, true, proc->PAY.buf[LQ[scan].pay_index].pc);
+               LQ[scan].missed = !hit;
+            }
+
+            // Check if load is unstalled.
+            execute_load(cycle, scan, scan_phase, LQ[scan].sq_index, LQ[scan].sq_index_phase);
+            unstalled = LQ[scan].value_avail;
+            pay_index = LQ[scan].pay_index;
+            value = LQ[scan].value;
+         }
+         else {
+            // Nothing it waits for happened: it would stall again.
+            inc_counter(spec_load_count);
          }
 
-         // Check if load is unstalled.
-         execute_load(cycle, scan, scan_phase, LQ[scan].sq_index, LQ[scan].sq_index_phase);
-         unstalled = LQ[scan].value_avail;
-         pay_index = LQ[scan].pay_index;
-         value = LQ[scan].value;
+         if (!unstalled && !LQ[scan].stall_store && LQ[scan].missed && (cycle < LQ[scan].miss_resolve_cycle))
+            next_resolve = MIN(next_resolve, LQ[scan].miss_resolve_cycle);
       }
-      scan = MOD_S((scan + 1), lq_size);
-      if (scan == 0) // wrap-around, i.e., phase change
-         scan_phase = !scan_phase;
    }
+
+   // All stalled loads were replayed: the earliest cycle at which one of their cache misses resolves.
+   if (!unstalled)
+      lq_next_resolve = next_resolve;
    return(unstalled);
 }
 
+// For idle-cycle fast-forward: describes what the load replay engine does in a cycle in which no stalled load unstalls.
+// Returns false if a stalled load will access the D$ again because it did not get an MHSR (this changes cache state).
+// Otherwise, 'num_replays' is the number of stalled loads that are run through the load execution datapath each cycle,
+// and 'next_event' is the earliest future cycle in which a stalled load's cache miss resolves ((cycle_t)-1 if none).
+bool lsu::replay_idle(cycle_t cycle, unsigned int& num_replays, cycle_t& next_event) {
+   int scan;
+   num_replays = 0;
+   next_event = (cycle_t)-1;
+   for (scan = lq_next_stalled(0, lq_size); scan >= 0; scan = lq_next_stalled((scan + 1), lq_size)) {
+      if (!PERFECT_DCACHE && (LQ[scan].miss_resolve_cycle == -1))
+         return(false);
+
+      // A load reservation that is not at the head of the LQ returns before being counted in execute_load().
+      if (!LQ[scan].amo || (scan == (int)lq_head))
+         num_replays++;
+
+      if (LQ[scan].missed && (cycle < LQ[scan].miss_resolve_cycle))
+         next_event = MIN(next_event, LQ[scan].miss_resolve_cycle);
+   }
+   return(true);
+}
+
 void lsu::execute_load(cycle_t cycle,
                        unsigned int lq_index, bool lq_index_phase,
                        unsigned int sq_index, bool sq_index_phase) {
@@ -454,6 +924,7 @@ void lsu::execute_load(cycle_t cycle,
            }
            else {
 	      // Load reservation has not yet reached the head of the LQ and must stall.
+	      record_stall(lq_index, false, 0);
 	      return;
 	   }
         }
@@ -586,6 +1057,7 @@ void lsu::execute_load(cycle_t cycle,
 		LQ[lq_index].stat_load_stall_miss = true;
 	}
 
+	record_stall(lq_index, stall_disambig, store_entry);
 }
 
 
@@ -604,6 +1076,17 @@ void lsu::restore(unsigned int recover_lq_tail, bool recover_lq_tail_phase,
 	// Restore LQ.
 	/////////////////////////////
 
+	// Repair the LAP's instance counters for the squashed loads, youngest first.
+	// Squashed loads are no longer stalled.
+	while ((lq_tail != recover_lq_tail) || (lq_tail_phase != recover_lq_tail_phase)) {
+		lq_tail = ((lq_tail == 0) ? (lq_size - 1) : (lq_tail - 1));
+		if (lq_tail == (lq_size - 1))   // wrapped around, so toggle phase bit
+			lq_tail_phase = !lq_tail_phase;
+		if (LOAD_ADDR_PRED)
+			lap_squash(lq_tail);
+		clear_stalled(lq_tail);
+	}
+
 	// Restore tail state.
 	lq_tail = recover_lq_tail;
 	lq_tail_phase = recover_lq_tail_phase;
@@ -630,6 +1113,14 @@ void lsu::restore(unsigned int recover_lq_tail, bool recover_lq_tail_phase,
 	// Restore SQ.
 	/////////////////////////////
 
+	// Remove the squashed stores from the SQ index.
+	while ((sq_tail != recover_sq_tail) || (sq_tail_phase != recover_sq_tail_phase)) {
+		sq_tail = ((sq_tail == 0) ? (sq_size - 1) : (sq_tail - 1));
+		if (sq_tail == (sq_size - 1))   // wrapped around, so toggle phase bit
+			sq_tail_phase = !sq_tail_phase;
+		sq_index_remove(sq_tail);
+	}
+
 	// Restore tail state.
 	sq_tail = recover_sq_tail;
 	sq_tail_phase = recover_sq_tail_phase;
@@ -659,19 +1150,50 @@ void lsu::train(bool load) {
       assert(lq_length > 0);
 
       // Train the MDP.
-      if (SPEC_DISAMBIG && MEM_DEP_PRED) {
+      if (SPEC_DISAMBIG && MEM_DEP_PRED && MDP_STORE_SETS) {
+         if (LQ[lq_head].stat_load_violation)
+	    ss_train(proc->PAY.buf[LQ[lq_head].pay_index].pc, LQ[lq_head].stat_violation_store_pc);
+
+	 // Periodically forget all store sets, so that stale dependences don't keep stalling loads.
+	 if (SSIT_CLEAR_INTERVAL && (++ss_loads == SSIT_CLEAR_INTERVAL)) {
+	    for (unsigned int i = 0; i < ssit_size; i++)
+	       SSIT[i].valid = false;
+	    ss_loads = 0;
+	 }
+      }
+      else if (SPEC_DISAMBIG && MEM_DEP_PRED) {
          uint64_t load_pc = proc->PAY.buf[LQ[lq_head].pay_index].pc;
+	 mdp_entry* m = mdp_lookup(load_pc);
          if (LQ[lq_head].stat_load_violation) {
-	    MDP[load_pc] = MDP_MAX;
+	    // Replace the entry, if another load has it.
+	    m = &MDP[mdp_index(load_pc)];
+	    m->valid = true;
+	    m->pc = load_pc;
+	    m->ctr = MDP_MAX;
 	 }
-	 else if (!MDP_STICKY && (MDP.find(load_pc) != MDP.end()) && LQ[lq_head].stat_load_stall_disambig_addrunknown) {
+	 else if (!MDP_STICKY && m && LQ[lq_head].stat_load_stall_disambig_addrunknown) {
 	    if (LQ[lq_head].stat_late_store_match)
-	       MDP[load_pc] = MDP_MAX;
-	    else if (MDP[load_pc] > 0)
-               MDP[load_pc]--;
+	       m->ctr = MDP_MAX;
+	    else if (m->ctr > 0)
+               m->ctr--;
 	 }
       }
 
+      // Train the LAP.
+      if (LOAD_ADDR_PRED && !LQ[lq_head].amo) {
+         assert(LQ[lq_head].addr_avail);
+         lap_train(proc->PAY.buf[LQ[lq_head].pay_index].pc, LQ[lq_head].addr, lq_head);
+
+         if (!LQ[lq_head].lap_hit)
+            n_lap_miss++;
+         else if (!LQ[lq_head].lap_confident)
+            n_lap_not_confident++;
+         else if (LQ[lq_head].stat_lap_correct)
+            n_lap_correct[LQ[lq_head].lap_probe_hit ? 1 : 0]++;
+         else
+            n_lap_incorrect[LQ[lq_head].lap_probe_hit ? 1 : 0]++;
+      }
+
       // STATS
       n_load++;
       if (LQ[lq_head].stat_load_stall_disambig) {
@@ -761,6 +1283,10 @@ bool lsu::commit(bool load, bool atomic_op) {
 	 }
       }
 
+      // The store leaves the SQ: wake up the loads it stalled (e.g., partial conflicts).
+      wake_waiters(sq_head);
+      sq_index_remove(sq_head);
+
       // Invalidate the entry.
       SQ[sq_head].valid = false;
   
@@ -778,7 +1304,23 @@ bool lsu::commit(bool load, bool atomic_op) {
 }
 
 
+// Functional warming (sampled simulation): a correct-path load or store accessed 'addr'.
+void lsu::warm(reg_t addr, bool is_store) {
+	if (!PERFECT_DCACHE)
+		DC->Warm(Tid, addr, is_store);
+}
+
 void lsu::flush() {
+	// No loads are in-flight anymore.
+	for (unsigned int i = 0; i < lap_size; i++) {
+		LAP[i].instance = 0;
+	}
+
+	// No stores are in-flight anymore.
+	for (unsigned int i = 0; i < LFST_SIZE; i++) {
+		LFST[i].valid = false;
+	}
+
 	// Flush LQ.
 	lq_head = 0;
 	lq_head_phase = false;
@@ -800,6 +1342,8 @@ void lsu::flush() {
 	for (unsigned int i = 0; i < sq_size; i++) {
 		SQ[i].valid = false;
 	}
+
+	clear_indices();
 }
 
 
@@ -821,6 +1365,12 @@ void lsu::copy_mem(char** master_mem_table) {
 
 
 // STATS
+
+// Percentage of 'n' out of 'total', 0 if 'total' is 0 (like the rates in stats.log).
+static double percent(unsigned int n, unsigned int total) {
+	return((total == 0) ? 0.0 : (100.0*(double)n/(double)total));
+}
+
 void lsu::dump_stats(FILE* fp) {
 	int addr_stall = (n_true_stall + n_false_stall);
 	int val_or_size_stall = (n_stall_disambig - addr_stall);
@@ -854,6 +1404,33 @@ void lsu::dump_stats(FILE* fp) {
 	        n_stall_miss_l,
 	        100.0*(double)n_stall_miss_l/(double)n_load);
 
+	if (LOAD_ADDR_PRED) {
+		unsigned int n_lap_conf = (n_lap_correct[0] + n_lap_incorrect[0] + n_lap_correct[1] + n_lap_incorrect[1]);
+		unsigned int n_lap_total = (n_lap_miss + n_lap_not_confident + n_lap_conf);
+
+		fprintf(fp, "LOAD ADDRESS PREDICTION (retired, non-atomic loads)\n");
+		fprintf(fp, "  loads            = %d\n", n_lap_total);
+		fprintf(fp, "  LAP miss         = %d (%.2f%%)\n",
+		        n_lap_miss,
+		        percent(n_lap_miss, n_lap_total));
+		fprintf(fp, "  not confident    = %d (%.2f%%)\n",
+		        n_lap_not_confident,
+		        percent(n_lap_not_confident, n_lap_total));
+		fprintf(fp, "  confident        = %d (%.2f%%)\n",
+		        n_lap_conf,
+		        percent(n_lap_conf, n_lap_total));
+		for (int h = 1; h >= 0; h--) {
+			fprintf(fp, "     predicted %-4s = %d: correct = %d (%.2f%%), incorrect = %d (%.2f%%)\n",
+			        (h ? "hit" : "miss"),
+			        (n_lap_correct[h] + n_lap_incorrect[h]),
+			        n_lap_correct[h],
+			        percent(n_lap_correct[h], (n_lap_correct[h] + n_lap_incorrect[h])),
+			        n_lap_incorrect[h],
+			        percent(n_lap_incorrect[h], (n_lap_correct[h] + n_lap_incorrect[h])));
+		}
+		fprintf(fp, "  prefetches dropped (no MHSR, all paths) = %d\n", n_lap_prefetch_drop);
+	}
+
 	fprintf(fp, "STORES (retired)\n");
 	fprintf(fp, "  stores           = %d\n", n_store);
 	fprintf(fp, "  miss stall       = %d (%.2f%%)\n",
@@ -863,6 +1440,8 @@ void lsu::dump_stats(FILE* fp) {
 	fprintf(fp, "MDP quick stats\n");
 	fprintf(fp, "  false stalls     = %d\n", n_false_stall);
 	fprintf(fp, "  load violations  = %d\n", n_load_violation);
+
+	DC->dump_prefetch_stats(fp);
 }
 
 
@@ -32,22 +32,67 @@ typedef struct {
   unsigned int pay_index; // Index into PAY buffer.
   unsigned int sq_index;  // SQ index of stalled load.
   bool sq_index_phase;
+  bool stall_store;       // The stalled load is waiting for an older store (on its wait list), not for its cache miss.
 
   // Dynamic loads may be classed as "stall type" or "speculate type",
   // based on whether or not speculative memory disambiguation is enabled
   // and a prediction from the memory dependence predictor (MDP).
   bool mdp_stall;
 
+  // Store sets (MDP_STORE_SETS).
+  bool ss_dep;                // load: predicted to depend on the store in SQ entry 'ss_store'
+  unsigned int ss_store;
+  bool ss_valid;              // store: member of store set 'ssid'
+  unsigned int ssid;
+
+  // Load address prediction (LOAD_ADDR_PRED), made when the load is dispatched into the LQ.
+  bool lap_hit;               // the LAP hit, predicting the address 'lap_addr' ...
+  bool lap_confident;         // ... confidently
+  reg_t lap_addr;
+  bool lap_probed;            // the predicted address was probed in the D$ ...
+  bool lap_probe_hit;         // ... and hit (otherwise, it was prefetched if LAP_PREFETCH)
+
   // STATS
+  bool stat_lap_correct;      // A confidently predicted address matched the computed address.
   bool stat_load_stall_disambig;  // Load stalled due to an unknown store address, an unavailable store value, or a different store value size.
   bool stat_load_stall_disambig_addrunknown; // Load stalled due to an unknown store address.
   bool stat_load_stall_miss;  // Load stalled due to a cache miss.
   bool stat_store_stall_miss; // Store commit stalled due to a cache miss.
   bool stat_forward;    // Load received value from store in LSQ.
   bool stat_load_violation;	// A load executed before an older conflicting store.
+  reg_t stat_violation_store_pc;	// ... the PC of that store.
   bool stat_late_store_match;	// A stalled load observed an address match with a late-arriving older store.
 } lsq_entry;
 
+// Single entry in the load address predictor (LAP): a stride address predictor.
+typedef struct {
+  uint64_t tag;               // PC tag
+  unsigned int conf;          // confidence counter (saturates at LAP_CONFMAX)
+  reg_t retired_addr;         // address of the last retired instance
+  int64_t stride;             // difference between the last two retired addresses
+  unsigned int instance;      // number of in-flight instances (LQ entries) that map to this entry
+} lap_entry;
+
+
+// Single entry in the MDP-sticky/MDP-ctr table: direct-mapped, tagged with the full load PC.
+typedef struct {
+  bool valid;
+  uint64_t pc;
+  uint64_t ctr;               // predict a conflict when > 0
+} mdp_entry;
+
+// Store sets: Store Set ID Table (SSIT) entry, indexed by load or store PC (not tagged).
+typedef struct {
+  bool valid;
+  unsigned int ssid;          // store set ID: index into the LFST
+} ssit_entry;
+
+// Store sets: Last Fetched Store Table (LFST) entry, one per store set.
+typedef struct {
+  bool valid;
+  unsigned int sq_index;      // SQ entry of the store set's last dispatched store, while it is in the SQ
+} lfst_entry;
+
 
 //Forward declaring classes 
 class mmu_t;
@@ -88,6 +133,38 @@ private:
   bool sq_head_phase;
   bool sq_tail_phase;
 
+  //////////////////////////
+  // Store Queue index
+  //////////////////////////
+  // Bit vectors over the SQ (sq_words words each), so that disambiguate() visits only the older stores that
+  // may conflict with a load, instead of walking the SQ:
+  // sq_addr_unknown: stores whose address is not available yet.
+  // sq_bucket[b]: stores whose address is available and hashes to bucket b. Accesses that overlap share their
+  //               8-byte block, and so their bucket.
+  unsigned int sq_words;
+  unsigned int sq_buckets;	// power of two
+  uint64_t* sq_addr_unknown;
+  uint64_t* sq_bucket;		// [sq_buckets * sq_words]
+  uint64_t* sq_cand;		// scratch: candidate stores of the load being disambiguated
+
+  //////////////////////////
+  // Stalled loads
+  //////////////////////////
+  // Loads that executed but have no value yet, as bit vectors over the LQ (lq_words words each).
+  // A stalled load is replayed only when something it waits for may have happened:
+  // lq_wake: woken by an event of an older store (see sq_waiters), including a store whose address
+  //          became available and matches the load's.
+  // lq_poll: replayed every cycle: it did not get an MHSR (it must access the D$ again), or it is atomic
+  //          (it waits to reach the LQ head).
+  // Otherwise, it waits for its cache miss, which resolves no earlier than lq_next_resolve.
+  // The loads that are not replayed would stall again, with the same outcome: they are only counted.
+  unsigned int lq_words;
+  uint64_t* lq_stalled;
+  uint64_t* lq_wake;
+  uint64_t* lq_poll;
+  uint64_t* sq_waiters;		// [sq_size * lq_words]: wait list of each store: the loads it stalled
+  cycle_t lq_next_resolve;
+
   //////////////////////////
   // Data Cache
   //////////////////////////
@@ -97,7 +174,23 @@ private:
   /////////////////////////////////////////////////////////////
   // Memory dependence predictor (MDP)
   /////////////////////////////////////////////////////////////
-  std::map<uint64_t, uint64_t> MDP;
+  // MDP-sticky, MDP-ctr: a counter per load PC.
+  mdp_entry* MDP;
+  unsigned int mdp_size;
+
+  // Store sets: a load and the stores it conflicted with share a store set. A load waits only for the
+  // address of the last store of its set dispatched before it, instead of all older unknown store addresses.
+  ssit_entry* SSIT;
+  unsigned int ssit_size;
+  lfst_entry* LFST;
+  unsigned int ss_next_ssid;	// next store set ID to allocate (round-robin)
+  unsigned int ss_loads;	// retired loads since the SSIT was last invalidated
+
+  /////////////////////////////////////////////////////////////
+  // Load address predictor (LAP)
+  /////////////////////////////////////////////////////////////
+  lap_entry* LAP;
+  unsigned int lap_size;
 
   //////////////////////////
   // Memory
@@ -126,6 +219,13 @@ private:
   unsigned int n_false_stall;
   unsigned int n_load_violation;
 
+  // Load address prediction measurements (retired, non-atomic loads).
+  unsigned int n_lap_miss;            // LAP tag miss
+  unsigned int n_lap_not_confident;   // LAP hit, not confident
+  unsigned int n_lap_correct[2];      // confident, correct (by probe outcome: [0] predicted miss, [1] predicted hit)
+  unsigned int n_lap_incorrect[2];    // confident, incorrect (same)
+  unsigned int n_lap_prefetch_drop;   // predicted misses that could not be prefetched (no free MHSR), all paths
+
   //////////////////////////
   //  Private functions
   //////////////////////////
@@ -150,6 +250,18 @@ private:
                     unsigned int lq_index, bool lq_index_phase,
                     unsigned int sq_index, bool sq_index_phase);
 
+  // Store Queue index and stalled load bookkeeping.
+  void clear_indices();
+  unsigned int sq_bucket_of(reg_t addr);
+  void sq_index_add(unsigned int sq_index);
+  void sq_index_remove(unsigned int sq_index);
+  int sq_prev_cand(unsigned int from, unsigned int to);
+  int lq_next_stalled(unsigned int from, unsigned int to);
+  void wake_waiters(unsigned int sq_index);
+  void wake_matching(unsigned int sq_index, unsigned int lq_index, bool lq_index_phase);
+  void record_stall(unsigned int lq_index, bool stall_store, unsigned int store_entry);
+  void clear_stalled(unsigned int lq_index);
+
   // The path for stores to detect mispredicted loads.
   bool ld_violation(unsigned int sq_index,
                     unsigned int lq_index, bool lq_index_phase,
@@ -158,6 +270,19 @@ private:
   // Allocate a chunk of memory.
   char* mem_newblock(void);
 
+  // Memory dependence predictor.
+  unsigned int mdp_index(uint64_t pc);
+  mdp_entry* mdp_lookup(uint64_t pc);
+  unsigned int ssit_index(uint64_t pc);
+  void ss_train(uint64_t load_pc, uint64_t store_pc);
+
+  // Load address predictor.
+  unsigned int lap_index(uint64_t pc);
+  uint64_t lap_tag(uint64_t pc);
+  bool lap_hit(uint64_t pc);
+  void lap_train(uint64_t pc, reg_t addr, unsigned int lq_index);
+  void lap_squash(unsigned int lq_index);
+
 
 public:
 
@@ -173,6 +298,11 @@ public:
                 unsigned int& lq_index, bool& lq_index_phase,
                 unsigned int& sq_index, bool& sq_index_phase);
 
+  // Dispatch Stage, right after dispatching a load: predict its address and probe the D$ with it.
+  // If the probe misses, the line is prefetched (LAP_PREFETCH), so that the load's own access hides some of the miss latency.
+  // 'probed' and 'probe_hit' report whether the load was confidently predicted and, if so, the probe's outcome.
+  void predict_load_addr(cycle_t cycle, unsigned int lq_index, bool& probed, bool& probe_hit);
+
   void store_addr(cycle_t cycle,
                   reg_t addr,
                   unsigned int sq_index,
@@ -186,6 +316,7 @@ public:
                  //reg_t back_data, // LWL/LWR
                  reg_t& value);
   bool load_unstall(cycle_t cycle, unsigned int& pay_index, reg_t& value);
+  bool replay_idle(cycle_t cycle, unsigned int& num_replays, cycle_t& next_event);
 
   void checkpoint(unsigned int& chkpt_lq_tail, bool& chkpt_lq_tail_phase,
                   unsigned int& chkpt_sq_tail, bool& chkpt_sq_tail_phase);
@@ -197,6 +328,9 @@ public:
 
   void flush();
 
+  // Functional warming of the D$ (and the levels behind it), for sampled simulation.
+  void warm(reg_t addr, bool is_store);
+
   void copy_mem(char** master_mem_table);
 
   // STATS
@@ -11,17 +11,32 @@
 #include <getopt.h>
 #include <vector>
 #include <string>
+#include <sstream>
 #include <memory>
 #include <algorithm>
+#include <cmath>
 #include "debug.h"
 #include "parameters.h"
+#include "vtage.h"
+#include "simpoint.h"
+#include "prefetcher.h"
 #include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <fstream>
+#include <map>
 
 static void help()
 {
   fprintf(stderr, "usage: micros [host options] <target program> [target options]\n");
   fprintf(stderr, "Host Options:\n");
-  fprintf(stderr, "  -c<gz_chkpt_file>  Start simulation from a .gz checkpoint file.\n");
+  fprintf(stderr, "  -c<gz_chkpt_file>  Start simulation from a .gz checkpoint file, or from a .ckpt checkpoint image (memory pages are loaded on first touch).\n");
+  fprintf(stderr, "  --convert-chkpt=<gz_chkpt_file>  Convert a .gz checkpoint to a .ckpt checkpoint image of the same name, then exit.\n");
+  fprintf(stderr, "  --bbv=<interval>,<name>  Profile the program's basic block vectors for SimPoint, one per <interval> instructions, to <name>.bb.gz at fast skip speed, then exit. With -e<n>, only the first <n> instructions are profiled.\n");
+  fprintf(stderr, "  --simpoint-chkpt=<interval>,<simpoints_file>,<weights_file>,<name>  In a single fast skip run, create a .ckpt checkpoint image at the start of each simpoint chosen by SimPoint (<name>.<interval #>.<cluster #>.ckpt), and their list with weights (<name>.chkpts), then exit.\n");
+  fprintf(stderr, "  --sweep=<config_file>[,<jobs>]  Configuration sweep: boot, restore (-c) or fast skip (-s) once, then simulate each configuration in its own process, at most <jobs> at a time (default: one per CPU). Each line of <config_file> is a configuration, given as timing simulator options (e.g., --iq=64 --DC=...). Configuration <n> writes stats.<n>.<date>.log.\n");
+  fprintf(stderr, "  --intervals=<n>,<length>,<warmup>[,<jobs>]  Parallel interval simulation: after restoring (-c) or fast skipping (-s), fast skip through the next <n> intervals of <length> instructions, and simulate each in its own process, at most <jobs> at a time (default: one per CPU), after <warmup> instructions of detailed warmup. Interval <i> writes stats.<date>.interval<i>.log, and the merged stats are written to stats.<date>.merged.log.\n");
+  fprintf(stderr, "  --combine-stats=<list_file>  Combine the stats logs of simulated simpoints, listed as \"<weight> <stats log>\" lines, into weighted whole-program stats, then exit.\n");
   fprintf(stderr, "  -d                 Interactive debug mode\n");
   fprintf(stderr, "  -e<n>              End simulation after <n> instructions have been committed by microarchitectural simulation\n");
   fprintf(stderr, "  -g                 Track histogram of PCs\n");
@@ -29,7 +44,8 @@ static void help()
   fprintf(stderr, "  -l<n>              Enable logging after <n> commits if compiled with support\n");
   fprintf(stderr, "  -m<n>              Provide <n> MB of target memory\n");
   fprintf(stderr, "  -p<n>              Simulate <n> processors\n");
-  fprintf(stderr, "  -s<n>              Fast skip <n> instructions before microarchitectural simulation\n");
+  fprintf(stderr, "  -s<n>              Fast skip <n> instructions before microarchitectural simulation (after restoring the checkpoint, with -c)\n");
+  fprintf(stderr, "  --warm-skip=<n>    Fast skip (-s) warms the caches (tags and replacement state, no timing) with the last <n> skipped instructions' fetches, loads and stores. 0: all skipped instructions.\n");
   fprintf(stderr, "  --perf=<pbp>,<pdc>,<pic>,<ptc>\tEach of pbp (perf. branch pred.), pdc (perf. D$), pic (perf. I$), and ptc (perf. T$), are 0 or 1\n");
   fprintf(stderr, "  --cp=<n>           <n> branch checkpoints for mispredict recovery\n");
 
@@ -43,7 +59,23 @@ static void help()
   fprintf(stderr, "  --cbpBHR=<n>       The gshare-indexed conditional branch predictor uses <n> bits of BHR\n");
   fprintf(stderr, "  --ibpPC=<n>        The gshare-indexed indirect branch predictor uses <n> bits of PC\n");
   fprintf(stderr, "  --ibpBHR=<n>       The gshare-indexed indirect branch predictor uses <n> bits of BHR\n");
+  fprintf(stderr, "  --ibpALG=<n>       The indirect branch predictor algorithm: 0 for gshare, 1 for ITTAGE\n");
+  fprintf(stderr, "  --ittage=<#tables>,<#index bits>,<min hist>,<max hist>\tConfigure the ITTAGE indirect branch predictor: tagged tables and index bits of each table (and of the base table), with history lengths from <min hist> to <max hist>.\n");
   fprintf(stderr, "  -t                 Enable trace cache\n");
+  fprintf(stderr, "  --tc=<#sets>,<assoc>,<max_cb>,<max_length>,<partial>\tConfigure the real (not perfect) trace cache, filled with retired instructions. <max_cb>, <max_length>: maximum conditional branches and instructions per trace (0: the fetch bundle's). <partial>: 1 to supply the instructions of a trace up to its first conditional branch predicted the other way.\n");
+  fprintf(stderr, "  --vp-enable=<0/1>  0: disable value prediction. 1: enable value prediction.\n");
+  fprintf(stderr, "  --vp-perf=<0/1>    0: real value prediction. 1: perfect value prediction (all eligible instructions are correctly predicted).\n");
+  fprintf(stderr, "  --vp=<algorithm>   The value prediction engine: svp (stride), lvp (last value), fcm (finite context method), vtage, or hybrid (svp+fcm+vtage with a chooser). Or 0 to 4, respectively.\n");
+  fprintf(stderr, "  --vp-svp=<VPQsize>,<oracleconf>,<#index bits>,<#tag bits>,<confmax>,<confinc>,<confdec>,<replace_stride>,<replace>,<predINTALU>,<predFPALU>,<predLOAD>\tConfigure the stride value predictor (SVP) and value prediction queue (VPQ). The other engines share the VPQ size, oracle confidence, tag bits, confidence and replacement settings.\n");
+  fprintf(stderr, "  --vp-fcm=<#VHT index bits>,<#VPT index bits>,<order>\tConfigure the FCM value predictor.\n");
+  fprintf(stderr, "  --vp-vtage=<#base index bits>,<#tables>,<#index bits>,<#tag bits>,<min hist>,<max hist>\tConfigure the VTAGE value predictor.\n");
+  fprintf(stderr, "  --vp-hybrid=<#chooser index bits>\tConfigure the hybrid value predictor's chooser.\n");
+  fprintf(stderr, "  --vp-loads-only=<0/1>  1: only loads are eligible for value prediction (overrides <predINTALU>,<predFPALU>,<predLOAD> of a preceding --vp-svp).\n");
+  fprintf(stderr, "  --lap=<enable>,<#index bits>,<#tag bits>,<confmax>,<prefetch>\tLoad address predictor (stride): at dispatch, probe the D$ with confidently predicted load addresses and, if <prefetch>, prefetch the lines that miss.\n");
+  fprintf(stderr, "  --vp-fpc=<n0>,<n1>,...\tForward probabilistic confidence counters: a correct prediction increments a confidence counter at <conf> with probability 1/2^<n_conf> (the last <n> applies to higher confidences). At most %d values.\n", VP_FPC_MAX_LEN);
+  fprintf(stderr, "  --vp-crit=<enable>,<#index bits>,<threshold>,<max>\tCriticality filter: only use confident predictions of PCs whose (saturating) count of Active List head stall cycles, less one per retired instance that didn't stall the head, is at least <threshold>.\n");
+  fprintf(stderr, "  --vp-consumer=<enable>,<#index bits>,<threshold>,<max>\tConsumer filter: only use confident predictions of PCs whose (saturating) count, incremented when a consumer was dispatched before the value was computed and decremented otherwise, is at least <threshold>.\n");
+  fprintf(stderr, "  --vp-recovery=<0/1/2>  Value misprediction recovery. 0: squash all instructions after the mispredicted instruction when it retires. 1: roll back to the mispredicted instruction's checkpoint at writeback. 2: selectively replay its issued dependents at writeback (falls back to 1 when they can't be replayed).\n");
 
   fprintf(stderr, "  --fq=<n>           Fetch queue has <n> entries\n");
   fprintf(stderr, "  --al=<n>           Active List has <n> entries\n");
@@ -52,14 +84,21 @@ static void help()
   fprintf(stderr, "  --iqnp=<n>         Issue Queue has <n> partitions for round-robin partition-based priority adjustment\n");
   fprintf(stderr, "  -a                 Enable pre-steering in dispatch stage (override dynamic lane steering at issue stage)\n");
   fprintf(stderr, "  -b                 Enable ideal age-based scheduling (override position-based scheduling)\n");
+  fprintf(stderr, "  --iq-wakeup=<0/1>  Issue Queue wakeup. 0: broadcast the tag to all entries (CAM scan). 1: wake up only the consumers recorded for the tag at dispatch (default).\n");
+  fprintf(stderr, "  --iq-select=<0/1>  Issue Queue select. 0: test every entry for readiness. 1: bit-scan a bitmap of ready entries (default). Both make the same issue decisions.\n");
   fprintf(stderr, "  --lsq=<n>          Load/Store Queue has <n> entries\n");
-  fprintf(stderr, "  --mdp=<mdp_model>,<mdp_ctr_max>\t<mdp_model>: 0 (always pred. conflict), 1 (always pred. no conflict), 2 (MDP-sticky), 3 (MDP-ctr), 4 (oracle). <mdp_ctr_max>: max counter value for MDP-ctr.\n");
+  fprintf(stderr, "  --mdp=<mdp_model>,<mdp_ctr_max>\t<mdp_model>: 0 (always pred. conflict), 1 (always pred. no conflict), 2 (MDP-sticky), 3 (MDP-ctr), 4 (oracle), 5 (store sets). <mdp_ctr_max>: max counter value for MDP-ctr.\n");
+  fprintf(stderr, "  --mdp-tables=<#MDP index bits>,<#SSIT index bits>,<#LFST entries>,<SSIT clear interval>\tSizes of the memory dependence predictor's tables: the MDP-sticky/MDP-ctr table, and the store sets' Store Set ID Table and Last Fetched Store Table. The SSIT is invalidated every <SSIT clear interval> retired loads (0: never).\n");
   fprintf(stderr, "  --splitstores=<0/1>\t0: disable split-stores. 1: enable split-stores.\n");
   fprintf(stderr, "  --fw=<n>           <n> wide fetch\n");
   fprintf(stderr, "  --dw=<n>           <n> wide dispatch\n");
   fprintf(stderr, "  --iw=<n>           <n> wide issue / <n> execution lanes\n");
   fprintf(stderr, "  --rw=<n>           <n> wide retire\n");
   fprintf(stderr, "  --phase=<n>        Phase interval is <n>\n");
+  fprintf(stderr, "  --idle-ff=<0/1>    1: fast-forward over cycles in which the pipeline is blocked until a cache miss resolves (cycle-exact).\n");
+  fprintf(stderr, "  --sample=<unit>,<warmup>,<period>,<warming>\tSampled simulation (SMARTS): in every <period> instructions, measure a sampling unit of <unit> instructions after <warmup> instructions of detailed warmup, and simulate the rest functionally. If <warming>, functional simulation warms the caches, BTB, trace cache, branch predictors and value predictor. Reports a CPI estimate with confidence intervals.\n");
+  fprintf(stderr, "  --async-checker=<0/1>  1: the functional simulator runs ahead on its own thread (default). 0: it is stepped by the timing simulator. Same results either way.\n");
+  fprintf(stderr, "  --uop-cache=<n>    Decode Stage caches <n> decoded instructions, indexed by PC (power-of-2, default 1024). 0: decode every instruction.\n");
   fprintf(stderr, "  --lane=<B>:<L>:<S>:<C>:<LFP>:<FP>:<MTF>\tEach of <X> is a bit vector indicating which lanes support that instruction type.\n");
   fprintf(stderr, "  --lat=<B>:<L>:<S>:<C>:<LFP>:<FP>:<MTF>\tEach of <X> is an unsigned integer indicating the latency of that instruction type.\n");
   fprintf(stderr, "  -u                 Shortcut to configure universal lanes. Equivalent to: --lane=0xffff:0xffff:0xffff:0xffff:0xffff:0xffff:0xffff --lat=1:1:1:1:1:1:1\n");
@@ -70,6 +109,8 @@ static void help()
   fprintf(stderr, "  --L2=<SIZE>:<ASSOC>:<BLOCKSIZE>:<#MHSR>:<HITTIME>\tConfigure L2 $. Derived # sets must be power-of-2. Block size must be power-of-2.\n");
   fprintf(stderr, "  --L3=<SIZE>:<ASSOC>:<BLOCKSIZE>:<#MHSR>:<HITTIME>\tConfigure L3 $. Derived # sets must be power-of-2. Block size must be power-of-2.\n");
   fprintf(stderr, "  --MEMLAT=<latency>\tConfigure a fixed miss penalty for a miss in the LLC.\n");
+  fprintf(stderr, "  --IC-prefetch=<type>,<degree>\tAttach a prefetcher to the L1 I$ (likewise --DC-prefetch, --L2-prefetch, --L3-prefetch). <type>: 0 (none, default), 1 (next-line), 2 (PC-stride), 3 (stream). <degree>: lines prefetched per trigger.\n");
+  fprintf(stderr, "  --cache-repl=<policy>\tReplacement policy of all caches: 0: LRU (default), 1: tree-PLRU (power-of-2 associativities only), 2: SRRIP.\n");
   exit(1);
 }
 
@@ -159,7 +200,7 @@ static void set_mdp_flags(const char* config) {
    uint64_t mdp_model, mdp_ctr_max;
    if (sscanf(config, "%lu,%lu", &mdp_model, &mdp_ctr_max) != 2) {
       fprintf(stderr, "Incorrect usage:\n");
-      fprintf(stderr, "--mdp=<mdp_model>,<mdp_ctr_max>\t<mdp_model>: 0 (always pred. conflict), 1 (always pred. no conflict), 2 (MDP-sticky), 3 (MDP-ctr), 4 (oracle). <mdp_ctr_max>: max counter value for MDP-ctr.\n");
+      fprintf(stderr, "--mdp=<mdp_model>,<mdp_ctr_max>\t<mdp_model>: 0 (always pred. conflict), 1 (always pred. no conflict), 2 (MDP-sticky), 3 (MDP-ctr), 4 (oracle), 5 (store sets). <mdp_ctr_max>: max counter value for MDP-ctr.\n");
       exit(-1);
    }
    else {
@@ -167,6 +208,7 @@ static void set_mdp_flags(const char* config) {
       SPEC_DISAMBIG = false;
       MEM_DEP_PRED = false;
       MDP_STICKY = false;
+      MDP_STORE_SETS = false;
       MDP_MAX = mdp_ctr_max;
       switch (mdp_model) {
          case 0:
@@ -193,7 +235,7 @@ static void set_mdp_flags(const char* config) {
 
             if (MDP_MAX == 0) {
                fprintf(stderr, "Incorrect usage:\n");
-               fprintf(stderr, "--mdp=<mdp_model>,<mdp_ctr_max>\t<mdp_model>: 0 (always pred. conflict), 1 (always pred. no conflict), 2 (MDP-sticky), 3 (MDP-ctr), 4 (oracle). <mdp_ctr_max>: max counter value for MDP-ctr.\n");
+               fprintf(stderr, "--mdp=<mdp_model>,<mdp_ctr_max>\t<mdp_model>: 0 (always pred. conflict), 1 (always pred. no conflict), 2 (MDP-sticky), 3 (MDP-ctr), 4 (oracle), 5 (store sets). <mdp_ctr_max>: max counter value for MDP-ctr.\n");
                fprintf(stderr, "<mdp_ctr_max> (%u) must be greater than 0.\n", MDP_MAX);
                exit(-1);
             }
@@ -204,16 +246,412 @@ static void set_mdp_flags(const char* config) {
             ORACLE_DISAMBIG = true;
             break;
 
+         case 5:
+	    // Store sets.
+	    SPEC_DISAMBIG = true;
+	    MEM_DEP_PRED = true;
+	    MDP_STORE_SETS = true;
+	    break;
+
          default:
             fprintf(stderr, "Incorrect usage:\n");
-            fprintf(stderr, "--mdp=<mdp_model>,<mdp_ctr_max>\t<mdp_model>: 0 (always pred. conflict), 1 (always pred. no conflict), 2 (MDP-sticky), 3 (MDP-ctr), 4 (oracle). <mdp_ctr_max>: max counter value for MDP-ctr.\n");
-            fprintf(stderr, "<mdp_model> (%lu) must be 0 to 4.\n", mdp_model);
+            fprintf(stderr, "--mdp=<mdp_model>,<mdp_ctr_max>\t<mdp_model>: 0 (always pred. conflict), 1 (always pred. no conflict), 2 (MDP-sticky), 3 (MDP-ctr), 4 (oracle), 5 (store sets). <mdp_ctr_max>: max counter value for MDP-ctr.\n");
+            fprintf(stderr, "<mdp_model> (%lu) must be 0 to 5.\n", mdp_model);
             exit(-1);
 	    break;
       }
    }
 }
 
+static void set_tc_config(const char* config) {
+   unsigned int partial;
+   if ((sscanf(config, "%u,%u,%u,%u,%u", &TC_SETS, &TC_ASSOC, &TC_MAX_CB, &TC_MAX_LENGTH, &partial) != 5) ||
+       !IsPow2(TC_SETS) || (TC_SETS == 0) || (TC_ASSOC == 0)) {
+      fprintf(stderr, "Incorrect usage of --tc=<#sets>,<assoc>,<max_cb>,<max_length>,<partial>\n");
+      fprintf(stderr, "...where <#sets> is a power-of-2 and <assoc> is at least 1.\n");
+      exit(-1);
+   }
+   TC_PARTIAL_HIT = (partial ? true : false);
+}
+
+static void set_ibp_algorithm(const char* config) {
+   if ((sscanf(config, "%u", &IBP_ALGORITHM) != 1) || (IBP_ALGORITHM > 1)) {
+      fprintf(stderr, "Incorrect usage of --ibpALG=<0/1>\n");
+      exit(-1);
+   }
+}
+
+static void set_ittage_config(const char* config) {
+   if ((sscanf(config, "%u,%u,%u,%u", &ITTAGE_NUM_TABLES, &ITTAGE_LOG2_SIZE, &ITTAGE_MIN_HIST, &ITTAGE_MAX_HIST) != 4) ||
+       (ITTAGE_NUM_TABLES == 0) || (ITTAGE_NUM_TABLES > 16) || (ITTAGE_LOG2_SIZE == 0) || (ITTAGE_LOG2_SIZE > 24) ||
+       (ITTAGE_MIN_HIST == 0) || (ITTAGE_MIN_HIST > ITTAGE_MAX_HIST)) {
+      fprintf(stderr, "Incorrect usage of --ittage=<#tables>,<#index bits>,<min hist>,<max hist>\n");
+      fprintf(stderr, "...where <#tables> is 1 to 16, <#index bits> is 1 to 24, and 0 < <min hist> <= <max hist>.\n");
+      exit(-1);
+   }
+}
+
+static void set_mdp_tables(const char* config) {
+   if ((sscanf(config, "%u,%u,%u,%u", &MDP_NUM_INDEX_BITS, &SSIT_NUM_INDEX_BITS, &LFST_SIZE, &SSIT_CLEAR_INTERVAL) != 4) ||
+       (MDP_NUM_INDEX_BITS > 24) || (SSIT_NUM_INDEX_BITS > 24) || (LFST_SIZE == 0)) {
+      fprintf(stderr, "Incorrect usage of --mdp-tables=<#MDP index bits>,<#SSIT index bits>,<#LFST entries>,<SSIT clear interval>\n");
+      fprintf(stderr, "...where the index bits are at most 24, and <#LFST entries> is at least 1.\n");
+      exit(-1);
+   }
+}
+
+static void set_svp_config(const char* config) {
+   unsigned int oracleconf, predINTALU, predFPALU, predLOAD;
+   if (sscanf(config, "%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u", &SVP_VPQ_SIZE, &oracleconf, &SVP_NUM_INDEX_BITS, &SVP_NUM_TAG_BITS,
+              &SVP_CONFMAX, &SVP_CONFINC, &SVP_CONFDEC, &SVP_REPLACE_STRIDE, &SVP_REPLACE, &predINTALU, &predFPALU, &predLOAD) != 12) {
+      fprintf(stderr, "Incorrect usage of --vp-svp=<VPQsize>,<oracleconf>,<#index bits>,<#tag bits>,<confmax>,<confinc>,<confdec>,<replace_stride>,<replace>,<predINTALU>,<predFPALU>,<predLOAD>\n");
+      fprintf(stderr, "...where oracleconf, predINTALU, predFPALU, and predLOAD are each 0 or 1.\n");
+      exit(-1);
+   }
+   else {
+      if (SVP_VPQ_SIZE == 0) {
+         fprintf(stderr, "--vp-svp: <VPQsize> (%u) must be greater than 0.\n", SVP_VPQ_SIZE);
+         exit(-1);
+      }
+      if ((SVP_NUM_INDEX_BITS > 24) || (SVP_NUM_TAG_BITS > 62)) {
+         fprintf(stderr, "--vp-svp: <#index bits> (%u) must be at most 24 and <#tag bits> (%u) must be at most 62.\n", SVP_NUM_INDEX_BITS, SVP_NUM_TAG_BITS);
+         exit(-1);
+      }
+      SVP_ORACLE_CONF = (oracleconf ? true : false);
+      PREDINTALU = (predINTALU ? true : false);
+      PREDFPALU = (predFPALU ? true : false);
+      PREDLOAD = (predLOAD ? true : false);
+   }
+}
+
+static void set_vp_recovery(const char* config) {
+   if ((sscanf(config, "%u", &VP_RECOVERY) != 1) || (VP_RECOVERY > 2)) {
+      fprintf(stderr, "Incorrect usage of --vp-recovery=<0/1/2>\n");
+      exit(-1);
+   }
+}
+
+static void set_vp_algorithm(const char* config) {
+   for (unsigned int i = 0; i < NUM_VP_ALGORITHMS; i++) {
+      if (strcmp(config, vp_algorithm_name[i]) == 0) {
+         VP_ALGORITHM = i;
+         return;
+      }
+   }
+   if ((sscanf(config, "%u", &VP_ALGORITHM) != 1) || (VP_ALGORITHM >= NUM_VP_ALGORITHMS)) {
+      fprintf(stderr, "Incorrect usage of --vp=<svp|lvp|fcm|vtage|hybrid> (or 0 to 4)\n");
+      exit(-1);
+   }
+}
+
+static void set_fcm_config(const char* config) {
+   if ((sscanf(config, "%u,%u,%u", &FCM_VHT_INDEX_BITS, &FCM_VPT_INDEX_BITS, &FCM_ORDER) != 3) ||
+       (FCM_VHT_INDEX_BITS > 24) || (FCM_VPT_INDEX_BITS == 0) || (FCM_VPT_INDEX_BITS > 24) || (FCM_ORDER == 0)) {
+      fprintf(stderr, "Incorrect usage of --vp-fcm=<#VHT index bits>,<#VPT index bits>,<order>\n");
+      fprintf(stderr, "...where the index bits are at most 24 (the VPT's at least 1), and order is at least 1.\n");
+      exit(-1);
+   }
+}
+
+static void set_vtage_config(const char* config) {
+   if ((sscanf(config, "%u,%u,%u,%u,%u,%u", &VTAGE_BASE_INDEX_BITS, &VTAGE_NUM_TABLES, &VTAGE_INDEX_BITS, &VTAGE_TAG_BITS,
+               &VTAGE_MIN_HIST, &VTAGE_MAX_HIST) != 6) ||
+       (VTAGE_BASE_INDEX_BITS > 24) || (VTAGE_NUM_TABLES == 0) || (VTAGE_NUM_TABLES > VTAGE_MAX_TABLES) ||
+       (VTAGE_INDEX_BITS == 0) || (VTAGE_INDEX_BITS > 24) || (VTAGE_TAG_BITS < 2) || (VTAGE_TAG_BITS > 62) ||
+       (VTAGE_MIN_HIST == 0) || (VTAGE_MIN_HIST > VTAGE_MAX_HIST) || (VTAGE_MAX_HIST > 64)) {
+      fprintf(stderr, "Incorrect usage of --vp-vtage=<#base index bits>,<#tables>,<#index bits>,<#tag bits>,<min hist>,<max hist>\n");
+      fprintf(stderr, "...where #tables is 1 to %d, index bits are at most 24, #tag bits is 2 to 62, and 1 <= min hist <= max hist <= 64.\n", VTAGE_MAX_TABLES);
+      exit(-1);
+   }
+}
+
+static void set_hybrid_vp_config(const char* config) {
+   if ((sscanf(config, "%u", &HYBRID_CHOOSER_INDEX_BITS) != 1) || (HYBRID_CHOOSER_INDEX_BITS > 24)) {
+      fprintf(stderr, "Incorrect usage of --vp-hybrid=<#chooser index bits> (at most 24)\n");
+      exit(-1);
+   }
+}
+
+static void set_vp_loads_only(const char* config) {
+   unsigned int loads_only;
+   if ((sscanf(config, "%u", &loads_only) != 1) || (loads_only > 1)) {
+      fprintf(stderr, "Incorrect usage of --vp-loads-only=<0/1>\n");
+      exit(-1);
+   }
+   PREDINTALU = !loads_only;
+   PREDFPALU = !loads_only;
+   PREDLOAD = true;
+}
+
+static void set_lap_config(const char* config) {
+   unsigned int enable, prefetch;
+   if ((sscanf(config, "%u,%u,%u,%u,%u", &enable, &LAP_NUM_INDEX_BITS, &LAP_NUM_TAG_BITS, &LAP_CONFMAX, &prefetch) != 5) ||
+       (LAP_NUM_INDEX_BITS > 24) || (LAP_NUM_TAG_BITS > 62)) {
+      fprintf(stderr, "Incorrect usage of --lap=<enable>,<#index bits>,<#tag bits>,<confmax>,<prefetch>\n");
+      fprintf(stderr, "...where enable and prefetch are each 0 or 1, <#index bits> is at most 24, and <#tag bits> is at most 62.\n");
+      exit(-1);
+   }
+   LOAD_ADDR_PRED = (enable ? true : false);
+   LAP_PREFETCH = (prefetch ? true : false);
+}
+
+static void set_vp_fpc_config(const char* config) {
+   const char* s = config;
+   int n;
+
+   VP_FPC_LEN = 0;
+   while (VP_FPC_LEN < VP_FPC_MAX_LEN) {
+      if ((sscanf(s, "%u%n", &VP_FPC_LOG2[VP_FPC_LEN], &n) != 1) || (VP_FPC_LOG2[VP_FPC_LEN] > 31))
+         break;
+      VP_FPC_LEN++;
+      s += n;
+      if (*s != ',')
+         break;
+      s++;
+   }
+   if ((VP_FPC_LEN == 0) || (*s != '\0')) {
+      fprintf(stderr, "Incorrect usage of --vp-fpc=<n0>,<n1>,...\n");
+      fprintf(stderr, "...where there are 1 to %d values, each at most 31.\n", VP_FPC_MAX_LEN);
+      exit(-1);
+   }
+   VP_FPC = true;
+}
+
+static void set_vp_crit_config(const char* config) {
+   unsigned int enable;
+   if ((sscanf(config, "%u,%u,%u,%u", &enable, &VP_CRIT_INDEX_BITS, &VP_CRIT_THRESHOLD, &VP_CRIT_MAX) != 4) ||
+       (VP_CRIT_INDEX_BITS > 24) || (VP_CRIT_THRESHOLD > VP_CRIT_MAX)) {
+      fprintf(stderr, "Incorrect usage of --vp-crit=<enable>,<#index bits>,<threshold>,<max>\n");
+      fprintf(stderr, "...where enable is 0 or 1, <#index bits> is at most 24, and <threshold> is at most <max>.\n");
+      exit(-1);
+   }
+   VP_CRIT_FILTER = (enable ? true : false);
+}
+
+static void set_vp_consumer_config(const char* config) {
+   unsigned int enable;
+   if ((sscanf(config, "%u,%u,%u,%u", &enable, &VP_CONSUMER_INDEX_BITS, &VP_CONSUMER_THRESHOLD, &VP_CONSUMER_MAX) != 4) ||
+       (VP_CONSUMER_INDEX_BITS > 24) || (VP_CONSUMER_THRESHOLD > VP_CONSUMER_MAX)) {
+      fprintf(stderr, "Incorrect usage of --vp-consumer=<enable>,<#index bits>,<threshold>,<max>\n");
+      fprintf(stderr, "...where enable is 0 or 1, <#index bits> is at most 24, and <threshold> is at most <max>.\n");
+      exit(-1);
+   }
+   VP_CONSUMER_FILTER = (enable ? true : false);
+}
+
+static void set_iq_wakeup(const char* config) {
+   if ((sscanf(config, "%u", &IQ_WAKEUP) != 1) || (IQ_WAKEUP > 1)) {
+      fprintf(stderr, "Incorrect usage of --iq-wakeup=<0/1>\n");
+      exit(-1);
+   }
+}
+
+static void set_prefetch_config(const char* config, const char* cache, unsigned int& type, unsigned int& degree) {
+   if ((sscanf(config, "%u,%u", &type, &degree) != 2) || (type > PF_STREAM) || (degree == 0)) {
+      fprintf(stderr, "Incorrect usage of --%s-prefetch=<type>,<degree>\n", cache);
+      fprintf(stderr, "...where <type> is 0 (none), 1 (next-line), 2 (PC-stride) or 3 (stream), and <degree> is positive.\n");
+      exit(-1);
+   }
+}
+
+static void set_cache_repl(const char* config) {
+   if ((sscanf(config, "%u", &CACHE_REPL) != 1) || (CACHE_REPL > 2)) {
+      fprintf(stderr, "Incorrect usage of --cache-repl=<0/1/2>\n");
+      exit(-1);
+   }
+}
+
+static void set_iq_select(const char* config) {
+   if ((sscanf(config, "%u", &IQ_SELECT) != 1) || (IQ_SELECT > 1)) {
+      fprintf(stderr, "Incorrect usage of --iq-select=<0/1>\n");
+      exit(-1);
+   }
+}
+
+static void set_uop_cache(const char* config) {
+   if ((sscanf(config, "%u", &UOP_CACHE_SIZE) != 1) || (UOP_CACHE_SIZE & (UOP_CACHE_SIZE - 1))) {
+      fprintf(stderr, "Incorrect usage of --uop-cache=<entries>: must be 0 or a power-of-2.\n");
+      exit(-1);
+   }
+}
+
+// Split a comma-separated option value.
+static std::vector<std::string> split_config(const char* config) {
+   std::vector<std::string> fields;
+   std::string field;
+   std::istringstream in(config);
+   while (std::getline(in, field, ','))
+      fields.push_back(field);
+   return(fields);
+}
+
+static void set_bbv_config(const char* config, uint64_t& interval, std::string& name) {
+   std::vector<std::string> fields = split_config(config);
+   if ((fields.size() != 2) || ((interval = strtoull(fields[0].c_str(), NULL, 10)) == 0) || fields[1].empty()) {
+      fprintf(stderr, "Incorrect usage of --bbv=<interval>,<name>\n");
+      fprintf(stderr, "...where <interval> is positive.\n");
+      exit(-1);
+   }
+   name = fields[1];
+}
+
+static void set_simpoint_config(const char* config, uint64_t& interval, std::string& simpoints_file, std::string& weights_file, std::string& name) {
+   std::vector<std::string> fields = split_config(config);
+   if ((fields.size() != 4) || ((interval = strtoull(fields[0].c_str(), NULL, 10)) == 0) || fields[3].empty()) {
+      fprintf(stderr, "Incorrect usage of --simpoint-chkpt=<interval>,<simpoints_file>,<weights_file>,<name>\n");
+      fprintf(stderr, "...where <interval> is positive, and the same as that of the profiled basic block vectors.\n");
+      exit(-1);
+   }
+   simpoints_file = fields[1];
+   weights_file = fields[2];
+   name = fields[3];
+}
+
+static void set_sweep_config(const char* config, std::string& file, unsigned int& jobs) {
+   std::vector<std::string> fields = split_config(config);
+   if ((fields.size() < 1) || (fields.size() > 2) || fields[0].empty() ||
+       ((fields.size() == 2) && ((jobs = atoi(fields[1].c_str())) == 0))) {
+      fprintf(stderr, "Incorrect usage of --sweep=<config_file>[,<jobs>]\n");
+      fprintf(stderr, "...where <jobs> is positive.\n");
+      exit(-1);
+   }
+   file = fields[0];
+}
+
+// Read the configurations of a sweep: one per line, skipping blank lines and '#' comments.
+static std::vector<std::string> read_sweep_configs(const std::string& file) {
+   std::vector<std::string> configs;
+   std::ifstream in(file.c_str());
+   std::string line;
+   if (!in.good()) {
+      fprintf(stderr, "ERROR: Opening sweep configuration file `%s' failed.\n", file.c_str());
+      exit(-1);
+   }
+   while (std::getline(in, line)) {
+      size_t first = line.find_first_not_of(" \t");
+      if ((first != std::string::npos) && (line[first] != '#'))
+         configs.push_back(line.substr(first));
+   }
+   if (configs.empty()) {
+      fprintf(stderr, "ERROR: No configurations in `%s'.\n", file.c_str());
+      exit(-1);
+   }
+   return(configs);
+}
+
+// Fork a process per configuration, at most 'jobs' at a time. Each process
+// inherits the booted, restored or fast skipped simulators copy-on-write.
+// Returns the configuration's index in its process, or -1 in the parent
+// once all configurations are done ('all_ok' if all exited with 0).
+static int fork_sweep(const std::vector<std::string>& configs, unsigned int jobs, bool& all_ok) {
+   std::map<pid_t, unsigned int> running;
+   unsigned int next = 0;
+   int wstatus;
+   pid_t pid;
+
+   all_ok = true;
+   while ((next < configs.size()) || !running.empty()) {
+      if ((next < configs.size()) && (running.size() < jobs)) {
+         fflush(stdout);
+         fflush(stderr);
+         pid = fork();
+         if (pid == 0)
+            return(next);
+         if (pid < 0) {
+            perror("fork");
+            exit(-1);
+         }
+         fprintf(stderr, "Sweep: configuration %u (pid %d): %s\n", next + 1, (int)pid, configs[next].c_str());
+         running[pid] = next++;
+      }
+      else {
+         pid = wait(&wstatus);
+         assert(running.count(pid));
+         bool ok = (WIFEXITED(wstatus) && (WEXITSTATUS(wstatus) == 0));
+         fprintf(stderr, "Sweep: configuration %u %s\n", running[pid] + 1, (ok ? "done" : "FAILED"));
+         all_ok = (all_ok && ok);
+         running.erase(pid);
+      }
+   }
+   return(-1);
+}
+
+static void set_intervals_config(const char* config, unsigned int& n, uint64_t& length, uint64_t& warmup, unsigned int& jobs) {
+   std::vector<std::string> fields = split_config(config);
+   if ((fields.size() < 3) || (fields.size() > 4) ||
+       ((n = atoi(fields[0].c_str())) == 0) || ((length = strtoull(fields[1].c_str(), NULL, 10)) == 0) ||
+       ((fields.size() == 4) && ((jobs = atoi(fields[3].c_str())) == 0))) {
+      fprintf(stderr, "Incorrect usage of --intervals=<n>,<length>,<warmup>[,<jobs>]\n");
+      fprintf(stderr, "...where <n>, <length> and <jobs> are positive.\n");
+      exit(-1);
+   }
+   warmup = strtoull(fields[2].c_str(), NULL, 10);
+}
+
+// Fast skip through 'n' consecutive intervals of 'length' instructions, forking a
+// process at the start of each interval's 'warmup', at most 'jobs' at a time. The
+// functional and timing simulators ('isa' may be NULL) are skipped in lockstep, and
+// each process inherits them, and the memory they share, copy-on-write. Returns the
+// interval's index in its process, or -1 in the parent once all intervals are done
+// ('all_ok' if all exited with 0). 'forked' intervals were reached before the program ended.
+static int fork_intervals(sim_t* isa, sim_t* micro, unsigned int n, uint64_t length, uint64_t warmup,
+                          unsigned int jobs, bool& all_ok, unsigned int& forked) {
+   std::map<pid_t, unsigned int> running;
+   uint64_t retired = 0;
+   int wstatus;
+   pid_t pid;
+
+   all_ok = true;
+   forked = 0;
+   while (((forked < n) && (running.size() < jobs)) || !running.empty()) {
+      if ((forked < n) && (running.size() < jobs)) {
+         uint64_t start = forked * length;
+         start = ((start > warmup) ? (start - warmup) : 0);
+         if (start > retired) {
+            if ((isa && !isa->run_fast(start - retired)) || !micro->run_fast(start - retired)) {
+               fprintf(stderr, "Intervals: the program ended before interval %u\n", forked + 1);
+               n = forked;
+               continue;
+            }
+            retired = start;
+         }
+
+         fflush(stdout);
+         fflush(stderr);
+         pid = fork();
+         if (pid == 0)
+            return(forked);
+         if (pid < 0) {
+            perror("fork");
+            exit(-1);
+         }
+         fprintf(stderr, "Intervals: interval %u (pid %d) at %" PRIu64 " instructions\n", forked + 1, (int)pid, forked * length);
+         running[pid] = forked++;
+      }
+      else {
+         pid = wait(&wstatus);
+         assert(running.count(pid));
+         bool ok = (WIFEXITED(wstatus) && (WEXITSTATUS(wstatus) == 0));
+         fprintf(stderr, "Intervals: interval %u %s\n", running[pid] + 1, (ok ? "done" : "FAILED"));
+         all_ok = (all_ok && ok);
+         running.erase(pid);
+      }
+   }
+   return(-1);
+}
+
+static void set_sample_config(const char* config) {
+   unsigned int warming;
+   if ((sscanf(config, "%lu,%lu,%lu,%u", &SAMPLE_UNIT, &SAMPLE_WARMUP, &SAMPLE_PERIOD, &warming) != 4) ||
+       (SAMPLE_UNIT == 0) || (SAMPLE_PERIOD < (SAMPLE_UNIT + SAMPLE_WARMUP))) {
+      fprintf(stderr, "Incorrect usage of --sample=<unit>,<warmup>,<period>,<warming>\n");
+      fprintf(stderr, "...where <unit> is positive, <period> is at least <unit>+<warmup>, and <warming> is 0 or 1.\n");
+      exit(-1);
+   }
+   SAMPLING = true;
+   SAMPLE_WARMING = (warming ? true : false);
+}
+
 static void config_IC(const char* config) {
    unsigned int temp_size, temp_blocksize;
    if (sscanf(config, "%u:%u:%u:%u", &temp_size, &L1_IC_ASSOC, &temp_blocksize, &L1_IC_NUM_MHSRs) != 4) {
@@ -327,10 +765,9 @@ sim_t*  s_micro;
 
 static void endSimulation(int signal)
 {
-  //*** Must delete the simulator instances in order to dump stats ***
-  // Stats are dumped in the destructor for the processor instances.
-  delete s_isa;
-  delete s_micro;
+  // Only request the end of the simulation: the timing simulator's run() returns, and main() stops the
+  // checker thread and deletes the simulator instances to dump stats. Neither is async-signal-safe.
+  end_simulation_requested = 1;
 }  
 
 
@@ -349,6 +786,23 @@ int main(int argc, char** argv)
   bool skip_enable = false;   /////////////
 
   std::string checkpoint_file = "";
+  std::string convert_file = "";
+
+  // SimPoint modes
+  uint64_t bbv_interval = 0;
+  std::string bbv_name = "";
+  uint64_t simpoint_interval = 0;
+  std::string simpoints_file = "", weights_file = "", simpoint_name = "";
+  std::string combine_file = "";
+
+  // Configuration sweep
+  std::string sweep_file = "";
+  unsigned int sweep_jobs = sysconf(_SC_NPROCESSORS_ONLN);
+
+  // Parallel interval simulation
+  unsigned int intervals = 0;
+  uint64_t interval_length = 0, interval_warmup = 0;
+  unsigned int interval_jobs = sysconf(_SC_NPROCESSORS_ONLN);
 
   option_parser_t parser;
   parser.help(&help);
@@ -361,12 +815,24 @@ int main(int argc, char** argv)
   parser.option('s', 0, 1, [&](const char* s){skip_amt = atoll(s); skip_enable = true;});
   parser.option('e', 0, 1, [&](const char* s){stop_amt = atoll(s); use_stop_amt = true;});
   parser.option('c', 0, 1, [&](const char* s){checkpoint_file = s;});
+  parser.option(0, "warm-skip", 1, [&](const char* s){FAST_SKIP_WARM_AMT = atoll(s); FAST_SKIP_WARMING = true;});
+  parser.option(0, "convert-chkpt", 1, [&](const char* s){convert_file = s;});
+  parser.option(0, "bbv", 1, [&](const char* s){set_bbv_config(s, bbv_interval, bbv_name);});
+  parser.option(0, "simpoint-chkpt", 1, [&](const char* s){set_simpoint_config(s, simpoint_interval, simpoints_file, weights_file, simpoint_name);});
+  parser.option(0, "combine-stats", 1, [&](const char* s){combine_file = s;});
+  parser.option(0, "sweep", 1, [&](const char* s){set_sweep_config(s, sweep_file, sweep_jobs);});
+  parser.option(0, "intervals", 1, [&](const char* s){set_intervals_config(s, intervals, interval_length, interval_warmup, interval_jobs);});
   parser.option(0, "IC", 1, [&](const char* s){config_IC(s);});
   parser.option(0, "DC", 1, [&](const char* s){config_DC(s);});
   parser.option(0, "L2", 1, [&](const char* s){config_L2(s);});
   parser.option(0, "L3", 1, [&](const char* s){config_L3(s);});
   parser.option(0, "L2L3exist", 1, [&](const char* s){config_L2L3present(s);});
   parser.option(0, "MEMLAT", 1, [&](const char* s){L1_IC_MISS_LATENCY = L1_DC_MISS_LATENCY = L2_MISS_LATENCY = atoi(s);});
+  parser.option(0, "cache-repl", 1, [&](const char* s){set_cache_repl(s);});
+  parser.option(0, "IC-prefetch", 1, [&](const char* s){set_prefetch_config(s, "IC", L1_IC_PREFETCHER, L1_IC_PREFETCH_DEGREE);});
+  parser.option(0, "DC-prefetch", 1, [&](const char* s){set_prefetch_config(s, "DC", L1_DC_PREFETCHER, L1_DC_PREFETCH_DEGREE);});
+  parser.option(0, "L2-prefetch", 1, [&](const char* s){set_prefetch_config(s, "L2", L2_PREFETCHER, L2_PREFETCH_DEGREE);});
+  parser.option(0, "L3-prefetch", 1, [&](const char* s){set_prefetch_config(s, "L3", L3_PREFETCHER, L3_PREFETCH_DEGREE);});
   parser.option(0, "perf", 1, [&](const char* s){set_perfect_flags(s);});
   parser.option(0, "cp"  , 1, [&](const char* s){NUM_CHECKPOINTS = atoi(s);});
 
@@ -380,7 +846,23 @@ int main(int argc, char** argv)
   parser.option(0, "cbpBHR", 1, [&](const char* s){CBP_BHR_LENGTH = atoi(s);});
   parser.option(0, "ibpPC", 1, [&](const char* s){IBP_PC_LENGTH = atoi(s);});
   parser.option(0, "ibpBHR", 1, [&](const char* s){IBP_BHR_LENGTH = atoi(s);});
+  parser.option(0, "ibpALG", 1, [&](const char* s){set_ibp_algorithm(s);});
+  parser.option(0, "ittage", 1, [&](const char* s){set_ittage_config(s);});
   parser.option('t', 0, 0, [&](const char* s){ENABLE_TRACE_CACHE = true;});
+  parser.option(0, "tc", 1, [&](const char* s){set_tc_config(s);});
+  parser.option(0, "vp-enable", 1, [&](const char* s){VALUE_PRED_EN = (atoi(s) ? true : false);});
+  parser.option(0, "vp-perf", 1, [&](const char* s){PERFECT_VALUE_PRED = (atoi(s) ? true : false);});
+  parser.option(0, "vp-svp", 1, [&](const char* s){set_svp_config(s);});
+  parser.option(0, "vp-recovery", 1, [&](const char* s){set_vp_recovery(s);});
+  parser.option(0, "vp", 1, [&](const char* s){set_vp_algorithm(s);});
+  parser.option(0, "vp-loads-only", 1, [&](const char* s){set_vp_loads_only(s);});
+  parser.option(0, "lap", 1, [&](const char* s){set_lap_config(s);});
+  parser.option(0, "vp-fpc", 1, [&](const char* s){set_vp_fpc_config(s);});
+  parser.option(0, "vp-crit", 1, [&](const char* s){set_vp_crit_config(s);});
+  parser.option(0, "vp-consumer", 1, [&](const char* s){set_vp_consumer_config(s);});
+  parser.option(0, "vp-fcm", 1, [&](const char* s){set_fcm_config(s);});
+  parser.option(0, "vp-vtage", 1, [&](const char* s){set_vtage_config(s);});
+  parser.option(0, "vp-hybrid", 1, [&](const char* s){set_hybrid_vp_config(s);});
 
   parser.option(0, "fq"  , 1, [&](const char* s){FETCH_QUEUE_SIZE = atoi(s);});
   parser.option(0, "al"  , 1, [&](const char* s){ACTIVE_LIST_SIZE = atoi(s);});
@@ -389,14 +871,21 @@ int main(int argc, char** argv)
   parser.option(0, "iqnp", 1, [&](const char* s){ISSUE_QUEUE_NUM_PARTS = atoi(s);});
   parser.option('a', 0, 0, [&](const char* s){PRESTEER = true;});
   parser.option('b', 0, 0, [&](const char* s){IDEAL_AGE_BASED = true;});
+  parser.option(0, "iq-wakeup", 1, [&](const char* s){set_iq_wakeup(s);});
+  parser.option(0, "iq-select", 1, [&](const char* s){set_iq_select(s);});
   parser.option(0, "lsq" , 1, [&](const char* s){LQ_SIZE = atoi(s);SQ_SIZE = atoi(s);});
   parser.option(0, "mdp", 1, [&](const char* s){set_mdp_flags(s);});
+  parser.option(0, "mdp-tables", 1, [&](const char* s){set_mdp_tables(s);});
   parser.option(0, "splitstores" , 1, [&](const char* s){SPLIT_STORES = (atoi(s) ? true : false);});
   parser.option(0, "fw"  , 1, [&](const char* s){FETCH_WIDTH = atoi(s);});
   parser.option(0, "dw"  , 1, [&](const char* s){DISPATCH_WIDTH = atoi(s);});
   parser.option(0, "iw"  , 1, [&](const char* s){ISSUE_WIDTH = atoi(s);});
   parser.option(0, "rw"  , 1, [&](const char* s){RETIRE_WIDTH = atoi(s);});
   parser.option(0, "phase",1, [&](const char *s){phase_interval = atoll(s);});
+  parser.option(0, "idle-ff",1, [&](const char *s){IDLE_FAST_FORWARD = (atoi(s) ? true : false);});
+  parser.option(0, "uop-cache", 1, [&](const char* s){set_uop_cache(s);});
+  parser.option(0, "sample", 1, [&](const char* s){set_sample_config(s);});
+  parser.option(0, "async-checker", 1, [&](const char* s){PIPE_ASYNC = (atoi(s) ? true : false);});
   parser.option(0, "lane" ,1, [&](const char *s){set_lane_matrix(s);});
   parser.option(0, "lat"  ,1, [&](const char *s){set_lane_latencies(s);});
   parser.option('u', 0, 0, [&](const char* s){set_lane_matrix("0xffff:0xffff:0xffff:0xffff:0xffff:0xffff:0xffff"); set_lane_latencies("1:1:1:1:1:1:1");});
@@ -408,25 +897,72 @@ int main(int argc, char** argv)
       FETCH_QUEUE_SIZE = 64;});
 
   auto argv1 = parser.parse(argv);
+
+  if (convert_file != "") {
+    std::string out_file = convert_file;
+    if (out_file.substr(out_file.find_last_of(".") + 1) == "gz")
+      out_file.erase(out_file.find_last_of("."));
+    out_file += "." CHKPT_EXT;
+    return (sim_t::convert_checkpoint(convert_file, out_file) ? 0 : -1);
+  }
+
+  if (combine_file != "")
+    return (simpoint_combine_stats(combine_file, stdout) ? 0 : -1);
+
   if (!*argv1)
     help();
   std::vector<std::string> htif_args(argv1, (const char*const*)argv + argc);
 
+  if (bbv_interval || simpoint_interval) {
+    // Only the functional simulator is needed, from boot.
+    sim_t* s_func = new sim_t(nprocs, mem_mb, htif_args, ISA_SIM);
+    bool ok;
+
+    s_func->boot();
+    if (bbv_interval)
+      ok = simpoint_bbv(s_func, bbv_interval, bbv_name, (use_stop_amt ? stop_amt : (uint64_t)-1));
+    else
+      ok = simpoint_checkpoints(s_func, simpoint_interval, simpoints_file, weights_file, simpoint_name);
+    delete s_func;
+    return (ok ? 0 : -1);
+  }
+
+  if ((sweep_file != "") && intervals) {
+    fprintf(stderr, "ERROR: --sweep and --intervals are exclusive.\n");
+    exit(-1);
+  }
+
+  std::vector<std::string> sweep_configs;
+  if (sweep_file != "")
+    sweep_configs = read_sweep_configs(sweep_file);
+  if ((sweep_file != "") || intervals) {
+    // The functional simulator is stepped by the thread that created it,
+    // which is the only thread to survive a fork.
+    PIPE_ASYNC = false;
+  }
+
   #ifdef RISCV_MICRO_CHECKER
-  s_isa = new sim_t(nprocs, mem_mb, htif_args, ISA_SIM);
+  DB = new debug_buffer_t(PIPE_QUEUE_SIZE);
+
+  if (PIPE_ASYNC) {
+    // The functional simulator is created by, and runs on, the debug buffer's producer thread.
+    s_isa = DB->create_async([&](){ return new sim_t(nprocs, mem_mb, htif_args, ISA_SIM); });
+  }
+  else {
+    s_isa = new sim_t(nprocs, mem_mb, htif_args, ISA_SIM);
+
+    DB->set_isa_sim(s_isa);
+    s_isa->set_procs_pipe(DB);
+  }
   #endif
 
-  s_micro = new sim_t(nprocs, mem_mb, htif_args, MICRO_SIM);
+  // In a sweep or in parallel interval simulation, the pipelines are built by each configuration's or interval's process.
+  s_micro = new sim_t(nprocs, mem_mb, htif_args, MICRO_SIM, ((sweep_file != "") || intervals));
 
   s_micro->set_debug(debug);
   s_micro->set_histogram(histogram);
 
   #ifdef RISCV_MICRO_CHECKER
-    DB = new debug_buffer_t(PIPE_QUEUE_SIZE);
-
-    DB->set_isa_sim(s_isa);
-
-    s_isa->set_procs_pipe(DB);
     s_micro->set_procs_pipe(DB);
   #endif
 
@@ -458,7 +994,7 @@ int main(int argc, char** argv)
 
   sigIntHandler.sa_handler = endSimulation;
   sigemptyset(&sigIntHandler.sa_mask);
-  sigIntHandler.sa_flags = 0;
+  sigIntHandler.sa_flags = SA_RESTART;	// e.g., sweep and interval parents keep waiting for their children
 
   sigaction(SIGINT,   &sigIntHandler, NULL);
 
@@ -529,23 +1065,35 @@ int main(int argc, char** argv)
     logging_on = true;
 
   #ifdef RISCV_MICRO_CHECKER
-    s_isa->boot();
+    auto isa_sim_setup = [&]() {
+      s_isa->boot();
 
-    if (checkpoint_file != "")
-    {
-      fprintf(stderr, "Restoring checkpoint from %s\n",checkpoint_file.c_str());
-      s_isa->restore_checkpoint(checkpoint_file);
-    }
-    else if (skip_enable) {
-      // If skip amount is provided, fast skip in the ISA sim
-      //s_isa->init_checkpoint("isa_checkpoint");
-      fprintf(stderr, "Fast skipping Spike for %lu instructions\n",skip_amt);
-      htif_code = s_isa->run_fast(skip_amt);
-      //htif_code = s_isa->create_checkpoint();
+      if (checkpoint_file != "")
+      {
+        fprintf(stderr, "Restoring checkpoint from %s\n",checkpoint_file.c_str());
+        s_isa->restore_checkpoint(checkpoint_file);
+      }
+      if (skip_enable) {
+        // If skip amount is provided, fast skip in the ISA sim
+        //s_isa->init_checkpoint("isa_checkpoint");
+        fprintf(stderr, "Fast skipping Spike for %lu instructions\n",skip_amt);
+        s_isa->run_fast(skip_amt);
+        //htif_code = s_isa->create_checkpoint();
+      }
+    };
+
+    if (PIPE_ASYNC) {
+      // Set up the functional simulator and fill the debug buffer on the producer thread,
+      // concurrently with setting up the timing simulator.
+      DB->run_async(isa_sim_setup);
     }
+    else {
+      isa_sim_setup();
 
-    // Fill the debug buffer
-    DB->run_ahead();
+      // Fill the debug buffer (in parallel interval simulation, by each interval's process).
+      if (!intervals)
+        DB->run_ahead();
+    }
   #endif
 
 
@@ -557,12 +1105,17 @@ int main(int argc, char** argv)
       fprintf(stderr, "Restoring checkpoint from %s\n",checkpoint_file.c_str());
       s_micro->restore_checkpoint(checkpoint_file);
   }
-  else if (skip_enable) {
+  if (skip_enable) {
       // If skip amount is provided, fast skip in the MICROS sim
       fprintf(stderr, "Fast skipping MICROS for %lu instructions\n",skip_amt);
       htif_code = s_micro->run_fast(skip_amt);
       // Stop simulation if HTIF returns non-zero code
-      if(!htif_code) return htif_code;
+      if(!htif_code) {
+        #ifdef RISCV_MICRO_CHECKER
+          DB->stop_async();
+        #endif
+        return htif_code;
+      }
   }
 
   //htif_code = s_micro->create_checkpoint();
@@ -573,10 +1126,84 @@ int main(int argc, char** argv)
   if(logging_on_at == 0)
     logging_on = true;
 
+  std::string stats_name;
+  if (sweep_file != "") {
+    bool all_ok;
+    int config = fork_sweep(sweep_configs, sweep_jobs, all_ok);
+    if (config < 0)
+      return (all_ok ? 0 : -1);
+
+    // This configuration's process: apply its options on top of the command line's.
+    std::istringstream config_in(sweep_configs[config]);
+    std::vector<std::string> config_opts;
+    std::vector<const char*> config_argv(1, argv[0]);
+    std::string opt;
+    while (config_in >> opt)
+      config_opts.push_back(opt);
+    for (unsigned int i = 0; i < config_opts.size(); i++)
+      config_argv.push_back(config_opts[i].c_str());
+    config_argv.push_back(NULL);
+    if (*parser.parse(config_argv.data())) {
+      fprintf(stderr, "Sweep: configuration %d may only have options: %s\n", config + 1, sweep_configs[config].c_str());
+      exit(-1);
+    }
+
+    stats_name = "stats." + std::to_string(config + 1);
+    STATS_LOG_NAME = stats_name.c_str();
+    s_micro->build_pipelines();
+  }
+  else if (intervals) {
+    // The stats logs of all intervals are named after the start of the run.
+    time_t now = time(0);
+    char date[32];
+    strftime(date, sizeof(date), "%y-%m-%d.%H:%M:%S", localtime(&now));
+    std::string prefix = std::string(STATS_LOG_NAME) + "." + date;
+
+    bool all_ok;
+    unsigned int forked;
+    #ifdef RISCV_MICRO_CHECKER
+      int interval = fork_intervals(s_isa, s_micro, intervals, interval_length, interval_warmup, interval_jobs, all_ok, forked);
+    #else
+      int interval = fork_intervals((sim_t*)NULL, s_micro, intervals, interval_length, interval_warmup, interval_jobs, all_ok, forked);
+    #endif
+    if (interval < 0) {
+      std::vector<std::string> logs;
+      for (unsigned int i = 0; i < forked; i++)
+        logs.push_back(prefix + ".interval" + std::to_string(i + 1) + ".log");
+      std::string merged_name = prefix + ".merged.log";
+      FILE* merged = fopen(merged_name.c_str(), "w");
+      if (!merged) {
+        fprintf(stderr, "ERROR: Opening file `%s' failed.\n", merged_name.c_str());
+        return -1;
+      }
+      bool ok = (all_ok && interval_merge_stats(logs, merged));
+      fclose(merged);
+      if (ok)
+        fprintf(stderr, "Intervals: merged the stats of %u intervals to %s\n", forked, merged_name.c_str());
+      return (ok ? 0 : -1);
+    }
+
+    // This interval's process: detailed warmup, then the measured interval.
+    uint64_t start = interval * interval_length;
+    STATS_WARMUP = ((start > interval_warmup) ? interval_warmup : start);
+    use_stop_amt = true;
+    stop_amt = STATS_WARMUP + interval_length;
+    stats_name = prefix + ".interval" + std::to_string(interval + 1) + ".log";
+    STATS_LOG_FILE = stats_name.c_str();
+    #ifdef RISCV_MICRO_CHECKER
+      DB->run_ahead();
+    #endif
+    s_micro->build_pipelines();
+  }
+
   fprintf(stderr, "Starting MICROS\n");
   htif_code = s_micro->run();
   fprintf(stderr, "Stopping MICROS: HTIF Exit Code %d\n",htif_code);
 
+  #ifdef RISCV_MICRO_CHECKER
+    DB->stop_async();
+  #endif
+
   //*** Must delete the simulator instances in order to dump stats ***
   // Stats are dumped in the destructor for the processor instances.
   delete s_isa;
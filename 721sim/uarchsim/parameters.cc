@@ -1,8 +1,11 @@
 #include <cinttypes>
+#include <cstddef>
 #include "fu.h"
+#include "parameters.h"
 
 // Pipe control
 uint32_t PIPE_QUEUE_SIZE  = 8192;
+bool     PIPE_ASYNC       = true;	// Run the functional simulator (checker) on its own thread.
 
 
 
@@ -34,10 +37,22 @@ bool SPEC_DISAMBIG = false;
 bool MEM_DEP_PRED = false;
 bool MDP_STICKY = false;
 unsigned int MDP_MAX = 63;
+unsigned int MDP_NUM_INDEX_BITS = 10;	// MDP-sticky, MDP-ctr: direct-mapped table of 2^n counters, tagged with the load PC.
+bool MDP_STORE_SETS = false;		// Store sets: loads only wait for the store predicted to produce their value.
+unsigned int SSIT_NUM_INDEX_BITS = 10;	// Store sets: Store Set ID Table (SSIT) of 2^n entries, indexed by load/store PC.
+unsigned int LFST_SIZE = 128;		// Store sets: Last Fetched Store Table (LFST) entries, i.e., number of store sets.
+unsigned int SSIT_CLEAR_INTERVAL = 100000;	// Store sets: invalidate the SSIT every n retired loads (0: never).
+bool LOAD_ADDR_PRED = false;		// Load address predictor: probe (and prefetch into) the D$ at dispatch with predicted load addresses.
+unsigned int LAP_NUM_INDEX_BITS = 10;
+unsigned int LAP_NUM_TAG_BITS = 14;
+unsigned int LAP_CONFMAX = 3;
+bool LAP_PREFETCH = true;
 bool SPLIT_STORES = false;
 
 bool PRESTEER = false;
 bool IDEAL_AGE_BASED = false;
+unsigned int IQ_WAKEUP = 1;	/* 0: CAM scan of all IQ entries, 1: per-physical-register consumer lists. */
+unsigned int IQ_SELECT = 1;	/* 0: scan all IQ entries, 1: bit-scan the ready bitmap. */
 uint32_t FU_LANE_MATRIX[(unsigned int)NUMBER_FU_TYPES] = {0x5A5A /*     BR: 0101 1010 */ ,
                                                           0x2121 /*     LS: 0010 0001 */ ,
                                                           0x5A5A /*  ALU_S: 0101 1010 */ ,
@@ -82,6 +97,8 @@ unsigned int L1_DC_MISS_LATENCY     = 100; // Used only when no L2 cache
 unsigned int L1_DC_NUM_MHSRs        = 128; 
 unsigned int L1_DC_MISS_SRV_PORTS   = 128;
 unsigned int L1_DC_MISS_SRV_LATENCY = 1;
+unsigned int L1_DC_PREFETCHER       = 0;	// Prefetcher (0: none, 1: next-line, 2: PC-stride, 3: stream).
+unsigned int L1_DC_PREFETCH_DEGREE  = 2;	// Lines prefetched per trigger.
 
 // L1 Instruction Cache.
 unsigned int L1_IC_SETS             = 128;
@@ -92,6 +109,8 @@ unsigned int L1_IC_MISS_LATENCY     = 100; // Used only when no L2 cache
 unsigned int L1_IC_NUM_MHSRs        = 32;
 unsigned int L1_IC_MISS_SRV_PORTS   = 1;
 unsigned int L1_IC_MISS_SRV_LATENCY = 1;
+unsigned int L1_IC_PREFETCHER       = 0;	// Prefetcher (0: none, 1: next-line, 2: PC-stride, 3: stream).
+unsigned int L1_IC_PREFETCH_DEGREE  = 2;	// Lines prefetched per trigger.
 
 // L2 Unified Cache.
 bool         L2_PRESENT           = true;
@@ -103,6 +122,8 @@ unsigned int L2_MISS_LATENCY      = 100;  // Used only when no L3
 unsigned int L2_NUM_MHSRs         = 128; 
 unsigned int L2_MISS_SRV_PORTS    = 128;
 unsigned int L2_MISS_SRV_LATENCY  = 1;
+unsigned int L2_PREFETCHER        = 0;	// Prefetcher (0: none, 1: next-line, 2: PC-stride, 3: stream).
+unsigned int L2_PREFETCH_DEGREE   = 2;	// Lines prefetched per trigger.
 
 // L3 Unified Cache.
 bool         L3_PRESENT           = true;
@@ -114,6 +135,10 @@ unsigned int L3_MISS_LATENCY      = 100;  // Used only when no L4
 unsigned int L3_NUM_MHSRs         = 128; 
 unsigned int L3_MISS_SRV_PORTS    = 128;
 unsigned int L3_MISS_SRV_LATENCY  = 1;
+unsigned int L3_PREFETCHER        = 0;	// Prefetcher (0: none, 1: next-line, 2: PC-stride, 3: stream).
+unsigned int L3_PREFETCH_DEGREE   = 2;	// Lines prefetched per trigger.
+
+unsigned int CACHE_REPL           = 0;	// Replacement policy of all caches (0: LRU, 1: tree-PLRU, 2: SRRIP).
 
 // Branch prediction unit
 bool AUTO_BQ_SIZE = true;
@@ -127,7 +152,57 @@ unsigned int CBP_PC_LENGTH = 20;
 unsigned int CBP_BHR_LENGTH = 16;
 unsigned int IBP_PC_LENGTH = 20;
 unsigned int IBP_BHR_LENGTH = 16;
+unsigned int IBP_ALGORITHM = 0;		// Indirect branch predictor: 0: gshare, 1: ITTAGE.
+unsigned int ITTAGE_NUM_TABLES = 8;	// ITTAGE: tagged tables ...
+unsigned int ITTAGE_LOG2_SIZE = 10;	// ... and log2 of the entries of each table (tagged tables and base table) ...
+unsigned int ITTAGE_MIN_HIST = 4;	// ... with history lengths from ...
+unsigned int ITTAGE_MAX_HIST = 640;	// ... to, in a geometric series.
 bool ENABLE_TRACE_CACHE = false;
+unsigned int TC_SETS = 256;		// Real trace cache (-t without a perfect T$): sets (power-of-2) ...
+unsigned int TC_ASSOC = 4;		// ... and ways, shared by the paths from a start pc.
+unsigned int TC_MAX_CB = 0;		// Maximum number of conditional branches in a trace (0: the number of predictions per cycle).
+unsigned int TC_MAX_LENGTH = 0;		// Maximum number of instructions in a trace (0: the fetch width).
+bool TC_PARTIAL_HIT = true;		// Supply the matching prefix of a trace whose embedded branches don't all match the predictions.
+
+// Value prediction unit
+bool VALUE_PRED_EN = false;
+bool PERFECT_VALUE_PRED = false;
+unsigned int VP_ALGORITHM = 0;	/* 0: svp, 1: lvp, 2: fcm, 3: vtage, 4: hybrid. */
+const char* vp_algorithm_name[] = {"svp", "lvp", "fcm", "vtage", "hybrid"};
+unsigned int SVP_VPQ_SIZE = 200;
+bool SVP_ORACLE_CONF = false;
+unsigned int SVP_NUM_INDEX_BITS = 10;
+unsigned int SVP_NUM_TAG_BITS = 14;
+unsigned int SVP_CONFMAX = 3;
+unsigned int SVP_CONFINC = 1;
+unsigned int SVP_CONFDEC = 3;		// a stride mismatch resets confidence
+unsigned int SVP_REPLACE_STRIDE = 1;
+unsigned int SVP_REPLACE = 1;
+unsigned int FCM_VHT_INDEX_BITS = 10;
+unsigned int FCM_VPT_INDEX_BITS = 12;
+unsigned int FCM_ORDER = 4;
+unsigned int VTAGE_BASE_INDEX_BITS = 10;
+unsigned int VTAGE_NUM_TABLES = 6;
+unsigned int VTAGE_INDEX_BITS = 10;
+unsigned int VTAGE_TAG_BITS = 12;
+unsigned int VTAGE_MIN_HIST = 2;
+unsigned int VTAGE_MAX_HIST = 64;
+unsigned int HYBRID_CHOOSER_INDEX_BITS = 10;
+bool PREDINTALU = true;
+bool PREDFPALU = true;
+bool PREDLOAD = true;
+bool VP_FPC = false;		// Forward probabilistic confidence counters.
+unsigned int VP_FPC_LOG2[VP_FPC_MAX_LEN];	// Increment conf with probability 1/2^VP_FPC_LOG2[conf].
+unsigned int VP_FPC_LEN = 0;
+bool VP_CRIT_FILTER = false;	// Only use confident predictions of PCs that stall the ROB head.
+unsigned int VP_CRIT_INDEX_BITS = 10;
+unsigned int VP_CRIT_THRESHOLD = 8;
+unsigned int VP_CRIT_MAX = 63;
+bool VP_CONSUMER_FILTER = false;	// Only use confident predictions of PCs whose consumers wait in the IQ.
+unsigned int VP_CONSUMER_INDEX_BITS = 10;
+unsigned int VP_CONSUMER_THRESHOLD = 2;
+unsigned int VP_CONSUMER_MAX = 3;
+unsigned int VP_RECOVERY = 0;	/* 0: squash at retire, 1: checkpoint rollback at writeback, 2: selective replay. */
 
 // Benchmark control.
 bool logging_on                     = false;
@@ -137,4 +212,19 @@ bool use_stop_amt                   = false;
 uint64_t stop_amt                   = 0xffffffffffffffff;
 
 uint64_t phase_interval             = 10000;
+
+const char* STATS_LOG_NAME          = "stats";	// Stats log: <name>.<date>.<time>.log
+const char* STATS_LOG_FILE          = NULL;	// If set, the stats log's file name, instead of the above.
+uint64_t STATS_WARMUP               = 0;	// Reset the stats counters after this many instructions are retired (0: never).
+
+bool IDLE_FAST_FORWARD              = false;	// Skip idle cycles (pipeline blocked until a cache miss resolves).
+
+bool SAMPLING                       = false;	// Sampled simulation (SMARTS): functional phases, detailed warmup, measured sampling units.
+uint64_t SAMPLE_UNIT                = 1000;	// Instructions per sampling unit.
+uint64_t SAMPLE_WARMUP              = 2000;	// Instructions of detailed warmup before each sampling unit.
+uint64_t SAMPLE_PERIOD              = 100000;	// Instructions per period (one sampling unit per period).
+bool SAMPLE_WARMING                 = true;	// Functional warming of the caches and predictors during the functional phases.
+bool FAST_SKIP_WARMING              = false;	// Fast skip (run_fast()) warms the caches with the functional simulator's fetches, loads and stores.
+uint64_t FAST_SKIP_WARM_AMT         = 0;	// Only the last this many fast-skipped instructions warm the caches (0: all of them).
+unsigned int UOP_CACHE_SIZE         = 1024;	// Entries in the decoded instruction cache used by the Decode Stage (power of two, 0: decode every instruction).
 uint64_t verbose_phase_counters     = true;
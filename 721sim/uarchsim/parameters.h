@@ -4,6 +4,7 @@
 
 // Pipe control
 extern unsigned int PIPE_QUEUE_SIZE;
+extern bool PIPE_ASYNC;
 
 
 // Oracle controls.
@@ -34,9 +35,21 @@ extern bool         SPEC_DISAMBIG;
 extern bool         MEM_DEP_PRED;
 extern bool         MDP_STICKY;
 extern unsigned int MDP_MAX;
+extern unsigned int MDP_NUM_INDEX_BITS;
+extern bool         MDP_STORE_SETS;
+extern unsigned int SSIT_NUM_INDEX_BITS;
+extern unsigned int LFST_SIZE;
+extern unsigned int SSIT_CLEAR_INTERVAL;
+extern bool         LOAD_ADDR_PRED;
+extern unsigned int LAP_NUM_INDEX_BITS;
+extern unsigned int LAP_NUM_TAG_BITS;
+extern unsigned int LAP_CONFMAX;
+extern bool         LAP_PREFETCH;
 extern bool         SPLIT_STORES;
 extern bool         PRESTEER;
 extern bool         IDEAL_AGE_BASED;
+extern unsigned int IQ_WAKEUP;
+extern unsigned int IQ_SELECT;
 extern unsigned int FU_LANE_MATRIX[];
 extern unsigned int FU_LAT[];
 
@@ -49,6 +62,8 @@ extern unsigned int L1_DC_MISS_LATENCY;
 extern unsigned int L1_DC_NUM_MHSRs;
 extern unsigned int L1_DC_MISS_SRV_PORTS;
 extern unsigned int L1_DC_MISS_SRV_LATENCY;
+extern unsigned int L1_DC_PREFETCHER;
+extern unsigned int L1_DC_PREFETCH_DEGREE;
 
 // L1 Instruction Cache.
 extern unsigned int L1_IC_SETS;
@@ -59,6 +74,8 @@ extern unsigned int L1_IC_MISS_LATENCY;
 extern unsigned int L1_IC_NUM_MHSRs;
 extern unsigned int L1_IC_MISS_SRV_PORTS;
 extern unsigned int L1_IC_MISS_SRV_LATENCY;
+extern unsigned int L1_IC_PREFETCHER;
+extern unsigned int L1_IC_PREFETCH_DEGREE;
 
 // L2 Unified Cache.
 extern bool         L2_PRESENT;
@@ -70,6 +87,8 @@ extern unsigned int L2_MISS_LATENCY;
 extern unsigned int L2_NUM_MHSRs; 
 extern unsigned int L2_MISS_SRV_PORTS;
 extern unsigned int L2_MISS_SRV_LATENCY;
+extern unsigned int L2_PREFETCHER;
+extern unsigned int L2_PREFETCH_DEGREE;
 
 // L3 Unified Cache.
 extern bool         L3_PRESENT;
@@ -81,6 +100,11 @@ extern unsigned int L3_MISS_LATENCY;
 extern unsigned int L3_NUM_MHSRs; 
 extern unsigned int L3_MISS_SRV_PORTS;
 extern unsigned int L3_MISS_SRV_LATENCY;
+extern unsigned int L3_PREFETCHER;
+extern unsigned int L3_PREFETCH_DEGREE;
+
+// Replacement policy of all caches (0: LRU, 1: tree-PLRU, 2: SRRIP).
+extern unsigned int CACHE_REPL;
 
 // Branch prediction unit
 extern bool AUTO_BQ_SIZE;
@@ -94,7 +118,59 @@ extern unsigned int CBP_PC_LENGTH;
 extern unsigned int CBP_BHR_LENGTH;
 extern unsigned int IBP_PC_LENGTH;
 extern unsigned int IBP_BHR_LENGTH;
+extern unsigned int IBP_ALGORITHM;
+extern unsigned int ITTAGE_NUM_TABLES;
+extern unsigned int ITTAGE_LOG2_SIZE;
+extern unsigned int ITTAGE_MIN_HIST;
+extern unsigned int ITTAGE_MAX_HIST;
 extern bool ENABLE_TRACE_CACHE;
+extern unsigned int TC_SETS;
+extern unsigned int TC_ASSOC;
+extern unsigned int TC_MAX_CB;
+extern unsigned int TC_MAX_LENGTH;
+extern bool TC_PARTIAL_HIT;
+
+// Value prediction unit
+extern bool VALUE_PRED_EN;
+extern bool PERFECT_VALUE_PRED;
+#define NUM_VP_ALGORITHMS	5
+extern unsigned int VP_ALGORITHM;
+extern const char* vp_algorithm_name[NUM_VP_ALGORITHMS];
+extern unsigned int SVP_VPQ_SIZE;
+extern bool SVP_ORACLE_CONF;
+extern unsigned int SVP_NUM_INDEX_BITS;
+extern unsigned int SVP_NUM_TAG_BITS;
+extern unsigned int SVP_CONFMAX;
+extern unsigned int SVP_CONFINC;
+extern unsigned int SVP_CONFDEC;
+extern unsigned int SVP_REPLACE_STRIDE;
+extern unsigned int SVP_REPLACE;
+extern unsigned int FCM_VHT_INDEX_BITS;
+extern unsigned int FCM_VPT_INDEX_BITS;
+extern unsigned int FCM_ORDER;
+extern unsigned int VTAGE_BASE_INDEX_BITS;
+extern unsigned int VTAGE_NUM_TABLES;
+extern unsigned int VTAGE_INDEX_BITS;
+extern unsigned int VTAGE_TAG_BITS;
+extern unsigned int VTAGE_MIN_HIST;
+extern unsigned int VTAGE_MAX_HIST;
+extern unsigned int HYBRID_CHOOSER_INDEX_BITS;
+extern bool PREDINTALU;
+extern bool PREDFPALU;
+extern bool PREDLOAD;
+#define VP_FPC_MAX_LEN	16
+extern bool VP_FPC;
+extern unsigned int VP_FPC_LOG2[VP_FPC_MAX_LEN];
+extern unsigned int VP_FPC_LEN;
+extern bool VP_CRIT_FILTER;
+extern unsigned int VP_CRIT_INDEX_BITS;
+extern unsigned int VP_CRIT_THRESHOLD;
+extern unsigned int VP_CRIT_MAX;
+extern bool VP_CONSUMER_FILTER;
+extern unsigned int VP_CONSUMER_INDEX_BITS;
+extern unsigned int VP_CONSUMER_THRESHOLD;
+extern unsigned int VP_CONSUMER_MAX;
+extern unsigned int VP_RECOVERY;
 
 // Benchmark control.
 extern bool logging_on;
@@ -104,6 +180,25 @@ extern bool use_stop_amt;
 extern uint64_t stop_amt;
 
 extern uint64_t phase_interval;
+
+extern const char* STATS_LOG_NAME;
+extern const char* STATS_LOG_FILE;
+extern uint64_t STATS_WARMUP;
+
+extern bool IDLE_FAST_FORWARD;
+
+// Sampled simulation (SMARTS).
+extern bool SAMPLING;
+extern uint64_t SAMPLE_UNIT;
+extern uint64_t SAMPLE_WARMUP;
+extern uint64_t SAMPLE_PERIOD;
+extern bool SAMPLE_WARMING;
+
+// Functional cache warming during fast skip.
+extern bool FAST_SKIP_WARMING;
+extern uint64_t FAST_SKIP_WARM_AMT;
+
+extern unsigned int UOP_CACHE_SIZE;
 extern uint64_t verbose_phase_counters;
 
 #endif //PARAMETERS_H
@@ -103,6 +103,7 @@ unsigned int payload::push() {
 	unsigned int index;
 
 	index = tail;
+	buf[index].issued = false;
 
 	// Increment tail by two, since each instruction is pre-allocated
 	// two entries, even and odd, to accommodate instruction splitting.
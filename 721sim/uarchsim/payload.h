@@ -58,7 +58,12 @@ public:
 	bool valid() { return content_valid; };
 };
 
-typedef struct {
+struct payload_t;
+
+// Function that executes an ALU instruction (see alu_ops/alu_ops.h).
+typedef reg_t (*alu_op_func_t)(payload_t &pay_buf, const state_t &state);
+
+typedef struct payload_t {
 
    ////////////////////////
    // Set by Fetch1 Stage.
@@ -95,6 +100,11 @@ typedef struct {
 
    unsigned int pred_tag;       // If the instruction is a branch, this is its
                                 // index into the Fetch Unit's branch queue.
+                                // Otherwise, this is the branch queue's tail
+                                // when the instruction was fetched, i.e., the
+                                // index of the next branch. It marks the
+                                // instruction's position among the branches,
+                                // for restarting fetch right after it.
 
    ////////////////////////
    // Set by Decode Stage.
@@ -162,6 +172,9 @@ typedef struct {
    bool left;			// Relic of PISA ISA - no longer used.
    bool right;			// Relic of PISA ISA - no longer used.
 
+   alu_op_func_t alu_op_fn;     // The function that executes the instruction
+                                // in the ALU, resolved once at decode.
+
    ////////////////////////
    // Set by Rename Stage.
    ////////////////////////
@@ -180,10 +193,37 @@ typedef struct {
                                 // this is the physical register specifier to
                                 // which it is renamed.
   
-   // Branch ID, for checkpointed branches only.
+   // Branch ID, for checkpointed branches and value predictions.
    unsigned int branch_ID;      // When a checkpoint is created for a branch,
                                 // this is the branch's ID (its bit position
                                 // in the Global Branch Mask).
+                                // Same for a checkpointed value prediction.
+
+   // Value prediction.
+   bool vp_eligible;            // If 'true', the instruction is eligible for
+                                // value prediction and holds a VPQ entry.
+   unsigned int vpq_index;      // If eligible, this is its index into the VPQ.
+   bool vp_hit;                 // If eligible: the value predictor has a prediction.
+   bool vp_confident;           // If eligible: the prediction is confident, i.e.,
+                                // the destination register was written with
+                                // 'vp_pred_value' and marked ready at dispatch.
+   bool vp_filtered;            // If eligible: the prediction was confident, but
+                                // a prediction filter discarded it (it is then
+                                // not 'vp_confident').
+   bool vp_head_stall;          // The instruction stalled the Active List head
+                                // (VP_CRIT_FILTER).
+   reg_t vp_pred_value;         // If 'vp_hit', this is the predicted value.
+   bool vp_checkpoint;          // If 'true', a checkpoint was created for the
+                                // confident prediction, so that a value
+                                // misprediction can be recovered at writeback
+                                // (VP_RECOVERY 1 and 2). 'branch_ID' is its ID.
+
+   // VPQ checkpoint, for checkpointed branches and value predictions.
+   unsigned int vpq_tail;       // VPQ tail (and its phase) immediately after
+   bool vpq_tail_phase;         // the branch, for restoring the VPQ on a
+                                // misprediction.
+   uint64_t vp_context;         // Value predictor's global context (e.g.,
+                                // branch history) before the branch.
 
    ////////////////////////
    // Set by Dispatch Stage.
@@ -195,8 +235,32 @@ typedef struct {
    unsigned int SQ_index;
    bool SQ_phase;
 
+   // Loads, with the load address predictor (LOAD_ADDR_PRED): the predicted
+   // address was confident, so the D$ was probed with it, and the probe hit.
+   bool lap_probed;
+   bool lap_probe_hit;
+
    unsigned int lane_id;        // Execution lane chosen for the instruction.
 
+   // LQ/SQ checkpoint, for checkpointed value predictions only.
+   // (Unlike branches, a predicted load needs its own LQ_index/SQ_index.)
+   unsigned int vp_LQ_tail;
+   bool vp_LQ_tail_phase;
+   unsigned int vp_SQ_tail;
+   bool vp_SQ_tail_phase;
+
+   // Selective replay (VP_RECOVERY 2): the instruction's branch mask, kept
+   // up-to-date as branches resolve, for re-inserting it into the IQ.
+   uint64_t branch_mask;
+
+   ////////////////////////
+   // Set by Schedule Stage.
+   ////////////////////////
+
+   bool issued;                 // The instruction has issued from the IQ.
+                                // Cleared when the payload entry is allocated,
+                                // and when the instruction is replayed.
+
    ////////////////////////
    // Set by Reg. Read Stage.
    ////////////////////////
@@ -33,7 +33,10 @@ static unsigned int count_bits32(unsigned int val)
   return count;
 }
 
-static void print_cache_config(FILE *fp, unsigned int sets, unsigned int assoc, unsigned int blocksize, unsigned int latency, unsigned int MHSRs, const char *disclaimer) {
+static void print_cache_config(FILE *fp, unsigned int sets, unsigned int assoc, unsigned int blocksize, unsigned int latency, unsigned int MHSRs, const char *disclaimer,
+                               unsigned int prefetcher, unsigned int degree) {
+   static const char* prefetcher_name[] = {"none", "next-line", "PC-stride", "stream"};
+
    unsigned int i = (sets*assoc*blocksize);
    if ((i >> 20) > 0)
       fprintf(fp, "   %d MB, ", (i >> 20));
@@ -51,6 +54,10 @@ static void print_cache_config(FILE *fp, unsigned int sets, unsigned int assoc,
 
    fprintf(fp, "   hit latency = %d cycles %s\n", latency, disclaimer);
    fprintf(fp, "   MHSRs = %d\n", MHSRs);
+   if (prefetcher == PF_NONE)
+      fprintf(fp, "   prefetcher = none\n");
+   else
+      fprintf(fp, "   prefetcher = %s (degree %d)\n", prefetcher_name[prefetcher], degree);
 }
 
 
@@ -77,7 +84,7 @@ pipeline_t::pipeline_t(
   statsModule(this),
   PAY(2*fetch_width + fq_size /* FETCH2, DECODE, FQ */ + 2*dispatch_width + rob_size /* RENAME2, DISPATCH, ROB */),
   FQ(fq_size,this),
-  IQ(iq_size,iq_num_parts,this),
+  IQ(iq_size,iq_num_parts,prf_size,this),
   LSU(lq_size, sq_size, Tid, _mmu, this)
 {
   unsigned int i, j, ex_depth;
@@ -87,6 +94,8 @@ pipeline_t::pipeline_t(
 
   // Initialize simulator time:
   cycle = 0;
+  idle_snapshot_valid = false;
+  vp_head_stalled = false;
   sequence = 0;
 
   // Initialize number of retired instructions.
@@ -129,7 +138,7 @@ pipeline_t::pipeline_t(
                                              (ltm->tm_year - 100), (1 + ltm->tm_mon), (ltm->tm_mday), \
                                              (ltm->tm_hour), (ltm->tm_min), (ltm->tm_sec)),           \
                                              fopen(tempstr, "w"))
-  this->stats_log = OPEN_LOG_FILE("stats");
+  this->stats_log = (STATS_LOG_FILE ? fopen(STATS_LOG_FILE, "w") : OPEN_LOG_FILE(STATS_LOG_NAME));
   //this->phase_log = OPEN_LOG_FILE("phase");
   this->phase_log = (FILE *)NULL;
   #undef OPEN_LOG_FILE
@@ -153,6 +162,7 @@ pipeline_t::pipeline_t(
                             this,
                             "l3_c",
                             NULL);
+       L3C->set_prefetcher(L3_PREFETCHER, L3_PREFETCH_DEGREE);
     }
     else {
        L3C = (CacheClass *) NULL;
@@ -169,6 +179,7 @@ pipeline_t::pipeline_t(
                          this,
                          "l2_c",
                          L3C);
+    L2C->set_prefetcher(L2_PREFETCHER, L2_PREFETCH_DEGREE);
   }
   else {
      L2C = (CacheClass *) NULL;
@@ -198,10 +209,17 @@ pipeline_t::pipeline_t(
 			      CBP_ALGORITHM,
 			      CBP_PC_LENGTH, CBP_BHR_LENGTH,
 			      IBP_PC_LENGTH, IBP_BHR_LENGTH,
+			      IBP_ALGORITHM,
+			      ITTAGE_NUM_TABLES, ITTAGE_LOG2_SIZE, ITTAGE_MIN_HIST, ITTAGE_MAX_HIST,
 			      RAS_SIZE,
 			      BQ_SIZE,
 			      ENABLE_TRACE_CACHE,
 			      PERFECT_TRACE_CACHE,
+			      TC_SETS,
+			      TC_ASSOC,
+			      TC_MAX_CB,
+			      TC_MAX_LENGTH,
+			      TC_PARTIAL_HIT,
 			      PERFECT_BRANCH_PRED,
 			      PERFECT_ICACHE,
 			      L1_IC_SETS,
@@ -222,6 +240,11 @@ pipeline_t::pipeline_t(
   /////////////////////////////////////////////////////////////
   DECODE = new pipeline_register[fetch_width];
 
+  /////////////////////////////////////////////////////////////
+  // Decoded instruction cache, used by the Decode Stage.
+  /////////////////////////////////////////////////////////////
+  UOPC = ((UOP_CACHE_SIZE > 0) ? new uop_cache_t(UOP_CACHE_SIZE) : (uop_cache_t *) NULL);
+
   /////////////////////////////////////////////////////////////
   // Pipeline register between the Rename1 and Rename2
   // sub-stages (within the Rename Stage).
@@ -278,6 +301,66 @@ pipeline_t::pipeline_t(
 
   LSU.set_l2_cache(L2C);
 
+  /////////////////////////////////////////////////////////////
+  // Value Predictor.
+  /////////////////////////////////////////////////////////////
+
+  if (VALUE_PRED_EN) {
+     VPinterface_t* engine = NULL;
+     hybrid_vp_t* hybrid;
+
+     switch (VP_ALGORITHM) {
+        case 0: // svp
+        case 1: // lvp
+           engine = new svp_t((VP_ALGORITHM == 1), SVP_VPQ_SIZE, SVP_NUM_INDEX_BITS, SVP_NUM_TAG_BITS,
+                              SVP_CONFMAX, SVP_CONFINC, SVP_CONFDEC, SVP_REPLACE_STRIDE, SVP_REPLACE);
+           break;
+        case 2: // fcm
+           engine = new fcm_t(SVP_VPQ_SIZE, FCM_VHT_INDEX_BITS, SVP_NUM_TAG_BITS, FCM_VPT_INDEX_BITS, FCM_ORDER,
+                              SVP_CONFMAX, SVP_CONFINC, SVP_CONFDEC, SVP_REPLACE);
+           break;
+        case 3: // vtage
+           engine = new vtage_t(SVP_VPQ_SIZE, VTAGE_BASE_INDEX_BITS, VTAGE_NUM_TABLES, VTAGE_INDEX_BITS, VTAGE_TAG_BITS,
+                                VTAGE_MIN_HIST, VTAGE_MAX_HIST, SVP_CONFMAX, SVP_CONFINC, SVP_CONFDEC, SVP_REPLACE);
+           break;
+        case 4: // hybrid of svp, fcm, and vtage
+           hybrid = new hybrid_vp_t(SVP_VPQ_SIZE, HYBRID_CHOOSER_INDEX_BITS);
+           hybrid->add_component("svp",
+                                 new svp_t(false, SVP_VPQ_SIZE, SVP_NUM_INDEX_BITS, SVP_NUM_TAG_BITS,
+                                           SVP_CONFMAX, SVP_CONFINC, SVP_CONFDEC, SVP_REPLACE_STRIDE, SVP_REPLACE),
+                                 false);
+           hybrid->add_component("fcm",
+                                 new fcm_t(SVP_VPQ_SIZE, FCM_VHT_INDEX_BITS, SVP_NUM_TAG_BITS, FCM_VPT_INDEX_BITS, FCM_ORDER,
+                                           SVP_CONFMAX, SVP_CONFINC, SVP_CONFDEC, SVP_REPLACE),
+                                 false);
+           hybrid->add_component("vtage",
+                                 new vtage_t(SVP_VPQ_SIZE, VTAGE_BASE_INDEX_BITS, VTAGE_NUM_TABLES, VTAGE_INDEX_BITS, VTAGE_TAG_BITS,
+                                             VTAGE_MIN_HIST, VTAGE_MAX_HIST, SVP_CONFMAX, SVP_CONFINC, SVP_CONFDEC, SVP_REPLACE),
+                                 true);
+           engine = hybrid;
+           break;
+        default:
+           printf("Error: unknown value prediction algorithm %u.\n", VP_ALGORITHM);
+           exit(-1);
+           break;
+     }
+
+     VP = new value_predictor(SVP_VPQ_SIZE, prf_size, engine);
+  }
+  else {
+     VP = (value_predictor *) NULL;
+  }
+
+  // Sampled simulation.
+  if (SAMPLING)
+     SAMPLER = new sampler_t(SAMPLE_UNIT, SAMPLE_WARMUP, SAMPLE_PERIOD);
+  else
+     SAMPLER = (sampler_t *) NULL;
+  stats_warmup = STATS_WARMUP;
+
+  // Functional cache warming during fast skip.
+  WARMER = new cache_warmer_t(this, mmu);
+
 
   // Declare and set the various knobs in the knobs database.
   // These will be printed in the stats.log file at the end of the run.
@@ -302,6 +385,8 @@ pipeline_t::pipeline_t(
   fprintf(stats_log, "   PARTITIONS = %d\n", iq_num_parts);
   fprintf(stats_log, "   PRESTEER = %d\n", (PRESTEER ? 1 : 0));
   fprintf(stats_log, "   IDEAL AGE-BASED = %d\n", (IDEAL_AGE_BASED ? 1 : 0));
+  fprintf(stats_log, "   WAKEUP = %s\n", ((IQ_WAKEUP == 0) ? "CAM scan" : "consumer lists"));
+  fprintf(stats_log, "   SELECT = %s\n", ((IQ_SELECT == 0) ? "scan" : "ready bitmap"));
   fprintf(stats_log, "LOAD/STORE UNIT:\n");
   fprintf(stats_log, "   LOAD QUEUE = %d\n", lq_size);
   fprintf(stats_log, "   STORE QUEUE = %d\n", sq_size);
@@ -311,11 +396,17 @@ pipeline_t::pipeline_t(
      fprintf(stats_log, "   MEMORY DEPENDENCE PREDICTOR: always predict conflict (always speculatively stall)\n");
   else if (!MEM_DEP_PRED)
      fprintf(stats_log, "   MEMORY DEPENDENCE PREDICTOR: always predict no conflict (always speculatively execute)\n");
+  else if (MDP_STORE_SETS)
+     fprintf(stats_log, "   MEMORY DEPENDENCE PREDICTOR: store sets (SSIT index bits: %d, LFST entries: %d, SSIT clear interval: %d loads)\n", SSIT_NUM_INDEX_BITS, LFST_SIZE, SSIT_CLEAR_INTERVAL);
   else if (MDP_STICKY)
-     fprintf(stats_log, "   MEMORY DEPENDENCE PREDICTOR: MDP-sticky\n");
+     fprintf(stats_log, "   MEMORY DEPENDENCE PREDICTOR: MDP-sticky (index bits: %d)\n", MDP_NUM_INDEX_BITS);
   else
-     fprintf(stats_log, "   MEMORY DEPENDENCE PREDICTOR: MDP-ctr (max ctr: %d)\n", MDP_MAX);
+     fprintf(stats_log, "   MEMORY DEPENDENCE PREDICTOR: MDP-ctr (max ctr: %d, index bits: %d)\n", MDP_MAX, MDP_NUM_INDEX_BITS);
   fprintf(stats_log, "   SPLIT STORES = %d\n", (SPLIT_STORES ? 1 : 0));
+  if (LOAD_ADDR_PRED)
+     fprintf(stats_log, "   LOAD ADDRESS PREDICTOR: stride (index bits: %d, tag bits: %d, confmax: %d, prefetch: %d)\n", LAP_NUM_INDEX_BITS, LAP_NUM_TAG_BITS, LAP_CONFMAX, (LAP_PREFETCH ? 1 : 0));
+  else
+     fprintf(stats_log, "   LOAD ADDRESS PREDICTOR: none\n");
 
   fprintf(stats_log, "\n=== PIPELINE STAGE WIDTHS =======================================================\n\n");
   fprintf(stats_log, "FETCH WIDTH = %d\n", fetch_width);
@@ -339,22 +430,24 @@ pipeline_t::pipeline_t(
 
   fprintf(stats_log, "\n=== MEMORY HIERARCHY ============================================================\n\n");
 
+  fprintf(stats_log, "REPLACEMENT POLICY = %s\n", ((CACHE_REPL == REPL_LRU) ? "LRU" : ((CACHE_REPL == REPL_PLRU) ? "tree-PLRU" : "SRRIP")));
+
   fprintf(stats_log, "L1 I$:\n");
-  print_cache_config(stats_log, L1_IC_SETS, L1_IC_ASSOC, (1<<L1_IC_LINE_SIZE), L1_IC_HIT_LATENCY, L1_IC_NUM_MHSRs, "(superseded by fetch unit's pipeline depth)");
+  print_cache_config(stats_log, L1_IC_SETS, L1_IC_ASSOC, (1<<L1_IC_LINE_SIZE), L1_IC_HIT_LATENCY, L1_IC_NUM_MHSRs, "(superseded by fetch unit's pipeline depth)", L1_IC_PREFETCHER, L1_IC_PREFETCH_DEGREE);
   if (!L2_PRESENT) fprintf(stats_log, "   miss latency = %d cycles\n", L1_IC_MISS_LATENCY);
 
   fprintf(stats_log, "L1 D$:\n");
-  print_cache_config(stats_log, L1_DC_SETS, L1_DC_ASSOC, (1<<L1_DC_LINE_SIZE), L1_DC_HIT_LATENCY, L1_DC_NUM_MHSRs, "(superseded by load/store lane's pipeline depth)");
+  print_cache_config(stats_log, L1_DC_SETS, L1_DC_ASSOC, (1<<L1_DC_LINE_SIZE), L1_DC_HIT_LATENCY, L1_DC_NUM_MHSRs, "(superseded by load/store lane's pipeline depth)", L1_DC_PREFETCHER, L1_DC_PREFETCH_DEGREE);
   if (!L2_PRESENT) fprintf(stats_log, "   miss latency = %d cycles\n", L1_DC_MISS_LATENCY);
 
   if (L2_PRESENT) {
      fprintf(stats_log, "L2$:\n");
-     print_cache_config(stats_log, L2_SETS, L2_ASSOC, (1<<L2_LINE_SIZE), L2_HIT_LATENCY, L2_NUM_MHSRs, "");
+     print_cache_config(stats_log, L2_SETS, L2_ASSOC, (1<<L2_LINE_SIZE), L2_HIT_LATENCY, L2_NUM_MHSRs, "", L2_PREFETCHER, L2_PREFETCH_DEGREE);
      if (!L3_PRESENT) fprintf(stats_log, "   miss latency = %d cycles\n", L2_MISS_LATENCY);
 
      if (L3_PRESENT) {
         fprintf(stats_log, "L3$:\n");
-        print_cache_config(stats_log, L3_SETS, L3_ASSOC, (1<<L3_LINE_SIZE), L3_HIT_LATENCY, L3_NUM_MHSRs, "");
+        print_cache_config(stats_log, L3_SETS, L3_ASSOC, (1<<L3_LINE_SIZE), L3_HIT_LATENCY, L3_NUM_MHSRs, "", L3_PREFETCHER, L3_PREFETCH_DEGREE);
         fprintf(stats_log, "   miss latency = %d cycles\n", L3_MISS_LATENCY);
      }
   }
@@ -371,11 +464,71 @@ pipeline_t::pipeline_t(
   fprintf(stats_log, "CBP_BHR_LENGTH = %d\n", CBP_BHR_LENGTH);
   fprintf(stats_log, "IBP_PC_LENGTH = %d\n", IBP_PC_LENGTH);
   fprintf(stats_log, "IBP_BHR_LENGTH = %d\n", IBP_BHR_LENGTH);
+  fprintf(stats_log, "IBP_ALGORITHM = %s\n", ((IBP_ALGORITHM == 0) ? "gshare" : ((IBP_ALGORITHM == 1) ? "ittage" : "unknown")));
+  if (IBP_ALGORITHM == 1)
+     fprintf(stats_log, "ITTAGE = %d tagged tables, %d index bits, history lengths %d to %d\n",
+             ITTAGE_NUM_TABLES, ITTAGE_LOG2_SIZE, ITTAGE_MIN_HIST, ITTAGE_MAX_HIST);
   fprintf(stats_log, "ENABLE_TRACE_CACHE = %d\n", (ENABLE_TRACE_CACHE ? 1 : 0));
+  if (ENABLE_TRACE_CACHE && !PERFECT_TRACE_CACHE)
+     fprintf(stats_log, "TRACE CACHE = %d sets, %d ways, max. cond. branches %d, max. length %d (0: fetch bundle's), partial hits %d\n",
+             TC_SETS, TC_ASSOC, TC_MAX_CB, TC_MAX_LENGTH, (TC_PARTIAL_HIT ? 1 : 0));
+
+  fprintf(stats_log, "\n=== VALUE PREDICTOR ===============================================================\n\n");
+
+  fprintf(stats_log, "VALUE_PRED_EN = %d\n", (VALUE_PRED_EN ? 1 : 0));
+  if (VALUE_PRED_EN) {
+     fprintf(stats_log, "VP_ALGORITHM = %s\n", vp_algorithm_name[VP_ALGORITHM]);
+     fprintf(stats_log, "PERFECT_VALUE_PRED = %d\n", (PERFECT_VALUE_PRED ? 1 : 0));
+     fprintf(stats_log, "SVP_VPQ_SIZE = %d\n", SVP_VPQ_SIZE);
+     fprintf(stats_log, "SVP_ORACLE_CONF = %d\n", (SVP_ORACLE_CONF ? 1 : 0));
+     VP->dump_config(stats_log);
+     fprintf(stats_log, "PREDINTALU = %d\n", (PREDINTALU ? 1 : 0));
+     fprintf(stats_log, "PREDFPALU = %d\n", (PREDFPALU ? 1 : 0));
+     fprintf(stats_log, "PREDLOAD = %d\n", (PREDLOAD ? 1 : 0));
+     fprintf(stats_log, "VP_RECOVERY = %s\n", ((VP_RECOVERY == 0) ? "squash at retire" : ((VP_RECOVERY == 1) ? "checkpoint rollback at writeback" : "selective replay at writeback")));
+     fprintf(stats_log, "VP_FPC = %d", (VP_FPC ? 1 : 0));
+     if (VP_FPC) {
+        fprintf(stats_log, " (log2(1/p) by confidence:");
+        for (unsigned int i = 0; i < VP_FPC_LEN; i++)
+           fprintf(stats_log, " %d", VP_FPC_LOG2[i]);
+        fprintf(stats_log, ")");
+     }
+     fprintf(stats_log, "\n");
+     fprintf(stats_log, "VP_CRIT_FILTER = %d", (VP_CRIT_FILTER ? 1 : 0));
+     if (VP_CRIT_FILTER)
+        fprintf(stats_log, " (index bits: %d, threshold: %d, max: %d)", VP_CRIT_INDEX_BITS, VP_CRIT_THRESHOLD, VP_CRIT_MAX);
+     fprintf(stats_log, "\n");
+     fprintf(stats_log, "VP_CONSUMER_FILTER = %d", (VP_CONSUMER_FILTER ? 1 : 0));
+     if (VP_CONSUMER_FILTER)
+        fprintf(stats_log, " (index bits: %d, threshold: %d, max: %d)", VP_CONSUMER_INDEX_BITS, VP_CONSUMER_THRESHOLD, VP_CONSUMER_MAX);
+     fprintf(stats_log, "\n");
+  }
+
+  fprintf(stats_log, "\n=== SAMPLED SIMULATION ==========================================================\n\n");
+
+  fprintf(stats_log, "SAMPLING = %d\n", (SAMPLING ? 1 : 0));
+  if (SAMPLING) {
+     SAMPLER->dump_config(stats_log);
+     fprintf(stats_log, "SAMPLE_WARMING = %d\n", (SAMPLE_WARMING ? 1 : 0));
+  }
+  if (STATS_WARMUP)
+     fprintf(stats_log, "STATS_WARMUP = %lu (stats counters exclude the first %lu retired instructions)\n", STATS_WARMUP, STATS_WARMUP);
+
+  fprintf(stats_log, "FAST_SKIP_WARMING = %d", (FAST_SKIP_WARMING ? 1 : 0));
+  if (FAST_SKIP_WARMING) {
+     if (FAST_SKIP_WARM_AMT)
+        fprintf(stats_log, " (caches warmed by the last %lu fast-skipped instructions)", FAST_SKIP_WARM_AMT);
+     else
+        fprintf(stats_log, " (caches warmed by all fast-skipped instructions)");
+  }
+  fprintf(stats_log, "\n");
 
   fprintf(stats_log, "\n=== INTERNAL SIMULATOR STRUCTURES ===============================================\n\n");
 
   fprintf(stats_log, "PAYLOAD_BUFFER_SIZE = %d\n", PAY.get_size());
+  fprintf(stats_log, "PIPE_QUEUE_SIZE = %d (%s)\n", PIPE_QUEUE_SIZE, (PIPE_ASYNC ? "asynchronous checker thread" : "synchronous checker"));
+  fprintf(stats_log, "IDLE_FAST_FORWARD = %d\n", (IDLE_FAST_FORWARD ? 1 : 0));
+  fprintf(stats_log, "UOP_CACHE_SIZE = %d\n", UOP_CACHE_SIZE);
 
   fprintf(stats_log, "\n=== END CONFIGURATION ===========================================================\n\n");
 
@@ -419,8 +572,16 @@ pipeline_t::~pipeline_t()
   }
 #endif
 
-  FetchUnit->output(stats->get_counter("commit_count"), stats->get_counter("cycle_count"), stats_log);
+  FetchUnit->output(counter(commit_count), counter(cycle_count), stats_log);
   LSU.dump_stats(stats_log);
+  if (L2C)
+     L2C->dump_prefetch_stats(stats_log);
+  if (L3C)
+     L3C->dump_prefetch_stats(stats_log);
+  if (VALUE_PRED_EN)
+     VP->dump_stats(stats_log);
+  if (SAMPLING)
+     SAMPLER->dump_stats(stats_log);
 
   #ifdef RISCV_MICRO_DEBUG
     fclose(this->fetch_log    );
@@ -533,6 +694,11 @@ bool pipeline_t::step_micro(size_t instret_limit, size_t& instret)
           break;
       }
     }
+    else if (SAMPLER && !SAMPLER->detailed()) {
+      // Sampled simulation: functional phase.
+      if (step_functional(instret_limit, instret))
+        return true;
+    }
     else {
 
         /////////////////////////////////////////////////////////////
@@ -550,7 +716,7 @@ bool pipeline_t::step_micro(size_t instret_limit, size_t& instret)
           if(instret == instret_limit)
             break;
           // Stop simulation if limit reached
-          if((counter(commit_count) >= stop_amt) && use_stop_amt){
+          if((num_insn >= stop_amt) && use_stop_amt){
             //stats->dump_knobs();
             //stats->dump_counters();
             //stats->dump_rates();
@@ -620,6 +786,21 @@ bool pipeline_t::step_micro(size_t instret_limit, size_t& instret)
 	  num_insn_last_beat = num_insn;
         }
 
+        // Skip ahead over cycles in which the pipeline is blocked and does nothing.
+        if (IDLE_FAST_FORWARD)
+          skip_idle_cycles();
+
+        // Sampled simulation: advance to the next phase, draining the pipeline before a functional phase.
+        if (SAMPLER && SAMPLER->end_cycle(num_insn, cycle))
+          sample_drain();
+
+        // Detailed warmup done: measure from here on.
+        if (stats_warmup && (num_insn >= stats_warmup)) {
+          stats->reset_counters();
+          stats->reset_phase_counters();
+          stats_warmup = 0;
+        }
+
     }
   }
   //catch(mem_trap_t& t)
@@ -647,6 +828,231 @@ bool pipeline_t::step_micro(size_t instret_limit, size_t& instret)
   return false;
 }
 
+// Idle-cycle fast-forward.
+//
+// If the cycle that just ended did nothing -- the Execution Lanes were empty before and after it and no other
+// stage made progress -- then the next cycles do nothing either, until the next time-based event: an instruction
+// cache miss or a stalled load's data cache miss resolving. Jump the cycle straight to that event.
+//
+// The skipped cycles are still accounted exactly: in each of them, the load replay engine runs every stalled load
+// through the load execution datapath (counting spec_load_count), the issue queue rotates its round-robin
+// partition priority, and the cycle is counted. Counters are updated
+// one at a time, in the same order as a simulated cycle, so that phase counters tick at the same point.
+// The skip stops short of cycles with periodic side-effects (logging enable, progress/deadlock check).
+void pipeline_t::skip_idle_cycles() {
+  idle_snapshot_t now;
+  unsigned int num_replays;
+  cycle_t next_event, ic_resolve_cycle;
+  unsigned int i, j;
+  bool same;
+
+  if (!LSU.replay_idle(cycle, num_replays, next_event)) {
+    idle_snapshot_valid = false;
+    return;
+  }
+
+  // Sample the progress indicators.
+  memset(&now, 0, sizeof(idle_snapshot_t));
+  now.lanes_empty = true;
+  for (i = 0; i < issue_width; i++) {
+    if (Execution_Lanes[i].rr.valid || Execution_Lanes[i].wb.valid)
+      now.lanes_empty = false;
+    for (j = 0; j < Execution_Lanes[i].ex_depth; j++) {
+      if (Execution_Lanes[i].ex[j].valid)
+        now.lanes_empty = false;
+    }
+  }
+  now.pay_head = PAY.head;
+  now.pay_tail = PAY.tail;
+  now.fetch_pc = FetchUnit->getPC();
+  now.ic_miss = FetchUnit->ic_miss_pending(ic_resolve_cycle);
+  now.decode_valid = DECODE[0].valid;
+  now.decode_index = DECODE[0].index;
+  now.fq_length = FQ.get_length();
+  now.rename2_valid = RENAME2[0].valid;
+  now.rename2_index = RENAME2[0].index;
+  now.dispatch_valid = DISPATCH[0].valid;
+  now.dispatch_index = DISPATCH[0].index;
+  now.iq_length = IQ.get_length();
+  now.stalled_loads = num_replays;
+  now.commit_count = counter(commit_count);
+  now.recovery_count = counter(recovery_count);
+
+  same = (idle_snapshot_valid && now.lanes_empty && (memcmp(&now, &idle_snapshot, sizeof(idle_snapshot_t)) == 0));
+  idle_snapshot = now;
+  idle_snapshot_valid = true;
+  if (!same)
+    return;
+
+  // The next event.
+  if (now.ic_miss && (cycle < ic_resolve_cycle))
+    next_event = MIN(next_event, ic_resolve_cycle);
+  if (next_event == (cycle_t)-1)
+    return;	// Nothing will ever happen: leave it to the deadlock check.
+
+  // Don't skip over the cycles that enable logging and check progress.
+  if (cycle < (uint64_t)logging_on_at)
+    next_event = MIN(next_event, (uint64_t)logging_on_at);
+  next_event = MIN(next_event, (cycle | (cycle_t)(0x400000 - 1)));
+
+  // The Schedule Stage still rotates the issue queue's round-robin partition priority every cycle.
+  IQ.skip_cycles(next_event - cycle);
+
+  // The AL head stays stalled, too.
+  if (vp_head_stalled)
+    VP->head_stall(PAY.buf[PAY.head].pc, next_event - cycle);
+
+  while (cycle < next_event) {
+    for (i = 0; i < num_replays; i++)
+      inc_counter(spec_load_count);
+    cycle++;
+    inc_counter(cycle_count);
+  }
+}
+
+// Sampled simulation: the functional phase.
+// Execute up to 'instret_limit' instructions functionally, like the debug mode of step_micro(), popping their
+// debug buffer entries as the Retire Stage would. If SAMPLE_WARMING, the caches and predictors are warmed with them.
+// Like processor_t::step(), stop at an exception or serializing instruction.
+// Returns 'true' if the simulation must stop (stop_amt).
+bool pipeline_t::step_functional(size_t instret_limit, size_t& instret)
+{
+  size_t prev_instret = instret;
+  reg_t pc;
+  reg_t next_pc;
+  db_t* actual;
+  bool stop_step;
+
+  stop_step = false;
+  while ((instret < instret_limit) && !stop_step && SAMPLER->functional(num_insn)) {
+    pc = FetchUnit->getPC();
+    actual = pipe->pop(pipe->first(pc));
+    instret++;
+    num_insn++;
+    SAMPLER->count_functional();
+
+    try {
+      insn_fetch_t fetch = mmu->load_insn(pc);
+      next_pc = execute_insn(this, pc, fetch);
+    }
+    catch (trap_t& t) {
+      next_pc = take_trap(t, pc);
+      stop_step = true;
+    }
+    catch (serialize_t& s) {
+      next_pc = pc;
+      stop_step = true;
+    }
+
+    if (SAMPLE_WARMING)
+      warm(pc, actual->a_inst, next_pc, actual);
+
+    FetchUnit->setPC(next_pc);
+    update_timer(&state, instret-prev_instret);
+    prev_instret = instret;
+
+    if ((num_insn >= stop_amt) && use_stop_amt)
+      return true;
+  }
+
+  if (!SAMPLER->functional(num_insn))
+    sample_resume();
+
+  return false;
+}
+
+void pipeline_t::warm(reg_t pc, insn_t inst, reg_t next_pc, db_t* actual)
+{
+  // Fetch: I$, BTB and branch predictors.
+  FetchUnit->warm(pc, inst, next_pc);
+
+  if (actual->a_exception)
+    return;
+
+  // D$ (and L2/L3 behind it).
+  switch (inst.opcode()) {
+    case OP_LOAD:
+    case OP_LOAD_FP:
+      LSU.warm(actual->a_addr, false);
+      break;
+    case OP_STORE:
+    case OP_STORE_FP:
+    case OP_AMO:
+      LSU.warm(actual->a_addr, true);
+      break;
+    default:
+      break;
+  }
+
+  // Value predictor.
+  if (VALUE_PRED_EN) {
+    if (inst.opcode() == OP_BRANCH)
+      VP->warm_branch(pc, (next_pc != INCREMENT_PC(pc)));
+    else if (vp_warm_eligible(inst) && (actual->a_num_rdst > 0))
+      VP->warm(pc, actual->a_rdst[0].value);
+  }
+}
+
+bool pipeline_t::vp_warm_eligible(insn_t inst)
+{
+  switch (inst.opcode()) {
+    case OP_LOAD:
+    case OP_LOAD_FP:
+      return(PREDLOAD);
+    case OP_OP_FP:
+    case OP_MADD:
+    case OP_MSUB:
+    case OP_NMADD:
+    case OP_NMSUB:
+      return(PREDFPALU);
+    case OP_OP_IMM:
+      return((inst.bits() != INSN_NOP) && PREDINTALU);
+    case OP_OP:
+    case OP_OP_32:
+    case OP_OP_IMM_32:
+    case OP_LUI:
+    case OP_AUIPC:
+      return(PREDINTALU);
+    default:
+      return(false);
+  }
+}
+
+// Detailed -> functional: the retired instructions are the architectural state.
+// Squash everything after them, and restart (functionally) at the oldest instruction not yet retired.
+void pipeline_t::sample_drain()
+{
+  // The functional simulator has finished the program: stay detailed until it ends.
+  if (pipe->empty()) {
+    SAMPLER->begin_detailed(num_insn);
+    return;
+  }
+
+  squash_complete(pipe->head_pc());
+  PAY.clear();
+  idle_snapshot_valid = false;
+  vp_head_stalled = false;
+
+  copy_state_from_micro();
+}
+
+// Functional -> detailed: complete the last warming fetch bundle, and restart the pipeline with the architectural state.
+void pipeline_t::sample_resume()
+{
+  FetchUnit->warm_flush();
+
+  get_state()->pc = FetchUnit->getPC();
+  copy_state_to_micro();
+
+  SAMPLER->begin_detailed(num_insn);
+}
+
+void pipeline_t::flush_uop_cache()
+{
+  if (UOPC)
+    UOPC->flush();
+}
+
 reg_t pipeline_t::take_trap(trap_t& t, reg_t epc)
 {
   #ifdef RISCV_MICRO_DEBUG
@@ -725,6 +1131,17 @@ void pipeline_t::copy_state_to_micro() {
    FetchUnit->setPC(get_state()->pc);
 }
 
+void pipeline_t::copy_state_from_micro() {
+   for (unsigned int i = 0; i < NXPR; i++){
+      // Integer RF: general registers 0-31.
+      get_state()->XPR.write(i, REN->read(REN->rename_rsrc(i)));
+      // Floating point RF: general registers 0-31.
+      get_state()->FPR.write(i, REN->read(REN->rename_rsrc(i+NXPR)));
+   }
+
+   get_state()->pc = FetchUnit->getPC();
+}
+
 uint64_t pipeline_t::get_arch_reg_value(int reg_id) { 
 
     return REN->read(REN->rename_rsrc(reg_id));
@@ -38,12 +38,24 @@
 
 #include "lsu.h"		// LOAD/STORE UNIT
 
+#include "value_predictor.h"	// VALUE PREDICTOR (VPQ + engine)
+#include "svp.h"		// VALUE PREDICTION ENGINES
+#include "fcm.h"
+#include "vtage.h"
+#include "hybrid_vp.h"
+
 #include "debug.h"
 
 #include "stats.h"
 
 #include "alu_ops.h"
 
+#include "uop_cache.h"		// DECODED INSTRUCTION CACHE
+
+#include "sampler.h"		// SAMPLED SIMULATION
+
+#include "cache_warmer.h"	// FUNCTIONAL CACHE WARMING DURING FAST SKIP
+
 //////////////////////////////////////////////////////////////////////////////
 
 /* instruction flags */
@@ -96,6 +108,28 @@
 #define FP_SOURCE3(in)		(in.rs3()+NXPR)
 #define FP_DEST(in) 		  (in.rd() +NXPR)
 
+// Progress indicators of the pipeline, sampled at the end of each cycle for idle-cycle fast-forward.
+// If two consecutive samples are equal and the Execution Lanes are empty, no stage did anything in the
+// cycle in between, so each following cycle does nothing as well until a cache miss resolves.
+typedef struct {
+	bool lanes_empty;		// No instruction in any Execution Lane.
+	unsigned int pay_head;		// Retire: pops the PAY.
+	unsigned int pay_tail;		// Fetch1 pushes the PAY; a misfetch rolls it back.
+	uint64_t fetch_pc;		// Fetch1.
+	bool ic_miss;			// Fetch1: started waiting for an instruction cache miss.
+	bool decode_valid;		// Fetch2 -> Decode.
+	unsigned int decode_index;
+	unsigned int fq_length;		// Decode -> FQ -> Rename1.
+	bool rename2_valid;		// Rename1 -> Rename2.
+	unsigned int rename2_index;
+	bool dispatch_valid;		// Rename2 -> Dispatch.
+	unsigned int dispatch_index;
+	unsigned int iq_length;		// Dispatch -> IQ -> Schedule.
+	unsigned int stalled_loads;	// Load replay engine.
+	uint64_t commit_count;		// Retire.
+	uint64_t recovery_count;	// Retire: squash.
+} idle_snapshot_t;
+
 //class mmu_t;
 //class sim_t;
 //class trap_t;
@@ -213,6 +247,10 @@ public:
   // Copy registers from fast skip state to pipeline register file.
   // Also reset the AMT.
   void copy_state_to_micro();
+  // Copy the committed registers from the pipeline register file back to the
+  // architectural state, e.g., for functional simulation (sampled simulation).
+  // The pipeline must be empty.
+  void copy_state_from_micro();
   uint64_t get_arch_reg_value(int reg_id); 
   uint64_t get_pc(){return get_state()->pc;}
   uint32_t get_instruction(uint64_t inst_pc);
@@ -238,6 +276,7 @@ private:
 //	void take_interrupt(); // take a trap if any interrupts are pending
 //	void serialize(); // collapse into defined architectural state
 	virtual reg_t take_trap(trap_t& t, reg_t epc); // take an exception
+	virtual void flush_uop_cache(); // invalidate the decoded instruction cache (the mmu flushed its instruction cache)
 //
 	friend class sim_t;
 	friend class mmu_t;
@@ -249,6 +288,7 @@ private:
   friend class issue_queue;
   friend class lsu;
   friend class CacheClass;
+  friend class cache_warmer_t;
 
 
 	//void build_opcode_map();
@@ -314,6 +354,12 @@ private:
 	/////////////////////////////////////////////////////////////
 	pipeline_register* DECODE;
 
+	/////////////////////////////////////////////////////////////
+	// Decoded instruction cache, used by the Decode Stage.
+	// NULL if disabled.
+	/////////////////////////////////////////////////////////////
+	uop_cache_t* UOPC;
+
 	/////////////////////////////////////////////////////////////
 	// Fetch Queue between the Decode and Rename Stages.
 	/////////////////////////////////////////////////////////////
@@ -352,6 +398,22 @@ private:
 	/////////////////////////////////////////////////////////////
 	lsu LSU;
 
+	/////////////////////////////////////////////////////////////
+	// Value Predictor.
+	/////////////////////////////////////////////////////////////
+	value_predictor* VP;
+
+	/////////////////////////////////////////////////////////////
+	// Sampled simulation (SMARTS), if SAMPLING.
+	/////////////////////////////////////////////////////////////
+	sampler_t* SAMPLER;
+
+	/////////////////////////////////////////////////////////////
+	// Functional cache warming during fast skip, if
+	// FAST_SKIP_WARMING.
+	/////////////////////////////////////////////////////////////
+	cache_warmer_t* WARMER;
+
 	/////////////////////////////////////////////////////////////
 	// Unified L2 and L3 caches.
 	/////////////////////////////////////////////////////////////
@@ -363,6 +425,11 @@ private:
 	//////////////////////
 
 	unsigned int steer(fu_type fu);
+	bool vp_eligible(unsigned int index);
+	void vp_predict(unsigned int index);
+	void vp_verify(unsigned int index);
+	void vp_rollback(unsigned int index);
+	bool vp_replay(unsigned int index);
 	void agen(unsigned int index);
 	void alu(unsigned int index);
 	void squash_complete(reg_t jump_PC);
@@ -379,6 +446,21 @@ private:
 
 	void split(uint64_t index);
 
+	// Idle-cycle fast-forward.
+	idle_snapshot_t idle_snapshot;	// Progress indicators at the end of the previous cycle.
+	bool idle_snapshot_valid;
+	bool vp_head_stalled;		// Retire Stage: an eligible, incomplete instruction stalled the AL head this cycle (VP_CRIT_FILTER).
+	void skip_idle_cycles();
+
+	// Sampled simulation.
+	bool step_functional(size_t instret_limit, size_t& instret);	// Functional phase: execute (and warm with) instructions, returns 'true' at stop_amt.
+	void warm(reg_t pc, insn_t inst, reg_t next_pc, db_t* actual);	// Warm the caches and predictors with a functionally executed instruction.
+	bool vp_warm_eligible(insn_t inst);				// vp_eligible(), by opcode.
+	void sample_drain();						// Detailed -> functional: squash the pipeline at the oldest unretired instruction.
+	void sample_resume();						// Functional -> detailed.
+
+	uint64_t stats_warmup;		// Reset the stats counters once this many instructions are retired (0: done or never).
+
 public:
 
 	// The thread id.
@@ -415,6 +497,9 @@ public:
   //
 
   stats_t* get_stats(){return &statsModule;}
+
+	// Fast skip: while on, the functional simulator's fetches, loads and stores warm the caches.
+	void set_cache_warming(bool on) { WARMER->enable(on); }
 };
 
 //reg_t illegal_instruction(processor_t* p, insn_t insn, reg_t pc);
@@ -0,0 +1,140 @@
+#include <cassert>
+
+#include "prefetcher.h"
+
+
+void next_line_prefetcher_t::train(reg_t pc, reg_t addr, bool trigger, std::vector<reg_t>& addrs) {
+   if (trigger) {
+      reg_t line = (addr >> line_size);
+      for (unsigned int i = 1; i <= degree; i++)
+         addrs.push_back((line + i) << line_size);
+   }
+}
+
+
+stride_prefetcher_t::stride_prefetcher_t(unsigned int degree, unsigned int line_size, unsigned int entries) :
+   prefetcher_t(degree, line_size) {
+   assert((entries > 0) && !(entries & (entries - 1)));
+   stride_entry_t e = {0, 0, 0, 0};
+   table.assign(entries, e);
+   index_mask = (entries - 1);
+}
+
+void stride_prefetcher_t::train(reg_t pc, reg_t addr, bool trigger, std::vector<reg_t>& addrs) {
+   if (pc == 0)
+      return;
+
+   stride_entry_t* e = &table[(pc >> 2) & index_mask];
+   if (e->pc != pc) {
+      e->pc = pc;
+      e->last_addr = addr;
+      e->stride = 0;
+      e->conf = 0;
+      return;
+   }
+
+   int64_t stride = (int64_t)(addr - e->last_addr);
+   if (stride == 0)
+      return;	// e.g., the same load replayed, or consecutive accesses to one line
+   if (stride == e->stride) {
+      if (e->conf < 3)
+         e->conf++;
+   }
+   else if (e->conf > 0) {
+      e->conf--;
+   }
+   else {
+      e->stride = stride;
+   }
+   e->last_addr = addr;
+
+   if (e->conf >= 2) {
+      reg_t line = (addr >> line_size);
+      for (unsigned int i = 1; i <= degree; i++) {
+         reg_t pf_addr = (addr + (reg_t)(i * e->stride));
+         if ((pf_addr >> line_size) != line)
+            addrs.push_back(pf_addr);
+      }
+   }
+}
+
+
+stream_prefetcher_t::stream_prefetcher_t(unsigned int degree, unsigned int line_size, unsigned int num_streams) :
+   prefetcher_t(degree, line_size) {
+   stream_t s = {false, 0, 0, 0, 0};
+   streams.assign(num_streams, s);
+   time = 0;
+}
+
+void stream_prefetcher_t::train(reg_t pc, reg_t addr, bool trigger, std::vector<reg_t>& addrs) {
+   const int64_t window = 4;	// lines: how far a trigger may be from a stream's last line to extend it
+   reg_t line = (addr >> line_size);
+   unsigned int i, victim;
+   int64_t delta;
+   int dir;
+
+   if (!trigger)
+      return;
+   time++;
+
+   // Extend the stream this trigger is near, if any.
+   for (i = 0; i < streams.size(); i++) {
+      delta = (int64_t)(line - streams[i].last_line);
+      if (streams[i].valid && (delta != 0) && (delta >= -window) && (delta <= window))
+         break;
+   }
+
+   if (i == streams.size()) {
+      // Start a new stream in the least-recently used tracker.
+      victim = 0;
+      for (i = 0; i < streams.size(); i++) {
+         if (!streams[i].valid) {
+            victim = i;
+            break;
+         }
+         if (streams[i].lru < streams[victim].lru)
+            victim = i;
+      }
+      streams[victim].valid = true;
+      streams[victim].last_line = line;
+      streams[victim].dir = 0;
+      streams[victim].conf = 0;
+      streams[victim].lru = time;
+      return;
+   }
+
+   stream_t* s = &streams[i];
+   dir = ((delta > 0) ? 1 : -1);
+   if (dir == s->dir) {
+      if (s->conf < 3)
+         s->conf++;
+   }
+   else {
+      s->dir = dir;
+      s->conf = 1;
+   }
+   s->last_line = line;
+   s->lru = time;
+
+   if (s->conf >= 2) {
+      for (unsigned int j = 1; j <= degree; j++)
+         addrs.push_back((line + (reg_t)((int64_t)j * s->dir)) << line_size);
+   }
+}
+
+
+prefetcher_t* new_prefetcher(unsigned int type, unsigned int degree, unsigned int line_size) {
+   switch (type) {
+      case PF_NONE:
+         return((prefetcher_t*)NULL);
+      case PF_NEXT_LINE:
+         return(new next_line_prefetcher_t(degree, line_size));
+      case PF_STRIDE:
+         return(new stride_prefetcher_t(degree, line_size));
+      case PF_STREAM:
+         return(new stream_prefetcher_t(degree, line_size));
+      default:
+         assert(0);
+         return((prefetcher_t*)NULL);
+   }
+}
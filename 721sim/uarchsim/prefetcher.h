@@ -0,0 +1,96 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <cinttypes>
+#include <vector>
+
+#include "decode.h"
+
+// Prefetcher types (parameters L1_IC_PREFETCHER, etc.).
+#define PF_NONE		0
+#define PF_NEXT_LINE	1
+#define PF_STRIDE	2
+#define PF_STREAM	3
+
+////////////////////////////////////////////////////
+// Abstract base class for all prefetchers.
+//
+// A prefetcher is attached to a cache level
+// (CacheClass) and trained on its demand access
+// stream. It only chooses addresses: the cache
+// filters out lines it already holds or is loading,
+// and issues the rest into free MHSRs as long as
+// demand misses are not blocked.
+////////////////////////////////////////////////////
+
+class prefetcher_t {
+   protected:
+      unsigned int degree;	// Lines to prefetch per trigger.
+      unsigned int line_size;	// Log2 of the cache's line size.
+
+   public:
+      prefetcher_t(unsigned int degree, unsigned int line_size) : degree(degree), line_size(line_size) {};
+      virtual ~prefetcher_t() {};
+
+      // Train on a demand access to 'addr' by the instruction at 'pc' (0: unknown, e.g., an access
+      // from the previous cache level's prefetcher). 'trigger' is true if the access missed, or is
+      // the first demand access to a prefetched line. Appends the addresses to prefetch to 'addrs'.
+      virtual void train(reg_t pc, reg_t addr, bool trigger, std::vector<reg_t>& addrs) = 0;
+
+      virtual const char* name() = 0;
+      unsigned int get_degree() { return(degree); }
+};
+
+// Tagged next-line: on a trigger, prefetch the next 'degree' lines.
+class next_line_prefetcher_t : public prefetcher_t {
+   public:
+      next_line_prefetcher_t(unsigned int degree, unsigned int line_size) : prefetcher_t(degree, line_size) {};
+      void train(reg_t pc, reg_t addr, bool trigger, std::vector<reg_t>& addrs);
+      const char* name() { return("next-line"); }
+};
+
+// PC-based stride: a table indexed by PC tracks each instruction's last address and stride. Once the
+// stride repeats, prefetch 'degree' strides ahead of every access by the instruction.
+class stride_prefetcher_t : public prefetcher_t {
+   private:
+      typedef struct {
+         reg_t pc;		// tag: the full PC
+         reg_t last_addr;
+         int64_t stride;
+         unsigned int conf;	// 2-bit confidence: prefetch when >= 2
+      } stride_entry_t;
+
+      std::vector<stride_entry_t> table;
+      unsigned int index_mask;
+
+   public:
+      stride_prefetcher_t(unsigned int degree, unsigned int line_size, unsigned int entries = 256);
+      void train(reg_t pc, reg_t addr, bool trigger, std::vector<reg_t>& addrs);
+      const char* name() { return("PC-stride"); }
+};
+
+// Stream: trackers follow up to 'num_streams' streams of triggers to nearby, consecutive lines (ascending
+// or descending). Once a stream's direction is confirmed, stay 'degree' lines ahead of it.
+class stream_prefetcher_t : public prefetcher_t {
+   private:
+      typedef struct {
+         bool valid;
+         reg_t last_line;
+         int dir;		// +1, -1, or 0 (not known yet)
+         unsigned int conf;	// prefetch when >= 2
+         uint64_t lru;		// time of last use
+      } stream_t;
+
+      std::vector<stream_t> streams;
+      uint64_t time;
+
+   public:
+      stream_prefetcher_t(unsigned int degree, unsigned int line_size, unsigned int num_streams = 16);
+      void train(reg_t pc, reg_t addr, bool trigger, std::vector<reg_t>& addrs);
+      const char* name() { return("stream"); }
+};
+
+// Returns a new prefetcher of 'type' (PF_*), or NULL for PF_NONE.
+prefetcher_t* new_prefetcher(unsigned int type, unsigned int degree, unsigned int line_size);
+
+#endif //PREFETCHER_H
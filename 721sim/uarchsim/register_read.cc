@@ -58,7 +58,9 @@ void pipeline_t::register_read(unsigned int lane_number) {
 
       //Issue Queue class has a wakeup function that broadcast the tag to every entry in the issue queue
       //ready bit of the destination register needs to be set using the function in the renamer class 
-      if (valid_notLoad_notAMO) {
+      //A confidently value-predicted destination register was already marked ready at dispatch
+      //and its dependents were already woken up, so skip the wakeup
+      if (valid_notLoad_notAMO && !PAY.buf[index].vp_confident) {
          IQ.wakeup(PAY.buf[index].C_phys_reg);
          REN->set_ready(PAY.buf[index].C_phys_reg);
       }
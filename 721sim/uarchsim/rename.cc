@@ -51,7 +51,11 @@ void pipeline_t::rename1() {
 void pipeline_t::rename2() {
    unsigned int i;
    unsigned int index;
-   unsigned int bundle_dst, bundle_branch;
+   unsigned int bundle_dst, bundle_branch, bundle_vp;
+   unsigned int bundle_vp_chkpt;
+   unsigned int vpq_tail;
+   bool vpq_tail_phase;
+   uint64_t vp_context;
 
    // Stall the rename2 sub-stage if either:
    // (1) There isn't a current rename bundle.
@@ -66,6 +70,7 @@ void pipeline_t::rename2() {
    // Third stall condition: There aren't enough rename resources for the current rename bundle.
    bundle_dst = 0;
    bundle_branch = 0;
+   bundle_vp = 0;
    for (i = 0; i < dispatch_width; i++) {
       if (!RENAME2[i].valid)
          break;			// Not a valid instruction: Reached the end of the rename bundle so exit loop.
@@ -102,6 +107,11 @@ void pipeline_t::rename2() {
       //********************************************
       // FIX_ME #1 END
       //********************************************
+
+      // Count the number of instructions in the rename bundle that need a VPQ entry.
+      if (vp_eligible(index)) {
+         bundle_vp++;
+      }
    }
 
    // FIX_ME #2
@@ -131,6 +141,54 @@ void pipeline_t::rename2() {
    // FIX_ME #2 END
    //********************************************
 
+   // Stall if the VPQ doesn't have enough free entries for the whole rename bundle.
+   if (VALUE_PRED_EN && VP->stall(bundle_vp)) {
+      return;
+   }
+
+   // Value prediction, in program order.
+   // Which predictions are confident (and, with value misprediction recovery at writeback, need a checkpoint)
+   // is only known after consulting the value predictor, whose speculative state (e.g., value and branch histories)
+   // evolves through the bundle. So predict the whole bundle first, and undo it if there aren't enough checkpoints.
+   if (VALUE_PRED_EN)
+      VP->checkpoint(vpq_tail, vpq_tail_phase, vp_context);
+   bundle_vp_chkpt = 0;
+
+   for (i = 0; i < dispatch_width; i++) {
+      if (!RENAME2[i].valid)
+         break;			// Not a valid instruction: Reached the end of the rename bundle so exit loop.
+
+      index = RENAME2[i].index;
+
+      // Allocate a VPQ entry and get a value prediction, if the instruction is eligible.
+      vp_predict(index);
+
+      // With value misprediction recovery at writeback, create a checkpoint for a confident prediction,
+      // just like for a branch. Since the instruction was already renamed, rolling back to the checkpoint
+      // squashes only the instructions after it.
+      PAY.buf[index].vp_checkpoint = (PAY.buf[index].vp_confident && (VP_RECOVERY != 0));
+      if (PAY.buf[index].vp_checkpoint) {
+         bundle_vp_chkpt++;
+      }
+
+      if (VALUE_PRED_EN) {
+         // Checkpointed branches and value predictions must record information for restoring the VPQ when they are recovered.
+         if (PAY.buf[index].checkpoint || PAY.buf[index].vp_checkpoint) {
+            VP->checkpoint(PAY.buf[index].vpq_tail, PAY.buf[index].vpq_tail_phase, PAY.buf[index].vp_context);
+         }
+
+         // Conditional branches update the value predictor's global branch history (if any) with their predicted direction.
+         if (IS_COND_BRANCH(PAY.buf[index].flags)) {
+            VP->branch(PAY.buf[index].pc, (PAY.buf[index].next_pc != INCREMENT_PC(PAY.buf[index].pc)));
+         }
+      }
+   }
+
+   if ((bundle_vp_chkpt > 0) && REN->stall_branch(bundle_branch + bundle_vp_chkpt)) {
+      VP->restore(vpq_tail, vpq_tail_phase, vp_context);
+      return;
+   }
+
    //
    // Sufficient resources are available to rename the rename bundle.
    //
@@ -228,6 +286,11 @@ void pipeline_t::rename2() {
       //********************************************
       // FIX_ME #5 END
       //********************************************
+
+      // Create the checkpoint for a confident value prediction (see above).
+      if (PAY.buf[index].vp_checkpoint) {
+         PAY.buf[index].branch_ID = REN->checkpoint();
+      }
    }
 
    //
@@ -244,3 +307,77 @@ void pipeline_t::rename2() {
       DISPATCH[i].branch_mask = RENAME2[i].branch_mask;
    }
 }
+
+
+bool pipeline_t::vp_eligible(unsigned int index) {
+   // An instruction is eligible for value prediction if it has a destination register,
+   // goes through the IQ, and is of a type that the user enabled for value prediction.
+   // Branches (link register), atomics, and system instructions are never eligible.
+   if (!VALUE_PRED_EN ||
+       !PAY.buf[index].C_valid ||
+       (PAY.buf[index].iq != SEL_IQ) ||
+       PAY.buf[index].split ||
+       IS_BRANCH(PAY.buf[index].flags) ||
+       IS_AMO(PAY.buf[index].flags) ||
+       IS_CSR(PAY.buf[index].flags)) {
+      return(false);
+   }
+   else if (IS_LOAD(PAY.buf[index].flags)) {
+      return(PREDLOAD);
+   }
+   else if (IS_FP_OP(PAY.buf[index].flags)) {
+      return(PREDFPALU);
+   }
+   else {
+      return(PREDINTALU);
+   }
+}
+
+void pipeline_t::vp_predict(unsigned int index) {
+   db_t* actual;
+   bool oracle_avail;
+   reg_t oracle_value;
+
+   PAY.buf[index].vp_eligible = vp_eligible(index);
+   PAY.buf[index].vp_hit = false;
+   PAY.buf[index].vp_confident = false;
+   PAY.buf[index].vp_filtered = false;
+   PAY.buf[index].vp_head_stall = false;
+
+   if (PAY.buf[index].vp_eligible) {
+      PAY.buf[index].vp_hit = VP->predict(PAY.buf[index].pc,
+                                          PAY.buf[index].vpq_index,
+                                          PAY.buf[index].vp_pred_value,
+                                          PAY.buf[index].vp_confident);
+
+      if (PERFECT_VALUE_PRED || SVP_ORACLE_CONF) {
+         // Oracle value: only instructions on the correct control-flow path have one.
+         oracle_avail = false;
+         oracle_value = 0;
+         if (PAY.buf[index].good_instruction) {
+            actual = get_pipe()->peek(PAY.buf[index].db_index);
+            if (actual->a_num_rdst > 0) {
+               oracle_avail = true;
+               oracle_value = actual->a_rdst[0].value;
+            }
+         }
+
+         if (PERFECT_VALUE_PRED) {
+            // Perfect value prediction: every eligible instruction is predicted, correctly.
+            PAY.buf[index].vp_hit = oracle_avail;
+            PAY.buf[index].vp_pred_value = oracle_value;
+            PAY.buf[index].vp_confident = oracle_avail;
+         }
+         else {
+            // Oracle confidence: only correct predictions are confident.
+            PAY.buf[index].vp_confident = (PAY.buf[index].vp_hit && oracle_avail && (PAY.buf[index].vp_pred_value == oracle_value));
+         }
+      }
+
+      // Prediction filters: only use the confident predictions that are likely to pay off.
+      if (PAY.buf[index].vp_confident && !PERFECT_VALUE_PRED && !VP->filter(PAY.buf[index].pc)) {
+         PAY.buf[index].vp_confident = false;
+         PAY.buf[index].vp_filtered = true;
+      }
+   }
+}
@@ -356,6 +356,10 @@ renamer:: renamer(uint64_t n_log_regs, uint64_t n_phys_regs, uint64_t n_branches
         activeList.list[AL_index].completed = true;
     }
 
+	void renamer:: clear_complete(uint64_t AL_index){
+        activeList.list[AL_index].completed = false;
+    }
+
 	void renamer:: resolve(uint64_t AL_index,
 		     uint64_t branch_ID,
 		     bool correct){
@@ -419,6 +419,12 @@ public:
 	/////////////////////////////////////////////////////////////////////
 	void set_complete(uint64_t AL_index);
 
+	/////////////////////////////////////////////////////////////////////
+	// Clear the completed bit of the indicated entry in the Active List.
+	// (Selective replay: the instruction must execute again.)
+	/////////////////////////////////////////////////////////////////////
+	void clear_complete(uint64_t AL_index);
+
 	/////////////////////////////////////////////////////////////////////
 	// This function is for handling branch resolution.
 	//
@@ -55,6 +55,13 @@ void pipeline_t::retire(size_t& instret) {
    // FIX_ME #17a END
    //********************************************
 
+   // Value prediction's criticality filter: attribute the cycle to the incomplete instruction stalling the AL head.
+   vp_head_stalled = (head_valid && !completed && VALUE_PRED_EN && VP_CRIT_FILTER && PAY.buf[PAY.head].vp_eligible);
+   if (vp_head_stalled) {
+      VP->head_stall(PAY.buf[PAY.head].pc, 1);
+      PAY.buf[PAY.head].vp_head_stall = true;
+   }
+
    if (head_valid && completed) {    // AL head exists and completed
 
       // Sanity checks of the 'amo' and 'csr' flags.
@@ -111,15 +118,37 @@ void pipeline_t::retire(size_t& instret) {
             get_state()->fflags |= PAY.buf[PAY.head].fflags;
          }
 
+	 // Train the value predictor with the committed instruction's value, and measure its prediction.
+	 if (VALUE_PRED_EN) {
+	    if (PAY.buf[PAY.head].vp_eligible) {
+	       VP->train(PAY.buf[PAY.head].vpq_index);
+	       VP->train_filters(PAY.buf[PAY.head].pc, PAY.buf[PAY.head].vp_head_stall, PAY.buf[PAY.head].C_phys_reg);
+	    }
+	    if (IS_COND_BRANCH(PAY.buf[PAY.head].flags))
+	       VP->commit_branch(PAY.buf[PAY.head].pc, (PAY.buf[PAY.head].c_next_pc != INCREMENT_PC(PAY.buf[PAY.head].pc)));
+	    VP->measure(PAY.buf[PAY.head].vp_eligible,
+	                PAY.buf[PAY.head].vp_hit,
+	                PAY.buf[PAY.head].vp_confident,
+	                PAY.buf[PAY.head].vp_filtered,
+	                (PAY.buf[PAY.head].vp_pred_value == PAY.buf[PAY.head].C_value.dw));
+	    if (PAY.buf[PAY.head].vp_eligible && IS_LOAD(PAY.buf[PAY.head].flags) && PAY.buf[PAY.head].lap_probed)
+	       VP->measure_load(PAY.buf[PAY.head].lap_probe_hit,
+	                        PAY.buf[PAY.head].vp_confident,
+	                        (PAY.buf[PAY.head].vp_pred_value == PAY.buf[PAY.head].C_value.dw));
+	 }
+
 	 // Check results.
 	 checker();
 
 	 // Keep track of the number of retired instructions.
 	 // Split instructions should only count as one architectural instruction, therefore, only the second uop should increment the count.
+	 // Likewise, feed each retired instruction to the trace cache's fill unit once.
 	 if (!PAY.buf[PAY.head].split || !PAY.buf[PAY.head].upper) {
 	    num_insn++;
             instret++;
 	    inc_counter(commit_count);
+	    FetchUnit->retire(PAY.buf[PAY.head].pc, PAY.buf[PAY.head].inst,
+	                      (branch ? PAY.buf[PAY.head].c_next_pc : INCREMENT_PC(PAY.buf[PAY.head].pc)));
 	 }
 	 if (PAY.buf[PAY.head].split && PAY.buf[PAY.head].upper)
 	    inc_counter(split_count);
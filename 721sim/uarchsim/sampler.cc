@@ -0,0 +1,120 @@
+#include <cassert>
+#include <cmath>
+
+#include "sampler.h"
+
+// Standard normal quantiles of the reported confidence intervals.
+#define SAMPLE_Z_95		1.96
+#define SAMPLE_Z_997		3.0
+
+// Target relative error of the recommended number of sampling units (at 99.7% confidence).
+#define SAMPLE_TARGET_ERROR	0.03
+
+
+sampler_t::sampler_t(uint64_t unit, uint64_t warmup, uint64_t period) {
+   assert(unit > 0);
+   assert(period >= (warmup + unit));
+
+   this->unit = unit;
+   this->warmup = warmup;
+   this->period = period;
+
+   // The first period starts with its functional phase.
+   phase = PHASE_FUNCTIONAL;
+   period_start = 0;
+   unit_start_insn = 0;
+   unit_start_cycle = 0;
+
+   // STATS
+   n_units = 0;
+   sum_cpi = 0.0;
+   sum_cpi_sq = 0.0;
+   n_measured_insn = 0;
+   n_measured_cycles = 0;
+   n_warmup_insn = 0;
+   n_functional_insn = 0;
+}
+
+void sampler_t::begin_detailed(uint64_t num_insn) {
+   assert(phase == PHASE_FUNCTIONAL);
+   phase = PHASE_WARMUP;
+   unit_start_insn = num_insn;	// start of the detailed warmup, until the unit starts
+}
+
+bool sampler_t::end_cycle(uint64_t num_insn, uint64_t cycle) {
+   double cpi;
+
+   switch (phase) {
+      case PHASE_WARMUP:
+         if (num_insn >= (period_start + period - unit)) {
+            n_warmup_insn += (num_insn - unit_start_insn);
+            phase = PHASE_MEASURE;
+            unit_start_insn = num_insn;
+            unit_start_cycle = cycle;
+         }
+         break;
+
+      case PHASE_MEASURE:
+         if (num_insn >= (unit_start_insn + unit)) {
+            cpi = (double)(cycle - unit_start_cycle) / (double)(num_insn - unit_start_insn);
+            n_units++;
+            sum_cpi += cpi;
+            sum_cpi_sq += (cpi * cpi);
+            n_measured_insn += (num_insn - unit_start_insn);
+            n_measured_cycles += (cycle - unit_start_cycle);
+
+            // Next period. Without a functional phase, simulation stays detailed.
+            period_start += period;
+            if (period == (warmup + unit)) {
+               phase = PHASE_WARMUP;
+               unit_start_insn = num_insn;
+            }
+            else {
+               phase = PHASE_FUNCTIONAL;
+               return(true);
+            }
+         }
+         break;
+
+      default:
+         assert(0);
+         break;
+   }
+
+   return(false);
+}
+
+void sampler_t::dump_config(FILE* fp) {
+   fprintf(fp, "SAMPLE_UNIT   = %" PRIu64 "\n", unit);
+   fprintf(fp, "SAMPLE_WARMUP = %" PRIu64 "\n", warmup);
+   fprintf(fp, "SAMPLE_PERIOD = %" PRIu64 "\n", period);
+}
+
+void sampler_t::dump_stats(FILE* fp) {
+   double mean, stddev, cv, ci95, ci997;
+   uint64_t n_needed;
+
+   fprintf(fp, "SAMPLED SIMULATION (SMARTS)\n");
+   fprintf(fp, "  sampling units        = %" PRIu64 "\n", n_units);
+   fprintf(fp, "  instr. (functional)   = %" PRIu64 "\n", n_functional_insn);
+   fprintf(fp, "  instr. (warmup)       = %" PRIu64 "\n", n_warmup_insn);
+   fprintf(fp, "  instr. (measured)     = %" PRIu64 " (%" PRIu64 " cycles)\n", n_measured_insn, n_measured_cycles);
+
+   if (n_units < 2) {
+      fprintf(fp, "  (at least two sampling units are needed for an estimate)\n");
+      return;
+   }
+
+   mean = sum_cpi / (double)n_units;
+   stddev = sqrt(fmax(0.0, (sum_cpi_sq - (double)n_units * mean * mean) / (double)(n_units - 1)));
+   cv = stddev / mean;
+   ci95 = SAMPLE_Z_95 * stddev / sqrt((double)n_units);
+   ci997 = SAMPLE_Z_997 * stddev / sqrt((double)n_units);
+   n_needed = (uint64_t)ceil(pow(SAMPLE_Z_997 * cv / SAMPLE_TARGET_ERROR, 2.0));
+
+   fprintf(fp, "  CPI estimate          = %.4f (IPC %.4f)\n", mean, 1.0/mean);
+   fprintf(fp, "  CPI std. deviation    = %.4f (coefficient of variation %.4f)\n", stddev, cv);
+   fprintf(fp, "  95%% conf. interval    = %.4f +/- %.4f (+/- %.2f%%)\n", mean, ci95, 100.0*ci95/mean);
+   fprintf(fp, "  99.7%% conf. interval  = %.4f +/- %.4f (+/- %.2f%%)\n", mean, ci997, 100.0*ci997/mean);
+   fprintf(fp, "  units for +/- %.0f%% at 99.7%% confidence = %" PRIu64 "\n", 100.0*SAMPLE_TARGET_ERROR, n_needed);
+}
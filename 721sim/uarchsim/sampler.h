@@ -0,0 +1,88 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <cinttypes>
+#include <cstdio>
+
+///////////////////////////////////////////////////////////////
+// Sampled simulation (SMARTS).
+//
+// The instruction stream is divided into periods of
+// SAMPLE_PERIOD instructions. Each period is simulated as:
+// 1. Functional phase: instructions are executed functionally,
+//    with no timing. If SAMPLE_WARMING, they warm the caches,
+//    the BTB, the branch predictors and the value predictor,
+//    in program order.
+// 2. Detailed warmup: SAMPLE_WARMUP instructions of detailed
+//    simulation, to refill the pipeline and its queues, not
+//    measured.
+// 3. Measurement: a sampling unit of SAMPLE_UNIT instructions
+//    of detailed simulation, whose CPI is recorded.
+// The CPI of the whole run is estimated by the mean CPI of the
+// sampling units, and its confidence interval by their
+// coefficient of variation (central limit theorem).
+//
+// Phases are delimited by the retired instruction count,
+// num_insn. The detailed phases end at the first cycle
+// boundary on or after their last instruction.
+///////////////////////////////////////////////////////////////
+
+typedef
+enum {
+   PHASE_FUNCTIONAL,
+   PHASE_WARMUP,
+   PHASE_MEASURE
+} sample_phase_e;
+
+
+class sampler_t {
+
+private:
+  uint64_t unit;              // instructions per sampling unit
+  uint64_t warmup;            // instructions of detailed warmup before each unit
+  uint64_t period;            // instructions per period (functional + warmup + unit)
+
+  sample_phase_e phase;
+  uint64_t period_start;      // num_insn at the start of the current period
+  uint64_t unit_start_insn;   // num_insn and cycle at the start of the current sampling unit
+  uint64_t unit_start_cycle;
+
+  //////////////////////////
+  // STATS
+  //////////////////////////
+  uint64_t n_units;           // completed sampling units
+  double sum_cpi;             // sum of their CPIs
+  double sum_cpi_sq;          // sum of their squared CPIs
+  uint64_t n_measured_insn;   // instructions and cycles in the sampling units
+  uint64_t n_measured_cycles;
+  uint64_t n_warmup_insn;     // instructions simulated in detail, but not measured
+  uint64_t n_functional_insn; // instructions executed functionally
+
+public:
+  sampler_t(uint64_t unit, uint64_t warmup, uint64_t period);
+
+  // Is simulation detailed (warmup or measurement)?
+  inline bool detailed() {
+     return(phase != PHASE_FUNCTIONAL);
+  }
+
+  // Is the instruction after 'num_insn' executed functionally?
+  inline bool functional(uint64_t num_insn) {
+     return((phase == PHASE_FUNCTIONAL) && (num_insn < (period_start + period - warmup - unit)));
+  }
+
+  // The functional simulation of the instruction after 'num_insn' is done:
+  // switch to detailed simulation (detailed warmup).
+  void begin_detailed(uint64_t num_insn);
+
+  // End of a cycle of detailed simulation. Advance to the next phase if the current one is complete.
+  // Returns 'true' if functional simulation resumes, i.e., the pipeline must be drained.
+  bool end_cycle(uint64_t num_insn, uint64_t cycle);
+
+  // STATS
+  void count_functional() { n_functional_insn++; }
+  void dump_config(FILE* fp);
+  void dump_stats(FILE* fp);
+};
+
+#endif //SAMPLER_H
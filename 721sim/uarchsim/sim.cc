@@ -11,9 +11,12 @@
 #include <iostream>
 #include <fstream>
 #include <gzstream.h>
+#include <sstream>
+#include <cstring>
 #include "pipeline.h"
 
 volatile bool ctrlc_pressed = false;
+volatile sig_atomic_t end_simulation_requested = 0;
 static void handle_signal(int sig)
 {
 	if (ctrlc_pressed) {
@@ -23,7 +26,7 @@ static void handle_signal(int sig)
 	signal(sig, &handle_signal);
 }
 
-sim_t::sim_t(size_t nprocs, size_t mem_mb, const std::vector<std::string>& args, proc_type_t _proc_type)
+sim_t::sim_t(size_t nprocs, size_t mem_mb, const std::vector<std::string>& args, proc_type_t _proc_type, bool defer_pipelines)
 	: htif(new htif_isasim_t(this, args)), procs(std::max(nprocs, size_t(1))),
 	  current_step(0), idle_cycles(0), current_proc(0), debug(false), checkpointing_enabled(false)
 {
@@ -58,32 +61,67 @@ sim_t::sim_t(size_t nprocs, size_t mem_mb, const std::vector<std::string>& args,
 		  procs[i]->set_proc_type("ISA_SIM");
     }
     else{
-		  procs[i] = new pipeline_t(
-		      this,
-          // Set this as MICRO_MMU so that mem operations
-          // do not push to debug buffer. This is necessary
-          // as we use the same class as ISA sim to instantiate
-          // the mmu.
-		      new mmu_t(mem, memsz, MICRO_MMU),  
-		      i,
-		      FETCH_QUEUE_SIZE,
-		      NUM_CHECKPOINTS,
-		      ACTIVE_LIST_SIZE,
-		      (AUTO_PRF_SIZE ? (NXPR + NFPR + ACTIVE_LIST_SIZE) : PRF_SIZE),
-		      ISSUE_QUEUE_SIZE,
-		      ISSUE_QUEUE_NUM_PARTS,
-		      LQ_SIZE,
-		      SQ_SIZE,
-		      FETCH_WIDTH,
-		      DISPATCH_WIDTH,
-		      ISSUE_WIDTH,
-		      RETIRE_WIDTH,
-		      FU_LANE_MATRIX,
-		      FU_LAT);
-		  procs[i]->set_proc_type("MICRO_SIM");
+      // Set this as MICRO_MMU so that mem operations
+      // do not push to debug buffer. This is necessary
+      // as we use the same class as ISA sim to instantiate
+      // the mmu.
+      if (defer_pipelines)
+        procs[i] = new processor_t(this, new mmu_t(mem, memsz, MICRO_MMU), i);
+      else
+        procs[i] = new_pipeline(new mmu_t(mem, memsz, MICRO_MMU), i);
+      procs[i]->set_proc_type("MICRO_SIM");
     }
 	}
+  pipelines_built = ((proc_type == MICRO_SIM) && !defer_pipelines);
+
+}
+
+processor_t* sim_t::new_pipeline(mmu_t* mmu, size_t id)
+{
+  return new pipeline_t(
+      this,
+      mmu,
+      id,
+      FETCH_QUEUE_SIZE,
+      NUM_CHECKPOINTS,
+      ACTIVE_LIST_SIZE,
+      (AUTO_PRF_SIZE ? (NXPR + NFPR + ACTIVE_LIST_SIZE) : PRF_SIZE),
+      ISSUE_QUEUE_SIZE,
+      ISSUE_QUEUE_NUM_PARTS,
+      LQ_SIZE,
+      SQ_SIZE,
+      FETCH_WIDTH,
+      DISPATCH_WIDTH,
+      ISSUE_WIDTH,
+      RETIRE_WIDTH,
+      FU_LANE_MATRIX,
+      FU_LAT);
+}
+
+void sim_t::build_pipelines()
+{
+  assert((proc_type == MICRO_SIM) && !pipelines_built);
+  for (size_t i = 0; i < procs.size(); i++) {
+    processor_t* func = procs[i];
+    processor_t* pipe = new_pipeline(func->get_mmu(), i);
+
+    // Carry over the functional processor's architectural and control state.
+    pipe->set_proc_type("MICRO_SIM");
+    pipe->state = func->state;
+    pipe->run = func->run;
+    pipe->serialized = func->serialized;
+    pipe->checker = func->checker;
+    pipe->debug = func->debug;
+    pipe->histogram_enabled = func->histogram_enabled;
+    pipe->pipe = func->pipe;
+    delete func;  // but not its mmu
+    procs[i] = pipe;
+  }
+  pipelines_built = true;
 
+  // Copy registers to the pipeline register files, as after a restore or fast skip.
+  for (size_t i = 0; i < procs.size(); i++)
+    ((pipeline_t*)procs[i])->copy_state_to_micro();
 }
 
 sim_t::~sim_t()
@@ -95,6 +133,10 @@ sim_t::~sim_t()
 		delete pmmu;
 	}
 	delete debug_mmu;
+	if (chkpt_image)
+		fprintf(stderr, "Checkpoint image: loaded %lu of %lu pages (%lu non-zero in image)\n",
+		        (unsigned long)chkpt_image->pages_loaded(), (unsigned long)chkpt_image->pages_total(),
+		        (unsigned long)chkpt_image->pages_nonzero());
 	free(mem);
 }
 
@@ -127,7 +169,8 @@ void sim_t::boot()
 
 int sim_t::run() {
    bool htif_return = true;
-   while (htif_return) {
+   assert((proc_type == ISA_SIM) || pipelines_built);
+   while (htif_return && !end_simulation_requested) {
       if (debug || ctrlc_pressed)
          interactive();
       else
@@ -187,13 +230,26 @@ bool sim_t::run_fast(size_t n)
   //set_procs_debug(true);
   set_procs_checker(false);
 
+  // Functional cache warming: the last FAST_SKIP_WARM_AMT instructions (all of them, if 0)
+  // warm the pipelines' caches. The instructions before them are skipped cold.
+  bool warm = (FAST_SKIP_WARMING && (proc_type == MICRO_SIM) && pipelines_built);
+  size_t cold = ((warm && FAST_SKIP_WARM_AMT && (FAST_SKIP_WARM_AMT < n)) ? (n - FAST_SKIP_WARM_AMT) : 0);
+  bool warming = false;
+
   bool htif_return = true;
   size_t total_retired = 0;
   size_t steps = 0;
-  while(total_retired < n && htif_return)
+  while(total_retired < n && htif_return && !end_simulation_requested)
 	{
     size_t instret = 0;
+    if (warm && !warming && (total_retired >= cold)) {
+      ifprintf(logging_on,stderr,"Warming the caches for the last %lu instructions of fast skip\n",(n - total_retired));
+      set_procs_cache_warming(true);
+      warming = true;
+    }
 		steps = std::min(n - total_retired, INTERLEAVE - current_step);
+    if (warm && !warming)
+      steps = std::min(steps, cold - total_retired);
 
     // This function continues until it has retired "steps" instructions
     // or it encounters a cycle with 0 retired instructions.
@@ -225,9 +281,12 @@ bool sim_t::run_fast(size_t n)
 		}
 	}
 
+  if (warming)
+    set_procs_cache_warming(false);
+
   // Copy registers from fast skip state to pipeline register file.
   // Also reset the AMT.
-  if(proc_type == MICRO_SIM){
+  if(proc_type == MICRO_SIM && pipelines_built){
     ifprintf(logging_on,stderr,"Copying state after skipping %lu instructions\n",total_retired);
     ((pipeline_t*)procs[current_proc])->copy_state_to_micro();
   }
@@ -291,6 +350,13 @@ void sim_t::set_simpoint(bool enable, size_t interval)
 }
 #endif
 
+void sim_t::set_bbv(bb_tracker_t* bbv)
+{
+  for (size_t i = 0; i < procs.size(); i++) {
+    procs[i]->set_bbv(bbv);
+  }
+}
+
 void sim_t::init_checkpoint(std::string checkpoint_file)
 {
   // Check if file name has .gz extension. If not, append .gz to the name
@@ -329,8 +395,42 @@ bool sim_t::create_checkpoint()
   return htif_return;
 }
 
+void sim_t::init_checkpoint_images()
+{
+  checkpointing_enabled = true;
+  htif->start_checkpointing(htif_replay);
+}
+
+// Unlike create_checkpoint(), this can be called repeatedly: each image gets
+// the HTIF replay up to this point, and the current memory and register state.
+bool sim_t::create_checkpoint_image(std::string checkpoint_file)
+{
+  assert(checkpointing_enabled);
+  if (chkpt_image)
+    chkpt_image->load_all();
+
+  chkpt_writer_t out;
+  if (!out.open(checkpoint_file, memsz, htif_replay.str() + "END_HTIF_CHECKPOINT 0 0 0\n")) {
+    std::cerr << "ERROR: Opening file `" << checkpoint_file << "' failed.\n";
+    return false;
+  }
+  for (size_t addr = 0; addr < memsz; addr += CHKPT_PAGE_SIZE)
+    out.add_page(mem + addr);
+  out.set_state(procs[current_proc]->get_state(), sizeof(state_t));
+  if (!out.close()) {
+    std::cerr << "ERROR: Writing file `" << checkpoint_file << "' failed.\n";
+    return false;
+  }
+  std::cerr << "Created processor checkpoint to " << checkpoint_file << std::endl;
+  return true;
+}
+
 void sim_t::create_memory_checkpoint(std::ostream& memory_chkpt)
 {
+  // Memory backed by a checkpoint image is only partially loaded.
+  if (chkpt_image)
+    chkpt_image->load_all();
+
   uint64_t signature = 0xbaadbeefdeadbeef;
   memory_chkpt.write((char*)&signature,8);
   memory_chkpt.write((char*)&memsz,sizeof(memsz));
@@ -349,6 +449,9 @@ bool sim_t::restore_checkpoint(std::string restore_file)
 {
   bool htif_return = true;
 
+  if (restore_file.substr(restore_file.find_last_of(".") + 1) == CHKPT_EXT)
+    return restore_image_checkpoint(restore_file);
+
   // Check if file name has .gz extension. If not, append .gz to the name
   if(restore_file.substr(restore_file.find_last_of(".") + 1) != "gz") {
     restore_file = restore_file+".gz";
@@ -389,15 +492,23 @@ void sim_t::restore_memory_checkpoint(std::istream& memory_chkpt)
 
 void sim_t::restore_proc_checkpoint(std::istream& proc_chkpt)
 {
-  state_t *state = procs[0]->get_state();
   uint64_t signature;
+  char state[sizeof(state_t)];
   proc_chkpt.read((char*)&signature,8);
   assert(signature == 0xdeadbeefbaadbeef);
-  proc_chkpt.read((char *)state,sizeof(state_t));
+  proc_chkpt.read(state,sizeof(state_t));
+  restore_proc_state(state,sizeof(state_t));
+}
+
+void sim_t::restore_proc_state(const char* chkpt_state, size_t len)
+{
+  state_t *state = procs[0]->get_state();
+  assert(len == sizeof(state_t));
+  memcpy((char *)state,chkpt_state,sizeof(state_t));
 
   // Copy registers from fast skip state to pipeline register file.
   // Also reset the AMT.
-  if(proc_type == MICRO_SIM){
+  if(proc_type == MICRO_SIM && pipelines_built){
     ifprintf(logging_on,stderr,"Copying state after restoring checkpoint\n");
     ((pipeline_t*)procs[current_proc])->copy_state_to_micro();
   }
@@ -407,6 +518,99 @@ void sim_t::restore_proc_checkpoint(std::istream& proc_chkpt)
 }
 
 
+// Restore from a .ckpt image. The HTIF replay and register state are small and
+// read up front; memory pages are inflated by the MMUs as they are first touched.
+bool sim_t::restore_image_checkpoint(std::string restore_file)
+{
+  bool htif_return = true;
+
+  chkpt_image.reset(new chkpt_image_t());
+  if (!chkpt_image->open(restore_file)) {
+    std::cerr << "ERROR: Opening checkpoint image `" << restore_file << "' failed.\n";
+    chkpt_image.reset();
+    return false;
+  }
+  // Check that the checkpointed memory size the current simulator memory size are same
+  assert(memsz == chkpt_image->memsz());
+
+  std::istringstream replay(chkpt_image->htif_replay());
+  htif_return = htif->restore_checkpoint(replay);
+  std::cerr << "Done restoring HTIF checkpoint from " << restore_file << std::endl;
+
+  // From here on, memory contents come from the image. This also discards
+  // whatever the HTIF replay wrote, as the old format's memory block did.
+  chkpt_image->attach(mem, memsz);
+  debug_mmu->set_chkpt_image(chkpt_image.get());
+  for (size_t i = 0; i < procs.size(); i++)
+    procs[i]->get_mmu()->set_chkpt_image(chkpt_image.get());
+
+  size_t state_len;
+  const char* state = chkpt_image->state(state_len);
+  restore_proc_state(state, state_len);
+  std::cerr << "Done restoring mem/reg checkpoint from " << restore_file << " ("
+            << chkpt_image->pages_nonzero() << " of " << chkpt_image->pages_total() << " pages non-zero)" << std::endl;
+
+  return htif_return;
+}
+
+bool sim_t::convert_checkpoint(std::string gz_file, std::string out_file)
+{
+  igzstream in;
+  in.open(gz_file.c_str(), std::ios::in | std::ios::binary);
+  if (!in.good()) {
+    std::cerr << "ERROR: Opening file `" << gz_file << "' failed.\n";
+    return false;
+  }
+
+  // HTIF replay text, up to and including its terminating record.
+  std::string replay, line;
+  while (std::getline(in, line)) {
+    replay += line;
+    replay += '\n';
+    if (line.compare(0, 19, "END_HTIF_CHECKPOINT") == 0)
+      break;
+  }
+
+  uint64_t signature;
+  uint64_t chkpt_memsz;
+  in.read((char*)&signature,8);
+  in.read((char*)&chkpt_memsz,sizeof(chkpt_memsz));
+  if (!in.good() || signature != 0xbaadbeefdeadbeef || (chkpt_memsz % CHKPT_PAGE_SIZE)) {
+    std::cerr << "ERROR: `" << gz_file << "' has no valid memory checkpoint.\n";
+    return false;
+  }
+
+  chkpt_writer_t out;
+  if (!out.open(out_file, chkpt_memsz, replay)) {
+    std::cerr << "ERROR: Opening file `" << out_file << "' failed.\n";
+    return false;
+  }
+
+  // Memory is streamed a page at a time, so conversion never holds the full image.
+  std::vector<char> page(CHKPT_PAGE_SIZE);
+  for (uint64_t addr = 0; addr < chkpt_memsz; addr += CHKPT_PAGE_SIZE) {
+    in.read(page.data(), CHKPT_PAGE_SIZE);
+    out.add_page(page.data());
+  }
+
+  char state[sizeof(state_t)];
+  in.read((char*)&signature,8);
+  in.read(state,sizeof(state_t));
+  if (!in.good() || signature != 0xdeadbeefbaadbeef) {
+    std::cerr << "ERROR: `" << gz_file << "' has no valid register checkpoint.\n";
+    return false;
+  }
+  out.set_state(state, sizeof(state_t));
+  in.close();
+
+  if (!out.close()) {
+    std::cerr << "ERROR: Writing file `" << out_file << "' failed.\n";
+    return false;
+  }
+  std::cerr << "Converted checkpoint " << gz_file << " to " << out_file << std::endl;
+  return true;
+}
+
 
 void sim_t::set_procs_debug(bool value)
 {
@@ -439,6 +643,13 @@ void sim_t::set_procs_checker(bool value)
 	}
 }
 
+void sim_t::set_procs_cache_warming(bool value)
+{
+	for (size_t i=0; i< procs.size(); i++) {
+		((pipeline_t*)procs[i])->set_cache_warming(value);
+	}
+}
+
 bool sim_t::get_procs_checker()
 {
 	for (size_t i=0; i< procs.size(); i++) {
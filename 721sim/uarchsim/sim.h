@@ -7,7 +7,10 @@
 #include <string>
 #include <memory>
 #include <fstream>
+#include <sstream>
 #include <gzstream.h>
+#include <signal.h>
+#include "chkpt_image.h"
 //#include "pipeline.h"
 #include "mmu.h"
 
@@ -18,12 +21,13 @@ enum proc_type_t {ISA_SIM,MICRO_SIM};
 
 class htif_isasim_t;
 class debug_buffer_t;
+class bb_tracker_t;
 
 // this class encapsulates the processors and memory in a RISC-V machine.
 class sim_t
 {
 public:
-	sim_t(size_t _nprocs, size_t mem_mb, const std::vector<std::string>& htif_args, proc_type_t _proc_type);
+	sim_t(size_t _nprocs, size_t mem_mb, const std::vector<std::string>& htif_args, proc_type_t _proc_type, bool defer_pipelines = false);
 	~sim_t();
 
 	// run the simulation to completion
@@ -35,6 +39,7 @@ public:
 	void set_histogram(bool value);
 	void set_procs_debug(bool value);
 	void set_procs_checker(bool value);
+	void set_procs_cache_warming(bool value);	// MICRO_SIM with pipelines only
 	bool get_procs_debug();
 	bool get_procs_checker();
 	htif_isasim_t* get_htif() {
@@ -44,6 +49,8 @@ public:
 #ifdef RISCV_ENABLE_SIMPOINT
   void set_simpoint(bool enable, size_t interval);
 #endif
+	// profile basic block vectors (SimPoint) while running, or stop if NULL
+	void set_bbv(bb_tracker_t* bbv);
 
 	// deliver an IPI to a specific processor
 	void send_ipi(reg_t who);
@@ -60,6 +67,14 @@ public:
   bool create_checkpoint();
   bool restore_checkpoint(std::string restore_file);
 
+  // Record the HTIF replay in memory, so that .ckpt images can be created
+  // at any number of points in a single run.
+  void init_checkpoint_images();
+  bool create_checkpoint_image(std::string checkpoint_file);
+
+  // Convert a .gz checkpoint to the paged, lazily-loaded .ckpt format.
+  static bool convert_checkpoint(std::string gz_file, std::string out_file);
+
 
 	// read one of the system control registers
 	reg_t get_scr(int which);
@@ -72,12 +87,20 @@ public:
 
   proc_type_t get_proc_type(){return proc_type;}
 
+  // A MICRO_SIM created with 'defer_pipelines' boots, restores or fast skips
+  // with functional processors, and only then builds its pipelines with the
+  // current parameters (e.g., in each process of a configuration sweep).
+  void build_pipelines();
+
 private:
   proc_type_t proc_type;
+  bool pipelines_built;
+  processor_t* new_pipeline(mmu_t* mmu, size_t id);
 	std::unique_ptr<htif_isasim_t> htif;
 	char* mem; // main memory
 	size_t memsz; // memory size in bytes
 	mmu_t* debug_mmu;  // debug port into main memory
+	std::unique_ptr<chkpt_image_t> chkpt_image; // backs main memory after restoring a .ckpt
 	std::vector<processor_t*> procs;
 
 	bool step(); // Step 1 cycle.
@@ -89,6 +112,7 @@ private:
 	bool histogram_enabled; // provide a histogram of PCs
   bool checkpointing_enabled;
   std::string checkpoint_file;
+  std::ostringstream htif_replay; // see init_checkpoint_images()
 
 	// presents a prompt for introspection into the simulation
 	void interactive();
@@ -123,11 +147,14 @@ private:
   void restore_memory_checkpoint(std::istream& memory_chkpt);
   void create_register_checkpoint(std::ostream& proc_chkpt);
   void restore_proc_checkpoint(std::istream& proc_chkpt);
+  bool restore_image_checkpoint(std::string restore_file);
+  void restore_proc_state(const char* state, size_t len);
 
 	friend class htif_isasim_t;
   friend class debug_buffer_t;
 };
 
 extern volatile bool ctrlc_pressed;
+extern volatile sig_atomic_t end_simulation_requested;	// Set by a signal handler: run() and run_fast() return early.
 
 #endif
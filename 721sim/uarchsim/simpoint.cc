@@ -0,0 +1,261 @@
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <vector>
+
+#include "sim.h"
+#include "bbtracker.h"
+#include "simpoint.h"
+
+
+bool simpoint_bbv(sim_t* sim, uint64_t interval, const std::string& name, uint64_t max_insn) {
+   // bb_tracker_t holds its whole hash table, so it lives on the heap.
+   bb_tracker_t* bbv = new bb_tracker_t();
+
+   bbv->init_bb_tracker(".", name.c_str(), interval);
+   sim->set_bbv(bbv);
+   fprintf(stderr, "Profiling basic block vectors, %" PRIu64 " instructions per interval, to %s.bb.gz\n", interval, name.c_str());
+   sim->run_fast(max_insn);
+   sim->set_bbv(NULL);
+   delete bbv;
+   return(true);
+}
+
+
+typedef struct {
+   uint64_t interval;   // simpoint: index of its interval
+   uint64_t cluster;
+   double weight;
+} simpoint_t;
+
+bool simpoint_checkpoints(sim_t* sim, uint64_t interval, const std::string& simpoints_file,
+                          const std::string& weights_file, const std::string& name) {
+   std::ifstream simpoints(simpoints_file.c_str());
+   std::ifstream weights(weights_file.c_str());
+   std::map<uint64_t, double> cluster_weight;
+   std::vector<simpoint_t> sp;
+   simpoint_t s;
+   double w;
+   uint64_t c;
+
+   if (!simpoints.good() || !weights.good()) {
+      fprintf(stderr, "ERROR: Opening simpoints file `%s' or weights file `%s' failed.\n", simpoints_file.c_str(), weights_file.c_str());
+      return(false);
+   }
+
+   // SimPoint's output: "<interval #> <cluster #>" and "<weight> <cluster #>" lines.
+   while (weights >> w >> c)
+      cluster_weight[c] = w;
+   while (simpoints >> s.interval >> s.cluster) {
+      if (cluster_weight.find(s.cluster) == cluster_weight.end()) {
+         fprintf(stderr, "ERROR: Simpoint cluster %" PRIu64 " has no weight in `%s'.\n", s.cluster, weights_file.c_str());
+         return(false);
+      }
+      s.weight = cluster_weight[s.cluster];
+      sp.push_back(s);
+   }
+   if (sp.empty()) {
+      fprintf(stderr, "ERROR: No simpoints in `%s'.\n", simpoints_file.c_str());
+      return(false);
+   }
+
+   // A single pass: skip to each simpoint in turn.
+   std::sort(sp.begin(), sp.end(), [](const simpoint_t& a, const simpoint_t& b) { return(a.interval < b.interval); });
+
+   std::string list_file = name + ".chkpts";
+   FILE* list = fopen(list_file.c_str(), "w");
+   if (!list) {
+      fprintf(stderr, "ERROR: Opening file `%s' failed.\n", list_file.c_str());
+      return(false);
+   }
+
+   sim->init_checkpoint_images();
+
+   uint64_t retired = 0;
+   bool ok = true;
+   for (unsigned int i = 0; ok && (i < sp.size()); i++) {
+      uint64_t start = sp[i].interval * interval;
+
+      if (start > retired) {
+         fprintf(stderr, "Fast skipping to simpoint %" PRIu64 " (cluster %" PRIu64 ", weight %.4f) at %" PRIu64 " instructions\n",
+                 sp[i].interval, sp[i].cluster, sp[i].weight, start);
+         if (!sim->run_fast(start - retired)) {
+            fprintf(stderr, "ERROR: The program ended before simpoint %" PRIu64 ".\n", sp[i].interval);
+            ok = false;
+            break;
+         }
+         retired = start;
+      }
+
+      std::ostringstream chkpt;
+      chkpt << name << "." << sp[i].interval << "." << sp[i].cluster << "." << CHKPT_EXT;
+      ok = sim->create_checkpoint_image(chkpt.str());
+      if (ok)
+         fprintf(list, "%.6f %s\n", sp[i].weight, chkpt.str().c_str());
+   }
+
+   fclose(list);
+   if (ok)
+      fprintf(stderr, "Wrote the list of %u weighted checkpoints to %s\n", (unsigned int)sp.size(), list_file.c_str());
+   return(ok);
+}
+
+
+// Read the "<name> : <value>" lines (counters and rates) of a stats log. Names not
+// already in 'names' are appended to it, in order of first appearance.
+static bool read_stats_log(const std::string& file, std::vector<std::string>& names, std::map<std::string, double>& value) {
+   std::ifstream stats(file.c_str());
+   std::string line;
+   char name[256];
+   double v;
+   int end;
+
+   if (!stats.good()) {
+      fprintf(stderr, "ERROR: Opening stats log `%s' failed.\n", file.c_str());
+      return(false);
+   }
+   value.clear();
+   while (std::getline(stats, line)) {
+      end = 0;
+      if ((sscanf(line.c_str(), "%255s : %lf%n", name, &v, &end) == 2) && (line[end] == '\0')) {
+         if (std::find(names.begin(), names.end(), name) == names.end())
+            names.push_back(name);
+         value[name] = v;
+      }
+   }
+   if (!value.count("commit_count") || !value.count("cycle_count") || (value["commit_count"] == 0.0)) {
+      fprintf(stderr, "ERROR: `%s' has no commit_count and cycle_count.\n", file.c_str());
+      return(false);
+   }
+   return(true);
+}
+
+static bool is_rate(const std::string& name) {
+   return((name.size() > 5) && (name.compare(name.size() - 5, 5, "_rate") == 0));
+}
+
+
+typedef struct {
+   double weight;
+   std::string file;
+   std::map<std::string, double> value;  // "<name> : <value>" lines of the stats log
+} simpoint_stats_t;
+
+bool simpoint_combine_stats(const std::string& list_file, FILE* fp) {
+   std::ifstream list(list_file.c_str());
+   std::vector<simpoint_stats_t> sp;
+   std::vector<std::string> names;   // in order of first appearance
+   simpoint_stats_t s;
+   double total_weight;
+
+   if (!list.good()) {
+      fprintf(stderr, "ERROR: Opening file `%s' failed.\n", list_file.c_str());
+      return(false);
+   }
+
+   total_weight = 0.0;
+   while (list >> s.weight >> s.file) {
+      if (!read_stats_log(s.file, names, s.value))
+         return(false);
+      sp.push_back(s);
+      total_weight += s.weight;
+   }
+   if (sp.empty() || (total_weight <= 0.0)) {
+      fprintf(stderr, "ERROR: No weighted stats logs in `%s'.\n", list_file.c_str());
+      return(false);
+   }
+
+   fprintf(fp, "=== SIMPOINTS ===================================================================\n\n");
+   fprintf(fp, "%-10s %14s %14s %8s  %s\n", "weight", "commit_count", "cycle_count", "CPI", "stats log");
+
+   // Whole-program CPI is the weighted mean of the simpoints' CPIs (not of their IPCs).
+   double cpi = 0.0;
+   for (unsigned int i = 0; i < sp.size(); i++) {
+      double sp_cpi = sp[i].value["cycle_count"] / sp[i].value["commit_count"];
+      fprintf(fp, "%-10.6f %14.0f %14.0f %8.4f  %s\n", sp[i].weight, sp[i].value["commit_count"], sp[i].value["cycle_count"], sp_cpi, sp[i].file.c_str());
+      cpi += (sp[i].weight / total_weight) * sp_cpi;
+   }
+   if (total_weight != 1.0)
+      fprintf(fp, "(weights are normalized by their total, %.6f)\n", total_weight);
+
+   // Other stats: the weighted mean of each, per simpoint. A stat missing from
+   // some stats logs is averaged over the others.
+   fprintf(fp, "\n=== WEIGHTED STATS (per simpoint) ===============================================\n\n");
+   for (unsigned int n = 0; n < names.size(); n++) {
+      double sum = 0.0;
+      double weight = 0.0;
+
+      if (names[n] == "ipc_rate")
+         continue;
+      for (unsigned int i = 0; i < sp.size(); i++) {
+         if (sp[i].value.count(names[n])) {
+            sum += sp[i].weight * sp[i].value[names[n]];
+            weight += sp[i].weight;
+         }
+      }
+      if (is_rate(names[n]))
+         fprintf(fp, "%s : %.4f\n", names[n].c_str(), sum / weight);
+      else
+         fprintf(fp, "%s : %.0f\n", names[n].c_str(), sum / weight);
+   }
+   fprintf(fp, "\nCPI : %.4f\n", cpi);
+   fprintf(fp, "ipc_rate : %.4f\n", 1.0 / cpi);
+   return(true);
+}
+
+
+bool interval_merge_stats(const std::vector<std::string>& files, FILE* fp) {
+   std::vector<std::map<std::string, double> > interval(files.size());
+   std::vector<std::string> names;   // in order of first appearance
+   double commit = 0.0;
+   double cycle = 0.0;
+
+   for (unsigned int i = 0; i < files.size(); i++) {
+      if (!read_stats_log(files[i], names, interval[i]))
+         return(false);
+      commit += interval[i]["commit_count"];
+      cycle += interval[i]["cycle_count"];
+   }
+   if (files.empty()) {
+      fprintf(stderr, "ERROR: No interval stats logs to merge.\n");
+      return(false);
+   }
+
+   fprintf(fp, "=== INTERVALS ===================================================================\n\n");
+   fprintf(fp, "%-8s %14s %14s %8s  %s\n", "interval", "commit_count", "cycle_count", "CPI", "stats log");
+   for (unsigned int i = 0; i < files.size(); i++)
+      fprintf(fp, "%-8u %14.0f %14.0f %8.4f  %s\n", i + 1, interval[i]["commit_count"], interval[i]["cycle_count"],
+              interval[i]["cycle_count"] / interval[i]["commit_count"], files[i].c_str());
+
+   // The intervals are consecutive: counters add up, and each other rate is the
+   // mean of the intervals' rates, weighted by their committed instructions.
+   fprintf(fp, "\n=== MERGED STATS ================================================================\n\n");
+   for (unsigned int n = 0; n < names.size(); n++) {
+      double sum = 0.0;
+      double weight = 0.0;
+
+      if (names[n] == "ipc_rate")
+         continue;
+      for (unsigned int i = 0; i < files.size(); i++) {
+         if (interval[i].count(names[n])) {
+            if (is_rate(names[n])) {
+               sum += interval[i]["commit_count"] * interval[i][names[n]];
+               weight += interval[i]["commit_count"];
+            }
+            else {
+               sum += interval[i][names[n]];
+            }
+         }
+      }
+      if (is_rate(names[n]))
+         fprintf(fp, "%s : %.4f\n", names[n].c_str(), sum / weight);
+      else
+         fprintf(fp, "%s : %.0f\n", names[n].c_str(), sum);
+   }
+   fprintf(fp, "\nCPI : %.4f\n", cycle / commit);
+   fprintf(fp, "ipc_rate : %.4f\n", commit / cycle);
+   return(true);
+}
@@ -0,0 +1,46 @@
+#ifndef SIMPOINT_H
+#define SIMPOINT_H
+
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class sim_t;
+
+///////////////////////////////////////////////////////////////
+// SimPoint support.
+//
+// 1. simpoint_bbv(): Run the functional simulator at fast skip
+//    speed and emit a basic block vector per interval of
+//    'interval' instructions, to <name>.bb.gz. This is the
+//    frequency vector file consumed by the SimPoint tool.
+// 2. simpoint_checkpoints(): Given the simpoints and weights
+//    files chosen by SimPoint for the same interval, run the
+//    functional simulator once and create a .ckpt checkpoint
+//    image at the start of each simpoint, named
+//    <name>.<interval #>.<cluster #>.ckpt. A list of the
+//    weighted checkpoints is written to <name>.chkpts, one
+//    "<weight> <checkpoint file>" per line.
+// 3. simpoint_combine_stats(): Each checkpoint is simulated
+//    (-c<checkpoint> -e<interval>) separately. Given a list of
+//    "<weight> <stats log>" lines, combine the per-simpoint
+//    stats into whole-program estimates.
+//
+// Both functional runs start at boot.
+//
+// interval_merge_stats() merges the stats logs of consecutive
+// intervals of one run, simulated in parallel (--intervals),
+// into the stats of the whole run.
+///////////////////////////////////////////////////////////////
+
+bool simpoint_bbv(sim_t* sim, uint64_t interval, const std::string& name, uint64_t max_insn);
+
+bool simpoint_checkpoints(sim_t* sim, uint64_t interval, const std::string& simpoints_file,
+                          const std::string& weights_file, const std::string& name);
+
+bool simpoint_combine_stats(const std::string& list_file, FILE* fp);
+
+bool interval_merge_stats(const std::vector<std::string>& files, FILE* fp);
+
+#endif
@@ -75,6 +75,9 @@ void pipeline_t::squash_complete(reg_t jump_PC) {
 	}
 
 	LSU.flush();
+
+	if (VALUE_PRED_EN)
+		VP->flush();
 }
 
 
@@ -107,6 +110,12 @@ void pipeline_t::resolve(unsigned int branch_ID, bool correct) {
 			// Writeback Stage:
 			CLEAR_BIT(Execution_Lanes[i].wb.branch_mask, branch_ID);
 		}
+
+		// Selective replay keeps a copy of each dispatched instruction's branch mask in its payload.
+		if (VP_RECOVERY == 2) {
+			for (i = 0, j = PAY.head; i < (unsigned int)PAY.length; i++, j = MOD((j + 1), PAY.PAYLOAD_BUFFER_SIZE))
+				CLEAR_BIT(PAY.buf[j].branch_mask, branch_ID);
+		}
 	}
 	else {
 		// Squash all instructions in the Decode through Dispatch Stages.
@@ -1,16 +1,45 @@
 #include "stats.h"
 #include "pipeline.h"
 #include "parameters.h"
+#include <mutex>
+
+// Process-wide mapping of counter names to counter IDs.
+static std::map<std::string, counter_id_t, ltstr> counter_id_map;
+static std::mutex counter_id_lock;
+
+counter_id_t stats_t::counter_id(const char* name){
+  std::lock_guard<std::mutex> guard(counter_id_lock);
+  std::map<std::string, counter_id_t, ltstr>::iterator id_iter = counter_id_map.find(name);
+  if(id_iter != counter_id_map.end()){
+    return id_iter->second;
+  }
+  counter_id_t id = (counter_id_t)counter_id_map.size();
+  assert(id < MAX_COUNTERS);
+  counter_id_map[name] = id;
+  return id;
+}
 
 stats_t::stats_t(pipeline_t* _proc){
 
   this->proc = _proc;
 
+  // All counter IDs refer to the scratch counter until their counters are registered.
+  scratch_counter.count = 0;
+  scratch_counter.phase_count = 0;
+  scratch_counter.name = NULL;
+  scratch_counter.hierarchy = NULL;
+  scratch_counter.valid_phase_counter = false;
+  for(unsigned int i = 0; i < MAX_COUNTERS; i++){
+    counters[i] = &scratch_counter;
+  }
+
   DECLARE_COUNTER(this, cycle_count               ,proc);
   DECLARE_COUNTER(this, commit_count              ,proc);
   DECLARE_COUNTER(this, ld_vio_count              ,proc);
   DECLARE_COUNTER(this, exception_count           ,proc);
   DECLARE_COUNTER(this, split_count               ,proc);
+  DECLARE_COUNTER(this, uop_cache_hit_count       ,proc);
+  DECLARE_COUNTER(this, uop_cache_miss_count      ,proc);
 #if 0
   DECLARE_COUNTER(this, load_count                ,proc);
   DECLARE_COUNTER(this, store_count               ,proc);
@@ -159,6 +188,7 @@ void stats_t::set_log_files(FILE* _stats_log,FILE* _phase_log){
 void stats_t::set_phase_interval(const char* name,uint64_t interval)
 {
   std::strcpy(phase_counter_name,name);
+  phase_counter_id = counter_id(name);
   phase_interval = interval;
   ifprintf(logging_on,stderr,"Setting phase interval to %s = %lu\n",phase_counter_name,interval);
 }
@@ -177,7 +207,8 @@ void stats_t::reset_phase_counters(){
   }
 }
 
-void stats_t::register_counter(const char* name, const char* hierarchy){
+counter_id_t stats_t::register_counter(const char* name, const char* hierarchy){
+  counter_id_t id = counter_id(name);
 
   counter_t* c    = new counter_t;
   c->count        = 0;
@@ -188,10 +219,14 @@ void stats_t::register_counter(const char* name, const char* hierarchy){
   strcpy(c->name,name);
   strcpy(c->hierarchy,hierarchy);
   counter_map[name] = c;
+  counters[id] = c;
   ifprintf(logging_on,stderr,"Counter name %s %s\n",name,hierarchy);
+  return id;
 }
 
-void stats_t::register_phase_counter(const char* name, const char* hierarchy){
+counter_id_t stats_t::register_phase_counter(const char* name, const char* hierarchy){
+  counter_id_t id = counter_id(name);
+
   // If the counter has been declared, mark it as a phase counter
   if(counter_map.find(name) != counter_map.end()){
     counter_map[name]->valid_phase_counter = true;
@@ -199,13 +234,17 @@ void stats_t::register_phase_counter(const char* name, const char* hierarchy){
   // If it does not exist, declare it and mark it as a phase counter
   else {
     counter_t* c    = new counter_t;
+    c->count        = 0;
+    c->phase_count  = 0;
     c->name         = new char[strlen(name)+1];
     c->hierarchy    = new char[strlen(hierarchy)+1];
     c->valid_phase_counter  = true;
     strcpy(c->name,name);
     strcpy(c->hierarchy,hierarchy);
     counter_map[name] = c;
+    counters[id] = c;
   }
+  return id;
 }
 
 void stats_t::register_rate(const char* name, const char* hierarchy, const char* numerator, const char* denominator, double multiplier){
@@ -219,6 +258,8 @@ void stats_t::register_rate(const char* name, const char* hierarchy, const char*
   strcpy(r->hierarchy,hierarchy);
   strcpy(r->numerator,numerator);
   strcpy(r->denominator,denominator);
+  r->numerator_id = counter_id(numerator);
+  r->denominator_id = counter_id(denominator);
   r->multiplier = multiplier;
   rate_map[name] = r;
 }
@@ -240,6 +281,8 @@ void stats_t::register_phase_rate(const char* name, const char* hierarchy, const
     strcpy(r->hierarchy,hierarchy);
     strcpy(r->numerator,numerator);
     strcpy(r->denominator,denominator);
+    r->numerator_id = counter_id(numerator);
+    r->denominator_id = counter_id(denominator);
     r->multiplier = multiplier;
     rate_map[name] = r;
   }
@@ -257,30 +300,12 @@ void stats_t::register_knob(const char* name, const char* hierarchy, unsigned in
 }
 
 
-void stats_t::update_counter(const char* name,unsigned int inc){
-  // If the counter has been declared and initialized
-  if(counter_map.find(name) != counter_map.end()){
-    counter_map[name]->count++;
-    counter_map[name]->phase_count++;
-  }
-  // Tick the phase check mechanism if updating the 
-  // counter on which phases are based on. Normally this
-  // would be commit_count or cycle_count.
-  if(!std::strcmp(name, phase_counter_name)){
-    phase_tick();
-  }
-}
-
-uint64_t stats_t::get_counter(const char* name){
-  return counter_map[name]->count;
-}
-
 unsigned int stats_t::get_knob(const char* name){
   return knob_map[name]->value;
 }
 
 void stats_t::phase_tick(){
-  if(counter_map[phase_counter_name]->phase_count >= phase_interval){
+  if(counters[phase_counter_id]->phase_count >= phase_interval){
     phase_id++;
     update_rates();
     dump_phase_counters();
@@ -295,20 +320,23 @@ void stats_t::phase_tick(){
 void stats_t::update_rates(){
   std::map<std::string, rate_t*, ltstr>::iterator rate_iter;
   for(rate_iter = rate_map.begin();rate_iter != rate_map.end(); rate_iter++){
-    if(counter_map[rate_iter->second->denominator]->count == 0){
+    counter_t* numerator = counters[rate_iter->second->numerator_id];
+    counter_t* denominator = counters[rate_iter->second->denominator_id];
+
+    if(denominator->count == 0){
       rate_iter->second->rate = (double)0.0;
     } else {
       rate_iter->second->rate = rate_iter->second->multiplier*
-                                double(counter_map[rate_iter->second->numerator]->count)/
-                                double(counter_map[rate_iter->second->denominator]->count);
+                                double(numerator->count)/
+                                double(denominator->count);
     }
 
-    if(counter_map[rate_iter->second->denominator]->phase_count == 0){
+    if(denominator->phase_count == 0){
       rate_iter->second->phase_rate = (double)0.0;
     } else {
       rate_iter->second->phase_rate = rate_iter->second->multiplier*
-                                      double(counter_map[rate_iter->second->numerator]->phase_count)/
-                                      double(counter_map[rate_iter->second->denominator]->phase_count);
+                                      double(numerator->phase_count)/
+                                      double(denominator->phase_count);
     }
   }
 }
@@ -10,12 +10,20 @@
 
 // Statistics related variables and funcions
 
-#define inc_counter(x)  stats->update_counter(#x,1)
-#define inc_counter_str(x)  stats->update_counter(x,1)
-#define dec_counter(x)  stats->update_counter(#x,-1)
-#define counter(x)      stats->get_counter(#x)
+// Counters are referenced by dense integer IDs, so that updating a counter is a plain array access.
+// COUNTER_ID() resolves a counter's name to its ID only once per call site (the first time it executes)
+// and caches it in a function-local static. IDs are process-wide: all stats_t instances share them.
+#define COUNTER_ID(x)   ([]() -> counter_id_t { static const counter_id_t id = stats_t::counter_id(#x); return id; }())
+
+#define inc_counter(x)  stats->update_counter(COUNTER_ID(x),1)
+#define inc_counter_str(x)  stats->update_counter(stats_t::counter_id(x),1)   // slow: resolves the name every time
+#define dec_counter(x)  stats->update_counter(COUNTER_ID(x),-1)
+#define counter(x)      stats->get_counter(COUNTER_ID(x))
 #define knob(x)         stats->get_knob(#x)
 
+// Maximum number of distinct counter names (IDs).
+#define MAX_COUNTERS    1024
+
 // Macro has been written this way to swallow semicolon
 #define DECLARE_COUNTER(stats,name,hierarchy) \
   do  {\
@@ -56,6 +64,8 @@ struct ltstr
     }
 };
 
+typedef unsigned int counter_id_t;
+
 typedef struct counter {
   uint64_t count;
   uint64_t phase_count;
@@ -72,6 +82,8 @@ typedef struct rate {
   char* hierarchy;
   char* numerator;
   char* denominator;
+  counter_id_t numerator_id;
+  counter_id_t denominator_id;
   bool valid_phase_rate; // When "true", indicates this must be dumped for each phase
 } rate_t;
 
@@ -96,13 +108,11 @@ public:
   stats_t(pipeline_t* _proc);
   ~stats_t(){}
   void set_phase_interval(const char* name,uint64_t interval);
-  void update_counter(const char* name,unsigned int inc=1);
   void update_pc_histogram(size_t pc);
   void update_br_histogram(size_t pc,bool misp);
-  uint64_t get_counter(const char* name);
   unsigned int get_knob(const char* name);
-  void register_counter(const char* name, const char* hierarchy);
-  void register_phase_counter(const char* name, const char* hierarchy);
+  counter_id_t register_counter(const char* name, const char* hierarchy);
+  counter_id_t register_phase_counter(const char* name, const char* hierarchy);
   void register_rate(const char* name, const char* hierarchy, const char* numerator, const char* denominator, double multiplier);
   void register_phase_rate(const char* name, const char* hierarchy, const char* numerator, const char* denominator, double multiplier);
   void register_knob(const char* name, const char* hierarchy, unsigned int value);
@@ -121,9 +131,31 @@ public:
 
   //inline void set_histogram(bool val){histogram_enabled = val;}
 
+  // Resolve a counter name to its ID, assigning a new ID if the name hasn't been seen before.
+  // This is slow (map lookup under a lock): cache the result, e.g., via COUNTER_ID().
+  static counter_id_t counter_id(const char* name);
+
+  // Counters that were not registered with this stats_t instance are silently ignored:
+  // their IDs map to a scratch counter that is never dumped.
+  inline void update_counter(counter_id_t id, int inc=1) {
+    counters[id]->count += inc;
+    counters[id]->phase_count += inc;
+    // Tick the phase check mechanism if updating the
+    // counter on which phases are based on. Normally this
+    // would be commit_count or cycle_count.
+    if (id == phase_counter_id)
+      phase_tick();
+  }
+
+  inline uint64_t get_counter(counter_id_t id) {
+    return counters[id]->count;
+  }
+
 private:
 
-  std::map<std::string, counter_t*, ltstr> counter_map;
+  std::map<std::string, counter_t*, ltstr> counter_map;   // registered counters, in name order (for dumping)
+  counter_t* counters[MAX_COUNTERS];                      // indexed by counter ID
+  counter_t scratch_counter;                              // target of all unregistered counter IDs
   std::map<std::string, rate_t*, ltstr> rate_map;
   //map<const char*, counter_t*, ltstr> phase_counter_map;
   std::map<std::string, knob_t*, ltstr> knob_map;
@@ -133,6 +165,7 @@ private:
   uint64_t phase_id;
   uint64_t phase_interval;
   char phase_counter_name[16];
+  counter_id_t phase_counter_id;
   FILE* stats_log;
   FILE* phase_log;
 
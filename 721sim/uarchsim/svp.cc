@@ -0,0 +1,161 @@
+#include <stdlib.h>
+#include <cinttypes>
+
+#include "pipeline.h"
+#include "svp.h"
+#include "vp_conf.h"
+
+
+svp_t::svp_t(bool last_value,
+             unsigned int vpq_size,
+             unsigned int index_bits,
+             unsigned int tag_bits,
+             unsigned int confmax,
+             unsigned int confinc,
+             unsigned int confdec,
+             unsigned int replace_stride,
+             unsigned int replace) {
+   assert(vpq_size > 0);
+   assert(index_bits < 32);
+   assert(tag_bits < 64);
+
+   this->last_value = last_value;
+   this->index_bits = index_bits;
+   this->tag_bits = tag_bits;
+   svp_size = (1 << index_bits);
+   this->confmax = confmax;
+   this->confinc = confinc;
+   this->confdec = confdec;
+   this->replace_stride = replace_stride;
+   this->replace = replace;
+
+   SVP = new svp_entry[svp_size];
+   for (unsigned int i = 0; i < svp_size; i++) {
+      SVP[i].tag = 0;
+      SVP[i].conf = 0;
+      SVP[i].retired_value = 0;
+      SVP[i].stride = 0;
+      SVP[i].instance = 0;
+   }
+
+   this->vpq_size = vpq_size;
+   inflight_pc = new uint64_t[vpq_size];
+   vpq_tail = 0;
+}
+
+svp_t::~svp_t() {
+   delete [] SVP;
+   delete [] inflight_pc;
+}
+
+// Instructions are word-aligned, so the two LSBs of the PC are dropped.
+unsigned int svp_t::get_index(uint64_t pc) {
+   return((unsigned int)((pc >> 2) & (svp_size - 1)));
+}
+
+uint64_t svp_t::get_tag(uint64_t pc) {
+   return((pc >> (2 + index_bits)) & ((((uint64_t)1) << tag_bits) - 1));
+}
+
+// An untagged SVP (tag_bits == 0) always hits, since all tags are 0.
+bool svp_t::hit(uint64_t pc) {
+   return(SVP[get_index(pc)].tag == get_tag(pc));
+}
+
+bool svp_t::predict(uint64_t pc, unsigned int vpq_index, uint64_t& pred_value, bool& confident) {
+   unsigned int index = get_index(pc);
+   bool svp_hit = hit(pc);
+
+   inflight_pc[vpq_index] = pc;
+   vpq_tail = MOD_S((vpq_index + 1), vpq_size);
+
+   if (svp_hit) {
+      // The prediction is for the next instance after all in-flight instances:
+      // retired value + (number of in-flight instances + 1) * stride.
+      pred_value = SVP[index].retired_value + ((uint64_t)(SVP[index].instance + 1) * (uint64_t)SVP[index].stride);
+      confident = (SVP[index].conf == confmax);
+      SVP[index].instance++;
+   }
+   else {
+      pred_value = 0;
+      confident = false;
+   }
+
+   return(svp_hit);
+}
+
+void svp_t::squash(unsigned int vpq_index, uint64_t pc) {
+   unsigned int index;
+
+   vpq_tail = vpq_index;
+
+   // Repair the instance counter of the squashed instruction's SVP entry.
+   if (hit(pc)) {
+      index = get_index(pc);
+      assert(SVP[index].instance > 0);
+      SVP[index].instance--;
+   }
+}
+
+void svp_t::flush() {
+   vpq_tail = 0;
+
+   // No instances are in-flight anymore.
+   for (unsigned int i = 0; i < svp_size; i++) {
+      SVP[i].instance = 0;
+   }
+}
+
+void svp_t::train(unsigned int vpq_index, uint64_t pc, uint64_t value) {
+   unsigned int index;
+   int64_t new_stride;
+
+   index = get_index(pc);
+
+   if (hit(pc)) {
+      new_stride = (last_value ? 0 : (int64_t)(value - SVP[index].retired_value));
+      if ((int64_t)(value - SVP[index].retired_value) == SVP[index].stride) {
+         SVP[index].conf = vp_conf_inc(SVP[index].conf, confinc, confmax);
+      }
+      else {
+         if (SVP[index].conf <= replace_stride)
+            SVP[index].stride = new_stride;
+         SVP[index].conf = (SVP[index].conf > confdec) ? (SVP[index].conf - confdec) : 0;
+      }
+      SVP[index].retired_value = value;
+
+      // The retired instance is no longer in-flight.
+      assert(SVP[index].instance > 0);
+      SVP[index].instance--;
+   }
+   else if (SVP[index].conf <= replace) {
+      // Replace the entry.
+      SVP[index].tag = get_tag(pc);
+      SVP[index].conf = 0;
+      SVP[index].retired_value = value;
+      SVP[index].stride = 0;
+
+      // Other in-flight instances of this instruction missed in the SVP when they were renamed.
+      // Count them now, so that the instance counter reflects all in-flight instances of the new owner.
+      SVP[index].instance = 0;
+      for (unsigned int j = MOD_S((vpq_index + 1), vpq_size); j != vpq_tail; j = MOD_S((j + 1), vpq_size)) {
+         if ((get_index(inflight_pc[j]) == index) && hit(inflight_pc[j]))
+            SVP[index].instance++;
+      }
+   }
+   else {
+      // Don't replace a confident entry right away: gradually weaken it.
+      SVP[index].conf--;
+   }
+}
+
+void svp_t::dump_config(FILE* fp) {
+   fprintf(fp, "SVP_NUM_INDEX_BITS = %d\n", index_bits);
+   fprintf(fp, "SVP_NUM_TAG_BITS = %d\n", tag_bits);
+   fprintf(fp, "SVP_CONFMAX = %d\n", confmax);
+   fprintf(fp, "SVP_CONFINC = %d\n", confinc);
+   fprintf(fp, "SVP_CONFDEC = %d\n", confdec);
+   if (!last_value)
+      fprintf(fp, "SVP_REPLACE_STRIDE = %d\n", replace_stride);
+   fprintf(fp, "SVP_REPLACE = %d\n", replace);
+}
@@ -0,0 +1,76 @@
+#ifndef SVP_H
+#define SVP_H
+
+#include "VPinterface.h"
+
+///////////////////////////////////////////////////////////////
+// Stride Value Predictor (SVP): a PC-indexed, tagged table of
+// {retired value, stride, confidence, instance} entries.
+//
+// The prediction for an in-flight instance is the retired
+// value plus (number of older in-flight instances + 1) strides.
+//
+// With 'last_value' set, the stride is always 0 and this is a
+// Last Value Predictor (LVP).
+///////////////////////////////////////////////////////////////
+
+// Single entry in the SVP.
+typedef struct {
+  uint64_t tag;               // PC tag (meaningless if the SVP is untagged)
+  unsigned int conf;          // confidence counter (saturates at confmax)
+  uint64_t retired_value;     // value of the last retired instance
+  int64_t stride;             // difference between the last two retired values
+  unsigned int instance;      // number of in-flight instances (VPQ entries) that map to this entry
+} svp_entry;
+
+
+class svp_t : public VPinterface_t {
+
+private:
+  bool last_value;            // LVP: never learn a stride
+
+  svp_entry* SVP;
+  unsigned int svp_size;
+  unsigned int index_bits;
+  unsigned int tag_bits;
+
+  unsigned int confmax;       // confidence threshold: a prediction is confident if conf == confmax
+  unsigned int confinc;       // confidence increment when the new stride matches
+  unsigned int confdec;       // confidence decrement when the new stride doesn't match
+  unsigned int replace_stride;// only replace the stride if conf <= replace_stride
+  unsigned int replace;       // only replace the entry (tag miss) if conf <= replace
+
+  // PCs of in-flight instances, by VPQ index, for recounting instances when an entry is replaced.
+  uint64_t* inflight_pc;
+  unsigned int vpq_size;
+  unsigned int vpq_tail;      // VPQ index after the youngest in-flight instance
+
+  unsigned int get_index(uint64_t pc);
+  uint64_t get_tag(uint64_t pc);
+  bool hit(uint64_t pc);
+
+public:
+  svp_t(bool last_value,
+        unsigned int vpq_size,
+        unsigned int index_bits,
+        unsigned int tag_bits,
+        unsigned int confmax,
+        unsigned int confinc,
+        unsigned int confdec,
+        unsigned int replace_stride,
+        unsigned int replace);
+  ~svp_t();
+
+  bool predict(uint64_t pc, unsigned int vpq_index, uint64_t& pred_value, bool& confident);
+  void spec_update_branch(uint64_t pc, bool taken) {}
+  uint64_t get_context() { return(0); }
+  void set_context(uint64_t context) {}
+  void squash(unsigned int vpq_index, uint64_t pc);
+  void flush();
+  void train(unsigned int vpq_index, uint64_t pc, uint64_t value);
+  void commit_branch(uint64_t pc, bool taken) {}
+  void dump_config(FILE* fp);
+  void dump_stats(FILE* fp) {}
+};
+
+#endif //SVP_H
@@ -14,12 +14,44 @@
 
 tagescl_wrapper_t::tagescl_wrapper_t(uint64_t bq_size) {
    TAGE = new tagescl_t();
-   log = new tage_log_t [bq_size];
+   log = new tage_log_t [bq_size]();	// zeroed: flush() may consult the entry of an empty branch queue
+
+   // The speculative history log holds the updates of all branches in the branch queue, plus the fetch bundle in the Fetch2 stage.
+   hist_size = (bq_size + 2);
+   hist_log = new tage_hist_undo_t [hist_size];
+   hist_head = 0;
+   hist_tail = 0;
+   fetch2_hist_pos = 0;
+   log_hist_pos = 0;
+
+   // The circular global history buffer must hold the longest history plus the history bits of all in-flight branches (two per branch).
+   assert((MAXHIST + 1 + 2*hist_size) <= HISTBUFFERLENGTH);
 }
 
 tagescl_wrapper_t::~tagescl_wrapper_t() {
 }
 
+// Speculatively update the history, logging an undo record.
+void tagescl_wrapper_t::hist_update(uint64_t pc, bool taken, uint64_t next_pc) {
+   assert((hist_tail - hist_head) < hist_size);
+   TAGE->getHistUndo(pc, hist_log[hist_tail % hist_size]);
+   hist_tail++;
+   TAGE->SpecHistoryUpdate(pc, OPTYPE_JMP_DIRECT_COND, taken, next_pc);
+}
+
+// Undo all speculative history updates from position 'pos' on.
+// The local and IMLI history table entries are undone youngest first, then the rest of the history is copied from the record at 'pos'.
+void tagescl_wrapper_t::hist_restore(uint64_t pos) {
+   assert((pos >= hist_head) && (pos <= hist_tail));
+   if (pos == hist_tail)
+      return;
+   while (hist_tail > pos) {
+      hist_tail--;
+      TAGE->HistoryUndo(hist_log[hist_tail % hist_size]);
+   }
+   TAGE->HistoryRestore(hist_log[pos % hist_size]);
+}
+
 // Get "m" cond. branch predictions or 1 indirect target prediction.
 // "pc" is the start PC of the fetch bundle.
 uint64_t tagescl_wrapper_t::predict(uint64_t pc) {
@@ -28,16 +60,7 @@ uint64_t tagescl_wrapper_t::predict(uint64_t pc) {
 
 // Save the predictor's context prior to speculatively updating it.
 void tagescl_wrapper_t::save_fetch2_context() {
-   TAGE->getTageHist(fetch2_TagePhist,
-   		     fetch2_TagePTGhist, fetch2_TageHist,
-		     fetch2_TageGHIST,
-		     fetch2_TageIMLIcount, fetch2_TageIMHIST,
-		     fetch2_TageL_shist, fetch2_TageS_slhist,
-		     fetch2_TageT_slhist,
-		     fetch2_TageCh_i,
-		     fetch2_TageCh_t0,
-		     fetch2_TageCh_t1,
-		     fetch2_TageSeed);
+   fetch2_hist_pos = hist_tail;
 }
 
 // Speculatively update the predictor's context.
@@ -54,28 +77,18 @@ void tagescl_wrapper_t::spec_update(uint64_t predictions, uint64_t num,
 // Using both seems redundant.
    assert (num <= 1);
    if (num != 0)
-      TAGE->SpecHistoryUpdate(pc, OPTYPE_JMP_DIRECT_COND, (bool) predictions, next_pc);
+      hist_update(pc, (bool) predictions, next_pc);
 }
 
 // Restore the predictor's context due to a misfetch.
 void tagescl_wrapper_t::restore_fetch2_context() {
-   TAGE->HistoryRevert(fetch2_TagePhist,
-		   	   fetch2_TagePTGhist,
-			   fetch2_TageHist,
-			   fetch2_TageGHIST,
-			   fetch2_TageIMLIcount,
-			   fetch2_TageIMHIST,
-			   fetch2_TageL_shist,
-			   fetch2_TageS_slhist,
-			   fetch2_TageT_slhist,
-			   fetch2_TageCh_i,
-			   fetch2_TageCh_t0,
-			   fetch2_TageCh_t1);
+   hist_restore(fetch2_hist_pos);
    //printf ("Restoring context due to misfetch here\n");
 }
 
 // Begin logging: perform initialization, if any, to prepare for logging branches in the FETCH2 bundle.
 void tagescl_wrapper_t::log_begin() {
+   log_hist_pos = fetch2_hist_pos;
 }
 
 // Log the predictor's context w.r.t. a branch in the FETCH2 bundle.
@@ -86,27 +99,7 @@ void tagescl_wrapper_t::log_begin() {
 // next_pc: PC of the instruction after this branch.
 void tagescl_wrapper_t::log_branch(uint64_t log_id, btb_branch_type_e branch_type, bool taken, uint64_t pc, uint64_t next_pc) {
    log[log_id].fetch_pc = pc;
-   log[log_id].TagePhist = fetch2_TagePhist;
-   log[log_id].TagePTGhist = fetch2_TagePTGhist;
-   log[log_id].TageSeed = fetch2_TageSeed;
-   for (int i = 0; i < 4096; i++)
-	   log[log_id].TageHist[i] = fetch2_TageHist[i];
-   log[log_id].TageGHIST = fetch2_TageGHIST;
-   log[log_id].TageIMLIcount = fetch2_TageIMLIcount;
-   for (int i = 0; i < 256; i++)
-	   log[log_id].TageIMHIST[i] = fetch2_TageIMHIST[i];
-   for (int i = 0; i < 256; i++)
-	   log[log_id].TageL_shist[i] = fetch2_TageL_shist[i];
-   for (int i = 0; i < 16; i++)
-	   log[log_id].TageS_slhist[i] = fetch2_TageS_slhist[i];
-   for (int i = 0; i < 16; i++)
-	   log[log_id].TageT_slhist[i] = fetch2_TageT_slhist[i];
-   for (int i = 0; i < 37; i++)
-	   log[log_id].TageCh_i[i] = fetch2_TageCh_i[i];
-   for (int i = 0; i < 37; i++)
-	   log[log_id].TageCh_t0[i] = fetch2_TageCh_t0[i];
-   for (int i = 0; i < 37; i++)
-	   log[log_id].TageCh_t1[i] = fetch2_TageCh_t1[i];
+   log[log_id].hist_pos = log_hist_pos;
 
    TAGE->getPredictionContext (
 		   log[log_id].TageBimIndex,
@@ -135,16 +128,21 @@ void tagescl_wrapper_t::log_branch(uint64_t log_id, btb_branch_type_e branch_typ
 		   log[log_id].TageLowConf,
 		   log[log_id].TageTHRES
 		   );
-   
-   //Following not needed for one branch prediction per cycle
+
+   // A conditional branch's speculative history update was logged by spec_update() in the Fetch1 stage.
+   // Its undo record holds the history prior to the branch, which is what the branch's update at commit consumes.
    if (branch_type == BTB_BRANCH) {
-      TAGE->MyHistoryUpdate(pc, OPTYPE_JMP_DIRECT_COND, taken, next_pc,
-   		            fetch2_TagePhist, fetch2_TagePTGhist,
-			    fetch2_TageHist, fetch2_TageGHIST,
-			    fetch2_TageIMLIcount, fetch2_TageIMHIST,
-			    fetch2_TageL_shist, fetch2_TageS_slhist,
-			    fetch2_TageT_slhist,
-			    fetch2_TageCh_i, fetch2_TageCh_t0, fetch2_TageCh_t1);
+      assert(log_hist_pos < hist_tail);
+      tage_hist_undo_t &undo = hist_log[log_hist_pos % hist_size];
+      log[log_id].TagePhist = undo.phist;
+      log[log_id].TagePTGhist = undo.ptghist;
+      log[log_id].TageGHIST = undo.GHIST;
+      log[log_id].TageIMLIcount = undo.IMLIcount;
+      log[log_id].TageIMHIST = undo.IMHIST;
+      log[log_id].TageL_shist = undo.L_shist;
+      log[log_id].TageS_slhist = undo.S_slhist;
+      log[log_id].TageT_slhist = undo.T_slhist;
+      log_hist_pos++;
    }
 }
 
@@ -154,34 +152,22 @@ void tagescl_wrapper_t::log_branch(uint64_t log_id, btb_branch_type_e branch_typ
 // taken: the corrected branch direction.
 // next_pc: the corrected target.
 void tagescl_wrapper_t::mispredict(uint64_t log_id, bool iscond, bool taken, uint64_t next_pc) {
-   TAGE->HistoryRevertAndUpdate(log[log_id].fetch_pc, OPTYPE_JMP_DIRECT_COND,
-                            taken, next_pc, log[log_id].TagePhist,
-                            log[log_id].TagePTGhist, log[log_id].TageHist,
-                            log[log_id].TageGHIST,
-                            log[log_id].TageIMLIcount, log[log_id].TageIMHIST,
-                            log[log_id].TageL_shist, log[log_id].TageS_slhist,
-                            log[log_id].TageT_slhist,
-                            log[log_id].TageCh_i,
-                            log[log_id].TageCh_t0,
-                            log[log_id].TageCh_t1);
+   hist_restore(log[log_id].hist_pos);
+   hist_update(log[log_id].fetch_pc, taken, next_pc);
    //printf ("Restoring context due to mispredict here\n");
 }
 
 // Restore the predictor's context due to a full squash.
 // log_id: log entry corresponding to the commit point of the pipeline.
 void tagescl_wrapper_t::flush(uint64_t log_id) {
-   TAGE->HistoryRevert(log[log_id].TagePhist,
-                           log[log_id].TagePTGhist,
-			   log[log_id].TageHist,
-			   log[log_id].TageGHIST,
-			   log[log_id].TageIMLIcount,
-			   log[log_id].TageIMHIST,
-			   log[log_id].TageL_shist,
-			   log[log_id].TageS_slhist,
-			   log[log_id].TageT_slhist,
-			   log[log_id].TageCh_i,
-			   log[log_id].TageCh_t0,
-			   log[log_id].TageCh_t1);
+   // If the branch queue is empty, the log entry is stale (its branch committed or was squashed).
+   // Its position may then lie outside the live part of the speculative history log: clamp it.
+   uint64_t pos = log[log_id].hist_pos;
+   if (pos < hist_head)
+      pos = hist_head;
+   else if (pos > hist_tail)
+      pos = hist_tail;
+   hist_restore(pos);
    //printf ("Restoring context due to flush here\n");
 }
 
@@ -215,4 +201,7 @@ void tagescl_wrapper_t::commit(uint64_t log_id, uint64_t pc, uint64_t branch_in_
 			      log[log_id].TageTHRES, log[log_id].TageIMLIcount,
 			      log[log_id].TageIMHIST, log[log_id].TageL_shist,
 			      log[log_id].TageS_slhist, log[log_id].TageT_slhist);
+
+   // The branch's speculative history update is no longer speculative.
+   hist_head = log[log_id].hist_pos + 1;
 }
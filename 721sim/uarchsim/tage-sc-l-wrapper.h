@@ -10,10 +10,18 @@
 
 // Anirudh:
 // Define a class for this predictor's local log entry.
+//
+// The speculative history itself is not copied into the log entry.
+// Instead, the entry records the position of the branch in the speculative
+// history log (see below): restoring the history to just before the branch
+// is done by undoing the speculative history updates from that position on.
+// The entry also keeps the few history values that the branch's update of the
+// predictor, at commit, consumes.
 
 class tage_log_t {
    public:
       uint64_t fetch_pc;
+      uint64_t hist_pos;	// position of this branch's speculative history update in the speculative history log
       int TageBimIndex;
       int TageBimPred;
       int TageIndex[37];
@@ -27,7 +35,6 @@ class tage_log_t {
       bool TageAltConf;
       long long TagePhist;
       int TagePTGhist;
-      uint8_t TageHist[4096];
       int TageSeed;
       bool Tagepredloop;
       int TageLIB;
@@ -44,13 +51,10 @@ class tage_log_t {
       long long TageGHIST;
       int TageTHRES;
       long long TageIMLIcount;
-      long long TageIMHIST[256];
-      long long TageL_shist[1 << 8];
-      long long TageS_slhist[1 << 4];
-      long long TageT_slhist[16];
-      folded_history TageCh_i[37];
-      folded_history TageCh_t0[37];
-      folded_history TageCh_t1[37];
+      long long TageIMHIST;	// IMHIST[TageIMLIcount]
+      long long TageL_shist;	// L_shist[] entry of the branch
+      long long TageS_slhist;	// S_slhist[] entry of the branch
+      long long TageT_slhist;	// T_slhist[] entry of the branch
 };
 
 class tagescl_wrapper_t : public BPinterface_t {
@@ -62,48 +66,21 @@ class tagescl_wrapper_t : public BPinterface_t {
       // - member variable for local log
       tage_log_t* log;
 
+      // - speculative history log
+      //   Circular log of undo records, one per speculative history update, in program order.
+      //   Positions are not wrapped: hist_head is the position of the oldest update that has not
+      //   committed, and hist_tail is the position of the next update.
+      tage_hist_undo_t* hist_log;
+      uint64_t hist_size;
+      uint64_t hist_head;
+      uint64_t hist_tail;
+
+      void hist_update(uint64_t pc, bool taken, uint64_t next_pc);	// Speculatively update the history, logging an undo record.
+      void hist_restore(uint64_t pos);					// Undo all speculative history updates from position 'pos' on.
+
       // - member variable(s) for fetch2 state
-      long long fetch2_TagePhist;
-      int fetch2_TagePTGhist;
-      uint8_t fetch2_TageHist[4096];
-      long long fetch2_TageGHIST;
-      long long fetch2_TageIMLIcount;
-      long long fetch2_TageIMHIST[256];
-      long long fetch2_TageL_shist[1 << 8];
-      long long fetch2_TageS_slhist[1 << 4];
-      long long fetch2_TageT_slhist[16];
-      folded_history fetch2_TageCh_i[37];
-      folded_history fetch2_TageCh_t0[37];
-      folded_history fetch2_TageCh_t1[37];
-      int fetch2_TageSeed;
-
-#if 0
-      int fetch2_TageBimIndex;
-      int fetch2_TageBimPred;
-      int fetch2_TageIndex[37];
-      uint fetch2_TageTag[37];
-      bool fetch2_TagePredTaken;
-      bool fetch2_TagePred;
-      bool fetch2_TageAltPred;
-      bool fetch2_TageLongestMatchPred;
-      int fetch2_TageHitBank;
-      int fetch2_TageAltBank;
-      bool fetch2_TageAltConf;
-      int fetch2_TageSeed;
-      bool fetch2_Tagepredloop;
-      int fetch2_TageLIB;
-      int fetch2_TageLI;
-      int fetch2_TageLHIT;
-      int fetch2_TageLTAG;
-      bool fetch2_TageLVALID;
-      bool fetch2_TagePredInter;
-      int fetch2_TageLSUM;
-      int fetch2_Tageupdatethreshold;
-      bool fetch2_TageHighConf;
-      bool fetch2_TageMedConf;
-      bool fetch2_TageLowConf;
-      int fetch2_TageTHRES;
-#endif
+      uint64_t fetch2_hist_pos;	// position in the speculative history log prior to the fetch bundle
+      uint64_t log_hist_pos;	// position in the speculative history log of the next branch logged in the fetch bundle
 
    public:
       tagescl_wrapper_t(uint64_t bq_size);
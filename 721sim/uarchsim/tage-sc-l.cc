@@ -76,7 +76,7 @@ void tagescl_t::reinit()
 	Seed = 0;
 
 	for (int i = 0; i < HISTBUFFERLENGTH; i++)
-		ghist[0] = 0;
+		ghist[i] = 0;
 	ptghist = 0;
 	updatethreshold = 35 << 3;
 
@@ -267,6 +267,11 @@ void tagescl_t::reinit()
 		S_slhist[i] = 0;
 
 	}
+	for (int i = 0; i < NTLOCAL; i++)
+		T_slhist[i] = 0;
+	for (int i = 0; i < 256; i++)
+		IMHIST[i] = 0;
+	IMLIcount = 0;
 	GHIST = 0;
 	ptghist = 0;
 	phist = 0;
@@ -408,40 +413,6 @@ void tagescl_t::getPredInfo(int &TageBimIndex, int &TageBimPred, int TageIndex[]
 	}
 }
 
-void tagescl_t::getTageHist(long long &TagePhist, int &TagePTGhist, uint8_t TageHist[], long long &TageGHIST,
-		long long &TageIMLIcount, long long TageIMHIST[], long long TageL_shist[], long long TageS_slhist[], long long TageT_slhist[],
-		folded_history TageCh_i[], folded_history TageCh_t0[], folded_history TageCh_t1[], int& TageSeed)
-		{
-	TagePhist = phist;
-	TagePTGhist = ptghist;
-	for (int i = 0; i < 4096; i++)
-			{
-		TageHist[i] = ghist[i];
-	}
-#ifdef SC
-	TageGHIST = GHIST;
-#ifdef IMLI
-	TageIMLIcount = IMLIcount;
-	for (int i = 0; i < 256; i++)
-		TageIMHIST[i] = IMHIST[i];
-#endif
-#ifdef LOCALH
-	for (int i = 0; i < NLOCAL; i++)
-		TageL_shist[i] = L_shist[i];
-	for (int i = 0; i < NSECLOCAL; i++)
-		TageS_slhist[i] = S_slhist[i];
-	for (int i = 0; i < NTLOCAL; i++)
-		TageT_slhist[i] = T_slhist[i];
-#endif
-#endif
-	for (int i = 1; i < 37; i++){
-		TageCh_i[i] = ch_i[i];
-		TageCh_t0[i] = ch_t[0][i];
-		TageCh_t1[i] = ch_t[1][i];
-	}
-	//TageSeed = Seed;
-}
-
 bool tagescl_t::getbim()
 {
 	BIM = (btable[BI].pred << 1) + (btable[BI >> HYSTSHIFT].hyst);
@@ -807,147 +778,6 @@ UINT64 target, long long &X, int &Y,
 	X = (X & ((1 << PHISTWIDTH) - 1));
 }
 
-void tagescl_t::HistoryRevertAndUpdate(UINT64 PC, OpType opType, bool taken,
-UINT64 target, long long TagePhist, int TagePTGhist, uint8_t TageHist[],
-		long long TageGHIST, long long TageIMLIcount, long long TageIMHIST[],
-		long long TageL_shist[], long long TageS_slhist[], long long TageT_slhist[],
-	       	folded_history TageCh_i[], folded_history TageCh_t0[], folded_history TageCh_t1[])
-		{
-	//Reverting State
-	phist = TagePhist;
-	ptghist = TagePTGhist;
-	GHIST = TageGHIST;
-	IMLIcount = TageIMLIcount;
-	for (int i = 0; i < 4096; i++)
-		ghist[i] = TageHist[i];
-#ifdef IMLI
-	for (int i = 0; i < 256; i++)
-		IMHIST[i] = TageIMHIST[i];
-#endif
-#ifdef SC
-	for (int i = 0; i < NLOCAL; i++)
-		L_shist[i] = TageL_shist[i];
-	for (int i = 0; i < NSECLOCAL; i++)
-		S_slhist[i] = TageS_slhist[i];
-	for (int i = 0; i < NTLOCAL; i++)
-		T_slhist[i] = TageT_slhist[i];
-#endif
-	for (int i = 1; i < 37; i++){
-	       	ch_i[i] = TageCh_i[i]; 
-		ch_t[0][i] = TageCh_t0[i];
-		ch_t[1][i] = TageCh_t1[i];
-	}
-
-	int brtype = 0;
-
-	switch (opType)
-	{
-		case OPTYPE_RET_UNCOND:
-			case OPTYPE_JMP_INDIRECT_UNCOND:
-			case OPTYPE_JMP_INDIRECT_COND:
-			case OPTYPE_CALL_INDIRECT_UNCOND:
-			case OPTYPE_CALL_INDIRECT_COND:
-			case OPTYPE_RET_COND:
-			brtype = 2;
-			break;
-		case OPTYPE_JMP_DIRECT_COND:
-			case OPTYPE_CALL_DIRECT_COND:
-			case OPTYPE_JMP_DIRECT_UNCOND:
-			case OPTYPE_CALL_DIRECT_UNCOND:
-			brtype = 0;
-			break;
-		default:
-			exit(1);
-	}
-	switch (opType)
-	{
-		case OPTYPE_JMP_DIRECT_COND:
-			case OPTYPE_CALL_DIRECT_COND:
-			case OPTYPE_JMP_INDIRECT_COND:
-			case OPTYPE_CALL_INDIRECT_COND:
-			case OPTYPE_RET_COND:
-			brtype += 1;
-			break;
-
-		default:
-			exit(1);
-	}
-
-//special treatment for indirect  branchs;
-	int maxt = 2;
-	if (brtype & 1)
-		maxt = 2;
-	else if ((brtype & 2))
-		maxt = 3;
-
-#ifdef IMLI
-	if (brtype & 1)
-			{
-#ifdef IMLI
-		IMHIST[IMLIcount] = (IMHIST[IMLIcount] << 1) + taken;
-#endif
-		if (target < PC)
-
-		{
-//This branch corresponds to a loop
-			if (!taken)
-			{
-//exit of the "loop"
-				IMLIcount = 0;
-
-			}
-			if (taken)
-			{
-
-				if (IMLIcount < ((1 << Im[0]) - 1))
-					IMLIcount++;
-			}
-		}
-	}
-
-#endif
-
-	if (brtype & 1)
-			{
-		GHIST = (GHIST << 1) + (taken & (target < PC));
-		L_shist[INDLOCAL] = (L_shist[INDLOCAL] << 1) + (taken);
-		S_slhist[INDSLOCAL] =
-				((S_slhist[INDSLOCAL] << 1) + taken) ^ (PC & 15);
-		T_slhist[INDTLOCAL] = (T_slhist[INDTLOCAL] << 1) + taken;
-	}
-
-	int T = ((PC ^ (PC >> 2))) ^ taken;
-	int PATH = PC ^ (PC >> 2) ^ (PC >> 4);
-	if ((brtype == 3) & taken)
-			{
-		T = (T ^ (target >> 2));
-		PATH = PATH ^ (target >> 2) ^ (target >> 4);
-	}
-
-	for (int t = 0; t < maxt; t++)
-			{
-		bool DIR = (T & 1);
-		T >>= 1;
-		int PATHBIT = (PATH & 127);
-		PATH >>= 1;
-//update  history
-		ptghist--;
-		ghist[ptghist & (HISTBUFFERLENGTH - 1)] = DIR;
-		phist = (phist << 1) ^ PATHBIT;
-
-		for (int i = 1; i <= NHIST; i++)
-				{
-
-			ch_i[i].update(ghist, ptghist);
-			ch_t[0][i].update(ghist, ptghist);
-			ch_t[1][i].update(ghist, ptghist);
-
-		}
-	}
-
-	phist = (phist & ((1 << PHISTWIDTH) - 1));
-}
-
 
 void tagescl_t::UpdatePredictor(UINT64 PC, OpType opType, bool resolveDir,
 		bool predDir, UINT64 branchTarget)
@@ -1262,8 +1092,8 @@ void tagescl_t::UpdatePredictorMicro(UINT64 PC, OpType opType, bool resolveDir,
 		int TageHitBank, int TageAltBank, bool TageAltConf, long long TagePhist, int TagePTGhist, int TageSeed,
 		bool Tagepredloop, int TageLIB, int TageLI, int TageLHIT, int TageLTAG, bool TageLVALID,
 		bool TagePredInter, int TageLSUM, bool TageHighConf, bool TageMedConf, bool TageLowConf,
-		long long TageGHIST, int TageTHRES, long long TageIMLIcount, long long TageIMHIST[], long long TageL_shist[], long long TageS_slhist[],
-		long long TageT_slhist[])
+		long long TageGHIST, int TageTHRES, long long TageIMLIcount, long long TageIMHIST, long long TageL_shist, long long TageS_slhist,
+		long long TageT_slhist)
 		{
 
 			//    if(DEBUG_BP)
@@ -1345,21 +1175,21 @@ void tagescl_t::UpdatePredictorMicro(UINT64 PC, OpType opType, bool resolveDir,
 				TageGHIST, Gm, GGEHL, GNB, LOGGNB, WG);
 		Gupdate(PC, resolveDir, TagePhist, Pm, PGEHL, PNB, LOGPNB, WP);
 #ifdef LOCALH
-		Gupdate(PC, resolveDir, TageL_shist[INDLOCAL], Lm, LGEHL, LNB, LOGLNB,
+		Gupdate(PC, resolveDir, TageL_shist, Lm, LGEHL, LNB, LOGLNB,
 				WL);
 #ifdef LOCALS
-		Gupdate(PC, resolveDir, TageS_slhist[INDSLOCAL], Sm,
+		Gupdate(PC, resolveDir, TageS_slhist, Sm,
 				SGEHL, SNB, LOGSNB, WS);
 #endif
 #ifdef LOCALT
 
-		Gupdate(PC, resolveDir, TageT_slhist[INDTLOCAL], Tm, TGEHL, TNB, LOGTNB,
+		Gupdate(PC, resolveDir, TageT_slhist, Tm, TGEHL, TNB, LOGTNB,
 				WT);
 #endif
 #endif
 
 #ifdef IMLI
-		Gupdate(PC, resolveDir, TageIMHIST[(TageIMLIcount)], IMm, IMGEHL, IMNB,
+		Gupdate(PC, resolveDir, TageIMHIST, IMm, IMGEHL, IMNB,
 		LOGIMNB, WIM);
 		Gupdate(PC, resolveDir, TageIMLIcount, Im, IGEHL, INB, LOGINB, WI);
 #endif
@@ -1628,6 +1458,53 @@ UINT64 branchTarget)
 
 }
 
+// Record what HistoryUpdate() of a conditional branch at PC is about to modify, so that it can be undone.
+void tagescl_t::getHistUndo(UINT64 PC, tage_hist_undo_t &undo)
+		{
+	undo.ptghist = ptghist;
+	for (int i = 1; i <= NHIST; i++)
+			{
+		undo.ch_i[i] = ch_i[i].comp;
+		undo.ch_t[0][i] = ch_t[0][i].comp;
+		undo.ch_t[1][i] = ch_t[1][i].comp;
+	}
+	undo.phist = phist;
+	undo.GHIST = GHIST;
+	undo.IMLIcount = IMLIcount;
+	undo.IMHIST = IMHIST[IMLIcount];
+	undo.L_index = INDLOCAL;
+	undo.L_shist = L_shist[INDLOCAL];
+	undo.S_index = INDSLOCAL;
+	undo.S_slhist = S_slhist[INDSLOCAL];
+	undo.T_index = INDTLOCAL;
+	undo.T_slhist = T_slhist[INDTLOCAL];
+}
+
+// Undo the local and IMLI history table entries modified by a speculative history update.
+// Undo records must be applied youngest first. The rest of the history is restored by HistoryRestore().
+void tagescl_t::HistoryUndo(const tage_hist_undo_t &undo)
+		{
+	IMHIST[undo.IMLIcount] = undo.IMHIST;
+	L_shist[undo.L_index] = undo.L_shist;
+	S_slhist[undo.S_index] = undo.S_slhist;
+	T_slhist[undo.T_index] = undo.T_slhist;
+}
+
+// Restore the global history pointer, scalars and folded histories to just before a speculative history update.
+void tagescl_t::HistoryRestore(const tage_hist_undo_t &undo)
+		{
+	ptghist = undo.ptghist;
+	for (int i = 1; i <= NHIST; i++)
+			{
+		ch_i[i].comp = undo.ch_i[i];
+		ch_t[0][i].comp = undo.ch_t[0][i];
+		ch_t[1][i].comp = undo.ch_t[1][i];
+	}
+	phist = undo.phist;
+	GHIST = undo.GHIST;
+	IMLIcount = undo.IMLIcount;
+}
+
 #ifdef LOOPPREDICTOR
 int tagescl_t::lindex(UINT64 PC)
 		{
@@ -1864,159 +1741,6 @@ void tagescl_t::loopupdateMicro(UINT64 PC, bool Taken, bool ALLOC, bool Tagepred
 
 #endif
 
-void tagescl_t::HistoryRevert(
-		long long TagePhist, int TagePTGhist, uint8_t TageHist[],
-		long long TageGHIST, long long TageIMLIcount, long long TageIMHIST[],
-		long long TageL_shist[], long long TageS_slhist[], long long TageT_slhist[],
-	       	folded_history TageCh_i[], folded_history TageCh_t0[], folded_history TageCh_t1[])
-		{
-	//Reverting State
-	phist = TagePhist;
-	ptghist = TagePTGhist;
-	GHIST = TageGHIST;
-	IMLIcount = TageIMLIcount;
-	for (int i = 0; i < 4096; i++)
-		ghist[i] = TageHist[i];
-#ifdef IMLI
-	for (int i = 0; i < 256; i++)
-		IMHIST[i] = TageIMHIST[i];
-#endif
-#ifdef SC
-	for (int i = 0; i < NLOCAL; i++)
-		L_shist[i] = TageL_shist[i];
-	for (int i = 0; i < NSECLOCAL; i++)
-		S_slhist[i] = TageS_slhist[i];
-	for (int i = 0; i < NTLOCAL; i++)
-		T_slhist[i] = TageT_slhist[i];
-#endif
-	for (int i = 1; i < 37; i++){
-	       	ch_i[i] = TageCh_i[i]; 
-		ch_t[0][i] = TageCh_t0[i];
-		ch_t[1][i] = TageCh_t1[i];
-	}
-
-		}
-
-
-void tagescl_t::MyHistoryUpdate(UINT64 PC, OpType opType, bool taken,
-UINT64 target, long long &X, int &Y,
-		uint8_t MyHist[],
-		long long &MyGHIST, long long &MyIMLIcount, long long MyIMHIST[],
-		long long MyL_shist[], long long MyS_slhist[], long long MyT_slhist[],
-		folded_history MyCh_i[], folded_history MyCh_t0[], folded_history MyCh_t1[])
-		{
-
-	int brtype = 0;
-
-	switch (opType)
-	{
-		case OPTYPE_RET_UNCOND:
-			case OPTYPE_JMP_INDIRECT_UNCOND:
-			case OPTYPE_JMP_INDIRECT_COND:
-			case OPTYPE_CALL_INDIRECT_UNCOND:
-			case OPTYPE_CALL_INDIRECT_COND:
-			case OPTYPE_RET_COND:
-			brtype = 2;
-			break;
-		case OPTYPE_JMP_DIRECT_COND:
-			case OPTYPE_CALL_DIRECT_COND:
-			case OPTYPE_JMP_DIRECT_UNCOND:
-			case OPTYPE_CALL_DIRECT_UNCOND:
-			brtype = 0;
-			break;
-		default:
-			exit(1);
-	}
-	switch (opType)
-	{
-		case OPTYPE_JMP_DIRECT_COND:
-			case OPTYPE_CALL_DIRECT_COND:
-			case OPTYPE_JMP_INDIRECT_COND:
-			case OPTYPE_CALL_INDIRECT_COND:
-			case OPTYPE_RET_COND:
-			brtype += 1;
-			break;
-
-		default:
-			exit(1);
-	}
-
-//special treatment for indirect  branchs;
-	int maxt = 2;
-	if (brtype & 1)
-		maxt = 2;
-	else if ((brtype & 2))
-		maxt = 3;
-
-#ifdef IMLI
-	if (brtype & 1)
-			{
-#ifdef IMLI
-		MyIMHIST[MyIMLIcount] = (MyIMHIST[MyIMLIcount] << 1) + taken;
-#endif
-		if (target < PC)
-
-		{
-//This branch corresponds to a loop
-			if (!taken)
-			{
-//exit of the "loop"
-				MyIMLIcount = 0;
-
-			}
-			if (taken)
-			{
-
-				if (MyIMLIcount < ((1 << Im[0]) - 1))
-					MyIMLIcount++;
-			}
-		}
-	}
-
-#endif
-
-	if (brtype & 1)
-			{
-		MyGHIST = (MyGHIST << 1) + (taken & (target < PC));
-		MyL_shist[INDLOCAL] = (MyL_shist[INDLOCAL] << 1) + (taken);
-		MyS_slhist[INDSLOCAL] =
-				((MyS_slhist[INDSLOCAL] << 1) + taken) ^ (PC & 15);
-		MyT_slhist[INDTLOCAL] = (MyT_slhist[INDTLOCAL] << 1) + taken;
-	}
-
-	int T = ((PC ^ (PC >> 2))) ^ taken;
-	int PATH = PC ^ (PC >> 2) ^ (PC >> 4);
-	if ((brtype == 3) & taken)
-			{
-		T = (T ^ (target >> 2));
-		PATH = PATH ^ (target >> 2) ^ (target >> 4);
-	}
-
-	for (int t = 0; t < maxt; t++)
-			{
-		bool DIR = (T & 1);
-		T >>= 1;
-		int PATHBIT = (PATH & 127);
-		PATH >>= 1;
-//update  history
-		Y--;
-		MyHist[Y & (HISTBUFFERLENGTH - 1)] = DIR;
-		X = (X << 1) ^ PATHBIT;
-
-		for (int i = 1; i <= NHIST; i++)
-				{
-
-			MyCh_i[i].update(MyHist, Y);
-			MyCh_t0[i].update(MyHist, Y);
-			MyCh_t1[i].update(MyHist, Y);
-
-		}
-	}
-
-	X = (X & ((1 << PHISTWIDTH) - 1));
-	
-}
-
 void tagescl_t::getPredictionContext(int &TageBimIndex, int &TageBimPred, int TageIndex[], uint TageTag[],
 		bool &TagePredTaken, bool &TagePred, bool &TageAltPred, bool &TageAltConf, bool &TageLongestMatchPred,
 		int &TageHitBank, int &TageAltBank, int &TageSeed,
@@ -40,7 +40,7 @@ using namespace std;
 #endif
 
 #define CONFWIDTH 7		//for the counters in the choser
-#define HISTBUFFERLENGTH 4096	// we use a 4K entries history buffer to store the branch history (this allows us to explore using history length up to 4K)
+#define HISTBUFFERLENGTH 8192	// we use an 8K entries history buffer to store the branch history (MAXHIST, plus the speculative history of all in-flight branches)
 
 #define BORNTICK  1024
 //To get the predictor storage budget on stderr  uncomment the next line
@@ -284,6 +284,29 @@ public:
 	}
 
 };
+
+// Undo record for one speculative history update (tagescl_t::HistoryUpdate() of a conditional branch).
+// It holds the global history pointer, scalars and folded histories prior to the update, so that restoring the history
+// to just before the update is a copy. It also holds the one entry of each local history table, and of the IMLI history
+// table, that the update modifies: these are undone record by record (youngest first).
+// The global history bits don't need to be saved: they stay in the circular ghist buffer.
+class tage_hist_undo_t {
+public:
+	int ptghist;
+	unsigned ch_i[NHIST + 1];	// folded_history::comp of ch_i[]
+	unsigned ch_t[2][NHIST + 1];	// folded_history::comp of ch_t[][]
+	long long phist;
+	long long GHIST;
+	long long IMLIcount;
+	long long IMHIST;		// IMHIST[IMLIcount]
+	int L_index;
+	long long L_shist;		// L_shist[L_index]
+	int S_index;
+	long long S_slhist;		// S_slhist[S_index]
+	int T_index;
+	long long T_slhist;		// T_slhist[T_index]
+};
+
 class tagescl_t {
 public:
 	int8_t Bias[(1 << LOGBIAS)];
@@ -514,31 +537,15 @@ public:
 			long long TageIMHIST[], long long TageL_shist[],
 			long long TageS_slhist[], long long TageT_slhist[],
 			folded_history TageCh_i[], folded_history TageCh_t0[], folded_history TageCh_t1[]);
-	void getTageHist(long long &TagePhist,
-			int &TagePTGhist, uint8_t TageHist[],
-			long long &TageGHIST, long long &TageIMLIcount,
-			long long TageIMHIST[], long long TageL_shist[],
-			long long TageS_slhist[], long long TageT_slhist[],
-			folded_history TageCh_i[], folded_history TageCh_t0[], folded_history TageCh_t1[], int& TageSeed);
 	void Tagepred(UINT64 PC);
 	bool getPrediction(UINT64 PC);
 	void printState();
 	void HistoryUpdate(UINT64 PC, OpType opType, bool taken,
 	UINT64 target, long long &X, int &Y, folded_history * H, folded_history * G,
 			folded_history * J);
-	void HistoryRevertAndUpdate(UINT64 PC, OpType opType, bool taken,
-	UINT64 target, long long TagePhist, int TagePTGhist,
-			uint8_t TageHist[], long long TageGHIST,
-			long long TageIMLIcount, long long TageIMHIST[],
-			long long TageL_shist[], long long TageS_slhist[],
-			long long TageT_slhist[],
-			folded_history TageCh_i[], folded_history TageCh_t0[], folded_history TageCh_t1[]);
-	void HistoryRevert( long long TagePhist, int TagePTGhist,
-			uint8_t TageHist[], long long TageGHIST,
-			long long TageIMLIcount, long long TageIMHIST[],
-			long long TageL_shist[], long long TageS_slhist[],
-			long long TageT_slhist[],
-			folded_history TageCh_i[], folded_history TageCh_t0[], folded_history TageCh_t1[]);
+	void getHistUndo(UINT64 PC, tage_hist_undo_t &undo);
+	void HistoryUndo(const tage_hist_undo_t &undo);
+	void HistoryRestore(const tage_hist_undo_t &undo);
 	void UpdatePredictor(UINT64 PC, OpType opType, bool resolveDir,
 			bool predDir, UINT64 branchTarget);
 	void UpdatePredictorMicro(UINT64 PC, OpType opType, bool resolveDir,
@@ -551,8 +558,8 @@ public:
 			int TageLHIT, int TageLTAG, bool TageLVALID, bool TagePredInter,
 			int TageLSUM, bool TageHighConf, bool TageMedConf, bool TageLowConf,
 			long long TageGHIST, int TageTHRES, long long TageIMLIcount,
-			long long TageIMHIST[], long long TageL_shist[],
-			long long TageS_slhist[], long long TageT_slhist[]);
+			long long TageIMHIST, long long TageL_shist,
+			long long TageS_slhist, long long TageT_slhist);
 	int Gpredict(UINT64 PC, long long BHIST, int *length, int8_t ** tab,
 			int NBR, int logs, int8_t * W);
 	void Gupdate(UINT64 PC, bool taken, long long BHIST, int *length,
@@ -561,12 +568,6 @@ public:
 	UINT64 branchTarget);
 	void SpecHistoryUpdate(UINT64 PC, OpType opType, bool taken,
 	UINT64 branchTarget);
-	void MyHistoryUpdate(UINT64 PC, OpType opType, bool taken,
-			UINT64 target, long long &X, int &Y,
-			uint8_t MyTageHist[],
-			long long &MyTageGHIST, long long &MyTageIMLIcount, long long MyTageIMHIST[],
-			long long MyTageL_shist[], long long MyTageS_slhist[], long long MyTageT_slhist[],
-			folded_history TageCh_i[], folded_history TageCh_t0[], folded_history TageCh_t1[]);
 
 #ifdef LOOPPREDICTOR
 	int lindex(UINT64 PC);
@@ -8,17 +8,55 @@
 #include "config.h"
 
 #include "fetchunit_types.h"
+#include "btb.h"
 #include "tc.h"
 
 
-tc_t::tc_t(bool perfect, mmu_t *mmu, uint64_t max_cb, uint64_t max_length) {
+tc_t::tc_t(bool perfect, mmu_t *mmu, uint64_t width, uint64_t max_cb, uint64_t max_length, uint64_t sets, uint64_t assoc, bool partial) {
    this->perfect = perfect;
    this->mmu = mmu;
+   this->width = width;
    this->max_cb = max_cb;
    this->max_length = max_length;
+   this->sets = sets;
+   this->assoc = assoc;
+   this->partial = partial;
+
+   assert((max_length > 0) && (max_length <= width));
+   assert((max_cb > 0) && (max_cb <= 64));
+
+   lines = NULL;
+   slots = NULL;
+   fill_slots = NULL;
+   if (!perfect) {
+      assert(IsPow2(sets) && (assoc > 0));
+      lines = new tc_line_t[sets * assoc];
+      slots = new tc_slot_t[sets * assoc * max_length];
+      for (uint64_t i = 0; i < (sets * assoc); i++) {
+         lines[i].valid = false;
+         lines[i].lru = 0;
+      }
+      fill_slots = new tc_slot_t[max_length];
+   }
+   time = 0;
+
+   fill_line.valid = true;
+   fill_line.length = 0;
+   fill_line.num_cb = 0;
+   fill_line.cb_dirs = 0;
+   fill_next_pc = 0;
+
+   meas_lookup = 0;
+   meas_hit = 0;
+   meas_partial = 0;
+   meas_insn = 0;
+   meas_fill = 0;
 }
 
 tc_t::~tc_t() {
+   delete [] lines;
+   delete [] slots;
+   delete [] fill_slots;
 }
 
 // Inputs:
@@ -39,15 +77,142 @@ tc_t::~tc_t() {
 //    - How many conditional branches are in the assembled fetch bundle, to know how many predictions to shift into its BHRs.
 //    - Whether or not it needs to pop the RAS.
 //    - Whether or not it needs to push the RAS, and, if so, which pc to push onto the RAS.
+//
+// Returns true if the trace cache hit (always, if perfect), false if it missed.
 bool tc_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_target, uint64_t ras_predicted_target, fetch_bundle_t bundle[], spec_update_t *update) {
+   tc_line_t *line;
+   tc_line_t *best;
+   tc_slot_t *slot;
+   uint64_t best_length;
+   bool best_full;
+   uint64_t length;
+   uint64_t cb;
+   uint64_t pos;
+   bool taken;
+
+   if (perfect)
+      return(lookup_perfect(pc, cb_predictions, ib_predicted_target, ras_predicted_target, bundle, update));
+
+   meas_lookup++;
+
+   // Search the set for the traces that start at 'pc'. Select the one whose embedded conditional branches all match
+   // the predictions (hit), otherwise the one that supplies the most instructions before a mismatch (partial hit).
+   line = &lines[((pc >> 2) & (sets - 1)) * assoc];
+   best = NULL;
+   best_length = 0;
+   best_full = false;
+   for (uint64_t way = 0; (way < assoc) && !best_full; way++, line++) {
+      if (!line->valid || (line->pc != pc))
+         continue;
+
+      // The trace is cut at its first conditional branch predicted the other way, if any: that branch ends the fetch bundle.
+      length = line->length;
+      slot = &slots[(line - lines) * max_length];
+      for (pos = 0, cb = 0; pos < (line->length - 1); pos++) {
+         if (slot[pos].branch && (slot[pos].branch_type == BTB_BRANCH)) {
+            if (((line->cb_dirs >> cb) & 1) != ((cb_predictions >> cb) & 1)) {
+               length = (pos + 1);
+               break;
+            }
+            cb++;
+         }
+      }
+
+      if ((length == line->length) || (length > best_length)) {
+         best = line;
+         best_length = length;
+         best_full = (length == line->length);
+      }
+   }
+
+   if (!best || (!best_full && !partial))
+      return(false);
+
+   best->lru = ++time;
+   if (best_full)
+      meas_hit++;
+   else
+      meas_partial++;
+   meas_insn += best_length;
+
+   // Supply the fetch bundle from the trace. Within the trace, an instruction's next_pc is the pc of the next one.
+   // The last instruction's next_pc is predicted, as in lookup_perfect().
+   update->pop_ras = false;
+   update->push_ras = false;
+   update->num_cb = 0;
+   slot = &slots[(best - lines) * max_length];
+   for (pos = 0; pos < best_length; pos++) {
+      bundle[pos].valid = true;
+      bundle[pos].pc = slot[pos].pc;
+      bundle[pos].insn = slot[pos].insn;
+      bundle[pos].exception = false;
+      bundle[pos].branch = slot[pos].branch;
+      bundle[pos].branch_type = slot[pos].branch_type;
+      bundle[pos].branch_target = slot[pos].branch_target;
+      if (slot[pos].branch && (slot[pos].branch_type == BTB_BRANCH))
+         update->num_cb++;
+
+      if (pos < (best_length - 1)) {
+         bundle[pos].next_pc = slot[pos + 1].pc;
+      }
+      else if (!slot[pos].branch) {
+         bundle[pos].next_pc = INCREMENT_PC(slot[pos].pc);
+      }
+      else {
+         switch (slot[pos].branch_type) {
+            case BTB_BRANCH:
+               taken = (((cb_predictions >> (update->num_cb - 1)) & 1) == 1);
+               bundle[pos].next_pc = (taken ? slot[pos].branch_target : INCREMENT_PC(slot[pos].pc));
+               break;
+
+            case BTB_JUMP_DIRECT:
+               bundle[pos].next_pc = slot[pos].branch_target;
+               break;
+
+            case BTB_CALL_DIRECT:
+               bundle[pos].next_pc = slot[pos].branch_target;
+               update->push_ras = true;
+               update->push_ras_pc = INCREMENT_PC(slot[pos].pc);
+               break;
+
+            case BTB_RETURN:
+               bundle[pos].next_pc = ras_predicted_target;
+               update->pop_ras = true;
+               break;
+
+            case BTB_CALL_INDIRECT:
+               bundle[pos].next_pc = ib_predicted_target;
+               update->push_ras = true;
+               update->push_ras_pc = INCREMENT_PC(slot[pos].pc);
+               break;
+
+            case BTB_JUMP_INDIRECT:
+               bundle[pos].next_pc = ib_predicted_target;
+               break;
+
+            default:
+               assert(0);
+               break;
+         }
+      }
+   }
+   update->next_pc = bundle[best_length - 1].next_pc;
+
+   // Mark any residual slots in the fetch bundle as invalid (no instructions in those slots).
+   for (pos = best_length; pos < width; pos++)
+      bundle[pos].valid = false;
+
+   return(true);
+}
+
+// Perfect trace cache: assemble the trace from memory, following the predictions.
+bool tc_t::lookup_perfect(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_target, uint64_t ras_predicted_target, fetch_bundle_t bundle[], spec_update_t *update) {
    insn_t insn;
    bool taken;
    uint64_t pos = 0;
    uint64_t num_cond_branch = 0;
    bool terminated = false;
 
-   assert(perfect);	// FIX_ME: add a real trace cache, too.
-
    // Initialize these two fields in the "update" variable (which is needed by the Fetch Unit to speculatively update its predictors and pc).
    // Initially assume the fetch bundle doesn't end in a call (push_ras) or return (pop_ras) instruction, and set to true if and when we determine that it does.
    update->pop_ras = false;
@@ -212,10 +377,119 @@ bool tc_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_ta
    update->num_cb = num_cond_branch;
 
    // Mark any residual slots in the fetch bundle as invalid (no instructions in those slots).
-   while (pos < max_length) {
+   while (pos < width) {
       bundle[pos].valid = false;
       pos++;
    }
 
    return(true);	// Perfect trace cache always hits.  The fetch bundle has at least one instruction.
 }
+
+// Fill unit.
+// Retired instructions are assembled into a trace until the trace selection policy ends it (see lookup_perfect()),
+// or at a serializing instruction (amo, csr), after which fetch restarts anyway. The trace is then written into the
+// trace cache, and the next retired instruction starts a new trace. A trace only holds a run of instructions that
+// flowed into each other: it is discarded at an exception or other change of control by a non-branch.
+void tc_t::fill(uint64_t pc, insn_t insn, uint64_t next_pc) {
+   tc_slot_t *slot;
+   bool terminated;
+
+   if (perfect)
+      return;
+
+   if ((fill_line.length > 0) && (pc != fill_next_pc)) {
+      fill_line.length = 0;
+      fill_line.num_cb = 0;
+      fill_line.cb_dirs = 0;
+   }
+   if (fill_line.length == 0)
+      fill_line.pc = pc;
+
+   slot = &fill_slots[fill_line.length];
+   fill_line.length++;
+   slot->pc = pc;
+   slot->insn = insn;
+   slot->branch = false;
+   terminated = (fill_line.length == max_length);
+
+   switch (insn.opcode()) {
+      case OP_BRANCH:
+      case OP_JAL:
+      case OP_JALR:
+         slot->branch = true;
+         slot->branch_type = btb_t::decode(insn, pc, slot->branch_target);
+         if (slot->branch_type == BTB_BRANCH) {
+            if (next_pc != INCREMENT_PC(pc))
+               fill_line.cb_dirs |= (((uint64_t)1) << fill_line.num_cb);
+            fill_line.num_cb++;
+            terminated = (terminated || (fill_line.num_cb == max_cb));
+         }
+         else if (slot->branch_type != BTB_JUMP_DIRECT) {
+            terminated = true;
+         }
+         break;
+
+      case OP_AMO:
+      case OP_SYSTEM:
+         terminated = true;
+         break;
+
+      default:
+         if (next_pc != INCREMENT_PC(pc)) {
+            fill_line.length = 0;
+            fill_line.num_cb = 0;
+            fill_line.cb_dirs = 0;
+            return;
+         }
+         break;
+   }
+
+   fill_next_pc = next_pc;
+
+   if (terminated) {
+      // A conditional branch that ends the trace is not embedded.
+      if (slot->branch && (slot->branch_type == BTB_BRANCH))
+         fill_line.cb_dirs &= ~(((uint64_t)1) << (fill_line.num_cb - 1));
+
+      fill_line_write();
+
+      fill_line.length = 0;
+      fill_line.num_cb = 0;
+      fill_line.cb_dirs = 0;
+   }
+}
+
+// Write the fill unit's trace into the trace cache, unless it is already there. Replace an invalid line or else the LRU line.
+void tc_t::fill_line_write() {
+   tc_line_t *line = &lines[((fill_line.pc >> 2) & (sets - 1)) * assoc];
+   tc_line_t *victim = line;
+
+   for (uint64_t way = 0; way < assoc; way++, line++) {
+      if (line->valid && (line->pc == fill_line.pc) && (line->length == fill_line.length) &&
+          (line->num_cb == fill_line.num_cb) && (line->cb_dirs == fill_line.cb_dirs))
+         return;
+      if (victim->valid && (!line->valid || (line->lru < victim->lru)))
+         victim = line;
+   }
+
+   *victim = fill_line;
+   victim->lru = ++time;
+   for (uint64_t pos = 0; pos < fill_line.length; pos++)
+      slots[((victim - lines) * max_length) + pos] = fill_slots[pos];
+   meas_fill++;
+}
+
+void tc_t::dump_stats(FILE *fp) {
+   if (perfect)
+      return;
+
+   fprintf(fp, "TRACE CACHE MEASUREMENTS---------------------------\n");
+   fprintf(fp, "Configuration: %lu sets, %lu ways, max. %lu instructions and %lu conditional branches per trace, partial hits %s\n",
+           sets, assoc, max_length, max_cb, (partial ? "enabled" : "disabled"));
+   fprintf(fp, "Lookups       = %lu\n", meas_lookup);
+   fprintf(fp, "Hits          = %lu (%.2f%%)\n", meas_hit, (meas_lookup ? (100.0*((double)meas_hit/(double)meas_lookup)) : 0.0));
+   fprintf(fp, "Partial hits  = %lu (%.2f%%)\n", meas_partial, (meas_lookup ? (100.0*((double)meas_partial/(double)meas_lookup)) : 0.0));
+   fprintf(fp, "Misses        = %lu (%.2f%%)\n", (meas_lookup - meas_hit - meas_partial), (meas_lookup ? (100.0*((double)(meas_lookup - meas_hit - meas_partial)/(double)meas_lookup)) : 0.0));
+   fprintf(fp, "Instructions supplied = %lu (%.2f per hit or partial hit)\n", meas_insn, ((meas_hit + meas_partial) ? ((double)meas_insn/(double)(meas_hit + meas_partial)) : 0.0));
+   fprintf(fp, "Traces filled = %lu\n", meas_fill);
+}
@@ -1,18 +1,76 @@
 
+// A trace cache line: a trace of up to "n" instructions starting at 'pc', with up to "m" conditional branches.
+typedef
+struct {
+	bool valid;
+	uint64_t pc;		// Start pc of the trace (tag).
+	uint64_t length;	// Number of instructions.
+	uint64_t num_cb;	// Number of conditional branches.
+	uint64_t cb_dirs;	// Taken/not-taken outcomes of the embedded conditional branches, packed like cb_predictions.
+				// A conditional branch that ends the trace is not embedded: it is predicted, like the branch ending a fetch bundle.
+	uint64_t lru;		// Time of last use.
+} tc_line_t;
+
+// An instruction in a trace cache line, with its branch information.
+typedef
+struct {
+	uint64_t pc;
+	insn_t insn;
+	bool branch;
+	btb_branch_type_e branch_type;
+	uint64_t branch_target;	// Taken target (not valid for indirect branches).
+} tc_slot_t;
+
+
 class tc_t {
 private:
 	// Perfect vs. real trace cache.
 	bool perfect;
 	mmu_t *mmu;	// need to reference the mmu if modeling a perfect trace cache
 
+	// Number of slots in the fetch bundle.
+	uint64_t width;
+
 	// "m": maximum number of conditional branches in a trace.
 	uint64_t max_cb;
 
         // "n": maximum number of instructions in a trace.
         uint64_t max_length;
 
+	// Real trace cache: 'sets' x 'assoc' lines, indexed by start pc.
+	// Path associativity: the lines of a set may hold different traces (paths) from the same start pc.
+	// The line whose embedded conditional branches match the predictions is a hit.
+	// If 'partial', a line whose embedded branches match only a prefix of the predictions is a partial hit:
+	// it supplies the instructions up to the first mismatching branch.
+	uint64_t sets;
+	uint64_t assoc;
+	bool partial;
+	tc_line_t *lines;	// [sets * assoc]
+	tc_slot_t *slots;	// [sets * assoc * max_length]
+	uint64_t time;
+
+	// Fill unit: the trace being assembled from retired instructions, with the same trace selection policy as lookup().
+	tc_line_t fill_line;
+	tc_slot_t *fill_slots;	// [max_length]
+	uint64_t fill_next_pc;	// pc of the instruction that follows the trace so far
+
+	// Measurements.
+	uint64_t meas_lookup;
+	uint64_t meas_hit;
+	uint64_t meas_partial;
+	uint64_t meas_insn;	// instructions supplied by hits and partial hits
+	uint64_t meas_fill;	// new traces written into the trace cache
+
+	bool lookup_perfect(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_target, uint64_t ras_predicted_target, fetch_bundle_t bundle[], spec_update_t *update);
+	void fill_line_write();
+
 public:
-	tc_t(bool perfect, mmu_t *mmu, uint64_t max_cb, uint64_t max_length);
+	tc_t(bool perfect, mmu_t *mmu, uint64_t width, uint64_t max_cb, uint64_t max_length, uint64_t sets, uint64_t assoc, bool partial);
 	~tc_t();
 	bool lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_target, uint64_t ras_predicted_target, fetch_bundle_t bundle[], spec_update_t *update);
+
+	// Fill unit: the instruction at 'pc' retired and 'next_pc' followed it.
+	void fill(uint64_t pc, insn_t insn, uint64_t next_pc);
+
+	void dump_stats(FILE *fp);
 };
@@ -0,0 +1,82 @@
+#include <cinttypes>
+#include <cassert>
+#include "decode.h"
+#include "fu.h"
+#include "payload.h"
+#include "uop_cache.h"
+
+uop_cache_t::uop_cache_t(uint64_t size) {
+	assert((size > 0) && ((size & (size - 1)) == 0));
+	this->size = size;
+	table = new uop_cache_entry_t[size];
+	flush();
+}
+
+uop_cache_t::~uop_cache_t() {
+	delete [] table;
+}
+
+bool uop_cache_t::lookup(payload_t& pay) {
+	uop_cache_entry_t* e = &table[index(pay.pc)];
+
+	if (!e->valid || (e->pc != pay.pc) || (e->inst.bits() != pay.inst.bits()))
+		return(false);
+
+	pay.flags       = e->uop.flags;
+	pay.fu          = e->uop.fu;
+	pay.checkpoint  = e->uop.checkpoint;
+	pay.split       = e->uop.split;
+	pay.split_store = e->uop.split_store;
+	pay.A_valid     = e->uop.A_valid;
+	pay.A_log_reg   = e->uop.A_log_reg;
+	pay.B_valid     = e->uop.B_valid;
+	pay.B_log_reg   = e->uop.B_log_reg;
+	pay.C_valid     = e->uop.C_valid;
+	pay.C_log_reg   = e->uop.C_log_reg;
+	pay.D_valid     = e->uop.D_valid;
+	pay.D_log_reg   = e->uop.D_log_reg;
+	pay.iq          = e->uop.iq;
+	pay.CSR_addr    = e->uop.CSR_addr;
+	pay.size        = e->uop.size;
+	pay.is_signed   = e->uop.is_signed;
+	pay.left        = e->uop.left;
+	pay.right       = e->uop.right;
+	pay.alu_op_fn   = e->uop.alu_op_fn;
+	return(true);
+}
+
+void uop_cache_t::fill(const payload_t& pay) {
+	uop_cache_entry_t* e = &table[index(pay.pc)];
+
+	assert(!pay.split);
+
+	e->valid = true;
+	e->pc = pay.pc;
+	e->inst = pay.inst;
+
+	e->uop.flags       = pay.flags;
+	e->uop.fu          = pay.fu;
+	e->uop.checkpoint  = pay.checkpoint;
+	e->uop.split       = pay.split;
+	e->uop.split_store = pay.split_store;
+	e->uop.A_valid     = pay.A_valid;
+	e->uop.A_log_reg   = pay.A_log_reg;
+	e->uop.B_valid     = pay.B_valid;
+	e->uop.B_log_reg   = pay.B_log_reg;
+	e->uop.C_valid     = pay.C_valid;
+	e->uop.C_log_reg   = pay.C_log_reg;
+	e->uop.D_valid     = pay.D_valid;
+	e->uop.D_log_reg   = pay.D_log_reg;
+	e->uop.iq          = pay.iq;
+	e->uop.CSR_addr    = pay.CSR_addr;
+	e->uop.size        = pay.size;
+	e->uop.is_signed   = pay.is_signed;
+	e->uop.left        = pay.left;
+	e->uop.right       = pay.right;
+	e->uop.alu_op_fn   = pay.alu_op_fn;
+}
+
+void uop_cache_t::flush() {
+	for (uint64_t i = 0; i < size; i++)
+		table[i].valid = false;
+}
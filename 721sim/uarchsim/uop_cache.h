@@ -0,0 +1,59 @@
+#ifndef UOP_CACHE_H
+#define UOP_CACHE_H
+
+// The static fields that the Decode Stage derives from an instruction's bits.
+// These are the same every time the instruction is decoded, so they are decoded once and cached.
+typedef struct {
+	unsigned int flags;
+	fu_type fu;
+	bool checkpoint;
+	bool split;
+	bool split_store;
+	bool A_valid;
+	unsigned int A_log_reg;
+	bool B_valid;
+	unsigned int B_log_reg;
+	bool C_valid;
+	unsigned int C_log_reg;
+	bool D_valid;
+	unsigned int D_log_reg;
+	sel_iq iq;
+	uint64_t CSR_addr;
+	unsigned int size;
+	bool is_signed;
+	bool left;
+	bool right;
+	alu_op_func_t alu_op_fn;
+} decoded_uop_t;
+
+typedef struct {
+	bool valid;
+	reg_t pc;		// tag: PC of the instruction
+	insn_t inst;		// tag: bits of the instruction (a hit requires both to match)
+	decoded_uop_t uop;
+} uop_cache_entry_t;
+
+// Direct-mapped, PC-indexed cache of decoded instructions.
+// Only instructions that decode into a single micro-op without an exception are cached.
+class uop_cache_t {
+private:
+	uop_cache_entry_t* table;
+	uint64_t size;		// number of entries (power of two)
+
+	uint64_t index(reg_t pc) { return((pc >> 2) & (size - 1)); }
+
+public:
+	uop_cache_t(uint64_t size);
+	~uop_cache_t();
+
+	// On a hit, copy the decoded instruction into its payload and return true.
+	bool lookup(payload_t& pay);
+
+	// Cache the decoded instruction in 'pay'.
+	void fill(const payload_t& pay);
+
+	// Invalidate all entries, e.g., when the instruction memory changes (FENCE.I) or its mapping changes.
+	void flush();
+};
+
+#endif //UOP_CACHE_H
@@ -0,0 +1,357 @@
+#include <stdlib.h>
+#include <cinttypes>
+
+#include "pipeline.h"
+
+
+value_predictor::value_predictor(unsigned int vpq_size, unsigned int num_phys_regs, VPinterface_t* engine) {
+   assert(vpq_size > 0);
+   assert(engine);
+
+   this->engine = engine;
+
+   // Prediction filters initialization.
+   crit = (VP_CRIT_FILTER ? new unsigned int[1 << VP_CRIT_INDEX_BITS]() : NULL);
+   consumer = (VP_CONSUMER_FILTER ? new unsigned int[1 << VP_CONSUMER_INDEX_BITS]() : NULL);
+   this->num_phys_regs = num_phys_regs;
+   pred_pending = (VP_CONSUMER_FILTER ? new bool[num_phys_regs]() : NULL);
+   consumer_waited = (VP_CONSUMER_FILTER ? new bool[num_phys_regs]() : NULL);
+
+   // VPQ initialization.
+   this->vpq_size = vpq_size;
+   vpq_head = 0;
+   vpq_head_phase = false;
+   vpq_tail = 0;
+   vpq_tail_phase = false;
+   vpq_length = 0;
+
+   VPQ = new vpq_entry[vpq_size];
+
+   // STATS
+   n_ineligible = 0;
+   n_eligible = 0;
+   n_miss = 0;
+   n_not_confident = 0;
+   n_filtered_correct = 0;
+   n_filtered_incorrect = 0;
+   n_conf_correct = 0;
+   n_conf_incorrect = 0;
+   for (unsigned int i = 0; i < 2; i++) {
+      n_load_probed[i] = 0;
+      n_load_probed_conf_correct[i] = 0;
+      n_load_probed_conf_incorrect[i] = 0;
+   }
+   n_rollback = 0;
+   n_replay = 0;
+   n_replayed = 0;
+}
+
+value_predictor::~value_predictor() {
+   delete engine;
+   delete [] VPQ;
+   delete [] crit;
+   delete [] consumer;
+   delete [] pred_pending;
+   delete [] consumer_waited;
+}
+
+bool value_predictor::stall(unsigned int bundle_vp) {
+   return((vpq_length + bundle_vp) > vpq_size);
+}
+
+bool value_predictor::predict(uint64_t pc, unsigned int& vpq_index, uint64_t& pred_value, bool& confident) {
+   // Assert that the VPQ isn't full.
+   assert(vpq_length < vpq_size);
+
+   // Allocate entry in the VPQ.
+   vpq_index = vpq_tail;
+   VPQ[vpq_tail].pc = pc;
+   VPQ[vpq_tail].value_avail = false;
+
+   // Advance VPQ tail pointer and increment VPQ length.
+   vpq_tail = MOD_S((vpq_tail + 1), vpq_size);
+   vpq_length++;
+
+   // Detect wrap-around of vpq_tail and toggle its phase bit accordingly.
+   if (vpq_tail == 0) {
+      vpq_tail_phase = !vpq_tail_phase;
+   }
+
+   return(engine->predict(pc, vpq_index, pred_value, confident));
+}
+
+void value_predictor::branch(uint64_t pc, bool taken) {
+   engine->spec_update_branch(pc, taken);
+}
+
+bool value_predictor::filter(uint64_t pc) {
+   if (VP_CRIT_FILTER && (crit[(pc >> 2) & ((1 << VP_CRIT_INDEX_BITS) - 1)] < VP_CRIT_THRESHOLD))
+      return(false);
+   if (VP_CONSUMER_FILTER && (consumer[(pc >> 2) & ((1 << VP_CONSUMER_INDEX_BITS) - 1)] < VP_CONSUMER_THRESHOLD))
+      return(false);
+   return(true);
+}
+
+void value_predictor::dispatch_producer(unsigned int phys_reg, bool predicted) {
+   if (VP_CONSUMER_FILTER) {
+      assert(phys_reg < num_phys_regs);
+      pred_pending[phys_reg] = predicted;
+      consumer_waited[phys_reg] = false;
+   }
+}
+
+// A consumer of a predicted register doesn't wait, but it would have without the prediction.
+// Counting it keeps the filter from turning off the very predictions that make consumers stop waiting.
+void value_predictor::dispatch_consumer(unsigned int phys_reg, bool ready) {
+   if (VP_CONSUMER_FILTER) {
+      assert(phys_reg < num_phys_regs);
+      if (!ready || pred_pending[phys_reg])
+         consumer_waited[phys_reg] = true;
+   }
+}
+
+void value_predictor::head_stall(uint64_t pc, uint64_t num_cycles) {
+   unsigned int* c;
+
+   if (VP_CRIT_FILTER) {
+      c = &crit[(pc >> 2) & ((1 << VP_CRIT_INDEX_BITS) - 1)];
+      *c = (((uint64_t)*c + num_cycles) > VP_CRIT_MAX) ? VP_CRIT_MAX : (*c + (unsigned int)num_cycles);
+   }
+}
+
+void value_predictor::train_filters(uint64_t pc, bool stalled_head, unsigned int phys_reg) {
+   unsigned int* c;
+
+   if (VP_CRIT_FILTER && !stalled_head) {
+      c = &crit[(pc >> 2) & ((1 << VP_CRIT_INDEX_BITS) - 1)];
+      if (*c > 0)
+         (*c)--;
+   }
+
+   if (VP_CONSUMER_FILTER) {
+      assert(phys_reg < num_phys_regs);
+      c = &consumer[(pc >> 2) & ((1 << VP_CONSUMER_INDEX_BITS) - 1)];
+      if (consumer_waited[phys_reg]) {
+         if (*c < VP_CONSUMER_MAX)
+            (*c)++;
+      }
+      else if (*c > 0) {
+         (*c)--;
+      }
+   }
+}
+
+void value_predictor::deposit(unsigned int vpq_index, uint64_t value, unsigned int phys_reg) {
+   assert(vpq_index < vpq_size);
+   VPQ[vpq_index].value_avail = true;
+   VPQ[vpq_index].value = value;
+
+   // The computed value is available now.
+   if (VP_CONSUMER_FILTER) {
+      assert(phys_reg < num_phys_regs);
+      pred_pending[phys_reg] = false;
+   }
+}
+
+void value_predictor::train(unsigned int vpq_index) {
+   // VPQ should not be empty, and eligible instructions retire in program order.
+   assert(vpq_length > 0);
+   assert(vpq_index == vpq_head);
+   assert(VPQ[vpq_head].value_avail);
+
+   // Advance the head pointer and decrement the queue length.
+   vpq_head = MOD_S((vpq_head + 1), vpq_size);
+   vpq_length--;
+
+   // Detect wrap-around of vpq_head and toggle its phase bit accordingly.
+   if (vpq_head == 0) {
+      vpq_head_phase = !vpq_head_phase;
+   }
+
+   engine->train(vpq_index, VPQ[vpq_index].pc, VPQ[vpq_index].value);
+}
+
+void value_predictor::commit_branch(uint64_t pc, bool taken) {
+   engine->commit_branch(pc, taken);
+}
+
+void value_predictor::warm(uint64_t pc, uint64_t value) {
+   unsigned int vpq_index;
+   uint64_t pred_value;
+   bool confident;
+
+   // The VPQ is empty between the detailed phases, so the instance is trained right away.
+   predict(pc, vpq_index, pred_value, confident);
+   VPQ[vpq_index].value_avail = true;
+   VPQ[vpq_index].value = value;
+   train(vpq_index);
+}
+
+void value_predictor::warm_branch(uint64_t pc, bool taken) {
+   branch(pc, taken);
+   commit_branch(pc, taken);
+}
+
+void value_predictor::checkpoint(unsigned int& chkpt_vpq_tail, bool& chkpt_vpq_tail_phase, uint64_t& chkpt_context) {
+   chkpt_vpq_tail = vpq_tail;
+   chkpt_vpq_tail_phase = vpq_tail_phase;
+   chkpt_context = engine->get_context();
+}
+
+void value_predictor::restore(unsigned int recover_vpq_tail, bool recover_vpq_tail_phase, uint64_t recover_context) {
+   unsigned int new_length;
+
+   // Compute the length after recovery.
+   new_length = MOD_S((vpq_size + recover_vpq_tail - vpq_head), vpq_size);
+   if ((new_length == 0) && (recover_vpq_tail_phase != vpq_head_phase)) {
+      new_length = vpq_size;
+   }
+   assert(new_length <= vpq_length);
+
+   // Undo the engine's speculative updates for the squashed instructions, youngest first.
+   while (vpq_length > new_length) {
+      vpq_tail = ((vpq_tail == 0) ? (vpq_size - 1) : (vpq_tail - 1));
+      if (vpq_tail == (vpq_size - 1))   // wrapped around, so toggle phase bit
+         vpq_tail_phase = !vpq_tail_phase;
+      vpq_length--;
+
+      engine->squash(vpq_tail, VPQ[vpq_tail].pc);
+   }
+
+   assert((vpq_tail == recover_vpq_tail) && (vpq_tail_phase == recover_vpq_tail_phase));
+
+   engine->set_context(recover_context);
+}
+
+void value_predictor::flush() {
+   // Flush VPQ.
+   vpq_head = 0;
+   vpq_head_phase = false;
+   vpq_tail = 0;
+   vpq_tail_phase = false;
+   vpq_length = 0;
+
+   // No instances are in-flight anymore.
+   engine->flush();
+}
+
+
+// STATS
+void value_predictor::measure(bool eligible, bool hit, bool confident, bool filtered, bool correct) {
+   if (!eligible) {
+      n_ineligible++;
+   }
+   else {
+      n_eligible++;
+      if (!hit)
+         n_miss++;
+      else if (filtered && correct)
+         n_filtered_correct++;
+      else if (filtered)
+         n_filtered_incorrect++;
+      else if (!confident)
+         n_not_confident++;
+      else if (correct)
+         n_conf_correct++;
+      else
+         n_conf_incorrect++;
+   }
+}
+
+void value_predictor::measure_load(bool probe_hit, bool confident, bool correct) {
+   unsigned int i = (probe_hit ? 1 : 0);
+
+   n_load_probed[i]++;
+   if (confident) {
+      if (correct)
+         n_load_probed_conf_correct[i]++;
+      else
+         n_load_probed_conf_incorrect[i]++;
+   }
+}
+
+void value_predictor::measure_recovery(bool replay, unsigned int num_replayed) {
+   if (replay) {
+      n_replay++;
+      n_replayed += num_replayed;
+   }
+   else {
+      n_rollback++;
+   }
+}
+
+void value_predictor::dump_config(FILE* fp) {
+   engine->dump_config(fp);
+}
+
+// Percentage of 'n' out of 'total', 0 if 'total' is 0 (like the rates in stats.log).
+static double percent(uint64_t n, uint64_t total) {
+   return((total == 0) ? 0.0 : (100.0*(double)n/(double)total));
+}
+
+void value_predictor::dump_stats(FILE* fp) {
+   uint64_t n_total = (n_ineligible + n_eligible);
+
+   fprintf(fp, "VPU MEASUREMENTS-----------------------------------\n");
+
+   fprintf(fp, "COVERAGE (retired)\n");
+   fprintf(fp, "  all instr.       = %" PRIu64 "\n", n_total);
+   fprintf(fp, "  ineligible       = %" PRIu64 " (%.2f%%)\n",
+           n_ineligible,
+           percent(n_ineligible, n_total));
+   fprintf(fp, "  eligible         = %" PRIu64 " (%.2f%%)\n",
+           n_eligible,
+           percent(n_eligible, n_total));
+   fprintf(fp, "     miss          = %" PRIu64 " (%.2f%%)\n",
+           n_miss,
+           percent(n_miss, n_total));
+   fprintf(fp, "     not confident = %" PRIu64 " (%.2f%%)\n",
+           n_not_confident,
+           percent(n_not_confident, n_total));
+   if (VP_CRIT_FILTER || VP_CONSUMER_FILTER) {
+      fprintf(fp, "     filtered      = %" PRIu64 " (%.2f%%)\n",
+              (n_filtered_correct + n_filtered_incorrect),
+              percent(n_filtered_correct + n_filtered_incorrect, n_total));
+   }
+   fprintf(fp, "     confident     = %" PRIu64 " (%.2f%%)\n",
+           (n_conf_correct + n_conf_incorrect),
+           percent(n_conf_correct + n_conf_incorrect, n_total));
+
+   fprintf(fp, "ACCURACY (retired, confident)\n");
+   fprintf(fp, "  correct          = %" PRIu64 " (%.2f%%)\n",
+           n_conf_correct,
+           percent(n_conf_correct, n_conf_correct + n_conf_incorrect));
+   fprintf(fp, "  incorrect        = %" PRIu64 " (%.2f%%)\n",
+           n_conf_incorrect,
+           percent(n_conf_incorrect, n_conf_correct + n_conf_incorrect));
+
+   if (VP_CRIT_FILTER || VP_CONSUMER_FILTER) {
+      fprintf(fp, "FILTERED (retired, confident but not used)\n");
+      fprintf(fp, "  would be correct = %" PRIu64 " (%.2f%%)\n",
+              n_filtered_correct,
+              percent(n_filtered_correct, n_filtered_correct + n_filtered_incorrect));
+      fprintf(fp, "  would be incorr. = %" PRIu64 " (%.2f%%)\n",
+              n_filtered_incorrect,
+              percent(n_filtered_incorrect, n_filtered_correct + n_filtered_incorrect));
+   }
+
+   if (LOAD_ADDR_PRED) {
+      fprintf(fp, "LOADS BY PREDICTED-ADDRESS D$ PROBE (retired, eligible, address confidently predicted)\n");
+      for (int i = 1; i >= 0; i--) {
+         uint64_t n_conf = (n_load_probed_conf_correct[i] + n_load_probed_conf_incorrect[i]);
+         fprintf(fp, "  predicted %-4s   = %" PRIu64 "\n", (i ? "hit" : "miss"), n_load_probed[i]);
+         fprintf(fp, "     confident     = %" PRIu64 " (%.2f%%)\n",
+                 n_conf,
+                 percent(n_conf, n_load_probed[i]));
+         fprintf(fp, "     correct       = %" PRIu64 " (%.2f%% of confident)\n",
+                 n_load_probed_conf_correct[i],
+                 percent(n_load_probed_conf_correct[i], n_conf));
+      }
+   }
+
+   fprintf(fp, "RECOVERY AT WRITEBACK (all paths)\n");
+   fprintf(fp, "  rollbacks        = %" PRIu64 "\n", n_rollback);
+   fprintf(fp, "  replays          = %" PRIu64 " (%" PRIu64 " instr. replayed)\n", n_replay, n_replayed);
+
+   engine->dump_stats(fp);
+}
@@ -1,75 +1,153 @@
 #ifndef VALUE_PREDICTOR_H
 #define VALUE_PREDICTOR_H
 
-#include <cstdint>
-#include <vector>
-#include <queue>
-#include <unordered_map>
-
-using namespace std; 
-
-// Maximum confidence level for prediction
-const unsigned int CONF_MAX = 3;
-const unsigned int REPLACE_THRESHOLD = 1; // Threshold to replace the prediction
-
-	/////////////////////////////////////////////////////////////////////
-	// Structure 1: Value Prediction Queue (VPQ) 
-	/////////////////////////////////////////////////////////////////////
-
-    // Define the structure for a value prediction entry.
-    struct ValuePredictionEntry {
-        uint64_t tag;             // The tag of the instruction
-        unsigned int confidence;  // Confidence counter (saturates at 3)
-        uint64_t retired_value;   // The last retired value of the instruction
-        int64_t stride;          // The stride between consecutive values
-        unsigned int instance;    // Latest Instance number in the pipeline
-    };
-
-    struct ValuePredictionQueue {
-        uint64_t head, tail;                
-        uint64_t size;                       // Size of the value prediction queue
-        uint64_t head_phase_bit, tail_phase_bit; // Phase bits to distinguish full/empty states when head equals tail
-        ValuePredictionEntry* queue;         // Array of value prediction entries
-
-
-        // Constructor and Destructor
-        ValuePredictionQueue(uint64_t size);
-        ~ValuePredictionQueue();
-
-        // Additional methods
-        void enqueue(const ValuePredictionEntry& entry);
-        bool dequeue(ValuePredictionEntry& entry);
-        bool isConfidentPrediction(uint64_t tag) const;
-        uint64_t getPredictedValue(uint64_t tag) const;
-        void updatePrediction(uint64_t tag, uint64_t new_value, unsigned int new_confidence, uint64_t new_stride);
-        void resetPrediction(uint64_t tag);
-        void trainOrReplace(uint64_t tag, uint64_t value); // Trains or replaces the entry at retirement
-        bool getPrediction(uint64_t tag, uint64_t &predicted_value); // Provides a prediction if available
-    };
-
-    ValuePredictionQueue vpQueue; 
-
-
-
-	/////////////////////////////////////////////////////////////////////
-	// Structure 2: Stride Value Predictor (SVP) 
-	/////////////////////////////////////////////////////////////////////
-
-
-
-
-
-
-
-    /////////////////////////////////////////////////////////////////////
-    // Additional functions to support value prediction in the pipeline
-    /////////////////////////////////////////////////////////////////////
-
-    //***************************************************************
-    //Rename Stage
-    //***************************************************************
-
-    //Call from the rename stage to get predicted value
-    bool get_confident_prediction(uint64_t logical_register, uint64_t& predicted_value);
-
-#endif
+#include <cinttypes>
+#include <cstdio>
+
+#include "VPinterface.h"
+
+///////////////////////////////////////////////////////////////
+// Value prediction unit including:
+// 1. A value prediction engine (VPinterface_t): SVP, LVP, FCM,
+//    VTAGE or a hybrid of these, selected by VP_ALGORITHM.
+// 2. Value Prediction Queue (VPQ): a circular queue holding the
+//    PCs (and, once executed, the values) of in-flight
+//    value-prediction-eligible instructions in program order.
+//
+// Life cycle of an eligible instruction:
+// * Rename2: allocate a VPQ entry and consult the engine.
+// * Writeback: deposit the computed value into its VPQ entry.
+// * Retire: pop the VPQ head and train the engine with its value.
+// * Branch misprediction: roll back the VPQ tail (and the
+//   engine's global context, if any).
+// * Value misprediction (VP_RECOVERY 1 and 2): same, unless its
+//   dependents can be selectively replayed instead.
+// * Complete squash: flush the VPQ.
+///////////////////////////////////////////////////////////////
+
+// Single entry in the VPQ.
+typedef struct {
+  uint64_t pc;                // PC of the instruction, presented to the engine at retirement and on squashes
+  bool value_avail;           // the computed value has been deposited
+  uint64_t value;             // computed value, used to train the engine at retirement
+} vpq_entry;
+
+
+class value_predictor {
+
+private:
+
+  //////////////////////////
+  // Value prediction engine
+  //////////////////////////
+  VPinterface_t* engine;
+
+  //////////////////////////
+  // Value Prediction Queue
+  //////////////////////////
+  vpq_entry* VPQ;
+  unsigned int vpq_size;
+  unsigned int vpq_head;
+  unsigned int vpq_tail;
+  unsigned int vpq_length;
+
+  // These extra bits enable distinguishing between a full queue versus an empty queue when head==tail.
+  bool vpq_head_phase;
+  bool vpq_tail_phase;
+
+  //////////////////////////
+  // Prediction filters
+  //////////////////////////
+  // A confident prediction is only used if it passes the enabled filters (PC-indexed, untagged counters).
+  unsigned int* crit;         // VP_CRIT_FILTER: ROB-head stall cycles attributed to the PC, less one per retired instance that didn't stall
+  unsigned int* consumer;     // VP_CONSUMER_FILTER: consumers were waiting in the IQ when the value was produced
+
+  // Per physical register, for VP_CONSUMER_FILTER.
+  unsigned int num_phys_regs;
+  bool* pred_pending;         // the register holds a predicted value, its computed value isn't available yet
+  bool* consumer_waited;      // a consumer was dispatched before the register's computed value was available
+
+  //////////////////////////
+  // STATS
+  //////////////////////////
+  // Retired instructions, broken down by value prediction outcome.
+  uint64_t n_ineligible;      // not eligible for value prediction (instruction type or user configuration)
+  uint64_t n_eligible;        // eligible for value prediction (sum of the next four)
+  uint64_t n_miss;            // eligible, no prediction
+  uint64_t n_not_confident;   // eligible, prediction, not confident
+  uint64_t n_filtered_correct;   // eligible, confident but not used due to a filter, would have been correct
+  uint64_t n_filtered_incorrect; // eligible, confident but not used due to a filter, would have been incorrect
+  uint64_t n_conf_correct;    // eligible, confident, correct
+  uint64_t n_conf_incorrect;  // eligible, confident, incorrect
+
+  // Retired eligible loads whose address was confidently predicted (LOAD_ADDR_PRED), by the outcome of the
+  // D$ probe with the predicted address: [0] predicted miss, [1] predicted hit.
+  uint64_t n_load_probed[2];
+  uint64_t n_load_probed_conf_correct[2];
+  uint64_t n_load_probed_conf_incorrect[2];
+
+  // Value misprediction recoveries at writeback (VP_RECOVERY 1 and 2), including wrong-path instructions.
+  uint64_t n_rollback;        // rolled back to the mispredicted instruction's checkpoint
+  uint64_t n_replay;          // repaired by selectively replaying dependents
+  uint64_t n_replayed;        // dependents replayed (sum over all selective replays)
+
+public:
+
+  value_predictor(unsigned int vpq_size, unsigned int num_phys_regs, VPinterface_t* engine);   // constructor (takes ownership of the engine)
+  ~value_predictor();
+
+  // Rename2 Stage: stall if the VPQ cannot accommodate the bundle's eligible instructions.
+  bool stall(unsigned int bundle_vp);
+
+  // Rename2 Stage: allocate a VPQ entry for an eligible instruction and get its prediction.
+  // Returns 'true' if the engine has a prediction, in which case 'pred_value' and 'confident' are valid.
+  bool predict(uint64_t pc, unsigned int& vpq_index, uint64_t& pred_value, bool& confident);
+
+  // Rename2 Stage: a conditional branch was renamed with the predicted direction 'taken'.
+  // Also called by the Writeback Stage, with the actual direction, after recovering from its misprediction.
+  void branch(uint64_t pc, bool taken);
+
+  // Rename2 Stage: should the confident prediction of the instruction at 'pc' be used? (Prediction filters.)
+  bool filter(uint64_t pc);
+
+  // Dispatch Stage (VP_CONSUMER_FILTER): an instruction that produces 'phys_reg', with or without a confident prediction,
+  // and an instruction that consumes 'phys_reg', which is or isn't ready.
+  void dispatch_producer(unsigned int phys_reg, bool predicted);
+  void dispatch_consumer(unsigned int phys_reg, bool ready);
+
+  // Retire Stage (VP_CRIT_FILTER): the instruction at 'pc' stalled the Active List head for 'num_cycles' cycles.
+  void head_stall(uint64_t pc, uint64_t num_cycles);
+
+  // Retire Stage: train the prediction filters with the retired, eligible instruction at 'pc'.
+  void train_filters(uint64_t pc, bool stalled_head, unsigned int phys_reg);
+
+  // Writeback Stage: record the computed value (of physical register 'phys_reg') in the instruction's VPQ entry.
+  void deposit(unsigned int vpq_index, uint64_t value, unsigned int phys_reg);
+
+  // Retire Stage: pop the VPQ head (which must be 'vpq_index') and train the engine with its value.
+  void train(unsigned int vpq_index);
+
+  // Retire Stage: a conditional branch retired with the actual direction 'taken'.
+  void commit_branch(uint64_t pc, bool taken);
+
+  // Functional warming (sampled simulation): an eligible instruction at 'pc' produced 'value',
+  // or a conditional branch at 'pc' went in the direction 'taken'. Nothing is measured.
+  void warm(uint64_t pc, uint64_t value);
+  void warm_branch(uint64_t pc, bool taken);
+
+  // Branch checkpoints and recovery.
+  void checkpoint(unsigned int& chkpt_vpq_tail, bool& chkpt_vpq_tail_phase, uint64_t& chkpt_context);
+  void restore(unsigned int recover_vpq_tail, bool recover_vpq_tail_phase, uint64_t recover_context);
+
+  // Complete squash.
+  void flush();
+
+  // STATS
+  void measure(bool eligible, bool hit, bool confident, bool filtered, bool correct);
+  void measure_load(bool probe_hit, bool confident, bool correct);
+  void measure_recovery(bool replay, unsigned int num_replayed);
+  void dump_config(FILE* fp);
+  void dump_stats(FILE* fp);
+};
+
+#endif //VALUE_PREDICTOR_H
@@ -0,0 +1,30 @@
+#include <cinttypes>
+
+#include "parameters.h"
+#include "vp_conf.h"
+
+
+// xorshift64: one generator per simulator thread.
+static thread_local uint64_t fpc_rng = 0x2545F4914F6CDD1DULL;
+
+static uint64_t fpc_random() {
+   fpc_rng ^= (fpc_rng << 13);
+   fpc_rng ^= (fpc_rng >> 7);
+   fpc_rng ^= (fpc_rng << 17);
+   return(fpc_rng);
+}
+
+unsigned int vp_conf_inc(unsigned int conf, unsigned int confinc, unsigned int confmax) {
+   unsigned int log2_prob;
+
+   if (conf >= confmax)
+      return(confmax);
+
+   if (!VP_FPC)
+      return(((conf + confinc) > confmax) ? confmax : (conf + confinc));
+
+   log2_prob = VP_FPC_LOG2[(conf < VP_FPC_LEN) ? conf : (VP_FPC_LEN - 1)];
+   if ((log2_prob == 0) || ((fpc_random() & ((((uint64_t)1) << log2_prob) - 1)) == 0))
+      conf++;
+   return(conf);
+}
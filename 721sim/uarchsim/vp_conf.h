@@ -0,0 +1,21 @@
+#ifndef VP_CONF_H
+#define VP_CONF_H
+
+///////////////////////////////////////////////////////////////
+// Confidence counter increment, shared by the value
+// prediction engines.
+//
+// Default: conf + confinc, saturating at confmax.
+//
+// Forward probabilistic counters (FPC, VP_FPC): conf + 1 with
+// probability 1/2^VP_FPC_LOG2[conf] (the last entry of the
+// vector applies to all higher counter values), so that
+// reaching confmax takes many more correct predictions in a
+// row than the counter's width suggests, without widening it.
+// The random numbers come from a fixed-seed generator, so
+// runs are reproducible.
+///////////////////////////////////////////////////////////////
+
+unsigned int vp_conf_inc(unsigned int conf, unsigned int confinc, unsigned int confmax);
+
+#endif //VP_CONF_H
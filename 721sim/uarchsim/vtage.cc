@@ -0,0 +1,239 @@
+#include <stdlib.h>
+#include <cinttypes>
+#include <cmath>
+
+#include "pipeline.h"
+#include "vtage.h"
+#include "vp_conf.h"
+
+#define VTAGE_U_RESET_PERIOD	(1 << 18)	// retired predictions between clearing all useful bits
+
+
+vtage_t::vtage_t(unsigned int vpq_size,
+                 unsigned int base_index_bits,
+                 unsigned int num_tables,
+                 unsigned int index_bits,
+                 unsigned int tag_bits,
+                 unsigned int min_hist,
+                 unsigned int max_hist,
+                 unsigned int confmax,
+                 unsigned int confinc,
+                 unsigned int confdec,
+                 unsigned int replace_value) {
+   assert(vpq_size > 0);
+   assert(base_index_bits < 32);
+   assert((num_tables > 0) && (num_tables <= VTAGE_MAX_TABLES));
+   assert((index_bits > 0) && (index_bits < 32));
+   assert((tag_bits > 1) && (tag_bits < 64));
+   assert((min_hist > 0) && (min_hist <= max_hist) && (max_hist <= 64));
+
+   this->base_index_bits = base_index_bits;
+   this->num_tables = num_tables;
+   this->index_bits = index_bits;
+   this->tag_bits = tag_bits;
+   this->confmax = confmax;
+   this->confinc = confinc;
+   this->confdec = confdec;
+   this->replace_value = replace_value;
+
+   // History lengths form a geometric series from min_hist to max_hist.
+   for (unsigned int t = 0; t < num_tables; t++) {
+      if (num_tables == 1)
+         hist_length[t] = min_hist;
+      else
+         hist_length[t] = (unsigned int)(min_hist * pow((double)max_hist / (double)min_hist, (double)t / (double)(num_tables - 1)) + 0.5);
+   }
+
+   base = new vtage_base_entry[1 << base_index_bits];
+   for (unsigned int i = 0; i < (1U << base_index_bits); i++) {
+      base[i].value = 0;
+      base[i].conf = 0;
+   }
+
+   for (unsigned int t = 0; t < num_tables; t++) {
+      table[t] = new vtage_entry[1 << index_bits];
+      for (unsigned int i = 0; i < (1U << index_bits); i++) {
+         table[t][i].tag = 0;
+         table[t][i].value = 0;
+         table[t][i].conf = 0;
+         table[t][i].u = false;
+      }
+   }
+
+   ghist = 0;
+   commit_ghist = 0;
+   train_count = 0;
+
+   log = new vtage_log_t[vpq_size];
+
+   // STATS
+   for (unsigned int t = 0; t <= num_tables; t++)
+      n_provider[t] = 0;
+   n_alloc = 0;
+   n_alloc_fail = 0;
+}
+
+vtage_t::~vtage_t() {
+   delete [] base;
+   for (unsigned int t = 0; t < num_tables; t++)
+      delete [] table[t];
+   delete [] log;
+}
+
+// Fold the most recent "length" bits of "hist" down to "bits" bits.
+uint64_t vtage_t::fold(uint64_t hist, unsigned int length, unsigned int bits) {
+   uint64_t folded = 0;
+
+   if (length < 64)
+      hist &= ((((uint64_t)1) << length) - 1);
+   for (unsigned int i = 0; i < length; i += bits)
+      folded ^= (hist >> i);
+   return(folded & ((((uint64_t)1) << bits) - 1));
+}
+
+unsigned int vtage_t::get_index(uint64_t pc, unsigned int t) {
+   return((unsigned int)(((pc >> 2) ^ (pc >> (2 + index_bits)) ^ fold(ghist, hist_length[t], index_bits)) & ((1 << index_bits) - 1)));
+}
+
+uint64_t vtage_t::get_tag(uint64_t pc, unsigned int t) {
+   return(((pc >> 2) ^ fold(ghist, hist_length[t], tag_bits) ^ (fold(ghist, hist_length[t], tag_bits - 1) << 1)) & ((((uint64_t)1) << tag_bits) - 1));
+}
+
+bool vtage_t::predict(uint64_t pc, unsigned int vpq_index, uint64_t& pred_value, bool& confident) {
+   vtage_log_t* l = &log[vpq_index];
+   int alt;
+
+   l->base_index = (unsigned int)((pc >> 2) & ((1 << base_index_bits) - 1));
+   l->provider = -1;
+   alt = -1;
+   for (unsigned int t = 0; t < num_tables; t++) {
+      l->index[t] = get_index(pc, t);
+      l->tag[t] = get_tag(pc, t);
+      if (table[t][l->index[t]].tag == l->tag[t]) {
+         alt = l->provider;
+         l->provider = t;
+      }
+   }
+
+   if (l->provider >= 0) {
+      pred_value = table[l->provider][l->index[l->provider]].value;
+      confident = (table[l->provider][l->index[l->provider]].conf == confmax);
+      l->has_alt = true;
+      l->alt_value = ((alt >= 0) ? table[alt][l->index[alt]].value : base[l->base_index].value);
+   }
+   else {
+      pred_value = base[l->base_index].value;
+      confident = (base[l->base_index].conf == confmax);
+      l->has_alt = false;
+   }
+   l->pred_value = pred_value;
+
+   // The base table always provides a prediction.
+   return(true);
+}
+
+void vtage_t::spec_update_branch(uint64_t pc, bool taken) {
+   ghist = ((ghist << 1) | (taken ? 1 : 0));
+}
+
+void vtage_t::commit_branch(uint64_t pc, bool taken) {
+   commit_ghist = ((commit_ghist << 1) | (taken ? 1 : 0));
+}
+
+void vtage_t::train(unsigned int vpq_index, uint64_t pc, uint64_t value) {
+   vtage_log_t* l = &log[vpq_index];
+   bool correct = (l->pred_value == value);
+   uint64_t* e_value;
+   unsigned int* e_conf;
+   bool allocated;
+
+   n_provider[l->provider + 1]++;
+
+   // Train the provider, unless it was replaced while the instruction was in flight.
+   if (l->provider >= 0) {
+      vtage_entry* e = &table[l->provider][l->index[l->provider]];
+      if (e->tag == l->tag[l->provider]) {
+         e_value = &e->value;
+         e_conf = &e->conf;
+         if (correct && l->has_alt && (l->alt_value != value))
+            e->u = true;
+      }
+      else {
+         e_value = NULL;
+         e_conf = NULL;
+      }
+   }
+   else {
+      e_value = &base[l->base_index].value;
+      e_conf = &base[l->base_index].conf;
+   }
+
+   if (e_value) {
+      if (*e_value == value) {
+         *e_conf = vp_conf_inc(*e_conf, confinc, confmax);
+      }
+      else {
+         if (*e_conf <= replace_value)
+            *e_value = value;
+         *e_conf = (*e_conf > confdec) ? (*e_conf - confdec) : 0;
+      }
+   }
+
+   // On a misprediction, allocate an entry in a table with a longer history than the provider.
+   if (!correct && (l->provider < (int)(num_tables - 1))) {
+      allocated = false;
+      for (unsigned int t = l->provider + 1; t < num_tables; t++) {
+         vtage_entry* e = &table[t][l->index[t]];
+         if (!e->u) {
+            e->tag = l->tag[t];
+            e->value = value;
+            e->conf = 0;
+            allocated = true;
+            n_alloc++;
+            break;
+         }
+      }
+
+      // No room: age the candidates, so that one can be allocated eventually.
+      if (!allocated) {
+         for (unsigned int t = l->provider + 1; t < num_tables; t++)
+            table[t][l->index[t]].u = false;
+         n_alloc_fail++;
+      }
+   }
+
+   train_count++;
+   if ((train_count % VTAGE_U_RESET_PERIOD) == 0) {
+      for (unsigned int t = 0; t < num_tables; t++)
+         for (unsigned int i = 0; i < (1U << index_bits); i++)
+            table[t][i].u = false;
+   }
+}
+
+void vtage_t::dump_config(FILE* fp) {
+   fprintf(fp, "VTAGE_BASE_INDEX_BITS = %d\n", base_index_bits);
+   fprintf(fp, "VTAGE_NUM_TABLES = %d\n", num_tables);
+   fprintf(fp, "VTAGE_INDEX_BITS = %d\n", index_bits);
+   fprintf(fp, "VTAGE_TAG_BITS = %d\n", tag_bits);
+   fprintf(fp, "VTAGE_HIST_LENGTHS =");
+   for (unsigned int t = 0; t < num_tables; t++)
+      fprintf(fp, " %d", hist_length[t]);
+   fprintf(fp, "\n");
+   fprintf(fp, "VTAGE_CONFMAX = %d\n", confmax);
+   fprintf(fp, "VTAGE_CONFINC = %d\n", confinc);
+   fprintf(fp, "VTAGE_CONFDEC = %d\n", confdec);
+   fprintf(fp, "VTAGE_REPLACE_VALUE = %d\n", replace_value);
+}
+
+void vtage_t::dump_stats(FILE* fp) {
+   uint64_t n_total = 0;
+
+   for (unsigned int t = 0; t <= num_tables; t++)
+      n_total += n_provider[t];
+
+   fprintf(fp, "VTAGE PROVIDER (retired, eligible)\n");
+   fprintf(fp, "  base             = %" PRIu64 " (%.2f%%)\n", n_provider[0], (n_total ? (100.0*(double)n_provider[0]/(double)n_total) : 0.0));
+   for (unsigned int t = 0; t < num_tables; t++)
+      fprintf(fp, "  T%-2d (hist %2d)    = %" PRIu64 " (%.2f%%)\n", t + 1, hist_length[t], n_provider[t + 1], (n_total ? (100.0*(double)n_provider[t + 1]/(double)n_total) : 0.0));
+   fprintf(fp, "  allocations      = %" PRIu64 " (%" PRIu64 " failed)\n", n_alloc, n_alloc_fail);
+}
@@ -0,0 +1,105 @@
+#ifndef VTAGE_H
+#define VTAGE_H
+
+#include "VPinterface.h"
+
+///////////////////////////////////////////////////////////////
+// VTAGE value predictor (Perais and Seznec, HPCA 2014).
+//
+// An untagged, PC-indexed base table backs a number of tagged
+// tables indexed by the PC hashed with increasingly long global
+// branch histories (geometric series). The hitting table with
+// the longest history provides the prediction.
+//
+// The global branch history is built at rename, in program
+// order, from the predicted directions of conditional branches.
+// It is checkpointed along with the VPQ tail and repaired on
+// branch mispredictions. A committed copy, built at retire,
+// restores it on a complete squash.
+///////////////////////////////////////////////////////////////
+
+#define VTAGE_MAX_TABLES	16
+
+typedef struct {
+  uint64_t value;
+  unsigned int conf;
+} vtage_base_entry;
+
+typedef struct {
+  uint64_t tag;
+  uint64_t value;
+  unsigned int conf;
+  bool u;                     // useful
+} vtage_entry;
+
+typedef struct {
+  unsigned int base_index;
+  unsigned int index[VTAGE_MAX_TABLES];
+  uint64_t tag[VTAGE_MAX_TABLES];
+  int provider;               // providing table, or -1 for the base table
+  uint64_t pred_value;        // provider's value
+  bool has_alt;               // there is an alternate prediction (next-longest hit, or base)
+  uint64_t alt_value;         // alternate prediction
+} vtage_log_t;
+
+
+class vtage_t : public VPinterface_t {
+
+private:
+  vtage_base_entry* base;
+  unsigned int base_index_bits;
+
+  vtage_entry* table[VTAGE_MAX_TABLES];
+  unsigned int num_tables;
+  unsigned int index_bits;
+  unsigned int tag_bits;
+  unsigned int hist_length[VTAGE_MAX_TABLES];
+
+  unsigned int confmax;
+  unsigned int confinc;
+  unsigned int confdec;
+  unsigned int replace_value; // only replace a provider's value if conf <= replace_value
+
+  uint64_t ghist;             // speculative global branch history (most recent in the LSB)
+  uint64_t commit_ghist;      // committed global branch history
+
+  uint64_t train_count;       // periodically clears the useful bits
+
+  vtage_log_t* log;           // indexed by VPQ index
+
+  uint64_t fold(uint64_t hist, unsigned int length, unsigned int bits);
+  unsigned int get_index(uint64_t pc, unsigned int t);
+  uint64_t get_tag(uint64_t pc, unsigned int t);
+
+  // STATS
+  uint64_t n_provider[VTAGE_MAX_TABLES + 1];  // retired predictions by provider (0: base)
+  uint64_t n_alloc;
+  uint64_t n_alloc_fail;
+
+public:
+  vtage_t(unsigned int vpq_size,
+          unsigned int base_index_bits,
+          unsigned int num_tables,
+          unsigned int index_bits,
+          unsigned int tag_bits,
+          unsigned int min_hist,
+          unsigned int max_hist,
+          unsigned int confmax,
+          unsigned int confinc,
+          unsigned int confdec,
+          unsigned int replace_value);
+  ~vtage_t();
+
+  bool predict(uint64_t pc, unsigned int vpq_index, uint64_t& pred_value, bool& confident);
+  void spec_update_branch(uint64_t pc, bool taken);
+  uint64_t get_context() { return(ghist); }
+  void set_context(uint64_t context) { ghist = context; }
+  void squash(unsigned int vpq_index, uint64_t pc) {}
+  void flush() { ghist = commit_ghist; }
+  void train(unsigned int vpq_index, uint64_t pc, uint64_t value);
+  void commit_branch(uint64_t pc, bool taken);
+  void dump_config(FILE* fp);
+  void dump_stats(FILE* fp);
+};
+
+#endif //VTAGE_H
@@ -145,6 +145,14 @@ void pipeline_t::writeback(unsigned int lane_number) {
             // Restore the LQ/SQ.
             LSU.restore(PAY.buf[index].LQ_index, PAY.buf[index].LQ_phase, PAY.buf[index].SQ_index, PAY.buf[index].SQ_phase);
 
+            // Restore the VPQ.
+            // Also repair the value predictor's global branch history (if any) with the branch's actual direction.
+            if (VALUE_PRED_EN) {
+               VP->restore(PAY.buf[index].vpq_tail, PAY.buf[index].vpq_tail_phase, PAY.buf[index].vp_context);
+               if (IS_COND_BRANCH(PAY.buf[index].flags))
+                  VP->branch(PAY.buf[index].pc, (PAY.buf[index].c_next_pc != INCREMENT_PC(PAY.buf[index].pc)));
+            }
+
             // FIX_ME #15d
             // Squash instructions after the branch in program order, in all pipeline registers and the IQ.
             //
@@ -173,6 +181,11 @@ void pipeline_t::writeback(unsigned int lane_number) {
          }
       }
 
+      //////////////////////////////////////////////////////////////////////////////////////////////////////////
+      // Verify the instruction's value prediction, if any.
+      //////////////////////////////////////////////////////////////////////////////////////////////////////////
+      vp_verify(index);
+
       //////////////////////////////////////////////////////////////////////////////////////////////////////////
       // FIX_ME #16
       // Set completed bit in Active List.
@@ -198,3 +211,147 @@ void pipeline_t::writeback(unsigned int lane_number) {
       Execution_Lanes[lane_number].wb.valid = false;
    }
 }
+
+
+void pipeline_t::vp_verify(unsigned int index) {
+   bool misp;
+
+   if (VALUE_PRED_EN && PAY.buf[index].vp_eligible) {
+      // Deposit the computed value into the instruction's VPQ entry, for training the value predictor at retirement.
+      VP->deposit(PAY.buf[index].vpq_index, PAY.buf[index].C_value.dw, PAY.buf[index].C_phys_reg);
+
+      // The instruction's destination register was speculatively written with a predicted value
+      // that turns out to be wrong: its consumers may have used the wrong value.
+      misp = (PAY.buf[index].vp_confident && (PAY.buf[index].vp_pred_value != PAY.buf[index].C_value.dw));
+
+      if (PAY.buf[index].vp_checkpoint) {
+         // Recover now, using the checkpoint created for the prediction (VP_RECOVERY 1 and 2).
+         if (misp && ((VP_RECOVERY != 2) || !vp_replay(index))) {
+            vp_rollback(index);
+         }
+         else {
+            // Correct prediction, or selective replay repaired the misprediction: free the checkpoint.
+            REN->resolve(PAY.buf[index].AL_index, PAY.buf[index].branch_ID, true);
+            resolve(PAY.buf[index].branch_ID, true);
+         }
+      }
+      else if (misp) {
+         // Flag the instruction in the Active List: the Retire Stage recovers by squashing everything after it ("approach #1").
+         set_value_misprediction(PAY.buf[index].AL_index);
+      }
+   }
+}
+
+
+// Value misprediction: roll back to the instruction's checkpoint.
+// This is the same as recovering a mispredicted branch, except the instruction isn't a branch:
+// the Fetch Unit restarts right after it.
+void pipeline_t::vp_rollback(unsigned int index) {
+   // Roll-back the Fetch Unit.
+   FetchUnit->rollback(PAY.buf[index].pred_tag, INCREMENT_PC(PAY.buf[index].pc));
+
+   // Restore the RMT, FL, and AL.
+   REN->resolve(PAY.buf[index].AL_index, PAY.buf[index].branch_ID, false);
+
+   // Restore the LQ/SQ.
+   LSU.restore(PAY.buf[index].vp_LQ_tail, PAY.buf[index].vp_LQ_tail_phase, PAY.buf[index].vp_SQ_tail, PAY.buf[index].vp_SQ_tail_phase);
+
+   // Restore the VPQ.
+   VP->restore(PAY.buf[index].vpq_tail, PAY.buf[index].vpq_tail_phase, PAY.buf[index].vp_context);
+
+   // Squash instructions after the instruction in program order, in all pipeline registers and the IQ.
+   resolve(PAY.buf[index].branch_ID, false);
+
+   // Rollback PAY to the point of the instruction.
+   PAY.rollback(index);
+
+   VP->measure_recovery(false, 0);
+}
+
+
+// Value misprediction: selectively replay the instructions that consumed the wrong value, directly or transitively.
+// The correct value is already in the Physical Register File, so dependents that haven't issued will read it.
+// Dependents that have issued are pulled back into the IQ to re-execute, and their own dependents in the IQ
+// wait for them to wakeup again.
+// Only simple instructions are replayed. If an issued dependent is a branch (it may have resolved using
+// the wrong value), a load or store (the LSU may have acted on it), or similar, return 'false' to fall
+// back to rolling back to the checkpoint. Likewise if the IQ can't take all of the dependents.
+bool pipeline_t::vp_replay(unsigned int index) {
+   std::vector<unsigned int> replay;	// issued dependents, in program order
+   std::vector<unsigned int> tainted;	// physical registers holding wrong values (or soon to be overwritten by replay)
+   unsigned int i, j, k;
+   bool dependent;
+
+   tainted.push_back(PAY.buf[index].C_phys_reg);
+
+   // Walk the instructions after the mispredicted one, in program order.
+   // Instructions that haven't issued yet (including those not yet renamed) are skipped: nothing to repair.
+   for (i = MOD((index + 2), PAY.PAYLOAD_BUFFER_SIZE); i != PAY.tail; i = MOD((i + 2), PAY.PAYLOAD_BUFFER_SIZE)) {
+      if (!PAY.buf[i].issued)
+         continue;
+
+      dependent = false;
+      for (k = 0; k < tainted.size(); k++) {
+         if ((PAY.buf[i].A_valid && (PAY.buf[i].A_phys_reg == tainted[k])) ||
+             (PAY.buf[i].B_valid && (PAY.buf[i].B_phys_reg == tainted[k])) ||
+             (PAY.buf[i].D_valid && (PAY.buf[i].D_phys_reg == tainted[k])))
+            dependent = true;
+      }
+
+      if (dependent) {
+         if (IS_BRANCH(PAY.buf[i].flags) ||
+             IS_MEM_OP(PAY.buf[i].flags) ||
+             IS_AMO(PAY.buf[i].flags) ||
+             IS_CSR(PAY.buf[i].flags) ||
+             PAY.buf[i].split ||
+             (PAY.buf[i].iq != SEL_IQ) ||
+             PAY.buf[i].vp_confident) {
+            return(false);
+         }
+
+         replay.push_back(i);
+         if (PAY.buf[i].C_valid)
+            tainted.push_back(PAY.buf[i].C_phys_reg);
+      }
+   }
+
+   if (IQ.stall(replay.size()))
+      return(false);
+
+   // Pull the dependents out of the Execution Lanes and undo their effects.
+   for (k = 0; k < replay.size(); k++) {
+      i = replay[k];
+
+      for (j = 0; j < issue_width; j++) {
+         if (Execution_Lanes[j].rr.valid && (Execution_Lanes[j].rr.index == i))
+            Execution_Lanes[j].rr.valid = false;
+         for (unsigned int d = 0; d < Execution_Lanes[j].ex_depth; d++) {
+            if (Execution_Lanes[j].ex[d].valid && (Execution_Lanes[j].ex[d].index == i))
+               Execution_Lanes[j].ex[d].valid = false;
+         }
+         if (Execution_Lanes[j].wb.valid && (Execution_Lanes[j].wb.index == i))
+            Execution_Lanes[j].wb.valid = false;
+      }
+
+      if (PAY.buf[i].C_valid) {
+         REN->clear_ready(PAY.buf[i].C_phys_reg);
+         IQ.replay(PAY.buf[i].C_phys_reg);
+      }
+      REN->clear_complete(PAY.buf[i].AL_index);
+   }
+
+   // Re-insert the dependents into the IQ. Note: they become the youngest IQ entries, which
+   // slightly distorts ideal age-based priority.
+   for (k = 0; k < replay.size(); k++) {
+      i = replay[k];
+      PAY.buf[i].issued = false;
+      IQ.dispatch(i, PAY.buf[i].branch_mask,
+                  PAY.buf[i].lane_id,
+                  PAY.buf[i].A_valid, (PAY.buf[i].A_valid ? REN->is_ready(PAY.buf[i].A_phys_reg) : false), PAY.buf[i].A_phys_reg,
+                  PAY.buf[i].B_valid, (PAY.buf[i].B_valid ? REN->is_ready(PAY.buf[i].B_phys_reg) : false), PAY.buf[i].B_phys_reg,
+                  PAY.buf[i].D_valid, (PAY.buf[i].D_valid ? REN->is_ready(PAY.buf[i].D_phys_reg) : false), PAY.buf[i].D_phys_reg);
+   }
+
+   VP->measure_recovery(true, replay.size());
+   return(true);
+}